@@ -79,11 +79,14 @@ public:
             return ((DataSource*)handle)->getSize(size);
         };
         mWrapper->flags = [](void *handle) -> uint32_t {
-            return ((DataSource*)handle)->flags();
+            return ((DataSource*)handle)->flags() | CDATASOURCE_FLAG_HINT_READ_AHEAD;
         };
         mWrapper->getUri = [](void *handle, char *uriString, size_t bufferSize) -> bool {
             return ((DataSource*)handle)->getUri(uriString, bufferSize);
         };
+        mWrapper->hintReadAhead = [](void *handle, off64_t offset, size_t size) {
+            ((DataSource*)handle)->hintReadAhead(offset, size);
+        };
         return mWrapper;
     }
 
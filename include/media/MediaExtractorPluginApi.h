@@ -35,6 +35,13 @@ struct CDataSource {
     uint32_t (*flags)(void *handle );
     bool (*getUri)(void *handle, char *uriString, size_t bufferSize);
     void *handle;
+    // Only present if flags() has CDATASOURCE_FLAG_HINT_READ_AHEAD set: plugins
+    // may be loaded by an older framework, whose CDataSource ends at handle.
+    void (*hintReadAhead)(void *handle, off64_t offset, size_t size);
+};
+
+enum : uint32_t {
+    CDATASOURCE_FLAG_HINT_READ_AHEAD = 1u << 31,
 };
 
 enum CMediaTrackReadOptions : uint32_t {
@@ -324,6 +324,14 @@ public:
         return mSource->flags(mSource->handle);
     }
 
+    // Hint that [offset, offset + size) is about to be read sequentially.
+    // Ignored by sources that cannot use it.
+    virtual void hintReadAhead(off64_t offset, size_t size) {
+        if (mSource->flags(mSource->handle) & CDATASOURCE_FLAG_HINT_READ_AHEAD) {
+            mSource->hintReadAhead(mSource->handle, offset, size);
+        }
+    }
+
     // Convenience methods:
     bool getUInt16(off64_t offset, uint16_t *x) {
         *x = 0;
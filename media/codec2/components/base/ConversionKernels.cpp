@@ -0,0 +1,675 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ConversionKernels.h>
+
+// Integer only kernels: the NEON of ARMv7 is exact as well. On x86, the SIMD kernels need the
+// 32-bit multiplies and the unsigned packing of SSE4.1, which x86_64 guarantees.
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define C2_CONVERSION_NEON 1
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define C2_CONVERSION_SSE 1
+#endif
+
+namespace android {
+
+namespace conversion {
+
+namespace {
+
+constexpr uint16_t kNeutralUVBitDepth10 = 512;
+
+#define CLIP3(min, v, max) (((v) < (min)) ? (min) : (((max) > (v)) ? (v) : (max)))
+
+// Scalar kernels, converting a row, or a pair of rows for 4:2:0 to 4:4:4, from pixel x.
+
+void convertY410RowPair(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *ySrcTop,
+                        const uint16_t *ySrcBot, const uint16_t *uSrc, const uint16_t *vSrc,
+                        size_t x, size_t width) {
+    dstTop += x;
+    dstBot += x;
+    ySrcTop += x;
+    ySrcBot += x;
+    uSrc += x / 2;
+    vSrc += x / 2;
+
+    uint32_t u01, v01, y01, y23, y45, y67, uv0, uv1;
+    for (; x < width - 3; x += 4) {
+        u01 = *((uint32_t *)uSrc);
+        uSrc += 2;
+        v01 = *((uint32_t *)vSrc);
+        vSrc += 2;
+
+        y01 = *((uint32_t *)ySrcTop);
+        ySrcTop += 2;
+        y23 = *((uint32_t *)ySrcTop);
+        ySrcTop += 2;
+        y45 = *((uint32_t *)ySrcBot);
+        ySrcBot += 2;
+        y67 = *((uint32_t *)ySrcBot);
+        ySrcBot += 2;
+
+        uv0 = (u01 & 0x3FF) | ((v01 & 0x3FF) << 20);
+        uv1 = (u01 >> 16) | ((v01 >> 16) << 20);
+
+        *dstTop++ = 3 << 30 | ((y01 & 0x3FF) << 10) | uv0;
+        *dstTop++ = 3 << 30 | ((y01 >> 16) << 10) | uv0;
+        *dstTop++ = 3 << 30 | ((y23 & 0x3FF) << 10) | uv1;
+        *dstTop++ = 3 << 30 | ((y23 >> 16) << 10) | uv1;
+
+        *dstBot++ = 3 << 30 | ((y45 & 0x3FF) << 10) | uv0;
+        *dstBot++ = 3 << 30 | ((y45 >> 16) << 10) | uv0;
+        *dstBot++ = 3 << 30 | ((y67 & 0x3FF) << 10) | uv1;
+        *dstBot++ = 3 << 30 | ((y67 >> 16) << 10) | uv1;
+    }
+
+    // There should be at most 2 more pixels to process. Note that we don't
+    // need to consider odd case as the buffer is always aligned to even.
+    if (x < width) {
+        u01 = *uSrc;
+        v01 = *vSrc;
+        y01 = *((uint32_t *)ySrcTop);
+        y45 = *((uint32_t *)ySrcBot);
+        uv0 = (u01 & 0x3FF) | ((v01 & 0x3FF) << 20);
+        *dstTop++ = ((y01 & 0x3FF) << 10) | uv0;
+        *dstTop++ = ((y01 >> 16) << 10) | uv0;
+        *dstBot++ = ((y45 & 0x3FF) << 10) | uv0;
+        *dstBot++ = ((y45 >> 16) << 10) | uv0;
+    }
+}
+
+void convertRGBA1010102RowPair(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *ySrcTop,
+                               const uint16_t *ySrcBot, const uint16_t *uSrc,
+                               const uint16_t *vSrc, size_t x, size_t width,
+                               const YUVToRGBCoeffs &coeffs) {
+    int32_t _y = coeffs._y;
+    int32_t _b_u = coeffs._b_u;
+    int32_t _neg_g_u = -coeffs._g_u;
+    int32_t _neg_g_v = -coeffs._g_v;
+    int32_t _r_v = coeffs._r_v;
+    int32_t _c16 = coeffs._c16;
+
+    dstTop += x;
+    dstBot += x;
+    ySrcTop += x;
+    ySrcBot += x;
+    uSrc += x / 2;
+    vSrc += x / 2;
+
+    for (; x < width; x += 2) {
+        int32_t u, v, y00, y01, y10, y11;
+        u = *uSrc - 512;
+        uSrc += 1;
+        v = *vSrc - 512;
+        vSrc += 1;
+
+        y00 = *ySrcTop - _c16;
+        ySrcTop += 1;
+        y01 = *ySrcTop - _c16;
+        ySrcTop += 1;
+        y10 = *ySrcBot - _c16;
+        ySrcBot += 1;
+        y11 = *ySrcBot - _c16;
+        ySrcBot += 1;
+
+        int32_t u_b = u * _b_u;
+        int32_t u_g = u * _neg_g_u;
+        int32_t v_g = v * _neg_g_v;
+        int32_t v_r = v * _r_v;
+
+        int32_t yMult, b, g, r;
+        yMult = y00 * _y + 512;
+        b = (yMult + u_b) / 1024;
+        g = (yMult + v_g + u_g) / 1024;
+        r = (yMult + v_r) / 1024;
+        b = CLIP3(0, b, 1023);
+        g = CLIP3(0, g, 1023);
+        r = CLIP3(0, r, 1023);
+        *dstTop++ = 3 << 30 | (b << 20) | (g << 10) | r;
+
+        yMult = y01 * _y + 512;
+        b = (yMult + u_b) / 1024;
+        g = (yMult + v_g + u_g) / 1024;
+        r = (yMult + v_r) / 1024;
+        b = CLIP3(0, b, 1023);
+        g = CLIP3(0, g, 1023);
+        r = CLIP3(0, r, 1023);
+        *dstTop++ = 3 << 30 | (b << 20) | (g << 10) | r;
+
+        yMult = y10 * _y + 512;
+        b = (yMult + u_b) / 1024;
+        g = (yMult + v_g + u_g) / 1024;
+        r = (yMult + v_r) / 1024;
+        b = CLIP3(0, b, 1023);
+        g = CLIP3(0, g, 1023);
+        r = CLIP3(0, r, 1023);
+        *dstBot++ = 3 << 30 | (b << 20) | (g << 10) | r;
+
+        yMult = y11 * _y + 512;
+        b = (yMult + u_b) / 1024;
+        g = (yMult + v_g + u_g) / 1024;
+        r = (yMult + v_r) / 1024;
+        b = CLIP3(0, b, 1023);
+        g = CLIP3(0, g, 1023);
+        r = CLIP3(0, r, 1023);
+        *dstBot++ = 3 << 30 | (b << 20) | (g << 10) | r;
+    }
+}
+
+void convertP010LumaRow(uint16_t *dstY, const uint16_t *srcY, size_t x, size_t width) {
+    for (; x < width; ++x) {
+        dstY[x] = srcY[x] << 6;
+    }
+}
+
+void convertP010ChromaRow(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                          size_t x, size_t chromaWidth) {
+    for (; x < chromaWidth; ++x) {
+        dstUV[2 * x] = srcU[x] << 6;
+        dstUV[2 * x + 1] = srcV[x] << 6;
+    }
+}
+
+void convertYUV420Planar16Row(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
+                              const uint32_t *srcRGBA, size_t x, size_t width, bool evenRow,
+                              const RGBToYUVCoeffs &coeffs) {
+    uint16_t r, g, b;
+    int32_t i32Y, i32U, i32V;
+    const int16_t(*weights)[3] = coeffs.weights;
+    const uint16_t zeroLvl = coeffs.zeroLvl;
+    const uint16_t maxLvlLuma = coeffs.maxLvlLuma;
+    const uint16_t maxLvlChroma = coeffs.maxLvlChroma;
+
+    for (; x < width; ++x) {
+        b = (srcRGBA[x]  >> 20) & 0x3FF;
+        g = (srcRGBA[x]  >> 10) & 0x3FF;
+        r = srcRGBA[x] & 0x3FF;
+
+        i32Y = ((r * weights[0][0] + g * weights[0][1] + b * weights[0][2] + 512) >> 10) +
+               zeroLvl;
+        dstY[x] = CLIP3(zeroLvl, i32Y, maxLvlLuma);
+        if (evenRow && x % 2 == 0) {
+            i32U = ((r * weights[1][0] + g * weights[1][1] + b * weights[1][2] + 512) >> 10) +
+                   512;
+            i32V = ((r * weights[2][0] + g * weights[2][1] + b * weights[2][2] + 512) >> 10) +
+                   512;
+            dstU[x >> 1] = CLIP3(zeroLvl, i32U, maxLvlChroma);
+            dstV[x >> 1] = CLIP3(zeroLvl, i32V, maxLvlChroma);
+        }
+    }
+}
+
+// SIMD kernels, converting blocks of 8 pixels of a row, or of a pair of rows. They return the
+// first pixel left to the scalar kernels.
+//
+// The (yMult + c) / 1024 of the scalar YUV to RGB conversion is computed as an arithmetic shift:
+// they only differ for negative values, which are clipped to 0 either way.
+
+#if defined(C2_CONVERSION_NEON)
+
+// Masks of the Y410 samples: the scalar kernel keeps the upper bits of the odd samples
+const uint32_t kY410Mask[4] = {0x3FF, 0xFFFF, 0x3FF, 0xFFFF};
+
+size_t convertY410RowPairSimd(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *ySrcTop,
+                              const uint16_t *ySrcBot, const uint16_t *uSrc,
+                              const uint16_t *vSrc, size_t width) {
+    const uint32x4_t mask = vld1q_u32(kY410Mask);
+    const uint32x4_t alpha = vdupq_n_u32(3u << 30);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const uint32x4_t u = vandq_u32(vmovl_u16(vld1_u16(uSrc + x / 2)), mask);
+        const uint32x4_t v = vandq_u32(vmovl_u16(vld1_u16(vSrc + x / 2)), mask);
+        const uint32x4_t uv0 = vorrq_u32(u, vshlq_n_u32(v, 20));
+        const uint32x4x2_t uv = vzipq_u32(uv0, uv0);
+        const uint16x8_t yTop = vld1q_u16(ySrcTop + x);
+        const uint16x8_t yBot = vld1q_u16(ySrcBot + x);
+        const uint32x4_t y[4] = {
+            vandq_u32(vmovl_u16(vget_low_u16(yTop)), mask),
+            vandq_u32(vmovl_u16(vget_high_u16(yTop)), mask),
+            vandq_u32(vmovl_u16(vget_low_u16(yBot)), mask),
+            vandq_u32(vmovl_u16(vget_high_u16(yBot)), mask),
+        };
+        uint32_t *dst[4] = {dstTop + x, dstTop + x + 4, dstBot + x, dstBot + x + 4};
+        for (int i = 0; i < 4; ++i) {
+            vst1q_u32(dst[i], vorrq_u32(vorrq_u32(alpha, vshlq_n_u32(y[i], 10)), uv.val[i % 2]));
+        }
+    }
+    return x;
+}
+
+inline uint32x4_t rgba1010102Pixels(uint16x4_t ySrc, const YUVToRGBCoeffs &coeffs,
+                                    int32x4_t uB, int32x4_t uvG, int32x4_t vR) {
+    const int32x4_t y = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(ySrc)),
+                                  vdupq_n_s32(coeffs._c16));
+    const int32x4_t yMult = vmlaq_s32(vdupq_n_s32(512), y, vdupq_n_s32(coeffs._y));
+    const int32x4_t zero = vdupq_n_s32(0);
+    const int32x4_t max = vdupq_n_s32(1023);
+    const int32x4_t b = vminq_s32(vmaxq_s32(vshrq_n_s32(vaddq_s32(yMult, uB), 10), zero), max);
+    const int32x4_t g = vminq_s32(vmaxq_s32(vshrq_n_s32(vaddq_s32(yMult, uvG), 10), zero), max);
+    const int32x4_t r = vminq_s32(vmaxq_s32(vshrq_n_s32(vaddq_s32(yMult, vR), 10), zero), max);
+    const uint32x4_t rgb = vreinterpretq_u32_s32(
+            vorrq_s32(vorrq_s32(vshlq_n_s32(b, 20), vshlq_n_s32(g, 10)), r));
+    return vorrq_u32(vdupq_n_u32(3u << 30), rgb);
+}
+
+size_t convertRGBA1010102RowPairSimd(uint32_t *dstTop, uint32_t *dstBot,
+                                     const uint16_t *ySrcTop, const uint16_t *ySrcBot,
+                                     const uint16_t *uSrc, const uint16_t *vSrc, size_t width,
+                                     const YUVToRGBCoeffs &coeffs) {
+    const int32x4_t neutral = vdupq_n_s32(512);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const int32x4_t u = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vld1_u16(uSrc + x / 2))),
+                                      neutral);
+        const int32x4_t v = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vld1_u16(vSrc + x / 2))),
+                                      neutral);
+        const int32x4_t uB = vmulq_s32(u, vdupq_n_s32(coeffs._b_u));
+        const int32x4_t uvG = vaddq_s32(vmulq_s32(v, vdupq_n_s32(-coeffs._g_v)),
+                                        vmulq_s32(u, vdupq_n_s32(-coeffs._g_u)));
+        const int32x4_t vR = vmulq_s32(v, vdupq_n_s32(coeffs._r_v));
+        // Each chroma sample applies to two horizontal pixels
+        const int32x4x2_t uB2 = vzipq_s32(uB, uB);
+        const int32x4x2_t uvG2 = vzipq_s32(uvG, uvG);
+        const int32x4x2_t vR2 = vzipq_s32(vR, vR);
+
+        const uint16x8_t yTop = vld1q_u16(ySrcTop + x);
+        const uint16x8_t yBot = vld1q_u16(ySrcBot + x);
+        vst1q_u32(dstTop + x, rgba1010102Pixels(vget_low_u16(yTop), coeffs,
+                                                uB2.val[0], uvG2.val[0], vR2.val[0]));
+        vst1q_u32(dstTop + x + 4, rgba1010102Pixels(vget_high_u16(yTop), coeffs,
+                                                    uB2.val[1], uvG2.val[1], vR2.val[1]));
+        vst1q_u32(dstBot + x, rgba1010102Pixels(vget_low_u16(yBot), coeffs,
+                                                uB2.val[0], uvG2.val[0], vR2.val[0]));
+        vst1q_u32(dstBot + x + 4, rgba1010102Pixels(vget_high_u16(yBot), coeffs,
+                                                    uB2.val[1], uvG2.val[1], vR2.val[1]));
+    }
+    return x;
+}
+
+size_t convertP010LumaRowSimd(uint16_t *dstY, const uint16_t *srcY, size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        vst1q_u16(dstY + x, vshlq_n_u16(vld1q_u16(srcY + x), 6));
+    }
+    return x;
+}
+
+size_t convertP010ChromaRowSimd(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                                size_t chromaWidth) {
+    size_t x = 0;
+    for (; x + 8 <= chromaWidth; x += 8) {
+        uint16x8x2_t uv;
+        uv.val[0] = vshlq_n_u16(vld1q_u16(srcU + x), 6);
+        uv.val[1] = vshlq_n_u16(vld1q_u16(srcV + x), 6);
+        vst2q_u16(dstUV + 2 * x, uv);
+    }
+    return x;
+}
+
+// ((r * w[0] + g * w[1] + b * w[2] + 512) >> 10) + offset, clipped to [min, max]
+inline int32x4_t rgbToYuvComponent(int32x4_t r, int32x4_t g, int32x4_t b, const int16_t w[3],
+                                   int32_t offset, int32_t min, int32_t max) {
+    int32x4_t sum = vmlaq_s32(vdupq_n_s32(512), r, vdupq_n_s32(w[0]));
+    sum = vmlaq_s32(sum, g, vdupq_n_s32(w[1]));
+    sum = vmlaq_s32(sum, b, vdupq_n_s32(w[2]));
+    const int32x4_t value = vaddq_s32(vshrq_n_s32(sum, 10), vdupq_n_s32(offset));
+    return vminq_s32(vmaxq_s32(value, vdupq_n_s32(min)), vdupq_n_s32(max));
+}
+
+inline void splitRGBA1010102(uint32x4_t rgba, int32x4_t *r, int32x4_t *g, int32x4_t *b) {
+    const uint32x4_t mask = vdupq_n_u32(0x3FF);
+    *r = vreinterpretq_s32_u32(vandq_u32(rgba, mask));
+    *g = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(rgba, 10), mask));
+    *b = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(rgba, 20), mask));
+}
+
+size_t convertYUV420Planar16RowSimd(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
+                                    const uint32_t *srcRGBA, size_t width, bool evenRow,
+                                    const RGBToYUVCoeffs &coeffs) {
+    const int16_t(*weights)[3] = coeffs.weights;
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const uint32x4_t rgba0 = vld1q_u32(srcRGBA + x);
+        const uint32x4_t rgba1 = vld1q_u32(srcRGBA + x + 4);
+        int32x4_t r, g, b;
+        splitRGBA1010102(rgba0, &r, &g, &b);
+        const int32x4_t y0 = rgbToYuvComponent(r, g, b, weights[0], coeffs.zeroLvl,
+                                               coeffs.zeroLvl, coeffs.maxLvlLuma);
+        splitRGBA1010102(rgba1, &r, &g, &b);
+        const int32x4_t y1 = rgbToYuvComponent(r, g, b, weights[0], coeffs.zeroLvl,
+                                               coeffs.zeroLvl, coeffs.maxLvlLuma);
+        vst1q_u16(dstY + x, vcombine_u16(vqmovun_s32(y0), vqmovun_s32(y1)));
+        if (evenRow) {
+            // Chroma is sampled from the even pixels
+            splitRGBA1010102(vuzpq_u32(rgba0, rgba1).val[0], &r, &g, &b);
+            const int32x4_t u = rgbToYuvComponent(r, g, b, weights[1], 512,
+                                                  coeffs.zeroLvl, coeffs.maxLvlChroma);
+            const int32x4_t v = rgbToYuvComponent(r, g, b, weights[2], 512,
+                                                  coeffs.zeroLvl, coeffs.maxLvlChroma);
+            vst1_u16(dstU + x / 2, vqmovun_s32(u));
+            vst1_u16(dstV + x / 2, vqmovun_s32(v));
+        }
+    }
+    return x;
+}
+
+#elif defined(C2_CONVERSION_SSE)
+
+size_t convertY410RowPairSimd(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *ySrcTop,
+                              const uint16_t *ySrcBot, const uint16_t *uSrc,
+                              const uint16_t *vSrc, size_t width) {
+    // The scalar kernel keeps the upper bits of the odd samples
+    const __m128i mask = _mm_setr_epi32(0x3FF, 0xFFFF, 0x3FF, 0xFFFF);
+    const __m128i alpha = _mm_set1_epi32(3u << 30);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i u = _mm_and_si128(
+                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(uSrc + x / 2))), mask);
+        const __m128i v = _mm_and_si128(
+                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(vSrc + x / 2))), mask);
+        const __m128i uv = _mm_or_si128(u, _mm_slli_epi32(v, 20));
+        const __m128i uv2[2] = {_mm_unpacklo_epi32(uv, uv), _mm_unpackhi_epi32(uv, uv)};
+        const __m128i yTop = _mm_loadu_si128((const __m128i *)(ySrcTop + x));
+        const __m128i yBot = _mm_loadu_si128((const __m128i *)(ySrcBot + x));
+        const __m128i y[4] = {
+            _mm_and_si128(_mm_cvtepu16_epi32(yTop), mask),
+            _mm_and_si128(_mm_cvtepu16_epi32(_mm_srli_si128(yTop, 8)), mask),
+            _mm_and_si128(_mm_cvtepu16_epi32(yBot), mask),
+            _mm_and_si128(_mm_cvtepu16_epi32(_mm_srli_si128(yBot, 8)), mask),
+        };
+        uint32_t *dst[4] = {dstTop + x, dstTop + x + 4, dstBot + x, dstBot + x + 4};
+        for (int i = 0; i < 4; ++i) {
+            _mm_storeu_si128((__m128i *)dst[i],
+                             _mm_or_si128(_mm_or_si128(alpha, _mm_slli_epi32(y[i], 10)),
+                                          uv2[i % 2]));
+        }
+    }
+    return x;
+}
+
+inline __m128i rgba1010102Pixels(__m128i ySrc, const YUVToRGBCoeffs &coeffs,
+                                 __m128i uB, __m128i uvG, __m128i vR) {
+    const __m128i y = _mm_sub_epi32(_mm_cvtepu16_epi32(ySrc), _mm_set1_epi32(coeffs._c16));
+    const __m128i yMult = _mm_add_epi32(_mm_mullo_epi32(y, _mm_set1_epi32(coeffs._y)),
+                                        _mm_set1_epi32(512));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi32(1023);
+    const __m128i b = _mm_min_epi32(
+            _mm_max_epi32(_mm_srai_epi32(_mm_add_epi32(yMult, uB), 10), zero), max);
+    const __m128i g = _mm_min_epi32(
+            _mm_max_epi32(_mm_srai_epi32(_mm_add_epi32(yMult, uvG), 10), zero), max);
+    const __m128i r = _mm_min_epi32(
+            _mm_max_epi32(_mm_srai_epi32(_mm_add_epi32(yMult, vR), 10), zero), max);
+    const __m128i rgb = _mm_or_si128(
+            _mm_or_si128(_mm_slli_epi32(b, 20), _mm_slli_epi32(g, 10)), r);
+    return _mm_or_si128(_mm_set1_epi32(3u << 30), rgb);
+}
+
+size_t convertRGBA1010102RowPairSimd(uint32_t *dstTop, uint32_t *dstBot,
+                                     const uint16_t *ySrcTop, const uint16_t *ySrcBot,
+                                     const uint16_t *uSrc, const uint16_t *vSrc, size_t width,
+                                     const YUVToRGBCoeffs &coeffs) {
+    const __m128i neutral = _mm_set1_epi32(512);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i u = _mm_sub_epi32(
+                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(uSrc + x / 2))), neutral);
+        const __m128i v = _mm_sub_epi32(
+                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(vSrc + x / 2))), neutral);
+        const __m128i uB = _mm_mullo_epi32(u, _mm_set1_epi32(coeffs._b_u));
+        const __m128i uvG = _mm_add_epi32(_mm_mullo_epi32(v, _mm_set1_epi32(-coeffs._g_v)),
+                                          _mm_mullo_epi32(u, _mm_set1_epi32(-coeffs._g_u)));
+        const __m128i vR = _mm_mullo_epi32(v, _mm_set1_epi32(coeffs._r_v));
+        // Each chroma sample applies to two horizontal pixels
+        const __m128i uB2[2] = {_mm_unpacklo_epi32(uB, uB), _mm_unpackhi_epi32(uB, uB)};
+        const __m128i uvG2[2] = {_mm_unpacklo_epi32(uvG, uvG), _mm_unpackhi_epi32(uvG, uvG)};
+        const __m128i vR2[2] = {_mm_unpacklo_epi32(vR, vR), _mm_unpackhi_epi32(vR, vR)};
+
+        const __m128i yTop = _mm_loadu_si128((const __m128i *)(ySrcTop + x));
+        const __m128i yBot = _mm_loadu_si128((const __m128i *)(ySrcBot + x));
+        const __m128i ySrc[4] = {yTop, _mm_srli_si128(yTop, 8), yBot, _mm_srli_si128(yBot, 8)};
+        uint32_t *dst[4] = {dstTop + x, dstTop + x + 4, dstBot + x, dstBot + x + 4};
+        for (int i = 0; i < 4; ++i) {
+            _mm_storeu_si128((__m128i *)dst[i], rgba1010102Pixels(
+                    ySrc[i], coeffs, uB2[i % 2], uvG2[i % 2], vR2[i % 2]));
+        }
+    }
+    return x;
+}
+
+size_t convertP010LumaRowSimd(uint16_t *dstY, const uint16_t *srcY, size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        _mm_storeu_si128((__m128i *)(dstY + x),
+                         _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(srcY + x)), 6));
+    }
+    return x;
+}
+
+size_t convertP010ChromaRowSimd(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                                size_t chromaWidth) {
+    size_t x = 0;
+    for (; x + 8 <= chromaWidth; x += 8) {
+        const __m128i u = _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(srcU + x)), 6);
+        const __m128i v = _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(srcV + x)), 6);
+        _mm_storeu_si128((__m128i *)(dstUV + 2 * x), _mm_unpacklo_epi16(u, v));
+        _mm_storeu_si128((__m128i *)(dstUV + 2 * x + 8), _mm_unpackhi_epi16(u, v));
+    }
+    return x;
+}
+
+// ((r * w[0] + g * w[1] + b * w[2] + 512) >> 10) + offset, clipped to [min, max]
+inline __m128i rgbToYuvComponent(__m128i r, __m128i g, __m128i b, const int16_t w[3],
+                                 int32_t offset, int32_t min, int32_t max) {
+    __m128i sum = _mm_add_epi32(_mm_mullo_epi32(r, _mm_set1_epi32(w[0])), _mm_set1_epi32(512));
+    sum = _mm_add_epi32(sum, _mm_mullo_epi32(g, _mm_set1_epi32(w[1])));
+    sum = _mm_add_epi32(sum, _mm_mullo_epi32(b, _mm_set1_epi32(w[2])));
+    const __m128i value = _mm_add_epi32(_mm_srai_epi32(sum, 10), _mm_set1_epi32(offset));
+    return _mm_min_epi32(_mm_max_epi32(value, _mm_set1_epi32(min)), _mm_set1_epi32(max));
+}
+
+inline void splitRGBA1010102(__m128i rgba, __m128i *r, __m128i *g, __m128i *b) {
+    const __m128i mask = _mm_set1_epi32(0x3FF);
+    *r = _mm_and_si128(rgba, mask);
+    *g = _mm_and_si128(_mm_srli_epi32(rgba, 10), mask);
+    *b = _mm_and_si128(_mm_srli_epi32(rgba, 20), mask);
+}
+
+size_t convertYUV420Planar16RowSimd(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
+                                    const uint32_t *srcRGBA, size_t width, bool evenRow,
+                                    const RGBToYUVCoeffs &coeffs) {
+    const int16_t(*weights)[3] = coeffs.weights;
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i rgba0 = _mm_loadu_si128((const __m128i *)(srcRGBA + x));
+        const __m128i rgba1 = _mm_loadu_si128((const __m128i *)(srcRGBA + x + 4));
+        __m128i r, g, b;
+        splitRGBA1010102(rgba0, &r, &g, &b);
+        const __m128i y0 = rgbToYuvComponent(r, g, b, weights[0], coeffs.zeroLvl,
+                                             coeffs.zeroLvl, coeffs.maxLvlLuma);
+        splitRGBA1010102(rgba1, &r, &g, &b);
+        const __m128i y1 = rgbToYuvComponent(r, g, b, weights[0], coeffs.zeroLvl,
+                                             coeffs.zeroLvl, coeffs.maxLvlLuma);
+        _mm_storeu_si128((__m128i *)(dstY + x), _mm_packus_epi32(y0, y1));
+        if (evenRow) {
+            // Chroma is sampled from the even pixels
+            const __m128i even = _mm_castps_si128(_mm_shuffle_ps(
+                    _mm_castsi128_ps(rgba0), _mm_castsi128_ps(rgba1), _MM_SHUFFLE(2, 0, 2, 0)));
+            splitRGBA1010102(even, &r, &g, &b);
+            const __m128i u = rgbToYuvComponent(r, g, b, weights[1], 512,
+                                                coeffs.zeroLvl, coeffs.maxLvlChroma);
+            const __m128i v = rgbToYuvComponent(r, g, b, weights[2], 512,
+                                                coeffs.zeroLvl, coeffs.maxLvlChroma);
+            _mm_storel_epi64((__m128i *)(dstU + x / 2), _mm_packus_epi32(u, u));
+            _mm_storel_epi64((__m128i *)(dstV + x / 2), _mm_packus_epi32(v, v));
+        }
+    }
+    return x;
+}
+
+#else
+
+size_t convertY410RowPairSimd(uint32_t *, uint32_t *, const uint16_t *, const uint16_t *,
+                              const uint16_t *, const uint16_t *, size_t) {
+    return 0;
+}
+
+size_t convertRGBA1010102RowPairSimd(uint32_t *, uint32_t *, const uint16_t *, const uint16_t *,
+                                     const uint16_t *, const uint16_t *, size_t,
+                                     const YUVToRGBCoeffs &) {
+    return 0;
+}
+
+size_t convertP010LumaRowSimd(uint16_t *, const uint16_t *, size_t) {
+    return 0;
+}
+
+size_t convertP010ChromaRowSimd(uint16_t *, const uint16_t *, const uint16_t *, size_t) {
+    return 0;
+}
+
+size_t convertYUV420Planar16RowSimd(uint16_t *, uint16_t *, uint16_t *, const uint32_t *, size_t,
+                                    bool, const RGBToYUVCoeffs &) {
+    return 0;
+}
+
+#endif
+
+}  // namespace
+
+bool isSimdKernelAvailable() {
+#if defined(C2_CONVERSION_NEON) || defined(C2_CONVERSION_SSE)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void convertYUV420Planar16ToY410(Kernel kernel, uint32_t *dst, const uint16_t *srcY,
+                                 const uint16_t *srcU, const uint16_t *srcV, size_t srcYStride,
+                                 size_t srcUStride, size_t srcVStride, size_t dstStride,
+                                 size_t width, size_t height) {
+    // Converting two lines at a time, slightly faster
+    for (size_t y = 0; y < height; y += 2) {
+        uint32_t *dstTop = dst;
+        uint32_t *dstBot = dst + dstStride;
+        const uint16_t *ySrcTop = srcY;
+        const uint16_t *ySrcBot = srcY + srcYStride;
+
+        size_t x = 0;
+        if (kernel == Kernel::SIMD) {
+            x = convertY410RowPairSimd(dstTop, dstBot, ySrcTop, ySrcBot, srcU, srcV, width);
+        }
+        convertY410RowPair(dstTop, dstBot, ySrcTop, ySrcBot, srcU, srcV, x, width);
+
+        srcY += srcYStride * 2;
+        srcU += srcUStride;
+        srcV += srcVStride;
+        dst += dstStride * 2;
+    }
+}
+
+void convertYUV420Planar16ToRGBA1010102(Kernel kernel, uint32_t *dst, const uint16_t *srcY,
+                                        const uint16_t *srcU, const uint16_t *srcV,
+                                        size_t srcYStride, size_t srcUStride, size_t srcVStride,
+                                        size_t dstStride, size_t width, size_t height,
+                                        const YUVToRGBCoeffs &coeffs) {
+    // Converting two lines at a time, slightly faster
+    for (size_t y = 0; y < height; y += 2) {
+        uint32_t *dstTop = dst;
+        uint32_t *dstBot = dst + dstStride;
+        const uint16_t *ySrcTop = srcY;
+        const uint16_t *ySrcBot = srcY + srcYStride;
+
+        size_t x = 0;
+        if (kernel == Kernel::SIMD) {
+            x = convertRGBA1010102RowPairSimd(dstTop, dstBot, ySrcTop, ySrcBot, srcU, srcV,
+                                              width, coeffs);
+        }
+        convertRGBA1010102RowPair(dstTop, dstBot, ySrcTop, ySrcBot, srcU, srcV, x, width,
+                                  coeffs);
+
+        srcY += srcYStride * 2;
+        srcU += srcUStride;
+        srcV += srcVStride;
+        dst += dstStride * 2;
+    }
+}
+
+void convertYUV420Planar16ToP010(Kernel kernel, uint16_t *dstY, uint16_t *dstUV,
+                                 const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV,
+                                 size_t srcYStride, size_t srcUStride, size_t srcVStride,
+                                 size_t dstYStride, size_t dstUVStride, size_t width,
+                                 size_t height, bool isMonochrome) {
+    for (size_t y = 0; y < height; ++y) {
+        size_t x = 0;
+        if (kernel == Kernel::SIMD) {
+            x = convertP010LumaRowSimd(dstY, srcY, width);
+        }
+        convertP010LumaRow(dstY, srcY, x, width);
+        srcY += srcYStride;
+        dstY += dstYStride;
+    }
+
+    if (isMonochrome) {
+        // Fill with neutral U/V values.
+        for (size_t y = 0; y < (height + 1) / 2; ++y) {
+            for (size_t x = 0; x < (width + 1) / 2; ++x) {
+                dstUV[2 * x] = kNeutralUVBitDepth10 << 6;
+                dstUV[2 * x + 1] = kNeutralUVBitDepth10 << 6;
+            }
+            dstUV += dstUVStride;
+        }
+        return;
+    }
+
+    for (size_t y = 0; y < (height + 1) / 2; ++y) {
+        size_t x = 0;
+        if (kernel == Kernel::SIMD) {
+            x = convertP010ChromaRowSimd(dstUV, srcU, srcV, (width + 1) / 2);
+        }
+        convertP010ChromaRow(dstUV, srcU, srcV, x, (width + 1) / 2);
+        srcU += srcUStride;
+        srcV += srcVStride;
+        dstUV += dstUVStride;
+    }
+}
+
+void convertRGBA1010102ToYUV420Planar16(Kernel kernel, uint16_t *dstY, uint16_t *dstU,
+                                        uint16_t *dstV, const uint32_t *srcRGBA,
+                                        size_t srcRGBStride, size_t width, size_t height,
+                                        const RGBToYUVCoeffs &coeffs) {
+    for (size_t y = 0; y < height; ++y) {
+        const bool evenRow = y % 2 == 0;
+        size_t x = 0;
+        if (kernel == Kernel::SIMD) {
+            x = convertYUV420Planar16RowSimd(dstY, dstU, dstV, srcRGBA, width, evenRow, coeffs);
+        }
+        convertYUV420Planar16Row(dstY, dstU, dstV, srcRGBA, x, width, evenRow, coeffs);
+        srcRGBA += srcRGBStride;
+        dstY += width;
+        if (evenRow) {
+            dstU += width / 2;
+            dstV += width / 2;
+        }
+    }
+}
+
+}  // namespace conversion
+
+}  // namespace android
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MultiAccessUnitHelper"
+#include <log/log.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <MultiAccessUnitHelper.h>
+
+namespace android {
+
+MultiAccessUnitHelper::MultiAccessUnitHelper() : mNextIndex(0u) {}
+
+void MultiAccessUnitHelper::scatter(
+        std::unique_ptr<C2Work> work, std::list<std::unique_ptr<C2Work>> *items) {
+    std::shared_ptr<const C2StreamAccessUnitInfos::input> infos;
+    if (work->input.buffers.size() == 1u && work->input.buffers[0]
+            && work->input.buffers[0]->data().type() == C2BufferData::LINEAR
+            && work->input.buffers[0]->data().linearBlocks().size() == 1u) {
+        infos = std::static_pointer_cast<const C2StreamAccessUnitInfos::input>(
+                work->input.buffers[0]->getInfo(C2StreamAccessUnitInfos::input::PARAM_TYPE));
+    }
+    if (!infos || infos->flexCount() <= 1u || work->worklets.size() != 1u) {
+        items->push_back(std::move(work));
+        return;
+    }
+
+    const C2ConstLinearBlock &block = work->input.buffers[0]->data().linearBlocks().front();
+    size_t totalSize = 0;
+    for (size_t i = 0; i < infos->flexCount(); ++i) {
+        totalSize += infos->m.values[i].size;
+    }
+    if (totalSize != block.size()) {
+        ALOGW("access units of %zu bytes in a buffer of %u bytes; processing as one",
+                totalSize, block.size());
+        items->push_back(std::move(work));
+        return;
+    }
+
+    const C2WorkOrdinalStruct &ordinal = work->input.ordinal;
+    const uint64_t parentIndex = ordinal.frameIndex.peeku();
+    const uint32_t eos = work->input.flags & C2FrameData::FLAG_END_OF_STREAM;
+    const uint32_t flags = work->input.flags & ~C2FrameData::FLAG_END_OF_STREAM;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    size_t offset = 0;
+    for (size_t i = 0; i < infos->flexCount(); ++i) {
+        const C2AccessUnitInfoStruct &info = infos->m.values[i];
+        const bool last = (i + 1 == infos->flexCount());
+
+        std::unique_ptr<C2Work> unit(new C2Work);
+        unit->input.flags = (C2FrameData::flags_t)(
+                flags | (info.flags & ~C2FrameData::FLAG_END_OF_STREAM) | (last ? eos : 0));
+        unit->input.ordinal.timestamp = info.timestamp;
+        unit->input.ordinal.frameIndex = kAccessUnitIndexFlag | mNextIndex++;
+        // keep the delta between the client and codec timestamps of the work
+        unit->input.ordinal.customOrdinal =
+            ordinal.customOrdinal + c2_cntr64_t(info.timestamp) - ordinal.timestamp;
+        unit->input.buffers.push_back(C2Buffer::CreateLinearBuffer(
+                block.subBlock(block.offset() + offset, info.size)));
+        if (i == 0) {
+            unit->input.configUpdate = std::move(work->input.configUpdate);
+        }
+        unit->worklets.emplace_back(new C2Worklet);
+        unit->worklets.front()->component = work->worklets.front()->component;
+        unit->workletsProcessed = 0u;
+        unit->result = C2_OK;
+        offset += info.size;
+
+        mParentIndices[unit->input.ordinal.frameIndex.peeku()] = parentIndex;
+        items->push_back(std::move(unit));
+    }
+    ALOGV("split frame #%" PRIu64 " into %zu access units", parentIndex, infos->flexCount());
+
+    work->input.configUpdate.clear();
+    mBatches[parentIndex] = Batch{ std::move(work), infos->flexCount(), {}, {}, false };
+}
+
+std::unique_ptr<C2Work> MultiAccessUnitHelper::gather(
+        std::unique_ptr<C2Work> work, const std::shared_ptr<C2BlockPool> &pool) {
+    const uint64_t frameIndex = work->input.ordinal.frameIndex.peeku();
+    if (!IsAccessUnitIndex(frameIndex)) {
+        return work;
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    auto parentIt = mParentIndices.find(frameIndex);
+    if (parentIt == mParentIndices.end()) {
+        ALOGD("dropping access unit #%" PRIu64 " of a flushed work", frameIndex);
+        return nullptr;
+    }
+    auto batchIt = mBatches.find(parentIt->second);
+    Batch &batch = batchIt->second;
+    C2Work &parent = *batch.work;
+
+    const bool hasWorklet = work->worklets.size() == 1u && work->worklets.front();
+    if (hasWorklet && (work->worklets.front()->output.flags & C2FrameData::FLAG_INCOMPLETE)) {
+        work->input.ordinal = parent.input.ordinal;
+        work->worklets.front()->output.ordinal.frameIndex = parent.input.ordinal.frameIndex;
+        return work;
+    }
+    mParentIndices.erase(parentIt);
+
+    if (work->result != C2_OK && parent.result == C2_OK) {
+        parent.result = work->result;
+    }
+    if (hasWorklet) {
+        C2FrameData &output = work->worklets.front()->output;
+        C2FrameData &gathered = parent.worklets.front()->output;
+        if (!batch.hasOutputOrdinal) {
+            gathered.ordinal = output.ordinal;
+            batch.hasOutputOrdinal = true;
+        }
+        gathered.flags = (C2FrameData::flags_t)(
+                gathered.flags | (output.flags & C2FrameData::FLAG_END_OF_STREAM));
+        for (const std::shared_ptr<C2Buffer> &buffer : output.buffers) {
+            if (!buffer) {
+                continue;
+            }
+            uint32_t size = 0;
+            if (buffer->data().type() == C2BufferData::LINEAR
+                    && buffer->data().linearBlocks().size() == 1u) {
+                size = buffer->data().linearBlocks().front().size();
+            }
+            batch.outputs.push_back(buffer);
+            batch.outputInfos.emplace_back(
+                    output.flags, size, output.ordinal.timestamp.peekll());
+        }
+        for (std::unique_ptr<C2Param> &param : output.configUpdate) {
+            gathered.configUpdate.push_back(std::move(param));
+        }
+        for (C2InfoBuffer &info : output.infoBuffers) {
+            gathered.infoBuffers.push_back(std::move(info));
+        }
+    }
+    if (--batch.numPending > 0u) {
+        return nullptr;
+    }
+
+    c2_status_t err = finishBatch(&batch, pool);
+    if (err != C2_OK && parent.result == C2_OK) {
+        parent.result = err;
+    }
+    std::unique_ptr<C2Work> done = std::move(batch.work);
+    mBatches.erase(batchIt);
+    ALOGV("gathered frame #%" PRIu64, done->input.ordinal.frameIndex.peeku());
+    return done;
+}
+
+c2_status_t MultiAccessUnitHelper::finishBatch(
+        Batch *batch, const std::shared_ptr<C2BlockPool> &pool) {
+    C2Work &work = *batch->work;
+    work.input.buffers.clear();
+    work.workletsProcessed = 1u;
+
+    C2FrameData &output = work.worklets.front()->output;
+    if (!batch->hasOutputOrdinal) {
+        output.ordinal = work.input.ordinal;
+    }
+    output.ordinal.frameIndex = work.input.ordinal.frameIndex;
+    output.buffers.clear();
+    if (batch->outputs.empty()) {
+        return C2_OK;
+    }
+
+    std::shared_ptr<C2Buffer> buffer;
+    if (batch->outputs.size() == 1u) {
+        buffer = batch->outputs.front();
+    } else {
+        size_t totalSize = 0;
+        for (const C2AccessUnitInfoStruct &info : batch->outputInfos) {
+            if (info.size == 0) {
+                ALOGE("cannot gather non-linear output buffers");
+                return C2_CORRUPTED;
+            }
+            totalSize += info.size;
+        }
+        if (!pool) {
+            return C2_NO_INIT;
+        }
+        std::shared_ptr<C2LinearBlock> block;
+        C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+        c2_status_t err = pool->fetchLinearBlock(totalSize, usage, &block);
+        if (err != C2_OK) {
+            ALOGE("fetchLinearBlock for gathered output failed with status %d", err);
+            return C2_NO_MEMORY;
+        }
+        C2WriteView wView = block->map().get();
+        if (wView.error()) {
+            ALOGE("write view map failed %d", wView.error());
+            return C2_CORRUPTED;
+        }
+        size_t offset = 0;
+        for (const std::shared_ptr<C2Buffer> &unitBuffer : batch->outputs) {
+            C2ReadView rView = unitBuffer->data().linearBlocks().front().map().get();
+            if (rView.error()) {
+                ALOGE("read view map failed %d", rView.error());
+                return C2_CORRUPTED;
+            }
+            memcpy(wView.data() + offset, rView.data(), rView.capacity());
+            offset += rView.capacity();
+        }
+        buffer = C2Buffer::CreateLinearBuffer(block->share(0, totalSize, C2Fence()));
+    }
+
+    std::shared_ptr<C2StreamAccessUnitInfos::output> infos =
+        C2StreamAccessUnitInfos::output::AllocShared(
+                batch->outputInfos.size(), 0u /* stream */, batch->outputInfos);
+    if (!infos) {
+        return C2_NO_MEMORY;
+    }
+    buffer->setInfo(infos);
+    output.buffers.push_back(buffer);
+    return C2_OK;
+}
+
+void MultiAccessUnitHelper::flush(std::list<std::unique_ptr<C2Work>> *flushedWork) {
+    std::lock_guard<std::mutex> lock(mLock);
+    for (auto it = flushedWork->begin(); it != flushedWork->end(); ) {
+        if (*it && IsAccessUnitIndex((*it)->input.ordinal.frameIndex.peeku())) {
+            it = flushedWork->erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto &entry : mBatches) {
+        entry.second.work->input.buffers.clear();
+        entry.second.work->worklets.front()->output.buffers.clear();
+        flushedWork->push_back(std::move(entry.second.work));
+    }
+    mBatches.clear();
+    mParentIndices.clear();
+}
+
+void MultiAccessUnitHelper::reset() {
+    std::lock_guard<std::mutex> lock(mLock);
+    mBatches.clear();
+    mParentIndices.clear();
+}
+
+}  // namespace android
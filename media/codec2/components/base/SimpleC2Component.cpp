@@ -24,11 +24,14 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+
 #include <C2Config.h>
 #include <C2Debug.h>
 #include <C2PlatformSupport.h>
 #include <Codec2BufferUtils.h>
 #include <Codec2CommonUtils.h>
+#include <ConversionKernels.h>
 #include <SimpleC2Component.h>
 
 namespace android {
@@ -70,71 +73,27 @@ void convertYUV420Planar8ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, con
     }
 }
 
-void convertYUV420Planar16ToY410(uint32_t *dst, const uint16_t *srcY, const uint16_t *srcU,
-                                 const uint16_t *srcV, size_t srcYStride, size_t srcUStride,
-                                 size_t srcVStride, size_t dstStride, size_t width, size_t height) {
-    // Converting two lines at a time, slightly faster
-    for (size_t y = 0; y < height; y += 2) {
-        uint32_t *dstTop = (uint32_t *)dst;
-        uint32_t *dstBot = (uint32_t *)(dst + dstStride);
-        uint16_t *ySrcTop = (uint16_t *)srcY;
-        uint16_t *ySrcBot = (uint16_t *)(srcY + srcYStride);
-        uint16_t *uSrc = (uint16_t *)srcU;
-        uint16_t *vSrc = (uint16_t *)srcV;
-
-        uint32_t u01, v01, y01, y23, y45, y67, uv0, uv1;
-        size_t x = 0;
-        for (; x < width - 3; x += 4) {
-            u01 = *((uint32_t *)uSrc);
-            uSrc += 2;
-            v01 = *((uint32_t *)vSrc);
-            vSrc += 2;
-
-            y01 = *((uint32_t *)ySrcTop);
-            ySrcTop += 2;
-            y23 = *((uint32_t *)ySrcTop);
-            ySrcTop += 2;
-            y45 = *((uint32_t *)ySrcBot);
-            ySrcBot += 2;
-            y67 = *((uint32_t *)ySrcBot);
-            ySrcBot += 2;
-
-            uv0 = (u01 & 0x3FF) | ((v01 & 0x3FF) << 20);
-            uv1 = (u01 >> 16) | ((v01 >> 16) << 20);
-
-            *dstTop++ = 3 << 30 | ((y01 & 0x3FF) << 10) | uv0;
-            *dstTop++ = 3 << 30 | ((y01 >> 16) << 10) | uv0;
-            *dstTop++ = 3 << 30 | ((y23 & 0x3FF) << 10) | uv1;
-            *dstTop++ = 3 << 30 | ((y23 >> 16) << 10) | uv1;
-
-            *dstBot++ = 3 << 30 | ((y45 & 0x3FF) << 10) | uv0;
-            *dstBot++ = 3 << 30 | ((y45 >> 16) << 10) | uv0;
-            *dstBot++ = 3 << 30 | ((y67 & 0x3FF) << 10) | uv1;
-            *dstBot++ = 3 << 30 | ((y67 >> 16) << 10) | uv1;
-        }
-
-        // There should be at most 2 more pixels to process. Note that we don't
-        // need to consider odd case as the buffer is always aligned to even.
-        if (x < width) {
-            u01 = *uSrc;
-            v01 = *vSrc;
-            y01 = *((uint32_t *)ySrcTop);
-            y45 = *((uint32_t *)ySrcBot);
-            uv0 = (u01 & 0x3FF) | ((v01 & 0x3FF) << 20);
-            *dstTop++ = ((y01 & 0x3FF) << 10) | uv0;
-            *dstTop++ = ((y01 >> 16) << 10) | uv0;
-            *dstBot++ = ((y45 & 0x3FF) << 10) | uv0;
-            *dstBot++ = ((y45 >> 16) << 10) | uv0;
-        }
+namespace {
 
-        srcY += srcYStride * 2;
-        srcU += srcUStride;
-        srcV += srcVStride;
-        dst += dstStride * 2;
-    }
+// Selects the SIMD conversion kernels when available, unless disabled for debugging.
+conversion::Kernel getConversionKernel() {
+    static const conversion::Kernel kernel =
+            conversion::isSimdKernelAvailable() &&
+                    property_get_bool("debug.c2.sw_conversion_simd", true /* default */)
+            ? conversion::Kernel::SIMD : conversion::Kernel::SCALAR;
+    return kernel;
 }
 
-namespace {
+// Number of threads converting a frame. The conversions run on the thread of the component,
+// so frames are only split when explicitly enabled, and when large enough to make up for the
+// handoff to the other threads.
+size_t getConversionThreadCount(size_t width, size_t height) {
+    constexpr size_t kMinPixelsPerThread = 1920 * 1080 / 2;
+    static const size_t threadCount =
+            std::clamp(property_get_int32("debug.c2.sw_conversion_threads", 1 /* default */),
+                       1, 8);
+    return std::clamp(width * height / kMinPixelsPerThread, (size_t)1, threadCount);
+}
 
 static C2ColorAspectsStruct FillMissingColorAspects(
         std::shared_ptr<const C2ColorAspectsStruct> aspects,
@@ -187,13 +146,8 @@ static C2ColorAspectsStruct FillMissingColorAspects(
     return _aspects;
 }
 
-// matrix conversion coefficients
-// (see media/libstagefright/colorconverter/ColorConverter.cpp for more details)
-struct Coeffs {
-    int32_t _y, _r_v, _g_u, _g_v, _b_u, _c16;
-};
-
-static const struct Coeffs GetCoeffsForAspects(const C2ColorAspectsStruct &aspects) {
+static const conversion::YUVToRGBCoeffs GetCoeffsForAspects(
+        const C2ColorAspectsStruct &aspects) {
     bool isFullRange = aspects.range == C2Color::RANGE_FULL;
 
     switch (aspects.matrix) {
@@ -202,9 +156,9 @@ static const struct Coeffs GetCoeffsForAspects(const C2ColorAspectsStruct &aspec
          * BT.601:  K_R = 0.299;  K_B = 0.114
          */
         if (isFullRange) {
-            return Coeffs { 1024, 1436, 352, 731, 1815, 0 };
+            return conversion::YUVToRGBCoeffs { 1024, 1436, 352, 731, 1815, 0 };
         } else {
-            return Coeffs { 1196, 1639, 402, 835, 2072, 64 };
+            return conversion::YUVToRGBCoeffs { 1196, 1639, 402, 835, 2072, 64 };
         }
         break;
 
@@ -213,9 +167,9 @@ static const struct Coeffs GetCoeffsForAspects(const C2ColorAspectsStruct &aspec
          * BT.709:  K_R = 0.2126;  K_B = 0.0722
          */
         if (isFullRange) {
-            return Coeffs { 1024, 1613, 192, 479, 1900, 0 };
+            return conversion::YUVToRGBCoeffs { 1024, 1613, 192, 479, 1900, 0 };
         } else {
-            return Coeffs { 1196, 1841, 219, 547, 2169, 64 };
+            return conversion::YUVToRGBCoeffs { 1196, 1841, 219, 547, 2169, 64 };
         }
         break;
 
@@ -225,121 +179,40 @@ static const struct Coeffs GetCoeffsForAspects(const C2ColorAspectsStruct &aspec
          * BT.2020:  K_R = 0.2627;  K_B = 0.0593
          */
         if (isFullRange) {
-            return Coeffs { 1024, 1510, 169, 585, 1927, 0 };
+            return conversion::YUVToRGBCoeffs { 1024, 1510, 169, 585, 1927, 0 };
         } else {
-            return Coeffs { 1196, 1724, 192, 668, 2200, 64 };
+            return conversion::YUVToRGBCoeffs { 1196, 1724, 192, 668, 2200, 64 };
         }
     }
 }
 
 }
 
-#define CLIP3(min, v, max) (((v) < (min)) ? (min) : (((max) > (v)) ? (v) : (max)))
-void convertYUV420Planar16ToRGBA1010102(
-        uint32_t *dst, const uint16_t *srcY, const uint16_t *srcU,
-        const uint16_t *srcV, size_t srcYStride, size_t srcUStride,
-        size_t srcVStride, size_t dstStride, size_t width,
-        size_t height,
-        std::shared_ptr<const C2ColorAspectsStruct> aspects) {
-
-    C2ColorAspectsStruct _aspects = FillMissingColorAspects(aspects, width, height);
-
-    struct Coeffs coeffs = GetCoeffsForAspects(_aspects);
-
-    int32_t _y = coeffs._y;
-    int32_t _b_u = coeffs._b_u;
-    int32_t _neg_g_u = -coeffs._g_u;
-    int32_t _neg_g_v = -coeffs._g_v;
-    int32_t _r_v = coeffs._r_v;
-    int32_t _c16 = coeffs._c16;
-
-    // Converting two lines at a time, slightly faster
-    for (size_t y = 0; y < height; y += 2) {
-        uint32_t *dstTop = (uint32_t *)dst;
-        uint32_t *dstBot = (uint32_t *)(dst + dstStride);
-        uint16_t *ySrcTop = (uint16_t *)srcY;
-        uint16_t *ySrcBot = (uint16_t *)(srcY + srcYStride);
-        uint16_t *uSrc = (uint16_t *)srcU;
-        uint16_t *vSrc = (uint16_t *)srcV;
-
-        for (size_t x = 0; x < width; x += 2) {
-            int32_t u, v, y00, y01, y10, y11;
-            u = *uSrc - 512;
-            uSrc += 1;
-            v = *vSrc - 512;
-            vSrc += 1;
-
-            y00 = *ySrcTop - _c16;
-            ySrcTop += 1;
-            y01 = *ySrcTop - _c16;
-            ySrcTop += 1;
-            y10 = *ySrcBot - _c16;
-            ySrcBot += 1;
-            y11 = *ySrcBot - _c16;
-            ySrcBot += 1;
-
-            int32_t u_b = u * _b_u;
-            int32_t u_g = u * _neg_g_u;
-            int32_t v_g = v * _neg_g_v;
-            int32_t v_r = v * _r_v;
-
-            int32_t yMult, b, g, r;
-            yMult = y00 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstTop++ = 3 << 30 | (b << 20) | (g << 10) | r;
-
-            yMult = y01 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstTop++ = 3 << 30 | (b << 20) | (g << 10) | r;
-
-            yMult = y10 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstBot++ = 3 << 30 | (b << 20) | (g << 10) | r;
-
-            yMult = y11 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstBot++ = 3 << 30 | (b << 20) | (g << 10) | r;
-        }
-
-        srcY += srcYStride * 2;
-        srcU += srcUStride;
-        srcV += srcVStride;
-        dst += dstStride * 2;
-    }
-}
-
 void convertYUV420Planar16ToY410OrRGBA1010102(
         uint32_t *dst, const uint16_t *srcY,
         const uint16_t *srcU, const uint16_t *srcV,
         size_t srcYStride, size_t srcUStride,
         size_t srcVStride, size_t dstStride, size_t width, size_t height,
         std::shared_ptr<const C2ColorAspectsStruct> aspects) {
+    const conversion::Kernel kernel = getConversionKernel();
     if (isAtLeastT()) {
-        convertYUV420Planar16ToRGBA1010102(dst, srcY, srcU, srcV, srcYStride, srcUStride,
-                                           srcVStride, dstStride, width, height, aspects);
+        C2ColorAspectsStruct _aspects = FillMissingColorAspects(aspects, width, height);
+        const conversion::YUVToRGBCoeffs coeffs = GetCoeffsForAspects(_aspects);
+        conversion::forEachRowBand(height, getConversionThreadCount(width, height),
+                                   [&](size_t row, size_t rowCount) {
+            conversion::convertYUV420Planar16ToRGBA1010102(
+                    kernel, dst + row * dstStride, srcY + row * srcYStride,
+                    srcU + row / 2 * srcUStride, srcV + row / 2 * srcVStride, srcYStride,
+                    srcUStride, srcVStride, dstStride, width, rowCount, coeffs);
+        });
     } else {
-        convertYUV420Planar16ToY410(dst, srcY, srcU, srcV, srcYStride, srcUStride, srcVStride,
-                                    dstStride, width, height);
+        conversion::forEachRowBand(height, getConversionThreadCount(width, height),
+                                   [&](size_t row, size_t rowCount) {
+            conversion::convertYUV420Planar16ToY410(
+                    kernel, dst + row * dstStride, srcY + row * srcYStride,
+                    srcU + row / 2 * srcUStride, srcV + row / 2 * srcVStride, srcYStride,
+                    srcUStride, srcVStride, dstStride, width, rowCount);
+        });
     }
 }
 
@@ -384,35 +257,15 @@ void convertYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t
                                  size_t srcUStride, size_t srcVStride, size_t dstYStride,
                                  size_t dstUVStride, size_t width, size_t height,
                                  bool isMonochrome) {
-    for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
-            dstY[x] = srcY[x] << 6;
-        }
-        srcY += srcYStride;
-        dstY += dstYStride;
-    }
-
-    if (isMonochrome) {
-        // Fill with neutral U/V values.
-        for (size_t y = 0; y < (height + 1) / 2; ++y) {
-            for (size_t x = 0; x < (width + 1) / 2; ++x) {
-                dstUV[2 * x] = kNeutralUVBitDepth10 << 6;
-                dstUV[2 * x + 1] = kNeutralUVBitDepth10 << 6;
-            }
-            dstUV += dstUVStride;
-        }
-        return;
-    }
-
-    for (size_t y = 0; y < (height + 1) / 2; ++y) {
-        for (size_t x = 0; x < (width + 1) / 2; ++x) {
-            dstUV[2 * x] = srcU[x] << 6;
-            dstUV[2 * x + 1] = srcV[x] << 6;
-        }
-        srcU += srcUStride;
-        srcV += srcVStride;
-        dstUV += dstUVStride;
-    }
+    const conversion::Kernel kernel = getConversionKernel();
+    conversion::forEachRowBand(height, getConversionThreadCount(width, height),
+                               [&](size_t row, size_t rowCount) {
+        conversion::convertYUV420Planar16ToP010(
+                kernel, dstY + row * dstYStride, dstUV + row / 2 * dstUVStride,
+                srcY + row * srcYStride, srcU + row / 2 * srcUStride,
+                srcV + row / 2 * srcVStride, srcYStride, srcUStride, srcVStride, dstYStride,
+                dstUVStride, width, rowCount, isMonochrome);
+    });
 }
 
 void convertP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
@@ -466,44 +319,28 @@ void convertRGBA1010102ToYUV420Planar16(uint16_t* dstY, uint16_t* dstU, uint16_t
                                         const uint32_t* srcRGBA, size_t srcRGBStride, size_t width,
                                         size_t height, C2Color::matrix_t colorMatrix,
                                         C2Color::range_t colorRange) {
-    uint16_t r, g, b;
-    int32_t i32Y, i32U, i32V;
-    uint16_t zeroLvl =  colorRange == C2Color::RANGE_FULL ? 0 : 64;
-    uint16_t maxLvlLuma =  colorRange == C2Color::RANGE_FULL ? 1023 : 940;
-    uint16_t maxLvlChroma =  colorRange == C2Color::RANGE_FULL ? 1023 : 960;
+    conversion::RGBToYUVCoeffs coeffs;
+    coeffs.zeroLvl =  colorRange == C2Color::RANGE_FULL ? 0 : 64;
+    coeffs.maxLvlLuma =  colorRange == C2Color::RANGE_FULL ? 1023 : 940;
+    coeffs.maxLvlChroma =  colorRange == C2Color::RANGE_FULL ? 1023 : 960;
     // set default range as limited
     if (colorRange != C2Color::RANGE_FULL) {
         colorRange = C2Color::RANGE_LIMITED;
     }
-    const int16_t(*weights)[3] = (colorMatrix == C2Color::MATRIX_BT709)
-                                         ? bt709Matrix_10bit[colorRange - 1]
-                                         : bt2020Matrix_10bit[colorRange - 1];
-
-    for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
-            b = (srcRGBA[x]  >> 20) & 0x3FF;
-            g = (srcRGBA[x]  >> 10) & 0x3FF;
-            r = srcRGBA[x] & 0x3FF;
-
-            i32Y = ((r * weights[0][0] + g * weights[0][1] + b * weights[0][2] + 512) >> 10) +
-                   zeroLvl;
-            dstY[x] = CLIP3(zeroLvl, i32Y, maxLvlLuma);
-            if (y % 2 == 0 && x % 2 == 0) {
-                i32U = ((r * weights[1][0] + g * weights[1][1] + b * weights[1][2] + 512) >> 10) +
-                       512;
-                i32V = ((r * weights[2][0] + g * weights[2][1] + b * weights[2][2] + 512) >> 10) +
-                       512;
-                dstU[x >> 1] = CLIP3(zeroLvl, i32U, maxLvlChroma);
-                dstV[x >> 1] = CLIP3(zeroLvl, i32V, maxLvlChroma);
-            }
-        }
-        srcRGBA += srcRGBStride;
-        dstY += width;
-        if (y % 2 == 0) {
-            dstU += width / 2;
-            dstV += width / 2;
-        }
-    }
+    coeffs.weights = (colorMatrix == C2Color::MATRIX_BT709)
+                             ? bt709Matrix_10bit[colorRange - 1]
+                             : bt2020Matrix_10bit[colorRange - 1];
+
+    const conversion::Kernel kernel = getConversionKernel();
+    // With an odd width, the last chroma sample of a row pair is written to the first sample of
+    // the next pair, and overwritten by it: the row pairs must be converted in order.
+    const size_t threadCount = width % 2 == 0 ? getConversionThreadCount(width, height) : 1;
+    conversion::forEachRowBand(height, threadCount, [&](size_t row, size_t rowCount) {
+        conversion::convertRGBA1010102ToYUV420Planar16(
+                kernel, dstY + row * width, dstU + row / 2 * (width / 2),
+                dstV + row / 2 * (width / 2), srcRGBA + row * srcRGBStride, srcRGBStride, width,
+                rowCount, coeffs);
+    });
 }
 
 std::unique_ptr<C2Work> SimpleC2Component::WorkQueue::pop_front() {
@@ -585,12 +422,14 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
             break;
         }
         case kWhatStop: {
+            thiz->waitForOutput();
             int32_t err = thiz->onStop();
             thiz->mOutputBlockPool.reset();
             Reply(msg, &err);
             break;
         }
         case kWhatReset: {
+            thiz->waitForOutput();
             thiz->onReset();
             thiz->mOutputBlockPool.reset();
             mRunning = false;
@@ -598,6 +437,7 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
             break;
         }
         case kWhatRelease: {
+            thiz->waitForOutput();
             thiz->onRelease();
             thiz->mOutputBlockPool.reset();
             mRunning = false;
@@ -685,6 +525,7 @@ SimpleC2Component::SimpleC2Component(
 SimpleC2Component::~SimpleC2Component() {
     mLooper->unregisterHandler(mHandler->id());
     (void)mLooper->stop();
+    stopOutputThread();
 }
 
 c2_status_t SimpleC2Component::setListener_vb(
@@ -717,8 +558,17 @@ c2_status_t SimpleC2Component::queue_nb(std::list<std::unique_ptr<C2Work>> * con
         Mutexed<WorkQueue>::Locked queue(mWorkQueue);
         queueWasEmpty = queue->empty();
         while (!items->empty()) {
-            queue->push_back(std::move(items->front()));
+            std::unique_ptr<C2Work> work = std::move(items->front());
             items->pop_front();
+            if (!mMultiAccessUnits) {
+                queue->push_back(std::move(work));
+                continue;
+            }
+            std::list<std::unique_ptr<C2Work>> units;
+            mMultiAccessUnitHelper.scatter(std::move(work), &units);
+            for (std::unique_ptr<C2Work> &unit : units) {
+                queue->push_back(std::move(unit));
+            }
         }
     }
     if (queueWasEmpty) {
@@ -755,6 +605,7 @@ c2_status_t SimpleC2Component::flush_sm(
             flushedWork->push_back(std::move(queue->pending().begin()->second));
             queue->pending().erase(queue->pending().begin());
         }
+        mMultiAccessUnitHelper.flush(flushedWork);
     }
 
     return C2_OK;
@@ -801,6 +652,14 @@ c2_status_t SimpleC2Component::start() {
     } else {
         (new AMessage(WorkHandler::kWhatStart, mHandler))->post();
     }
+    {
+        C2PortMaxAccessUnitsInfo::input maxAccessUnits(1u);
+        std::vector<std::unique_ptr<C2Param>> heapParams;
+        c2_status_t err = intf()->query_vb({ &maxAccessUnits }, {}, C2_DONT_BLOCK, &heapParams);
+        mMultiAccessUnits = (err == C2_OK && maxAccessUnits.value > 1u);
+        ALOGV("max access units per input buffer: %u",
+                mMultiAccessUnits ? maxAccessUnits.value : 1u);
+    }
     state.lock();
     state->mState = RUNNING;
     return C2_OK;
@@ -820,6 +679,7 @@ c2_status_t SimpleC2Component::stop() {
         queue->clear();
         queue->pending().clear();
     }
+    mMultiAccessUnitHelper.reset();
     sp<AMessage> reply;
     (new AMessage(WorkHandler::kWhatStop, mHandler))->postAndAwaitResponse(&reply);
     int32_t err;
@@ -841,6 +701,7 @@ c2_status_t SimpleC2Component::reset() {
         queue->clear();
         queue->pending().clear();
     }
+    mMultiAccessUnitHelper.reset();
     sp<AMessage> reply;
     (new AMessage(WorkHandler::kWhatReset, mHandler))->postAndAwaitResponse(&reply);
     return C2_OK;
@@ -867,6 +728,22 @@ std::list<std::unique_ptr<C2Work>> vec(std::unique_ptr<C2Work> &work) {
 
 }  // namespace
 
+void SimpleC2Component::returnWork(std::unique_ptr<C2Work> work) {
+    work = mMultiAccessUnitHelper.gather(std::move(work), mOutputBlockPool);
+    if (!work) {
+        return;
+    }
+    // The output thread may still return work while the component is being
+    // destroyed, when nobody is listening anymore.
+    std::shared_ptr<C2Component> thiz = weak_from_this().lock();
+    if (!thiz) {
+        ALOGV("dropping work returned during destruction");
+        return;
+    }
+    std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
+    listener->onWorkDone_nb(thiz, vec(work));
+}
+
 void SimpleC2Component::finish(
         uint64_t frameIndex, std::function<void(const std::unique_ptr<C2Work> &)> fillWork) {
     std::unique_ptr<C2Work> work;
@@ -881,8 +758,7 @@ void SimpleC2Component::finish(
     }
     if (work) {
         fillWork(work);
-        std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        returnWork(std::move(work));
         ALOGV("returning pending work");
     }
 }
@@ -907,12 +783,112 @@ void SimpleC2Component::cloneAndSend(
     work->worklets.emplace_back(new C2Worklet);
     if (work) {
         fillWork(work);
-        std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        returnWork(std::move(work));
         ALOGV("cloned and sending work");
     }
 }
 
+SimpleC2Component::OutputThread::OutputThread(SimpleC2Component *thiz)
+    : Thread(false), mThiz(thiz) {}
+
+bool SimpleC2Component::OutputThread::threadLoop() {
+    Mutexed<OutputQueue>::Locked queue(mThiz->mOutputQueue);
+    if (queue->entries.empty()) {
+        if (exitPending()) {
+            return false;
+        }
+        queue.waitForCondition(queue->cond);
+        return true;
+    }
+    OutputEntry entry = std::move(queue->entries.front());
+    queue->entries.pop_front();
+    // wake up the work handler if it waits for room in the queue
+    queue->cond.broadcast();
+    queue.unlock();
+
+    mThiz->runOutputEntry(&entry);
+
+    queue.lock();
+    if (--queue->numPending == 0u) {
+        queue->cond.broadcast();
+    }
+    return true;
+}
+
+void SimpleC2Component::setOutputPipelineDepth(size_t depth) {
+    waitForOutput();
+    if (depth > 0u && !mOutputThread) {
+        sp<OutputThread> thread = new OutputThread(this);
+        if (thread->run((intf()->getName() + " output").c_str(), ANDROID_PRIORITY_VIDEO) != OK) {
+            ALOGW("failed to start the output thread; pipelined mode disabled");
+            return;
+        }
+        mOutputThread = thread;
+    }
+    ALOGV("output pipeline depth: %zu", depth);
+    mOutputQueue.lock()->depth = depth;
+}
+
+void SimpleC2Component::stopOutputThread() {
+    if (!mOutputThread) {
+        return;
+    }
+    waitForOutput();
+    mOutputThread->requestExit();
+    {
+        Mutexed<OutputQueue>::Locked queue(mOutputQueue);
+        // output work queued from now on runs on the caller
+        queue->depth = 0u;
+        queue->cond.broadcast();
+    }
+    mOutputThread->join();
+    mOutputThread.clear();
+}
+
+void SimpleC2Component::queueOutputWork(std::function<void()> outputWork) {
+    mStagedOutput.push_back({ std::move(outputWork), nullptr });
+}
+
+void SimpleC2Component::runOutputEntry(OutputEntry *entry) {
+    if (entry->outputWork) {
+        entry->outputWork();
+    }
+    if (entry->work) {
+        returnWork(std::move(entry->work));
+    }
+}
+
+void SimpleC2Component::releaseStagedOutput(std::unique_ptr<C2Work> work) {
+    if (work) {
+        mStagedOutput.push_back({ nullptr, std::move(work) });
+    }
+    Mutexed<OutputQueue>::Locked queue(mOutputQueue);
+    if (queue->depth == 0u) {
+        queue.unlock();
+        while (!mStagedOutput.empty()) {
+            OutputEntry entry = std::move(mStagedOutput.front());
+            mStagedOutput.pop_front();
+            runOutputEntry(&entry);
+        }
+        return;
+    }
+    while (!mStagedOutput.empty()) {
+        while (queue->entries.size() >= queue->depth) {
+            queue.waitForCondition(queue->cond);
+        }
+        queue->entries.splice(queue->entries.end(), mStagedOutput, mStagedOutput.begin());
+        ++queue->numPending;
+        queue->cond.broadcast();
+    }
+}
+
+void SimpleC2Component::waitForOutput() {
+    Mutexed<OutputQueue>::Locked queue(mOutputQueue);
+    while (queue->numPending > 0u) {
+        queue.waitForCondition(queue->cond);
+    }
+}
+
 bool SimpleC2Component::processQueue() {
     std::unique_ptr<C2Work> work;
     uint64_t generation;
@@ -933,6 +909,7 @@ bool SimpleC2Component::processQueue() {
     }
     if (isFlushPending) {
         ALOGV("processing pending flush");
+        waitForOutput();
         c2_status_t err = onFlush_sm();
         if (err != C2_OK) {
             ALOGD("flush err: %d", err);
@@ -989,6 +966,7 @@ bool SimpleC2Component::processQueue() {
 
     if (!work) {
         c2_status_t err = drain(drainMode, mOutputBlockPool);
+        releaseStagedOutput();
         if (err != C2_OK) {
             Mutexed<ExecState>::Locked state(mExecState);
             std::shared_ptr<C2Component::Listener> listener = state->mListener;
@@ -1029,19 +1007,14 @@ bool SimpleC2Component::processQueue() {
         work->result = C2_NOT_FOUND;
         queue.unlock();
 
-        Mutexed<ExecState>::Locked state(mExecState);
-        std::shared_ptr<C2Component::Listener> listener = state->mListener;
-        state.unlock();
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        releaseStagedOutput(std::move(work));
         return hasQueuedWork;
     }
     if (work->workletsProcessed != 0u) {
         queue.unlock();
-        Mutexed<ExecState>::Locked state(mExecState);
         ALOGV("returning this work");
-        std::shared_ptr<C2Component::Listener> listener = state->mListener;
-        state.unlock();
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        // after the output work, which may finish earlier work
+        releaseStagedOutput(std::move(work));
     } else {
         ALOGV("queue pending work");
         work->input.buffers.clear();
@@ -1055,13 +1028,11 @@ bool SimpleC2Component::processQueue() {
         (void)queue->pending().insert({ frameIndex, std::move(work) });
 
         queue.unlock();
+        releaseStagedOutput();
         if (unexpected) {
             ALOGD("unexpected pending work");
             unexpected->result = C2_CORRUPTED;
-            Mutexed<ExecState>::Locked state(mExecState);
-            std::shared_ptr<C2Component::Listener> listener = state->mListener;
-            state.unlock();
-            listener->onWorkDone_nb(shared_from_this(), vec(unexpected));
+            returnWork(std::move(unexpected));
         }
     }
     return hasQueuedWork;
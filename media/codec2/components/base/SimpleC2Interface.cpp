@@ -28,6 +28,9 @@ namespace android {
 
 /* SimpleInterface */
 
+// maximum number of access units in an input buffer of a compressed audio decoder
+static constexpr uint32_t kMaxInputAccessUnits = 32u;
+
 static C2R SubscribedParamIndicesSetter(
         bool mayBlock, C2InterfaceHelper::C2P<C2SubscribedParamIndicesTuning> &me) {
     (void)mayBlock;
@@ -136,6 +139,15 @@ SimpleInterface<void>::BaseParams::BaseParams(
         codedPoolId = rawPoolId;
     }
 
+    // SimpleC2Component splits input buffers of multiple access units for compressed audio
+    if (domain == C2Component::DOMAIN_AUDIO && kind == C2Component::KIND_DECODER
+            && mediaType != rawMediaType) {
+        addParameter(
+                DefineParam(mMaxInputAccessUnits, C2_PARAMKEY_INPUT_MAX_ACCESS_UNITS)
+                .withConstValue(new C2PortMaxAccessUnitsInfo::input(kMaxInputAccessUnits))
+                .build());
+    }
+
     addParameter(
             DefineParam(mInputFormat, C2_PARAMKEY_INPUT_STREAM_BUFFER_TYPE)
             .withConstValue(new C2StreamBufferTypeSetting::input(
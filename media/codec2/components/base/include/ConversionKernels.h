@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONVERSION_KERNELS_H_
+#define CONVERSION_KERNELS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <media/stagefright/foundation/RowBands.h>
+
+namespace android {
+
+/**
+ * Kernels of the pixel format conversions of SimpleC2Component.h.
+ *
+ * Every conversion has a portable scalar kernel and a SIMD kernel (NEON, or SSE4.1 on x86)
+ * producing bit-exact results. The kernel is selected at run time, which lets tests and
+ * benchmarks compare them on the same device.
+ */
+namespace conversion {
+
+enum class Kernel {
+    SCALAR,
+    SIMD,
+};
+
+// Returns true if the SIMD kernels are built for the target.
+bool isSimdKernelAvailable();
+
+// YUV to RGB matrix coefficients, in 1/1024 units
+// (see media/libstagefright/colorconverter/ColorConverter.cpp for more details)
+struct YUVToRGBCoeffs {
+    int32_t _y, _r_v, _g_u, _g_v, _b_u, _c16;
+};
+
+// RGB to YUV matrix weights, in 1/1024 units, and levels of the YUV range
+struct RGBToYUVCoeffs {
+    const int16_t (*weights)[3];
+    uint16_t zeroLvl, maxLvlLuma, maxLvlChroma;
+};
+
+void convertYUV420Planar16ToY410(Kernel kernel, uint32_t *dst, const uint16_t *srcY,
+                                 const uint16_t *srcU, const uint16_t *srcV, size_t srcYStride,
+                                 size_t srcUStride, size_t srcVStride, size_t dstStride,
+                                 size_t width, size_t height);
+
+void convertYUV420Planar16ToRGBA1010102(Kernel kernel, uint32_t *dst, const uint16_t *srcY,
+                                        const uint16_t *srcU, const uint16_t *srcV,
+                                        size_t srcYStride, size_t srcUStride, size_t srcVStride,
+                                        size_t dstStride, size_t width, size_t height,
+                                        const YUVToRGBCoeffs &coeffs);
+
+void convertYUV420Planar16ToP010(Kernel kernel, uint16_t *dstY, uint16_t *dstUV,
+                                 const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV,
+                                 size_t srcYStride, size_t srcUStride, size_t srcVStride,
+                                 size_t dstYStride, size_t dstUVStride, size_t width,
+                                 size_t height, bool isMonochrome);
+
+// The destination planes are tightly packed: the stride of dstY is width, the stride of dstU
+// and dstV is width / 2.
+void convertRGBA1010102ToYUV420Planar16(Kernel kernel, uint16_t *dstY, uint16_t *dstU,
+                                        uint16_t *dstV, const uint32_t *srcRGBA,
+                                        size_t srcRGBStride, size_t width, size_t height,
+                                        const RGBToYUVCoeffs &coeffs);
+
+// Bands of rows are converted by the persistent workers of RowBandWorkers.
+using ::android::forEachRowBand;
+
+}  // namespace conversion
+
+}  // namespace android
+
+#endif  // CONVERSION_KERNELS_H_
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MULTI_ACCESS_UNIT_HELPER_H_
+#define MULTI_ACCESS_UNIT_HELPER_H_
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <C2Component.h>
+#include <C2Config.h>
+
+namespace android {
+
+/**
+ * Splits works whose input buffer holds multiple access units, as described by
+ * C2StreamAccessUnitInfos::input, into a work per access unit, and gathers the
+ * outputs of these works into one work per input work.
+ *
+ * The works of the access units use frame indices of their own, which do not
+ * collide with the frame indices of the client.
+ */
+class MultiAccessUnitHelper {
+public:
+    MultiAccessUnitHelper();
+    ~MultiAccessUnitHelper() = default;
+
+    /**
+     * Replaces |work| in |items| by the works of its access units, if its
+     * input buffer holds multiple access units. Otherwise, appends |work| as
+     * is.
+     */
+    void scatter(std::unique_ptr<C2Work> work, std::list<std::unique_ptr<C2Work>> *items);
+
+    /**
+     * Takes a done work. Returns the work to send to the client, if any:
+     * |work| itself if it is not the work of an access unit, or the work of
+     * the input buffer once the works of all its access units are done.
+     *
+     * The outputs of the access units are copied into one linear block from
+     * |pool|, and described by C2StreamAccessUnitInfos::output.
+     *
+     * Works flagged with C2FrameData::FLAG_INCOMPLETE are sent as is, with
+     * the frame index of their input buffer.
+     */
+    std::unique_ptr<C2Work> gather(
+            std::unique_ptr<C2Work> work, const std::shared_ptr<C2BlockPool> &pool);
+
+    /**
+     * Replaces the works of access units in |flushedWork| by the works of
+     * their input buffers, and forgets all the works in flight.
+     */
+    void flush(std::list<std::unique_ptr<C2Work>> *flushedWork);
+
+    /**
+     * Forgets all the works in flight.
+     */
+    void reset();
+
+    /**
+     * Returns true if |frameIndex| is the frame index of an access unit.
+     */
+    static bool IsAccessUnitIndex(uint64_t frameIndex) {
+        return (frameIndex & kAccessUnitIndexFlag) != 0;
+    }
+
+private:
+    static constexpr uint64_t kAccessUnitIndexFlag = 1ull << 62;
+
+    // Work of an input buffer, and the outputs of its access units. The
+    // worklet of |work| collects the output flags, ordinal and config updates.
+    struct Batch {
+        std::unique_ptr<C2Work> work;
+        size_t numPending;
+        std::vector<std::shared_ptr<C2Buffer>> outputs;
+        std::vector<C2AccessUnitInfoStruct> outputInfos;
+        bool hasOutputOrdinal;
+    };
+
+    std::mutex mLock;
+    uint64_t mNextIndex;
+    // batches by the frame index of their input buffer
+    std::map<uint64_t, Batch> mBatches;
+    // frame index of the input buffer of each access unit in flight
+    std::map<uint64_t, uint64_t> mParentIndices;
+
+    c2_status_t finishBatch(Batch *batch, const std::shared_ptr<C2BlockPool> &pool);
+};
+
+}  // namespace android
+
+#endif  // MULTI_ACCESS_UNIT_HELPER_H_
@@ -22,10 +22,12 @@
 
 #include <C2Component.h>
 #include <C2Config.h>
+#include <MultiAccessUnitHelper.h>
 
 #include <media/stagefright/foundation/AHandler.h>
 #include <media/stagefright/foundation/ALooper.h>
 #include <media/stagefright/foundation/Mutexed.h>
+#include <utils/Thread.h>
 
 struct C2ColorAspectsStruct;
 
@@ -185,6 +187,41 @@ protected:
             const std::shared_ptr<C2GraphicBlock> &block,
             const C2Rect &crop);
 
+    /**
+     * Enable the pipelined mode, where the output work queued with
+     * queueOutputWork() runs on an output thread while the next work is
+     * processed.
+     *
+     * This method must be called from onInit(). At most |depth| output work
+     * can wait for the output thread: queueOutputWork() blocks until one of
+     * them has run. A depth of 0 disables the pipelined mode.
+     */
+    void setOutputPipelineDepth(size_t depth);
+
+    /**
+     * Queue the output stage of a work, e.g. the copy or conversion of a
+     * decoded frame into its output block, followed by finish().
+     *
+     * This method must be called from process() or drain(). The output work
+     * runs in queueing order, once the current work has been either returned
+     * or made pending: |outputWork| must finish() the current work instead of
+     * filling it. In the pipelined mode it runs on the output thread, and
+     * everything it uses must remain valid until then. Otherwise it runs right
+     * after process() or drain() returns.
+     *
+     * \param[in]   outputWork    the function to run.
+     */
+    void queueOutputWork(std::function<void()> outputWork);
+
+    /**
+     * Wait for the queued output work to run, and stop the output thread.
+     *
+     * Components which enable the pipelined mode must call this method first
+     * in their destructor, before they release anything the output work uses:
+     * ~SimpleC2Component() runs too late for that.
+     */
+    void stopOutputThread();
+
     static constexpr uint32_t NO_DRAIN = ~0u;
 
     C2ReadView mDummyReadView;
@@ -272,6 +309,53 @@ private:
     class BlockingBlockPool;
     std::shared_ptr<BlockingBlockPool> mOutputBlockPool;
 
+    // Output stage of a work: |outputWork| runs first, then |work| is returned
+    // to the client. Either can be empty.
+    struct OutputEntry {
+        std::function<void()> outputWork;
+        std::unique_ptr<C2Work> work;
+    };
+
+    struct OutputQueue {
+        std::list<OutputEntry> entries;
+        Condition cond;
+        // entries, plus the entry which is running
+        size_t numPending{0u};
+        size_t depth{0u};
+    };
+    Mutexed<OutputQueue> mOutputQueue;
+
+    class OutputThread : public Thread {
+    public:
+        explicit OutputThread(SimpleC2Component *thiz);
+        ~OutputThread() override = default;
+        bool threadLoop() override;
+
+    private:
+        SimpleC2Component *mThiz;
+    };
+    sp<OutputThread> mOutputThread;
+
+    // Output work queued by the current process() or drain(), only accessed
+    // from the work handler.
+    std::list<OutputEntry> mStagedOutput;
+
+    // Splits input buffers of multiple access units into a work per access
+    // unit, if the interface declares C2PortMaxAccessUnitsInfo::input above 1.
+    bool mMultiAccessUnits{false};
+    MultiAccessUnitHelper mMultiAccessUnitHelper;
+
+    // Returns |work| to the client, once the works of all the access units of
+    // its input buffer are done.
+    void returnWork(std::unique_ptr<C2Work> work);
+
+    void runOutputEntry(OutputEntry *entry);
+    // Returns |work| after the staged output work, and releases the staged
+    // output work to the output thread, or runs it in the non-pipelined mode.
+    void releaseStagedOutput(std::unique_ptr<C2Work> work = nullptr);
+    // Waits until the output thread has run all the released output work.
+    void waitForOutput();
+
     std::vector<int> mBitDepth10HalPixelFormats;
     SimpleC2Component() = delete;
 };
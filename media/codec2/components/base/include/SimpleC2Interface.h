@@ -157,6 +157,7 @@ public:
 
         std::shared_ptr<C2PortStreamCountTuning::input> mInputStreamCount;
         std::shared_ptr<C2PortStreamCountTuning::output> mOutputStreamCount;
+        std::shared_ptr<C2PortMaxAccessUnitsInfo::input> mMaxInputAccessUnits;
 
         std::shared_ptr<C2SubscribedParamIndicesTuning> mSubscribedParamIndices;
         std::shared_ptr<C2PortSuggestedBufferCountTuning::input> mSuggestedInputBufferCount;
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <ConversionKernels.h>
+
+using namespace android::conversion;
+
+namespace {
+
+constexpr size_t kWidth = 1920;
+constexpr size_t kHeight = 1080;
+
+constexpr int16_t kBt709LimitedWeights[3][3] = {
+    {186, 627, 63}, {-103, -345, 448}, {448, -407, -41}};
+constexpr YUVToRGBCoeffs kBt709LimitedCoeffs = {1196, 1841, 219, 547, 2169, 64};
+
+template <typename T>
+std::vector<T> randomPlane(size_t size, uint32_t mask) {
+    std::mt19937 rng(size);
+    std::vector<T> plane(size);
+    for (T &v : plane) {
+        v = rng() & mask;
+    }
+    return plane;
+}
+
+// Args: kernel, thread count
+void setUp(benchmark::State &state, Kernel *kernel, size_t *threadCount) {
+    *kernel = static_cast<Kernel>(state.range(0));
+    *threadCount = state.range(1);
+    if (*kernel == Kernel::SIMD && !isSimdKernelAvailable()) {
+        state.SkipWithError("no SIMD kernel on this target");
+    }
+    state.SetLabel(std::string(*kernel == Kernel::SIMD ? "simd" : "scalar") + "/" +
+                   std::to_string(*threadCount) + "t");
+}
+
+void BM_YUV420Planar16ToY410(benchmark::State &state) {
+    Kernel kernel;
+    size_t threadCount;
+    setUp(state, &kernel, &threadCount);
+    const auto srcY = randomPlane<uint16_t>(kWidth * kHeight, 0x3FF);
+    const auto srcU = randomPlane<uint16_t>(kWidth * kHeight / 4, 0x3FF);
+    const auto srcV = randomPlane<uint16_t>(kWidth * kHeight / 4, 0x3FF);
+    std::vector<uint32_t> dst(kWidth * kHeight);
+    for (auto _ : state) {
+        forEachRowBand(kHeight, threadCount, [&](size_t row, size_t rowCount) {
+            convertYUV420Planar16ToY410(kernel, dst.data() + row * kWidth,
+                                        srcY.data() + row * kWidth,
+                                        srcU.data() + row / 2 * (kWidth / 2),
+                                        srcV.data() + row / 2 * (kWidth / 2), kWidth, kWidth / 2,
+                                        kWidth / 2, kWidth, kWidth, rowCount);
+        });
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+}
+
+void BM_YUV420Planar16ToRGBA1010102(benchmark::State &state) {
+    Kernel kernel;
+    size_t threadCount;
+    setUp(state, &kernel, &threadCount);
+    const auto srcY = randomPlane<uint16_t>(kWidth * kHeight, 0x3FF);
+    const auto srcU = randomPlane<uint16_t>(kWidth * kHeight / 4, 0x3FF);
+    const auto srcV = randomPlane<uint16_t>(kWidth * kHeight / 4, 0x3FF);
+    std::vector<uint32_t> dst(kWidth * kHeight);
+    for (auto _ : state) {
+        forEachRowBand(kHeight, threadCount, [&](size_t row, size_t rowCount) {
+            convertYUV420Planar16ToRGBA1010102(
+                    kernel, dst.data() + row * kWidth, srcY.data() + row * kWidth,
+                    srcU.data() + row / 2 * (kWidth / 2), srcV.data() + row / 2 * (kWidth / 2),
+                    kWidth, kWidth / 2, kWidth / 2, kWidth, kWidth, rowCount,
+                    kBt709LimitedCoeffs);
+        });
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+}
+
+void BM_YUV420Planar16ToP010(benchmark::State &state) {
+    Kernel kernel;
+    size_t threadCount;
+    setUp(state, &kernel, &threadCount);
+    const auto srcY = randomPlane<uint16_t>(kWidth * kHeight, 0x3FF);
+    const auto srcU = randomPlane<uint16_t>(kWidth * kHeight / 4, 0x3FF);
+    const auto srcV = randomPlane<uint16_t>(kWidth * kHeight / 4, 0x3FF);
+    std::vector<uint16_t> dstY(kWidth * kHeight);
+    std::vector<uint16_t> dstUV(kWidth * kHeight / 2);
+    for (auto _ : state) {
+        forEachRowBand(kHeight, threadCount, [&](size_t row, size_t rowCount) {
+            convertYUV420Planar16ToP010(kernel, dstY.data() + row * kWidth,
+                                        dstUV.data() + row / 2 * kWidth,
+                                        srcY.data() + row * kWidth,
+                                        srcU.data() + row / 2 * (kWidth / 2),
+                                        srcV.data() + row / 2 * (kWidth / 2), kWidth, kWidth / 2,
+                                        kWidth / 2, kWidth, kWidth, kWidth, rowCount,
+                                        false /* isMonochrome */);
+        });
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+}
+
+void BM_RGBA1010102ToYUV420Planar16(benchmark::State &state) {
+    Kernel kernel;
+    size_t threadCount;
+    setUp(state, &kernel, &threadCount);
+    const RGBToYUVCoeffs coeffs = {kBt709LimitedWeights, 64, 940, 960};
+    const auto srcRGBA = randomPlane<uint32_t>(kWidth * kHeight, 0xFFFFFFFF);
+    std::vector<uint16_t> dstY(kWidth * kHeight);
+    std::vector<uint16_t> dstU(kWidth * kHeight / 4);
+    std::vector<uint16_t> dstV(kWidth * kHeight / 4);
+    for (auto _ : state) {
+        forEachRowBand(kHeight, threadCount, [&](size_t row, size_t rowCount) {
+            convertRGBA1010102ToYUV420Planar16(
+                    kernel, dstY.data() + row * kWidth, dstU.data() + row / 2 * (kWidth / 2),
+                    dstV.data() + row / 2 * (kWidth / 2), srcRGBA.data() + row * kWidth, kWidth,
+                    kWidth, rowCount, coeffs);
+        });
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+}
+
+void kernelArgs(benchmark::internal::Benchmark *b) {
+    for (Kernel kernel : {Kernel::SCALAR, Kernel::SIMD}) {
+        for (int threadCount : {1, 2, 4}) {
+            b->Args({static_cast<int>(kernel), threadCount});
+        }
+    }
+    b->UseRealTime();
+}
+
+BENCHMARK(BM_YUV420Planar16ToY410)->Apply(kernelArgs);
+BENCHMARK(BM_YUV420Planar16ToRGBA1010102)->Apply(kernelArgs);
+BENCHMARK(BM_YUV420Planar16ToP010)->Apply(kernelArgs);
+BENCHMARK(BM_RGBA1010102ToYUV420Planar16)->Apply(kernelArgs);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <ConversionKernels.h>
+
+using namespace android::conversion;
+
+namespace {
+
+constexpr int16_t kBt709Weights[2][3][3] = {
+    {{218, 732, 74}, {-117, -395, 512}, {512, -465, -47}},  // RANGE_FULL
+    {{186, 627, 63}, {-103, -345, 448}, {448, -407, -41}},  // RANGE_LIMITED
+};
+
+constexpr YUVToRGBCoeffs kYUVToRGBCoeffs[] = {
+    {1024, 1436, 352, 731, 1815, 0},   // BT.601 full range
+    {1196, 1841, 219, 547, 2169, 64},  // BT.709 limited range
+};
+
+// Extra elements at the end of the rows, which must be left untouched.
+constexpr size_t kPadding = 13;
+constexpr uint16_t kGuard16 = 0xA5A5;
+constexpr uint32_t kGuard32 = 0xA5A5A5A5;
+
+template <typename T>
+std::vector<T> randomPlane(size_t size, uint32_t mask, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<T> plane(size);
+    for (T &v : plane) {
+        v = rng() & mask;
+    }
+    return plane;
+}
+
+// Frame sizes: widths and heights around the SIMD block sizes, odd sizes, and a full HD frame.
+class ConversionKernelsTest : public ::testing::TestWithParam<std::tuple<size_t, size_t>> {
+protected:
+    void SetUp() override {
+        std::tie(mWidth, mHeight) = GetParam();
+        // The 4:2:0 to 4:4:4 conversions read even width rows pairs
+        mSrcYStride = mWidth + 1 + kPadding;
+        mSrcUVStride = (mWidth + 1) / 2 + kPadding;
+        const size_t rows = mHeight + 1;
+        mSrcY = randomPlane<uint16_t>(mSrcYStride * rows, 0x3FF, mWidth * 31 + mHeight);
+        mSrcU = randomPlane<uint16_t>(mSrcUVStride * rows / 2 + mSrcUVStride, 0x3FF, 1);
+        mSrcV = randomPlane<uint16_t>(mSrcUVStride * rows / 2 + mSrcUVStride, 0x3FF, 2);
+    }
+
+    // Runs |convert| with the scalar kernel and then with the SIMD kernel, for the whole frame,
+    // and then for row bands, and expects the same output.
+    template <typename T, typename Convert>
+    void expectBitExact(size_t dstSize, T guard, Convert convert) {
+        std::vector<T> expected(dstSize, guard);
+        convert(Kernel::SCALAR, expected.data(), 1);
+        if (!isSimdKernelAvailable()) {
+            GTEST_SKIP() << "no SIMD kernel on this target";
+        }
+        for (size_t threadCount : {1, 3}) {
+            std::vector<T> actual(dstSize, guard);
+            convert(Kernel::SIMD, actual.data(), threadCount);
+            for (size_t i = 0; i < dstSize; ++i) {
+                ASSERT_EQ(expected[i], actual[i])
+                        << "at " << i << " with " << threadCount << " threads";
+            }
+        }
+    }
+
+    size_t mWidth;
+    size_t mHeight;
+    size_t mSrcYStride;
+    size_t mSrcUVStride;
+    std::vector<uint16_t> mSrcY;
+    std::vector<uint16_t> mSrcU;
+    std::vector<uint16_t> mSrcV;
+};
+
+TEST_P(ConversionKernelsTest, Y410) {
+    // The Y410 kernels convert pairs of rows of even widths
+    const size_t width = mWidth & ~size_t(1);
+    const size_t height = (mHeight + 1) & ~size_t(1);
+    const size_t dstStride = width + kPadding;
+    expectBitExact<uint32_t>(dstStride * height, kGuard32,
+                             [&](Kernel kernel, uint32_t *dst, size_t threadCount) {
+        forEachRowBand(height, threadCount, [&](size_t row, size_t rowCount) {
+            convertYUV420Planar16ToY410(kernel, dst + row * dstStride,
+                                        mSrcY.data() + row * mSrcYStride,
+                                        mSrcU.data() + row / 2 * mSrcUVStride,
+                                        mSrcV.data() + row / 2 * mSrcUVStride, mSrcYStride,
+                                        mSrcUVStride, mSrcUVStride, dstStride, width, rowCount);
+        });
+    });
+}
+
+TEST_P(ConversionKernelsTest, RGBA1010102) {
+    const size_t width = mWidth & ~size_t(1);
+    const size_t height = (mHeight + 1) & ~size_t(1);
+    const size_t dstStride = width + kPadding;
+    for (const YUVToRGBCoeffs &coeffs : kYUVToRGBCoeffs) {
+        expectBitExact<uint32_t>(dstStride * height, kGuard32,
+                                 [&](Kernel kernel, uint32_t *dst, size_t threadCount) {
+            forEachRowBand(height, threadCount, [&](size_t row, size_t rowCount) {
+                convertYUV420Planar16ToRGBA1010102(
+                        kernel, dst + row * dstStride, mSrcY.data() + row * mSrcYStride,
+                        mSrcU.data() + row / 2 * mSrcUVStride,
+                        mSrcV.data() + row / 2 * mSrcUVStride, mSrcYStride, mSrcUVStride,
+                        mSrcUVStride, dstStride, width, rowCount, coeffs);
+            });
+        });
+    }
+}
+
+TEST_P(ConversionKernelsTest, RGBA1010102Clips) {
+    // Saturated samples exercise the clipping of all the components
+    const size_t width = mWidth & ~size_t(1);
+    const size_t height = (mHeight + 1) & ~size_t(1);
+    for (uint16_t &y : mSrcY) y = y & 1 ? 0x3FF : 0;
+    for (uint16_t &u : mSrcU) u = u & 1 ? 0x3FF : 0;
+    for (uint16_t &v : mSrcV) v = v & 2 ? 0x3FF : 0;
+    expectBitExact<uint32_t>(width * height, kGuard32,
+                             [&](Kernel kernel, uint32_t *dst, size_t) {
+        convertYUV420Planar16ToRGBA1010102(kernel, dst, mSrcY.data(), mSrcU.data(),
+                                           mSrcV.data(), mSrcYStride, mSrcUVStride, mSrcUVStride,
+                                           width, width, height, kYUVToRGBCoeffs[1]);
+    });
+}
+
+TEST_P(ConversionKernelsTest, P010) {
+    const size_t dstYStride = mWidth + kPadding;
+    const size_t dstUVStride = (mWidth + 1) / 2 * 2 + kPadding;
+    const size_t chromaHeight = (mHeight + 1) / 2;
+    const size_t dstSize = dstYStride * mHeight + dstUVStride * chromaHeight;
+    for (bool isMonochrome : {false, true}) {
+        expectBitExact<uint16_t>(dstSize, kGuard16,
+                                 [&](Kernel kernel, uint16_t *dst, size_t threadCount) {
+            uint16_t *dstUV = dst + dstYStride * mHeight;
+            forEachRowBand(mHeight, threadCount, [&](size_t row, size_t rowCount) {
+                convertYUV420Planar16ToP010(
+                        kernel, dst + row * dstYStride, dstUV + row / 2 * dstUVStride,
+                        mSrcY.data() + row * mSrcYStride, mSrcU.data() + row / 2 * mSrcUVStride,
+                        mSrcV.data() + row / 2 * mSrcUVStride, mSrcYStride, mSrcUVStride,
+                        mSrcUVStride, dstYStride, dstUVStride, mWidth, rowCount, isMonochrome);
+            });
+        });
+    }
+}
+
+TEST_P(ConversionKernelsTest, RGBA1010102ToYUV420Planar16) {
+    const size_t srcStride = mWidth + kPadding;
+    const std::vector<uint32_t> srcRGBA =
+            randomPlane<uint32_t>(srcStride * mHeight, 0xFFFFFFFF, mWidth + mHeight * 17);
+    // Tightly packed destination planes, with room for the last chroma sample of odd widths
+    const size_t chromaSize = mWidth / 2 * ((mHeight + 1) / 2) + 1;
+    const size_t dstSize = mWidth * mHeight + 2 * chromaSize;
+    for (size_t range = 0; range < 2; ++range) {
+        const RGBToYUVCoeffs coeffs = {kBt709Weights[range], uint16_t(range ? 64 : 0),
+                                       uint16_t(range ? 940 : 1023),
+                                       uint16_t(range ? 960 : 1023)};
+        // An odd width writes the last chroma sample of a row pair to the next one
+        const size_t threadCount = mWidth % 2 == 0 ? 3 : 1;
+        expectBitExact<uint16_t>(dstSize, kGuard16,
+                                 [&](Kernel kernel, uint16_t *dst, size_t threads) {
+            uint16_t *dstU = dst + mWidth * mHeight;
+            uint16_t *dstV = dstU + chromaSize;
+            forEachRowBand(mHeight, std::min(threads, threadCount),
+                           [&](size_t row, size_t rowCount) {
+                convertRGBA1010102ToYUV420Planar16(
+                        kernel, dst + row * mWidth, dstU + row / 2 * (mWidth / 2),
+                        dstV + row / 2 * (mWidth / 2), srcRGBA.data() + row * srcStride,
+                        srcStride, mWidth, rowCount, coeffs);
+            });
+        });
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        Sizes, ConversionKernelsTest,
+        ::testing::Values(std::make_tuple(4, 2), std::make_tuple(8, 2), std::make_tuple(14, 6),
+                          std::make_tuple(16, 16), std::make_tuple(17, 9),
+                          std::make_tuple(33, 7), std::make_tuple(176, 144),
+                          std::make_tuple(1920, 1080)),
+        [](const ::testing::TestParamInfo<ConversionKernelsTest::ParamType> &info) {
+            return std::to_string(std::get<0>(info.param)) + "x" +
+                   std::to_string(std::get<1>(info.param));
+        });
+
+TEST(ConversionKernelsRowBandTest, CoversAllRowsOnce) {
+    for (size_t height : {1, 2, 7, 64, 1080}) {
+        for (size_t threadCount : {1, 2, 3, 8}) {
+            std::vector<int> counts(height);
+            forEachRowBand(height, threadCount, [&](size_t row, size_t rowCount) {
+                EXPECT_EQ(0u, row % 2);
+                for (size_t y = row; y < row + rowCount; ++y) {
+                    ++counts[y];
+                }
+            });
+            for (size_t y = 0; y < height; ++y) {
+                ASSERT_EQ(1, counts[y]) << "row " << y << " of " << height << " with "
+                                        << threadCount << " threads";
+            }
+        }
+    }
+}
+
+}  // namespace
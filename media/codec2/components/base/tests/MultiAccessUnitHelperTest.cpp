@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MultiAccessUnitHelperTest"
+#include <log/log.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <C2BufferPriv.h>
+#include <C2PlatformSupport.h>
+#include <MultiAccessUnitHelper.h>
+
+using namespace android;
+
+namespace {
+
+// One second of 48 kHz AAC: access units of 1024 samples, decoded to 16-bit
+// stereo.
+constexpr size_t kNumAccessUnits = 47;
+constexpr int64_t kAccessUnitDurationUs = 1024 * 1000000ll / 48000;
+constexpr size_t kOutputSize = 1024 * 2 * 2;
+constexpr size_t kAccessUnitsPerBuffer = 16;
+
+size_t accessUnitSize(size_t index) {
+    return 200 + (index * 37) % 300;
+}
+
+uint8_t byteAt(size_t index, size_t offset) {
+    return index * 7 + offset;
+}
+
+}  // namespace
+
+class MultiAccessUnitHelperTest : public ::testing::Test {
+  public:
+    void SetUp() override {
+        std::shared_ptr<C2Allocator> allocator;
+        ASSERT_EQ(C2_OK, GetCodec2PlatformAllocatorStore()->fetchAllocator(
+                C2AllocatorStore::DEFAULT_LINEAR, &allocator));
+        mPool = std::make_shared<C2BasicLinearBlockPool>(allocator);
+    }
+
+    std::shared_ptr<C2Buffer> makeBuffer(size_t size, size_t index) {
+        std::shared_ptr<C2LinearBlock> block;
+        C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+        EXPECT_EQ(C2_OK, mPool->fetchLinearBlock(size, usage, &block));
+        if (!block) {
+            return nullptr;
+        }
+        C2WriteView wView = block->map().get();
+        for (size_t i = 0; i < size; ++i) {
+            wView.data()[i] = byteAt(index, i);
+        }
+        return C2Buffer::CreateLinearBuffer(block->share(0, size, C2Fence()));
+    }
+
+    // Makes the work of the access units |first| to |first| + |count| - 1, in
+    // one input buffer.
+    std::unique_ptr<C2Work> makeWork(uint64_t frameIndex, size_t first, size_t count) {
+        std::vector<C2AccessUnitInfoStruct> infos;
+        size_t totalSize = 0;
+        for (size_t i = first; i < first + count; ++i) {
+            infos.emplace_back(0u, accessUnitSize(i), i * kAccessUnitDurationUs);
+            totalSize += accessUnitSize(i);
+        }
+        std::shared_ptr<C2LinearBlock> block;
+        C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+        EXPECT_EQ(C2_OK, mPool->fetchLinearBlock(totalSize, usage, &block));
+        if (!block) {
+            return nullptr;
+        }
+        C2WriteView wView = block->map().get();
+        size_t offset = 0;
+        for (size_t i = first; i < first + count; ++i) {
+            for (size_t j = 0; j < accessUnitSize(i); ++j) {
+                wView.data()[offset++] = byteAt(i, j);
+            }
+        }
+        std::shared_ptr<C2Buffer> buffer =
+            C2Buffer::CreateLinearBuffer(block->share(0, totalSize, C2Fence()));
+        buffer->setInfo(C2StreamAccessUnitInfos::input::AllocShared(infos.size(), 0u, infos));
+
+        std::unique_ptr<C2Work> work(new C2Work);
+        work->input.flags = (C2FrameData::flags_t)0;
+        work->input.ordinal.timestamp = first * kAccessUnitDurationUs;
+        work->input.ordinal.frameIndex = frameIndex;
+        work->input.ordinal.customOrdinal = first * kAccessUnitDurationUs;
+        work->input.buffers.push_back(buffer);
+        work->worklets.emplace_back(new C2Worklet);
+        work->workletsProcessed = 0u;
+        work->result = C2_OK;
+        return work;
+    }
+
+    // Decodes an access unit the way an audio decoder does, into an output of
+    // kOutputSize bytes.
+    void decode(const std::unique_ptr<C2Work> &work, size_t index) {
+        ASSERT_EQ(1u, work->input.buffers.size());
+        const C2ConstLinearBlock block = work->input.buffers[0]->data().linearBlocks().front();
+        EXPECT_EQ(accessUnitSize(index), block.size());
+        C2ReadView rView = block.map().get();
+        ASSERT_EQ(C2_OK, rView.error());
+        for (size_t j = 0; j < rView.capacity(); ++j) {
+            if (rView.data()[j] != byteAt(index, j)) {
+                ADD_FAILURE() << "access unit " << index << " differs at " << j;
+                break;
+            }
+        }
+        EXPECT_EQ((int64_t)(index * kAccessUnitDurationUs),
+                  work->input.ordinal.timestamp.peekll());
+
+        C2FrameData &output = work->worklets.front()->output;
+        output.flags = (C2FrameData::flags_t)(
+                work->input.flags & C2FrameData::FLAG_END_OF_STREAM);
+        output.ordinal = work->input.ordinal;
+        output.buffers.push_back(makeBuffer(kOutputSize, index));
+        work->workletsProcessed = 1u;
+        work->result = C2_OK;
+    }
+
+    std::shared_ptr<C2BlockPool> mPool;
+    MultiAccessUnitHelper mHelper;
+};
+
+TEST_F(MultiAccessUnitHelperTest, GathersOutputsOfInputBuffer) {
+    size_t numWakeups = 0;
+    size_t numBuffers = 0;
+    for (size_t first = 0; first < kNumAccessUnits; first += kAccessUnitsPerBuffer) {
+        const size_t count = std::min(kAccessUnitsPerBuffer, kNumAccessUnits - first);
+        const uint64_t frameIndex = numBuffers++;
+        std::unique_ptr<C2Work> work = makeWork(frameIndex, first, count);
+        ASSERT_NE(nullptr, work);
+        if (first + count == kNumAccessUnits) {
+            work->input.flags = C2FrameData::FLAG_END_OF_STREAM;
+        }
+
+        std::list<std::unique_ptr<C2Work>> units;
+        mHelper.scatter(std::move(work), &units);
+        ASSERT_EQ(count, units.size());
+
+        size_t index = first;
+        for (std::unique_ptr<C2Work> &unit : units) {
+            const uint64_t unitIndex = unit->input.ordinal.frameIndex.peeku();
+            EXPECT_TRUE(MultiAccessUnitHelper::IsAccessUnitIndex(unitIndex));
+            const bool last = (index + 1 == kNumAccessUnits);
+            EXPECT_EQ(last, (bool)(unit->input.flags & C2FrameData::FLAG_END_OF_STREAM));
+            decode(unit, index);
+            ++index;
+
+            std::unique_ptr<C2Work> done = mHelper.gather(std::move(unit), mPool);
+            if (index < first + count) {
+                EXPECT_EQ(nullptr, done);
+                continue;
+            }
+            ASSERT_NE(nullptr, done);
+            ++numWakeups;
+            EXPECT_EQ(frameIndex, done->input.ordinal.frameIndex.peeku());
+            EXPECT_TRUE(done->input.buffers.empty());
+            EXPECT_EQ(1u, done->workletsProcessed);
+            EXPECT_EQ(C2_OK, done->result);
+
+            const C2FrameData &output = done->worklets.front()->output;
+            EXPECT_EQ(last, (bool)(output.flags & C2FrameData::FLAG_END_OF_STREAM));
+            EXPECT_EQ((int64_t)(first * kAccessUnitDurationUs), output.ordinal.timestamp.peekll());
+            ASSERT_EQ(1u, output.buffers.size());
+            std::shared_ptr<const C2StreamAccessUnitInfos::output> infos =
+                std::static_pointer_cast<const C2StreamAccessUnitInfos::output>(
+                        output.buffers[0]->getInfo(C2StreamAccessUnitInfos::output::PARAM_TYPE));
+            ASSERT_NE(nullptr, infos);
+            ASSERT_EQ(count, infos->flexCount());
+
+            C2ReadView rView = output.buffers[0]->data().linearBlocks().front().map().get();
+            ASSERT_EQ(count * kOutputSize, rView.capacity());
+            for (size_t i = 0; i < count; ++i) {
+                EXPECT_EQ(kOutputSize, infos->m.values[i].size);
+                EXPECT_EQ((int64_t)((first + i) * kAccessUnitDurationUs),
+                          infos->m.values[i].timestamp);
+                EXPECT_EQ(byteAt(first + i, kOutputSize - 1),
+                          rView.data()[i * kOutputSize + kOutputSize - 1]);
+            }
+        }
+    }
+
+    ALOGI("1 s of audio: %zu wakeups with %zu access units per buffer, %zu without",
+          numWakeups, kAccessUnitsPerBuffer, kNumAccessUnits);
+    RecordProperty("AccessUnitsPerSecond", std::to_string(kNumAccessUnits));
+    RecordProperty("WakeupsPerSecond", std::to_string(numWakeups));
+    EXPECT_EQ((kNumAccessUnits + kAccessUnitsPerBuffer - 1) / kAccessUnitsPerBuffer, numWakeups);
+}
+
+TEST_F(MultiAccessUnitHelperTest, PassesThroughSingleAccessUnits) {
+    std::unique_ptr<C2Work> work = makeWork(5u, 0, 1);
+    ASSERT_NE(nullptr, work);
+    C2Work *raw = work.get();
+
+    std::list<std::unique_ptr<C2Work>> units;
+    mHelper.scatter(std::move(work), &units);
+    ASSERT_EQ(1u, units.size());
+    EXPECT_EQ(raw, units.front().get());
+    EXPECT_EQ(5u, units.front()->input.ordinal.frameIndex.peeku());
+
+    decode(units.front(), 0);
+    std::unique_ptr<C2Work> done = mHelper.gather(std::move(units.front()), mPool);
+    EXPECT_EQ(raw, done.get());
+}
+
+TEST_F(MultiAccessUnitHelperTest, PassesThroughIncompleteOutput) {
+    std::unique_ptr<C2Work> work = makeWork(7u, 0, 2);
+    ASSERT_NE(nullptr, work);
+    std::list<std::unique_ptr<C2Work>> units;
+    mHelper.scatter(std::move(work), &units);
+    ASSERT_EQ(2u, units.size());
+
+    decode(units.front(), 0);
+    units.front()->worklets.front()->output.flags = C2FrameData::FLAG_INCOMPLETE;
+    std::unique_ptr<C2Work> done = mHelper.gather(std::move(units.front()), mPool);
+    ASSERT_NE(nullptr, done);
+    EXPECT_EQ(7u, done->input.ordinal.frameIndex.peeku());
+    EXPECT_EQ(7u, done->worklets.front()->output.ordinal.frameIndex.peeku());
+}
+
+TEST_F(MultiAccessUnitHelperTest, FlushReturnsInputWorks) {
+    std::list<std::unique_ptr<C2Work>> units;
+    mHelper.scatter(makeWork(1u, 0, 4), &units);
+    mHelper.scatter(makeWork(2u, 4, 1), &units);
+    ASSERT_EQ(5u, units.size());
+
+    // The first access unit was decoded before the flush.
+    std::unique_ptr<C2Work> unit = std::move(units.front());
+    units.pop_front();
+    decode(unit, 0);
+    EXPECT_EQ(nullptr, mHelper.gather(std::move(unit), mPool));
+    std::unique_ptr<C2Work> inFlight = std::move(units.front());
+    units.pop_front();
+
+    mHelper.flush(&units);
+    ASSERT_EQ(2u, units.size());
+    std::vector<uint64_t> frameIndices;
+    for (const std::unique_ptr<C2Work> &work : units) {
+        frameIndices.push_back(work->input.ordinal.frameIndex.peeku());
+    }
+    EXPECT_EQ(std::vector<uint64_t>({ 2u, 1u }), frameIndices);
+
+    // Access units in flight during the flush are dropped.
+    decode(inFlight, 1);
+    EXPECT_EQ(nullptr, mHelper.gather(std::move(inFlight), mPool));
+}
@@ -0,0 +1,503 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SimpleC2ComponentTest"
+#include <log/log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <C2PlatformSupport.h>
+#include <SimpleC2Component.h>
+#include <SimpleC2Interface.h>
+
+using namespace android;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr char kComponentName[] = "c2.android.test.output-pipeline";
+constexpr auto kTimeout = 5s;
+
+// What the output work of FakeDecoder observed, kept outside of the component so that it
+// outlives it.
+struct Stats {
+    // output work queued by process() or drain() and not done yet
+    std::atomic<size_t> numOutstanding{0u};
+    std::atomic<size_t> maxOutstanding{0u};
+    // onFlush_sm(), onStop(), onReset() or onRelease() found output work outstanding
+    std::atomic<size_t> numEarlyCallbacks{0u};
+    // output work ran after the component was torn down
+    std::atomic<size_t> numLateOutputs{0u};
+    std::atomic<size_t> numOutputsOnWorkHandler{0u};
+    std::atomic<size_t> numOutputsOnOutputThread{0u};
+};
+
+class FakeDecoder : public SimpleC2Component {
+  public:
+    // An audio decoder takes input buffers of multiple access units, which SimpleC2Component
+    // splits.
+    class IntfImpl : public SimpleInterface<void>::BaseParams {
+      public:
+        IntfImpl(const std::shared_ptr<C2ReflectorHelper> &helper, bool audio)
+            : SimpleInterface<void>::BaseParams(
+                    helper, kComponentName, C2Component::KIND_DECODER,
+                    audio ? C2Component::DOMAIN_AUDIO : C2Component::DOMAIN_OTHER,
+                    audio ? "audio/x-test" : "application/x-test") {
+            noPrivateBuffers();
+            noInputReferences();
+            noOutputReferences();
+            noInputLatency();
+            noTimeStretch();
+            setDerivedInstance(this);
+        }
+    };
+
+    // Returns a work |delay| works after it was queued, like a decoder that reorders frames.
+    // The output work of each work takes |outputTime|. An |audio| decoder outputs the frame
+    // index of the work in a linear buffer.
+    FakeDecoder(size_t depth, size_t delay, std::chrono::microseconds outputTime,
+                const std::shared_ptr<Stats> &stats, bool audio = false)
+        : SimpleC2Component(std::make_shared<SimpleInterface<IntfImpl>>(
+                  kComponentName, 0 /* id */,
+                  std::make_shared<IntfImpl>(
+                          std::static_pointer_cast<C2ReflectorHelper>(
+                                  GetCodec2PlatformComponentStore()->getParamReflector()),
+                          audio))),
+          mAudio(audio),
+          mDepth(depth),
+          mDelay(delay),
+          mOutputTime(outputTime),
+          mStats(stats) {}
+
+    ~FakeDecoder() override {
+        stopOutputThread();
+        mAlive = false;
+    }
+
+  protected:
+    c2_status_t onInit() override {
+        setOutputPipelineDepth(mDepth);
+        return C2_OK;
+    }
+
+    c2_status_t onStop() override {
+        checkNoOutstandingOutput();
+        mHeld.clear();
+        return C2_OK;
+    }
+
+    void onReset() override {
+        checkNoOutstandingOutput();
+        mHeld.clear();
+    }
+
+    void onRelease() override { checkNoOutstandingOutput(); }
+
+    c2_status_t onFlush_sm() override {
+        checkNoOutstandingOutput();
+        mHeld.clear();
+        return C2_OK;
+    }
+
+    void process(const std::unique_ptr<C2Work> &work,
+                 const std::shared_ptr<C2BlockPool> &pool) override {
+        mWorkHandlerThread = std::this_thread::get_id();
+        mPool = pool;
+        work->result = C2_OK;
+        work->workletsProcessed = 0u;
+        mHeld.push_back(work->input.ordinal.frameIndex.peeku());
+        const bool eos = (work->input.flags & C2FrameData::FLAG_END_OF_STREAM) != 0;
+        while (mHeld.size() > mDelay || (eos && !mHeld.empty())) {
+            queueOutput(mHeld.front());
+            mHeld.pop_front();
+        }
+    }
+
+    c2_status_t drain(uint32_t, const std::shared_ptr<C2BlockPool> &) override {
+        for (uint64_t index : mHeld) {
+            queueOutput(index);
+        }
+        mHeld.clear();
+        return C2_OK;
+    }
+
+  private:
+    const bool mAudio;
+    const size_t mDepth;
+    const size_t mDelay;
+    const std::chrono::microseconds mOutputTime;
+    const std::shared_ptr<Stats> mStats;
+    std::atomic<bool> mAlive{true};
+    std::thread::id mWorkHandlerThread;
+    std::list<uint64_t> mHeld;
+    std::shared_ptr<C2BlockPool> mPool;
+
+    void checkNoOutstandingOutput() {
+        if (mStats->numOutstanding > 0u) {
+            ++mStats->numEarlyCallbacks;
+        }
+    }
+
+    void queueOutput(uint64_t index) {
+        size_t numOutstanding = ++mStats->numOutstanding;
+        size_t maxOutstanding = mStats->maxOutstanding;
+        while (numOutstanding > maxOutstanding &&
+               !mStats->maxOutstanding.compare_exchange_weak(maxOutstanding, numOutstanding)) {
+        }
+        queueOutputWork([this, index] {
+            if (!mAlive) {
+                ++mStats->numLateOutputs;
+            }
+            if (std::this_thread::get_id() == mWorkHandlerThread) {
+                ++mStats->numOutputsOnWorkHandler;
+            } else {
+                ++mStats->numOutputsOnOutputThread;
+            }
+            // e.g. the conversion into the output block
+            std::this_thread::sleep_for(mOutputTime);
+            finish(index, [this, index](const std::unique_ptr<C2Work> &work) {
+                work->worklets.front()->output.flags = (C2FrameData::flags_t)(
+                        work->input.flags & C2FrameData::FLAG_END_OF_STREAM);
+                work->worklets.front()->output.ordinal = work->input.ordinal;
+                work->workletsProcessed = 1u;
+                work->result = C2_OK;
+                if (mAudio) {
+                    work->result = outputIndex(index, &work->worklets.front()->output);
+                }
+            });
+            --mStats->numOutstanding;
+        });
+    }
+
+    c2_status_t outputIndex(uint64_t index, C2FrameData *output) {
+        std::shared_ptr<C2LinearBlock> block;
+        C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+        c2_status_t err = mPool->fetchLinearBlock(sizeof(index), usage, &block);
+        if (err != C2_OK) {
+            return err;
+        }
+        C2WriteView wView = block->map().get();
+        if (wView.error()) {
+            return wView.error();
+        }
+        memcpy(wView.data(), &index, sizeof(index));
+        output->buffers.push_back(createLinearBuffer(block, 0, sizeof(index)));
+        return C2_OK;
+    }
+};
+
+class Listener : public C2Component::Listener {
+  public:
+    void onWorkDone_nb(std::weak_ptr<C2Component>,
+                       std::list<std::unique_ptr<C2Work>> workItems) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (const std::unique_ptr<C2Work> &work : workItems) {
+            mResults.push_back(work->result);
+            if (work->result == C2_OK && !work->worklets.empty()) {
+                const C2FrameData &output = work->worklets.front()->output;
+                mFrameIndices.push_back(work->input.ordinal.frameIndex.peeku());
+                mFlags.push_back(output.flags);
+                mOutputs.push_back(output.buffers.empty() ? nullptr : output.buffers.front());
+            }
+        }
+        mCondition.notify_all();
+    }
+
+    void onTripped_nb(std::weak_ptr<C2Component>,
+                      std::vector<std::shared_ptr<C2SettingResult>>) override {}
+
+    void onError_nb(std::weak_ptr<C2Component>, uint32_t errorCode) override {
+        ADD_FAILURE() << "component error " << errorCode;
+    }
+
+    bool waitForFrames(size_t count) {
+        std::unique_lock<std::mutex> lock(mLock);
+        return mCondition.wait_for(lock, kTimeout,
+                                   [this, count] { return mFrameIndices.size() >= count; });
+    }
+
+    bool waitForFrame(uint64_t index) {
+        std::unique_lock<std::mutex> lock(mLock);
+        return mCondition.wait_for(lock, kTimeout, [this, index] {
+            return std::find(mFrameIndices.begin(), mFrameIndices.end(), index) !=
+                    mFrameIndices.end();
+        });
+    }
+
+    std::vector<uint64_t> frameIndices() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mFrameIndices;
+    }
+
+    std::vector<C2FrameData::flags_t> flags() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mFlags;
+    }
+
+    std::vector<c2_status_t> results() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mResults;
+    }
+
+    std::vector<std::shared_ptr<C2Buffer>> outputs() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mOutputs;
+    }
+
+  private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::vector<uint64_t> mFrameIndices;
+    std::vector<C2FrameData::flags_t> mFlags;
+    std::vector<c2_status_t> mResults;
+    std::vector<std::shared_ptr<C2Buffer>> mOutputs;
+};
+
+}  // namespace
+
+class SimpleC2ComponentTest : public ::testing::TestWithParam<size_t /* depth */> {
+  public:
+    void TearDown() override {
+        if (mComponent) {
+            mComponent->release();
+            mComponent.reset();
+        }
+    }
+
+    void start(size_t delay, std::chrono::microseconds outputTime, bool audio = false) {
+        mStats = std::make_shared<Stats>();
+        mListener = std::make_shared<Listener>();
+        mComponent = std::make_shared<FakeDecoder>(
+                GetParam(), delay, outputTime, mStats, audio);
+        ASSERT_EQ(C2_OK, mComponent->setListener_vb(mListener, C2_MAY_BLOCK));
+        ASSERT_EQ(C2_OK, mComponent->start());
+    }
+
+    void queue(uint64_t first, size_t count, bool eos = false) {
+        std::list<std::unique_ptr<C2Work>> items;
+        for (uint64_t index = first; index < first + count; ++index) {
+            std::unique_ptr<C2Work> work(new C2Work);
+            work->input.ordinal.frameIndex = index;
+            work->input.ordinal.timestamp = index * 1000;
+            work->input.flags = (C2FrameData::flags_t)0;
+            if (eos && index == first + count - 1) {
+                work->input.flags = C2FrameData::FLAG_END_OF_STREAM;
+            }
+            work->worklets.emplace_back(new C2Worklet);
+            items.push_back(std::move(work));
+        }
+        ASSERT_EQ(C2_OK, mComponent->queue_nb(&items));
+    }
+
+    // Queues a work of an input buffer of |numAccessUnits| access units of 1 byte.
+    void queueAccessUnits(uint64_t index, size_t numAccessUnits, bool eos = false) {
+        std::shared_ptr<C2BlockPool> pool;
+        ASSERT_EQ(C2_OK, GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool));
+        std::shared_ptr<C2LinearBlock> block;
+        C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+        ASSERT_EQ(C2_OK, pool->fetchLinearBlock(numAccessUnits, usage, &block));
+        std::vector<C2AccessUnitInfoStruct> infos;
+        for (size_t i = 0; i < numAccessUnits; ++i) {
+            infos.emplace_back(0u, 1u, (index * numAccessUnits + i) * 1000);
+        }
+        std::shared_ptr<C2Buffer> buffer =
+            C2Buffer::CreateLinearBuffer(block->share(0, numAccessUnits, C2Fence()));
+        buffer->setInfo(C2StreamAccessUnitInfos::input::AllocShared(infos.size(), 0u, infos));
+
+        std::unique_ptr<C2Work> work(new C2Work);
+        work->input.ordinal.frameIndex = index;
+        work->input.ordinal.timestamp = index * numAccessUnits * 1000;
+        work->input.flags = eos ? C2FrameData::FLAG_END_OF_STREAM : (C2FrameData::flags_t)0;
+        work->input.buffers.push_back(buffer);
+        work->worklets.emplace_back(new C2Worklet);
+        std::list<std::unique_ptr<C2Work>> items;
+        items.push_back(std::move(work));
+        ASSERT_EQ(C2_OK, mComponent->queue_nb(&items));
+    }
+
+    size_t depth() const { return GetParam(); }
+
+    std::shared_ptr<Stats> mStats;
+    std::shared_ptr<Listener> mListener;
+    std::shared_ptr<FakeDecoder> mComponent;
+};
+
+TEST_P(SimpleC2ComponentTest, ReturnsWorkInOrder) {
+    constexpr size_t kNumFrames = 60;
+    for (size_t delay : {0u, 3u}) {
+        SCOPED_TRACE(testing::Message() << "delay " << delay);
+        start(delay, 500us);
+        queue(0, kNumFrames, true /* eos */);
+        ASSERT_TRUE(mListener->waitForFrames(kNumFrames));
+
+        std::vector<uint64_t> frameIndices = mListener->frameIndices();
+        ASSERT_EQ(kNumFrames, frameIndices.size());
+        for (size_t i = 0; i < kNumFrames; ++i) {
+            EXPECT_EQ(i, frameIndices[i]);
+        }
+        if (depth() > 0u) {
+            EXPECT_EQ(0u, mStats->numOutputsOnWorkHandler.load());
+            EXPECT_EQ(kNumFrames, mStats->numOutputsOnOutputThread.load());
+        } else {
+            EXPECT_EQ(kNumFrames, mStats->numOutputsOnWorkHandler.load());
+            EXPECT_EQ(0u, mStats->numOutputsOnOutputThread.load());
+        }
+        EXPECT_EQ(C2_OK, mComponent->stop());
+        mComponent->release();
+        mComponent.reset();
+    }
+}
+
+TEST_P(SimpleC2ComponentTest, BoundsQueuedOutputWork) {
+    constexpr size_t kNumFrames = 20;
+    // The output work takes much longer than process(), so the output queue fills up.
+    start(0 /* delay */, 5ms);
+    queue(0, kNumFrames, true /* eos */);
+    ASSERT_TRUE(mListener->waitForFrames(kNumFrames));
+
+    // The queue holds at most |depth| output work. One more runs on the output thread, and
+    // one more is queued by process() before it waits for room.
+    EXPECT_LE(mStats->maxOutstanding.load(), std::max<size_t>(depth(), 1u) + 2u);
+    if (depth() > 0u) {
+        EXPECT_GE(mStats->maxOutstanding.load(), depth());
+    }
+}
+
+TEST_P(SimpleC2ComponentTest, SignalsEndOfStreamOnLastWork) {
+    constexpr size_t kNumFrames = 10;
+    // The last works are still held by the decoder when the end of stream arrives.
+    start(3 /* delay */, 1ms);
+    queue(0, kNumFrames, true /* eos */);
+    ASSERT_TRUE(mListener->waitForFrames(kNumFrames));
+
+    std::vector<C2FrameData::flags_t> flags = mListener->flags();
+    ASSERT_EQ(kNumFrames, flags.size());
+    for (size_t i = 0; i + 1 < kNumFrames; ++i) {
+        EXPECT_EQ(0u, flags[i] & C2FrameData::FLAG_END_OF_STREAM) << "frame " << i;
+    }
+    EXPECT_NE(0u, flags.back() & C2FrameData::FLAG_END_OF_STREAM);
+}
+
+TEST_P(SimpleC2ComponentTest, GathersAccessUnitsOfOutputWork) {
+    constexpr size_t kNumFrames = 8;
+    constexpr size_t kAccessUnitsPerFrame = 5;
+    start(2 /* delay */, 500us, true /* audio */);
+    for (size_t i = 0; i < kNumFrames; ++i) {
+        queueAccessUnits(i, kAccessUnitsPerFrame, i + 1 == kNumFrames /* eos */);
+    }
+    ASSERT_TRUE(mListener->waitForFrames(kNumFrames));
+
+    // The access units are returned to the client as the works it queued.
+    std::vector<uint64_t> frameIndices = mListener->frameIndices();
+    std::vector<std::shared_ptr<C2Buffer>> outputs = mListener->outputs();
+    std::vector<C2FrameData::flags_t> flags = mListener->flags();
+    ASSERT_EQ(kNumFrames, frameIndices.size());
+    std::set<uint64_t> accessUnitIndices;
+    for (size_t i = 0; i < kNumFrames; ++i) {
+        SCOPED_TRACE(testing::Message() << "frame " << i);
+        EXPECT_EQ(i, frameIndices[i]);
+        EXPECT_EQ(i + 1 == kNumFrames, (flags[i] & C2FrameData::FLAG_END_OF_STREAM) != 0);
+        ASSERT_NE(nullptr, outputs[i]);
+        std::shared_ptr<const C2StreamAccessUnitInfos::output> infos =
+            std::static_pointer_cast<const C2StreamAccessUnitInfos::output>(
+                    outputs[i]->getInfo(C2StreamAccessUnitInfos::output::PARAM_TYPE));
+        ASSERT_NE(nullptr, infos);
+        ASSERT_EQ(kAccessUnitsPerFrame, infos->flexCount());
+
+        // The outputs of the access units are gathered in order.
+        C2ReadView rView = outputs[i]->data().linearBlocks().front().map().get();
+        ASSERT_EQ(kAccessUnitsPerFrame * sizeof(uint64_t), rView.capacity());
+        uint64_t lastIndex = 0;
+        for (size_t j = 0; j < kAccessUnitsPerFrame; ++j) {
+            EXPECT_EQ(sizeof(uint64_t), infos->m.values[j].size);
+            EXPECT_EQ((int64_t)((i * kAccessUnitsPerFrame + j) * 1000),
+                      infos->m.values[j].timestamp);
+            uint64_t index;
+            memcpy(&index, rView.data() + j * sizeof(index), sizeof(index));
+            EXPECT_TRUE(j == 0 || index > lastIndex);
+            EXPECT_TRUE(accessUnitIndices.insert(index).second);
+            lastIndex = index;
+        }
+    }
+    if (depth() > 0u) {
+        EXPECT_EQ(kNumFrames * kAccessUnitsPerFrame, mStats->numOutputsOnOutputThread.load());
+    }
+}
+
+TEST_P(SimpleC2ComponentTest, WaitsForOutputBeforeFlush) {
+    start(2 /* delay */, 2ms);
+    queue(0, 10);
+    std::this_thread::sleep_for(5ms);
+
+    std::list<std::unique_ptr<C2Work>> flushedWork;
+    ASSERT_EQ(C2_OK, mComponent->flush_sm(C2Component::FLUSH_COMPONENT, &flushedWork));
+    // The flush is applied by the work handler before the next work.
+    queue(100, 1, true /* eos */);
+    ASSERT_TRUE(mListener->waitForFrame(100));
+    EXPECT_EQ(0u, mStats->numEarlyCallbacks.load());
+}
+
+TEST_P(SimpleC2ComponentTest, WaitsForOutputBeforeStop) {
+    start(0 /* delay */, 2ms);
+    queue(0, 10);
+    std::this_thread::sleep_for(5ms);
+    EXPECT_EQ(C2_OK, mComponent->stop());
+    EXPECT_EQ(0u, mStats->numOutstanding.load());
+    EXPECT_EQ(0u, mStats->numEarlyCallbacks.load());
+}
+
+TEST_P(SimpleC2ComponentTest, WaitsForOutputBeforeReset) {
+    start(0 /* delay */, 2ms);
+    queue(0, 10);
+    std::this_thread::sleep_for(5ms);
+    EXPECT_EQ(C2_OK, mComponent->reset());
+    EXPECT_EQ(0u, mStats->numOutstanding.load());
+    EXPECT_EQ(0u, mStats->numEarlyCallbacks.load());
+}
+
+TEST_P(SimpleC2ComponentTest, WaitsForOutputBeforeRelease) {
+    start(0 /* delay */, 2ms);
+    queue(0, 10);
+    std::this_thread::sleep_for(5ms);
+    EXPECT_EQ(C2_OK, mComponent->release());
+    EXPECT_EQ(0u, mStats->numOutstanding.load());
+    EXPECT_EQ(0u, mStats->numEarlyCallbacks.load());
+}
+
+TEST_P(SimpleC2ComponentTest, RunsOutputWorkBeforeDestruction) {
+    start(0 /* delay */, 2ms);
+    queue(0, 10);
+    std::this_thread::sleep_for(5ms);
+    // The client drops the component without stopping it.
+    mComponent.reset();
+    EXPECT_EQ(0u, mStats->numOutstanding.load());
+    EXPECT_EQ(0u, mStats->numLateOutputs.load());
+}
+
+INSTANTIATE_TEST_SUITE_P(OutputPipelineDepth, SimpleC2ComponentTest,
+                         ::testing::Values(0u /* serial */, 1u, 2u, 4u));
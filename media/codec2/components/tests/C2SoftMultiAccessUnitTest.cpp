@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "C2SoftMultiAccessUnitTest"
+#include <log/log.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <C2ComponentFactory.h>
+#include <C2Config.h>
+#include <C2PlatformSupport.h>
+
+using namespace android;
+using namespace std::chrono_literals;
+
+extern "C" ::C2ComponentFactory* CreateCodec2Factory();
+extern "C" void DestroyCodec2Factory(::C2ComponentFactory* factory);
+
+namespace {
+
+// Decodes input buffers of multiple access units through a software audio
+// decoder, which splits them in SimpleC2Component. The decoder must decode
+// each access unit on its own, like G.711.
+
+constexpr auto kTimeout = 5s;
+constexpr size_t kNumAccessUnits = 47;
+constexpr size_t kAccessUnitsPerBuffer = 16;
+constexpr int64_t kAccessUnitDurationUs = 20000;
+
+size_t accessUnitSize(size_t index) {
+    return 160 + (index % 7) * 8;
+}
+
+uint8_t byteAt(size_t index, size_t offset) {
+    return (uint8_t)(index * 131 + offset * 7 + (offset >> 3));
+}
+
+class Listener : public C2Component::Listener {
+  public:
+    void onWorkDone_nb(std::weak_ptr<C2Component>,
+                       std::list<std::unique_ptr<C2Work>> workItems) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (std::unique_ptr<C2Work> &work : workItems) {
+            const uint64_t frameIndex = work->input.ordinal.frameIndex.peeku();
+            EXPECT_EQ(0u, mDone.count(frameIndex)) << "frame " << frameIndex << " returned twice";
+            mDone[frameIndex] = std::move(work);
+        }
+        mCondition.notify_all();
+    }
+
+    void onTripped_nb(std::weak_ptr<C2Component>,
+                      std::vector<std::shared_ptr<C2SettingResult>>) override {}
+
+    void onError_nb(std::weak_ptr<C2Component>, uint32_t errorCode) override {
+        ADD_FAILURE() << "component error " << errorCode;
+    }
+
+    bool waitForWorks(size_t count) {
+        std::unique_lock<std::mutex> lock(mLock);
+        return mCondition.wait_for(lock, kTimeout, [this, count] { return mDone.size() >= count; });
+    }
+
+    std::map<uint64_t, std::unique_ptr<C2Work>> takeWorks() {
+        std::lock_guard<std::mutex> lock(mLock);
+        std::map<uint64_t, std::unique_ptr<C2Work>> done;
+        done.swap(mDone);
+        return done;
+    }
+
+  private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::map<uint64_t, std::unique_ptr<C2Work>> mDone;
+};
+
+}  // namespace
+
+class C2SoftMultiAccessUnitTest : public ::testing::Test {
+  public:
+    void SetUp() override {
+        mFactory = CreateCodec2Factory();
+        ASSERT_NE(nullptr, mFactory);
+        ASSERT_EQ(C2_OK, GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &mPool));
+    }
+
+    void TearDown() override {
+        if (mComponent) {
+            mComponent->release();
+            mComponent.reset();
+        }
+        if (mFactory) {
+            DestroyCodec2Factory(mFactory);
+        }
+    }
+
+    void start() {
+        if (mComponent) {
+            mComponent->release();
+            mComponent.reset();
+        }
+        ASSERT_EQ(C2_OK, mFactory->createComponent(
+                0 /* id */, &mComponent, std::default_delete<C2Component>()));
+        C2PortMaxAccessUnitsInfo::input maxAccessUnits(1u);
+        std::vector<std::unique_ptr<C2Param>> heapParams;
+        ASSERT_EQ(C2_OK, mComponent->intf()->query_vb({ &maxAccessUnits }, {}, C2_MAY_BLOCK,
+                                                      &heapParams));
+        ASSERT_GE(maxAccessUnits.value, kAccessUnitsPerBuffer);
+        mListener = std::make_shared<Listener>();
+        ASSERT_EQ(C2_OK, mComponent->setListener_vb(mListener, C2_MAY_BLOCK));
+        ASSERT_EQ(C2_OK, mComponent->start());
+    }
+
+    // Makes the work of the access units |first| to |first| + |count| - 1, in
+    // one input buffer.
+    std::unique_ptr<C2Work> makeWork(uint64_t frameIndex, size_t first, size_t count) {
+        std::vector<C2AccessUnitInfoStruct> infos;
+        size_t totalSize = 0;
+        for (size_t i = first; i < first + count; ++i) {
+            infos.emplace_back(0u, accessUnitSize(i), i * kAccessUnitDurationUs);
+            totalSize += accessUnitSize(i);
+        }
+        std::shared_ptr<C2LinearBlock> block;
+        C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+        EXPECT_EQ(C2_OK, mPool->fetchLinearBlock(totalSize, usage, &block));
+        if (!block) {
+            return nullptr;
+        }
+        C2WriteView wView = block->map().get();
+        size_t offset = 0;
+        for (size_t i = first; i < first + count; ++i) {
+            for (size_t j = 0; j < accessUnitSize(i); ++j) {
+                wView.data()[offset++] = byteAt(i, j);
+            }
+        }
+        std::shared_ptr<C2Buffer> buffer =
+            C2Buffer::CreateLinearBuffer(block->share(0, totalSize, C2Fence()));
+        if (count > 1) {
+            buffer->setInfo(C2StreamAccessUnitInfos::input::AllocShared(infos.size(), 0u, infos));
+        }
+
+        std::unique_ptr<C2Work> work(new C2Work);
+        work->input.flags = (C2FrameData::flags_t)0;
+        if (first + count == kNumAccessUnits) {
+            work->input.flags = C2FrameData::FLAG_END_OF_STREAM;
+        }
+        work->input.ordinal.timestamp = first * kAccessUnitDurationUs;
+        work->input.ordinal.frameIndex = frameIndex;
+        work->input.ordinal.customOrdinal = first * kAccessUnitDurationUs;
+        work->input.buffers.push_back(buffer);
+        work->worklets.emplace_back(new C2Worklet);
+        return work;
+    }
+
+    // Decodes all access units, |accessUnitsPerBuffer| per input buffer.
+    std::map<uint64_t, std::unique_ptr<C2Work>> decode(size_t accessUnitsPerBuffer) {
+        start();
+        if (HasFatalFailure()) {
+            return {};
+        }
+        std::list<std::unique_ptr<C2Work>> items;
+        for (size_t first = 0; first < kNumAccessUnits; first += accessUnitsPerBuffer) {
+            const size_t count = std::min(accessUnitsPerBuffer, kNumAccessUnits - first);
+            items.push_back(makeWork(items.size(), first, count));
+        }
+        const size_t numWorks = items.size();
+        EXPECT_EQ(C2_OK, mComponent->queue_nb(&items));
+        EXPECT_TRUE(mListener->waitForWorks(numWorks));
+        EXPECT_EQ(C2_OK, mComponent->stop());
+        return mListener->takeWorks();
+    }
+
+    static std::vector<uint8_t> outputOf(const std::unique_ptr<C2Work> &work) {
+        std::vector<uint8_t> output;
+        for (const std::shared_ptr<C2Buffer> &buffer : work->worklets.front()->output.buffers) {
+            C2ReadView rView = buffer->data().linearBlocks().front().map().get();
+            EXPECT_EQ(C2_OK, rView.error());
+            output.insert(output.end(), rView.data(), rView.data() + rView.capacity());
+        }
+        return output;
+    }
+
+    ::C2ComponentFactory *mFactory = nullptr;
+    std::shared_ptr<C2BlockPool> mPool;
+    std::shared_ptr<C2Component> mComponent;
+    std::shared_ptr<Listener> mListener;
+};
+
+TEST_F(C2SoftMultiAccessUnitTest, DecodesAccessUnitsOfInputBuffer) {
+    std::map<uint64_t, std::unique_ptr<C2Work>> reference = decode(1u);
+    ASSERT_EQ(kNumAccessUnits, reference.size());
+    std::map<uint64_t, std::unique_ptr<C2Work>> gathered = decode(kAccessUnitsPerBuffer);
+    ASSERT_EQ((kNumAccessUnits + kAccessUnitsPerBuffer - 1) / kAccessUnitsPerBuffer,
+              gathered.size());
+
+    for (const auto &entry : gathered) {
+        SCOPED_TRACE(testing::Message() << "frame " << entry.first);
+        const std::unique_ptr<C2Work> &work = entry.second;
+        const size_t first = entry.first * kAccessUnitsPerBuffer;
+        const size_t count = std::min(kAccessUnitsPerBuffer, kNumAccessUnits - first);
+        ASSERT_EQ(C2_OK, work->result);
+        ASSERT_EQ(1u, work->workletsProcessed);
+        const C2FrameData &output = work->worklets.front()->output;
+        EXPECT_EQ(entry.first, output.ordinal.frameIndex.peeku());
+        EXPECT_EQ((int64_t)(first * kAccessUnitDurationUs), output.ordinal.timestamp.peekll());
+        EXPECT_EQ(first + count == kNumAccessUnits,
+                  (output.flags & C2FrameData::FLAG_END_OF_STREAM) != 0);
+
+        // The output buffer holds the outputs of the access units decoded one by one.
+        ASSERT_EQ(1u, output.buffers.size());
+        std::shared_ptr<const C2StreamAccessUnitInfos::output> infos =
+            std::static_pointer_cast<const C2StreamAccessUnitInfos::output>(
+                    output.buffers[0]->getInfo(C2StreamAccessUnitInfos::output::PARAM_TYPE));
+        ASSERT_NE(nullptr, infos);
+        ASSERT_EQ(count, infos->flexCount());
+        std::vector<uint8_t> expected;
+        for (size_t i = first; i < first + count; ++i) {
+            std::vector<uint8_t> unitOutput = outputOf(reference.at(i));
+            EXPECT_EQ(unitOutput.size(), infos->m.values[i - first].size);
+            EXPECT_EQ((int64_t)(i * kAccessUnitDurationUs), infos->m.values[i - first].timestamp);
+            expected.insert(expected.end(), unitOutput.begin(), unitOutput.end());
+        }
+        EXPECT_EQ(expected, outputOf(work));
+    }
+}
+
+TEST_F(C2SoftMultiAccessUnitTest, FlushReturnsEachWorkOnce) {
+    constexpr size_t kNumWorks = 12;
+    start();
+    std::list<std::unique_ptr<C2Work>> items;
+    for (size_t i = 0; i < kNumWorks; ++i) {
+        items.push_back(makeWork(i, 0, kAccessUnitsPerBuffer));
+    }
+    ASSERT_EQ(C2_OK, mComponent->queue_nb(&items));
+
+    // Flush while the access units of the works are being decoded.
+    std::list<std::unique_ptr<C2Work>> flushedWork;
+    ASSERT_EQ(C2_OK, mComponent->flush_sm(C2Component::FLUSH_COMPONENT, &flushedWork));
+    std::map<uint64_t, std::unique_ptr<C2Work>> works;
+    for (std::unique_ptr<C2Work> &work : flushedWork) {
+        ASSERT_NE(nullptr, work);
+        const uint64_t frameIndex = work->input.ordinal.frameIndex.peeku();
+        // The client gets back the works it queued, not the access units.
+        ASSERT_LT(frameIndex, kNumWorks);
+        EXPECT_EQ(0u, works.count(frameIndex));
+        works[frameIndex] = std::move(work);
+    }
+
+    // The component keeps decoding after the flush.
+    items.push_back(makeWork(kNumWorks, kNumAccessUnits - 3, 3));
+    ASSERT_EQ(C2_OK, mComponent->queue_nb(&items));
+    ASSERT_TRUE(mListener->waitForWorks(kNumWorks + 1 - works.size()));
+    std::map<uint64_t, std::unique_ptr<C2Work>> done = mListener->takeWorks();
+    ASSERT_EQ(1u, done.count(kNumWorks));
+    EXPECT_EQ(C2_OK, done[kNumWorks]->result);
+    EXPECT_NE(0u, done[kNumWorks]->worklets.front()->output.flags &
+                      C2FrameData::FLAG_END_OF_STREAM);
+    for (auto &entry : done) {
+        EXPECT_EQ(0u, works.count(entry.first)) << "frame " << entry.first << " returned twice";
+        works[entry.first] = std::move(entry.second);
+    }
+    EXPECT_EQ(kNumWorks + 1, works.size());
+}
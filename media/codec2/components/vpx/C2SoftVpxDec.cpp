@@ -19,6 +19,7 @@
 #include <log/log.h>
 
 #include <algorithm>
+#include <cutils/properties.h>
 #include <media/stagefright/foundation/AUtils.h>
 #include <media/stagefright/foundation/MediaDefs.h>
 
@@ -369,15 +370,22 @@ C2SoftVpxDec::C2SoftVpxDec(
       mIntf(intfImpl),
       mCodecCtx(nullptr),
       mCoreCount(1),
-      mQueue(new Mutexed<ConversionQueue>) {
+      mQueue(new Mutexed<ConversionQueue>),
+      mPipelinedOutput(false),
+      mWorkOutputQueued(false) {
 }
 
 C2SoftVpxDec::~C2SoftVpxDec() {
+    // The output work uses the frame buffers and the converter.
+    stopOutputThread();
     onRelease();
 }
 
 c2_status_t C2SoftVpxDec::onInit() {
     status_t err = initDecoder();
+    // Converting a 4K frame takes long enough to overlap with the decoding of the next one.
+    constexpr size_t kOutputPipelineDepth = 2;
+    setOutputPipelineDepth(mPipelinedOutput ? kOutputPipelineDepth : 0);
     return err == OK ? C2_OK : C2_CORRUPTED;
 }
 
@@ -436,6 +444,42 @@ static int GetCPUCoreCount() {
     return cpuCoreCount;
 }
 
+// static
+int C2SoftVpxDec::GetFrameBuffer(void *priv, size_t minSize, vpx_codec_frame_buffer_t *fb) {
+    C2SoftVpxDec *thiz = static_cast<C2SoftVpxDec *>(priv);
+    Mutexed<std::list<std::unique_ptr<FrameBuffer>>>::Locked buffers(thiz->mFrameBuffers);
+    auto it = std::find_if(buffers->begin(), buffers->end(),
+                           [](const std::unique_ptr<FrameBuffer> &buffer) {
+                               return buffer->refCount == 0u;
+                           });
+    if (it == buffers->end()) {
+        it = buffers->insert(buffers->end(), std::make_unique<FrameBuffer>());
+    }
+    FrameBuffer *buffer = it->get();
+    if (buffer->data.size() < minSize) {
+        // zeroed like the internal frame buffers of the decoder
+        buffer->data.assign(minSize, 0);
+    }
+    buffer->refCount = 1u;
+    fb->data = buffer->data.data();
+    fb->size = buffer->data.size();
+    fb->priv = buffer;
+    return 0;
+}
+
+// static
+int C2SoftVpxDec::ReleaseFrameBuffer(void *priv, vpx_codec_frame_buffer_t *fb) {
+    static_cast<C2SoftVpxDec *>(priv)->releaseFrameBuffer(fb->priv);
+    return 0;
+}
+
+void C2SoftVpxDec::releaseFrameBuffer(void *fbPriv) {
+    if (fbPriv != nullptr) {
+        Mutexed<std::list<std::unique_ptr<FrameBuffer>>>::Locked buffers(mFrameBuffers);
+        --static_cast<FrameBuffer *>(fbPriv)->refCount;
+    }
+}
+
 status_t C2SoftVpxDec::initDecoder() {
 #ifdef VP9
     mMode = MODE_VP9;
@@ -478,6 +522,13 @@ status_t C2SoftVpxDec::initDecoder() {
         return UNKNOWN_ERROR;
     }
 
+    // Only the VP9 decoder supports external frame buffers. The pipelined output is opt-in
+    // until its output has been compared with the serial path on devices.
+    mPipelinedOutput = mMode == MODE_VP9 &&
+            property_get_bool("debug.c2.sw_output_pipeline", false /* default */) &&
+            vpx_codec_set_frame_buffer_functions(
+                    mCodecCtx, GetFrameBuffer, ReleaseFrameBuffer, this) == VPX_CODEC_OK;
+
     if (mMode == MODE_VP9) {
         using namespace std::string_literals;
         for (int i = 0; i < mCoreCount; ++i) {
@@ -514,6 +565,7 @@ status_t C2SoftVpxDec::destroyDecoder() {
         }
     }
     mConverterThreads.clear();
+    mFrameBuffers.lock()->clear();
 
     return OK;
 }
@@ -531,9 +583,8 @@ void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
 }
 
 void C2SoftVpxDec::finishWork(uint64_t index, const std::unique_ptr<C2Work> &work,
-                           const std::shared_ptr<C2GraphicBlock> &block) {
-    std::shared_ptr<C2Buffer> buffer = createGraphicBuffer(block,
-                                                           C2Rect(mWidth, mHeight));
+                           const std::shared_ptr<C2GraphicBlock> &block, const C2Rect &crop) {
+    std::shared_ptr<C2Buffer> buffer = createGraphicBuffer(block, crop);
     auto fillWork = [buffer, index, intf = this->mIntf](
             const std::unique_ptr<C2Work> &work) {
         uint32_t flags = 0;
@@ -585,6 +636,7 @@ void C2SoftVpxDec::process(
     work->workletsProcessed = 0u;
     work->worklets.front()->output.configUpdate.clear();
     work->worklets.front()->output.flags = work->input.flags;
+    mWorkOutputQueued = false;
 
     if (mSignalledError || mSignalledOutputEos) {
         work->result = C2_BAD_VALUE;
@@ -757,32 +809,61 @@ status_t C2SoftVpxDec::outputBuffer(
            block->width(), block->height(), mWidth, mHeight,
            ((c2_cntr64_t *)img->user_priv)->peekll());
 
-    uint8_t *dstY = const_cast<uint8_t *>(wView.data()[C2PlanarLayout::PLANE_Y]);
-    uint8_t *dstU = const_cast<uint8_t *>(wView.data()[C2PlanarLayout::PLANE_U]);
-    uint8_t *dstV = const_cast<uint8_t *>(wView.data()[C2PlanarLayout::PLANE_V]);
+    const uint64_t index = ((c2_cntr64_t *)img->user_priv)->peekull();
+    if (!mPipelinedOutput) {
+        convertImage(*img, &wView, format, mWidth, mHeight, defaultColorAspects);
+        finishWork(index, work, std::move(block), C2Rect(mWidth, mHeight));
+        return OK;
+    }
+
+    // The image is only valid until the next decode, but its frame buffer is kept until the
+    // output work has run.
+    {
+        Mutexed<std::list<std::unique_ptr<FrameBuffer>>>::Locked buffers(mFrameBuffers);
+        ++static_cast<FrameBuffer *>(img->fb_priv)->refCount;
+    }
+    if (work && c2_cntr64_t(index) == work->input.ordinal.frameIndex) {
+        mWorkOutputQueued = true;
+    }
+    queueOutputWork([this, image = *img, wView, block, format, width = mWidth,
+                     height = mHeight, defaultColorAspects, index]() mutable {
+        convertImage(image, &wView, format, width, height, defaultColorAspects);
+        releaseFrameBuffer(image.fb_priv);
+        finishWork(index, nullptr, block, C2Rect(width, height));
+    });
+    return OK;
+}
 
-    size_t srcYStride = img->stride[VPX_PLANE_Y];
-    size_t srcUStride = img->stride[VPX_PLANE_U];
-    size_t srcVStride = img->stride[VPX_PLANE_V];
-    C2PlanarLayout layout = wView.layout();
+void C2SoftVpxDec::convertImage(const vpx_image_t &img, C2GraphicView *wView, uint32_t format,
+                                uint32_t width, uint32_t height,
+                                const std::shared_ptr<C2StreamColorAspectsTuning::output>
+                                        &defaultColorAspects) {
+    uint8_t *dstY = const_cast<uint8_t *>(wView->data()[C2PlanarLayout::PLANE_Y]);
+    uint8_t *dstU = const_cast<uint8_t *>(wView->data()[C2PlanarLayout::PLANE_U]);
+    uint8_t *dstV = const_cast<uint8_t *>(wView->data()[C2PlanarLayout::PLANE_V]);
+
+    size_t srcYStride = img.stride[VPX_PLANE_Y];
+    size_t srcUStride = img.stride[VPX_PLANE_U];
+    size_t srcVStride = img.stride[VPX_PLANE_V];
+    C2PlanarLayout layout = wView->layout();
     size_t dstYStride = layout.planes[C2PlanarLayout::PLANE_Y].rowInc;
     size_t dstUStride = layout.planes[C2PlanarLayout::PLANE_U].rowInc;
     size_t dstVStride = layout.planes[C2PlanarLayout::PLANE_V].rowInc;
 
-    if (img->fmt == VPX_IMG_FMT_I42016) {
-        const uint16_t *srcY = (const uint16_t *)img->planes[VPX_PLANE_Y];
-        const uint16_t *srcU = (const uint16_t *)img->planes[VPX_PLANE_U];
-        const uint16_t *srcV = (const uint16_t *)img->planes[VPX_PLANE_V];
+    if (img.fmt == VPX_IMG_FMT_I42016) {
+        const uint16_t *srcY = (const uint16_t *)img.planes[VPX_PLANE_Y];
+        const uint16_t *srcU = (const uint16_t *)img.planes[VPX_PLANE_U];
+        const uint16_t *srcV = (const uint16_t *)img.planes[VPX_PLANE_V];
 
         if (format == HAL_PIXEL_FORMAT_RGBA_1010102) {
             Mutexed<ConversionQueue>::Locked queue(*mQueue);
             size_t i = 0;
             constexpr size_t kHeight = 64;
-            for (; i < mHeight; i += kHeight) {
+            for (; i < height; i += kHeight) {
                 queue->entries.push_back(
                         [dstY, srcY, srcU, srcV,
                          srcYStride, srcUStride, srcVStride, dstYStride,
-                         width = mWidth, height = std::min(mHeight - i, kHeight),
+                         width, height = std::min(height - i, kHeight),
                          defaultColorAspects] {
                             convertYUV420Planar16ToY410OrRGBA1010102(
                                     (uint32_t *)dstY, srcY, srcU, srcV, srcYStride / 2,
@@ -805,22 +886,20 @@ status_t C2SoftVpxDec::outputBuffer(
         } else if (format == HAL_PIXEL_FORMAT_YCBCR_P010) {
             convertYUV420Planar16ToP010((uint16_t *)dstY, (uint16_t *)dstU, srcY, srcU, srcV,
                                         srcYStride / 2, srcUStride / 2, srcVStride / 2,
-                                        dstYStride / 2, dstUStride / 2, mWidth, mHeight);
+                                        dstYStride / 2, dstUStride / 2, width, height);
         } else {
             convertYUV420Planar16ToYV12(dstY, dstU, dstV, srcY, srcU, srcV, srcYStride / 2,
                                         srcUStride / 2, srcVStride / 2, dstYStride, dstUStride,
-                                        mWidth, mHeight);
+                                        width, height);
         }
     } else {
-        const uint8_t *srcY = (const uint8_t *)img->planes[VPX_PLANE_Y];
-        const uint8_t *srcU = (const uint8_t *)img->planes[VPX_PLANE_U];
-        const uint8_t *srcV = (const uint8_t *)img->planes[VPX_PLANE_V];
+        const uint8_t *srcY = (const uint8_t *)img.planes[VPX_PLANE_Y];
+        const uint8_t *srcU = (const uint8_t *)img.planes[VPX_PLANE_U];
+        const uint8_t *srcV = (const uint8_t *)img.planes[VPX_PLANE_V];
 
         convertYUV420Planar8ToYV12(dstY, dstU, dstV, srcY, srcU, srcV, srcYStride, srcUStride,
-                                   srcVStride, dstYStride, dstVStride, dstVStride, mWidth, mHeight);
+                                   srcVStride, dstYStride, dstVStride, dstVStride, width, height);
     }
-    finishWork(((c2_cntr64_t *)img->user_priv)->peekull(), work, std::move(block));
-    return OK;
 }
 
 c2_status_t C2SoftVpxDec::drainInternal(
@@ -840,7 +919,7 @@ c2_status_t C2SoftVpxDec::drainInternal(
     }
 
     if (drainMode == DRAIN_COMPONENT_WITH_EOS &&
-            work && work->workletsProcessed == 0u) {
+            work && work->workletsProcessed == 0u && !mWorkOutputQueued) {
         fillEmptyWork(work);
     }
 
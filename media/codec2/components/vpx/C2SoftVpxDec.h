@@ -86,10 +86,32 @@ struct C2SoftVpxDec : public SimpleC2Component {
     std::shared_ptr<Mutexed<ConversionQueue>> mQueue;
     std::vector<sp<ConverterThread>> mConverterThreads;
 
+    // Frame buffers of the VP9 decoder. The output work holds a reference to
+    // the frame buffer it converts, so that the decoder does not reuse it
+    // before the conversion is done.
+    struct FrameBuffer {
+        std::vector<uint8_t> data;
+        uint32_t refCount{0u};
+    };
+    Mutexed<std::list<std::unique_ptr<FrameBuffer>>> mFrameBuffers;
+    // The output is converted in the output work of SimpleC2Component,
+    // which requires the frame buffers above.
+    bool mPipelinedOutput;
+    // The output work of the current work is queued.
+    bool mWorkOutputQueued;
+
+    static int GetFrameBuffer(void *priv, size_t minSize, vpx_codec_frame_buffer_t *fb);
+    static int ReleaseFrameBuffer(void *priv, vpx_codec_frame_buffer_t *fb);
+    void releaseFrameBuffer(void *fbPriv);
+
     status_t initDecoder();
     status_t destroyDecoder();
     void finishWork(uint64_t index, const std::unique_ptr<C2Work> &work,
-                    const std::shared_ptr<C2GraphicBlock> &block);
+                    const std::shared_ptr<C2GraphicBlock> &block, const C2Rect &crop);
+    void convertImage(const vpx_image_t &img, C2GraphicView *wView, uint32_t format,
+                      uint32_t width, uint32_t height,
+                      const std::shared_ptr<C2StreamColorAspectsTuning::output>
+                              &defaultColorAspects);
     status_t outputBuffer(
             const std::shared_ptr<C2BlockPool> &pool,
             const std::unique_ptr<C2Work> &work);
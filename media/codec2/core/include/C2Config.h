@@ -2540,6 +2540,68 @@ typedef C2StreamParam<C2Info, C2SimpleValueStruct<int32_t>, kParamIndexAverageBl
         C2AndroidStreamAverageBlockQuantizationInfo;
 constexpr char C2_PARAMKEY_AVERAGE_QP[] = "coded.average-qp";
 
+/**
+ * Multiple access units
+ *
+ * These parameters are not standardized yet. They use indices at the end of the vendor range
+ * instead of platform indices, so that they cannot collide with platform parameters added later.
+ * Their keys are reflected with the "vendor." prefix.
+ */
+
+namespace {
+
+enum C2MultipleAccessUnitsParamIndexKind : C2Param::type_index_t {
+    kParamIndexMultipleAccessUnitsStart = C2Param::TYPE_INDEX_VENDOR_START + 0x7F00,
+
+    /* ===================================== structures ===================================== */
+    kParamIndexAccessUnitInfo = kParamIndexMultipleAccessUnitsStart,
+
+    /* =================================== parameters =================================== */
+    kParamIndexMaxAccessUnits, // input, u32
+    kParamIndexAccessUnitInfos, // buffer info, struct[]
+};
+
+}
+
+/**
+ * Maximum number of access units the component accepts in one input buffer.
+ *
+ * Components that do not declare this, or declare 1, take one access unit per input buffer.
+ */
+typedef C2PortParam<C2Info, C2Uint32Value, kParamIndexMaxAccessUnits> C2PortMaxAccessUnitsInfo;
+constexpr char C2_PARAMKEY_INPUT_MAX_ACCESS_UNITS[] = "input.max-access-units";
+
+/**
+ * Access unit in a buffer holding multiple access units.
+ *
+ * The access units are laid out back to back in the buffer, in the order of the array.
+ */
+struct C2AccessUnitInfoStruct {
+    C2AccessUnitInfoStruct() : flags(0), size(0), timestamp(0) {}
+    C2AccessUnitInfoStruct(uint32_t flags_, uint32_t size_, int64_t timestamp_)
+        : flags(flags_), size(size_), timestamp(timestamp_) { }
+
+    uint32_t flags;     ///< C2FrameData::flags_t of the access unit
+    uint32_t size;      ///< size of the access unit in bytes
+    int64_t timestamp;  ///< timestamp of the access unit in microseconds
+
+    DEFINE_AND_DESCRIBE_C2STRUCT(AccessUnitInfo)
+    C2FIELD(flags, "flags")
+    C2FIELD(size, "size")
+    C2FIELD(timestamp, "timestamp")
+};
+
+/**
+ * Access units of a linear buffer, attached as buffer info.
+ *
+ * On input, the component processes each access unit as a separate frame. On output, the
+ * component returns the outputs of the access units of an input buffer in one buffer.
+ */
+typedef C2StreamParam<C2Info, C2SimpleArrayStruct<C2AccessUnitInfoStruct>,
+        kParamIndexAccessUnitInfos> C2StreamAccessUnitInfos;
+constexpr char C2_PARAMKEY_INPUT_ACCESS_UNIT_INFOS[] = "input.access-unit-infos";
+constexpr char C2_PARAMKEY_OUTPUT_ACCESS_UNIT_INFOS[] = "output.access-unit-infos";
+
 /// @}
 
 #endif  // C2CONFIG_H_
@@ -169,7 +169,8 @@ CCodecBufferChannel::CCodecBufferChannel(
       mInputMetEos(false),
       mLastInputBufferAvailableTs(0u),
       mIsHWDecoder(false),
-      mSendEncryptedInfoBuffer(false) {
+      mSendEncryptedInfoBuffer(false),
+      mMaxInputAccessUnits(1u) {
     {
         Mutexed<Input>::Locked input(mInput);
         input->buffers.reset(new DummyInputBuffers(""));
@@ -305,6 +306,25 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
                 uint64_t frameIndex = work->input.ordinal.frameIndex.peeku();
                 output->rotation[frameIndex] = rotation;
             }
+            sp<ABuffer> accessUnitInfo;
+            if (c2buffer && mMaxInputAccessUnits > 1u
+                    && buffer->meta()->findBuffer("accessUnitInfo", &accessUnitInfo)) {
+                const AccessUnitInfo *units = (const AccessUnitInfo *)accessUnitInfo->data();
+                size_t numUnits = accessUnitInfo->size() / sizeof(AccessUnitInfo);
+                std::vector<C2AccessUnitInfoStruct> infos;
+                for (size_t i = 0; i < numUnits; ++i) {
+                    uint32_t unitFlags = 0;
+                    if (units[i].mFlags & BUFFER_FLAG_CODEC_CONFIG) {
+                        unitFlags |= C2FrameData::FLAG_CODEC_CONFIG;
+                    }
+                    if (units[i].mFlags & BUFFER_FLAG_DECODE_ONLY) {
+                        unitFlags |= C2FrameData::FLAG_DROP_FRAME;
+                    }
+                    infos.emplace_back(unitFlags, units[i].mSize, units[i].mTimestamp);
+                }
+                c2buffer->setInfo(C2StreamAccessUnitInfos::input::AllocShared(
+                        infos.size(), 0u /* stream */, infos));
+            }
             work->input.buffers.push_back(c2buffer);
             if (encryptedBlock) {
                 work->input.infoBuffers.emplace_back(C2InfoBuffer::CreateLinearBuffer(
@@ -1254,6 +1274,7 @@ status_t CCodecBufferChannel::start(
     C2PortActualDelayTuning::output outputDelay(0);
     C2ActualPipelineDelayTuning pipelineDelay(0);
     C2SecureModeTuning secureMode(C2Config::SM_UNPROTECTED);
+    C2PortMaxAccessUnitsInfo::input maxInputAccessUnits(1u);
 
     c2_status_t err = mComponent->query(
             {
@@ -1266,6 +1287,7 @@ status_t CCodecBufferChannel::start(
                 &pipelineDelay,
                 &outputDelay,
                 &secureMode,
+                &maxInputAccessUnits,
             },
             {},
             C2_DONT_BLOCK,
@@ -1291,6 +1313,8 @@ status_t CCodecBufferChannel::start(
     // secure mode is a static parameter (shall not change in the executing state)
     mSendEncryptedInfoBuffer = secureMode.value == C2Config::SM_READ_PROTECTED_WITH_ENCRYPTED;
 
+    mMaxInputAccessUnits = maxInputAccessUnits ? std::max(maxInputAccessUnits.value, 1u) : 1u;
+
     std::shared_ptr<C2AllocatorStore> allocatorStore = GetCodec2PlatformAllocatorStore();
     int poolMask = GetCodec2PoolMask();
     C2PlatformAllocatorStore::id_t preferredLinearId = GetPreferredLinearAllocatorId(poolMask);
@@ -2448,6 +2472,10 @@ void CCodecBufferChannel::setDescrambler(const sp<IDescrambler> &descrambler) {
     mDescrambler = descrambler;
 }
 
+size_t CCodecBufferChannel::getMaxInputAccessUnits() const {
+    return mMaxInputAccessUnits;
+}
+
 uint32_t CCodecBufferChannel::getBuffersPixelFormat(bool isEncoder) {
     if (isEncoder) {
         return getInputBuffersPixelFormat();
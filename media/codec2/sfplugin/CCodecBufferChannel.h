@@ -62,6 +62,7 @@ public:
     // BufferChannelBase interface
     void setCrypto(const sp<ICrypto> &crypto) override;
     void setDescrambler(const sp<IDescrambler> &descrambler) override;
+    size_t getMaxInputAccessUnits() const override;
 
     virtual status_t queueInputBuffer(const sp<MediaCodecBuffer> &buffer) override;
     virtual status_t queueSecureInputBuffer(
@@ -392,6 +393,7 @@ private:
         return mCrypto != nullptr || mDescrambler != nullptr;
     }
     std::atomic_bool mSendEncryptedInfoBuffer;
+    std::atomic_size_t mMaxInputAccessUnits;
 
     std::atomic_bool mTunneled;
 };
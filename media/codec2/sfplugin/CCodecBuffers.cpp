@@ -21,8 +21,10 @@
 #include <C2AllocatorGralloc.h>
 #include <C2PlatformSupport.h>
 
+#include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/MediaDefs.h>
+#include <media/stagefright/CodecBase.h>
 #include <media/stagefright/MediaCodecConstants.h>
 #include <media/stagefright/SkipCutBuffer.h>
 #include <mediadrm/ICrypto.h>
@@ -382,6 +384,7 @@ OutputBuffers::BufferAction OutputBuffers::popFromStashAndRegister(
     (*outBuffer)->meta()->setInt64("timeUs", entry.timestamp);
     (*outBuffer)->meta()->setInt32("flags", entry.flags);
     (*outBuffer)->meta()->setInt64("frameIndex", entry.ordinal.frameIndex.peekll());
+    setAccessUnitInfo(*c2Buffer, entry.timestamp, *outBuffer);
     ALOGV("[%s] popFromStashAndRegister: "
           "out buffer index = %zu [%p] => %p + %zu (%lld)",
           mName, *index, outBuffer->get(),
@@ -394,6 +397,46 @@ OutputBuffers::BufferAction OutputBuffers::popFromStashAndRegister(
     return NOTIFY_CLIENT;
 }
 
+void OutputBuffers::setAccessUnitInfo(
+        const std::shared_ptr<C2Buffer> &c2Buffer,
+        int64_t timestamp,
+        const sp<MediaCodecBuffer> &outBuffer) {
+    std::shared_ptr<const C2StreamAccessUnitInfos::output> infos;
+    if (c2Buffer) {
+        infos = std::static_pointer_cast<const C2StreamAccessUnitInfos::output>(
+                c2Buffer->getInfo(C2StreamAccessUnitInfos::output::PARAM_TYPE));
+    }
+    size_t totalSize = 0;
+    for (size_t i = 0; infos && i < infos->flexCount(); ++i) {
+        totalSize += infos->m.values[i].size;
+    }
+    if (!infos || infos->flexCount() == 0u || totalSize != outBuffer->size()) {
+        // e.g. if the skip-cut buffer trimmed the output
+        outBuffer->meta()->remove("accessUnitInfo");
+        return;
+    }
+
+    // The access units are timestamped relative to the first one, which the
+    // client timestamp of the buffer corresponds to.
+    sp<ABuffer> accessUnitInfo = new ABuffer(infos->flexCount() * sizeof(AccessUnitInfo));
+    AccessUnitInfo *units = (AccessUnitInfo *)accessUnitInfo->data();
+    const int64_t firstTimestamp = infos->m.values[0].timestamp;
+    for (size_t i = 0; i < infos->flexCount(); ++i) {
+        const C2AccessUnitInfoStruct &info = infos->m.values[i];
+        uint32_t flags = 0;
+        if (info.flags & C2FrameData::FLAG_END_OF_STREAM) {
+            flags |= BUFFER_FLAG_END_OF_STREAM;
+        }
+        if (info.flags & C2FrameData::FLAG_DROP_FRAME) {
+            flags |= BUFFER_FLAG_DECODE_ONLY;
+        }
+        units[i].mFlags = flags;
+        units[i].mSize = info.size;
+        units[i].mTimestamp = timestamp + info.timestamp - firstTimestamp;
+    }
+    outBuffer->meta()->setBuffer("accessUnitInfo", accessUnitInfo);
+}
+
 bool OutputBuffers::popPending(StashEntry *entry) {
     if (mPending.empty()) {
         return false;
@@ -477,6 +477,16 @@ private:
      */
     bool popPending(StashEntry *entry);
 
+    /**
+     * Set the "accessUnitInfo" meta of |outBuffer| from the access units of
+     * |c2Buffer|, if it holds the outputs of multiple input access units.
+     * |timestamp| is the client timestamp of the buffer.
+     */
+    void setAccessUnitInfo(
+            const std::shared_ptr<C2Buffer> &c2Buffer,
+            int64_t timestamp,
+            const sp<MediaCodecBuffer> &outBuffer);
+
     /**
      * Push an entry as the first entry of mPending.
      */
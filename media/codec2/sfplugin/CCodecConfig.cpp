@@ -402,6 +402,10 @@ void CCodecConfig::initializeStandardParams() {
 
     add(ConfigMapper(KEY_MAX_INPUT_SIZE, C2_PARAMKEY_INPUT_MAX_BUFFER_SIZE, "value")
         .limitTo(D::INPUT));
+    // reflected as a vendor parameter, see C2PortMaxAccessUnitsInfo
+    add(ConfigMapper("android._max-input-access-units",
+                     std::string("vendor.") + C2_PARAMKEY_INPUT_MAX_ACCESS_UNITS, "value")
+        .limitTo(D::AUDIO & D::DECODER & D::INPUT & D::READ));
     // remove when codecs switch to PARAMKEY
     deprecated(ConfigMapper(KEY_MAX_INPUT_SIZE, "coded.max-frame-size", "value")
                .limitTo(D::INPUT));
@@ -19,6 +19,8 @@
 #include <gtest/gtest.h>
 
 #include <codec2/hidl/client.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/CodecBase.h>
 #include <media/stagefright/MediaCodecConstants.h>
 
 #include <C2BlockInternal.h>
@@ -914,4 +916,65 @@ TEST(LinearOutputBuffersTest, PcmConvertFormat) {
     ASSERT_TRUE(buffers->releaseBuffer(clientBuffer, &c2Buffer));
 }
 
+TEST(LinearOutputBuffersTest, AccessUnitInfo) {
+    std::shared_ptr<LinearOutputBuffers> buffers =
+        std::make_shared<LinearOutputBuffers>("test");
+    sp<AMessage> format{new AMessage};
+    format->setInt32(KEY_CHANNEL_COUNT, 2);
+    format->setInt32(KEY_SAMPLE_RATE, 48000);
+    buffers->setFormat(format);
+
+    std::shared_ptr<C2BlockPool> pool;
+    ASSERT_EQ(OK, GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool));
+    std::shared_ptr<C2LinearBlock> block;
+    ASSERT_EQ(OK, pool->fetchLinearBlock(
+            3 * 4096, C2MemoryUsage{C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE}, &block));
+
+    // The outputs of three access units, with codec timestamps 21333us apart.
+    std::vector<C2AccessUnitInfoStruct> infos = {
+        { 0u, 4096u, 100000 },
+        { 0u, 4096u, 121333 },
+        { C2FrameData::FLAG_END_OF_STREAM, 4096u, 142666 },
+    };
+    std::shared_ptr<C2Buffer> c2Buffer =
+        C2Buffer::CreateLinearBuffer(block->share(0, 3 * 4096, C2Fence()));
+    ASSERT_EQ(C2_OK, c2Buffer->setInfo(
+            C2StreamAccessUnitInfos::output::AllocShared(infos.size(), 0u, infos)));
+
+    C2WorkOrdinalStruct ordinal;
+    ordinal.timestamp = 100000;
+    ordinal.frameIndex = 0;
+    buffers->pushToStash(c2Buffer, true /* notify */, 5000000, 0, format, ordinal);
+
+    std::shared_ptr<C2Buffer> popped;
+    size_t index;
+    sp<MediaCodecBuffer> clientBuffer;
+    ASSERT_EQ(OutputBuffers::NOTIFY_CLIENT,
+              buffers->popFromStashAndRegister(&popped, &index, &clientBuffer));
+
+    sp<ABuffer> accessUnitInfo;
+    ASSERT_TRUE(clientBuffer->meta()->findBuffer("accessUnitInfo", &accessUnitInfo));
+    ASSERT_EQ(3 * sizeof(AccessUnitInfo), accessUnitInfo->size());
+    const AccessUnitInfo *units = (const AccessUnitInfo *)accessUnitInfo->data();
+    // The access units are reported in the client timeline of the buffer.
+    EXPECT_EQ(5000000, units[0].mTimestamp);
+    EXPECT_EQ(5021333, units[1].mTimestamp);
+    EXPECT_EQ(5042666, units[2].mTimestamp);
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(4096u, units[i].mSize);
+    }
+    EXPECT_EQ(0u, units[0].mFlags);
+    EXPECT_EQ((uint32_t)BUFFER_FLAG_END_OF_STREAM, units[2].mFlags);
+    ASSERT_TRUE(buffers->releaseBuffer(clientBuffer, &popped));
+
+    // A buffer of a single access unit has no access unit info.
+    c2Buffer = C2Buffer::CreateLinearBuffer(block->share(0, 4096, C2Fence()));
+    ordinal.frameIndex = 1;
+    buffers->pushToStash(c2Buffer, true /* notify */, 5064000, 0, format, ordinal);
+    ASSERT_EQ(OutputBuffers::NOTIFY_CLIENT,
+              buffers->popFromStashAndRegister(&popped, &index, &clientBuffer));
+    EXPECT_FALSE(clientBuffer->meta()->findBuffer("accessUnitInfo", &accessUnitInfo));
+    ASSERT_TRUE(buffers->releaseBuffer(clientBuffer, &popped));
+}
+
 } // namespace android
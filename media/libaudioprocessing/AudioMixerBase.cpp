@@ -28,6 +28,7 @@
 #include <utils/Log.h>
 
 #include "AudioMixerOps.h"
+#include "MixerWorkerPool.h"
 
 // The FCC_2 macro refers to the Fixed Channel Count of 2 for the legacy integer mixer.
 #ifndef FCC_2
@@ -56,6 +57,17 @@ namespace android {
 
 // ----------------------------------------------------------------------------
 
+// Out of line, as mWorkerPool is of an incomplete type in the header.
+AudioMixerBase::AudioMixerBase(size_t frameCount, uint32_t sampleRate)
+    : mSampleRate(sampleRate)
+    , mFrameCount(frameCount)
+{
+}
+
+AudioMixerBase::~AudioMixerBase()
+{
+}
+
 bool AudioMixerBase::isValidFormat(audio_format_t format) const
 {
     switch (format) {
@@ -608,6 +620,19 @@ size_t AudioMixerBase::getUnreleasedFrames(int name) const
     return 0;
 }
 
+void AudioMixerBase::setParallelMixing(size_t threadCount, uint64_t cpuMask)
+{
+    if (threadCount == mParallelThreadCount && cpuMask == mParallelCpuMask) {
+        return;
+    }
+    ALOGV("setParallelMixing(%zu, %#llx)", threadCount, (unsigned long long)cpuMask);
+    mParallelThreadCount = threadCount;
+    mParallelCpuMask = cpuMask;
+    // the pool is recreated by the thread calling process().
+    mWorkerPool.reset();
+    invalidate();
+}
+
 std::string AudioMixerBase::trackNames() const
 {
     std::stringstream ss;
@@ -735,6 +760,12 @@ void AudioMixerBase::process__validate()
         }
     }
 
+    if ((mHook == &AudioMixerBase::process__genericResampling
+            || mHook == &AudioMixerBase::process__genericNoResampling)
+            && prepareParallel()) {
+        mHook = &AudioMixerBase::process__genericParallel;
+    }
+
     ALOGV("mixer configuration change: %zu "
         "all16BitsStereoNoResample=%d, resampling=%d, volumeRamp=%d",
         mEnabled.size(), all16BitsStereoNoResample, resampling, volumeRamp);
@@ -1222,6 +1253,136 @@ void AudioMixerBase::process__genericResampling()
     }
 }
 
+// Number of samples in the private buffer of a track mixed in parallel.
+// The resampler always produces at least stereo, see track__genericResample().
+static size_t parallelTrackSamples(size_t frameCount, uint32_t mixerChannelCount)
+{
+    return frameCount * std::max(mixerChannelCount, (uint32_t)FCC_2);
+}
+
+bool AudioMixerBase::prepareParallel()
+{
+    if (mParallelThreadCount == 0 || mEnabled.size() < kParallelMinTracks) {
+        return false;
+    }
+    if (mWorkerPool == nullptr) {
+        mWorkerPool = std::make_unique<MixerWorkerPool>(mParallelThreadCount, mParallelCpuMask);
+    }
+    if (mOutputTemp.get() == nullptr) {
+        mOutputTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+    }
+    if (mResampleTemp.get() == nullptr) {
+        mResampleTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+    }
+    while (mWorkerResampleTemp.size() < mWorkerPool->threadCount()) {
+        mWorkerResampleTemp.emplace_back(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+    }
+
+    size_t samples = 0;
+    for (const int name : mEnabled) {
+        samples += parallelTrackSamples(mFrameCount, mTracks[name]->mMixerChannelCount);
+    }
+    if (samples > mParallelTempSize) {
+        mParallelTemp.reset(new int32_t[samples]);
+        mParallelTempSize = samples;
+    }
+    mParallelTasks.reserve(mEnabled.size());
+    return true;
+}
+
+// mix one track over the whole mix buffer, acquiring its input as needed.
+void AudioMixerBase::processTrack(TrackBase *t, int32_t *out, int32_t *temp, int32_t *aux)
+{
+    // as in process__genericResampling, the resampler acquires and releases the buffers.
+    if (t->needs & NEEDS_RESAMPLE) {
+        (t->*t->hook)(out, mFrameCount, temp, aux);
+        return;
+    }
+
+    size_t outFrames = 0;
+    while (outFrames < mFrameCount) {
+        t->buffer.frameCount = mFrameCount - outFrames;
+        t->bufferProvider->getNextBuffer(&t->buffer);
+        t->mIn = t->buffer.raw;
+        // t->mIn == nullptr can happen if the track was flushed just after having
+        // been enabled for mixing.
+        if (t->mIn == nullptr) break;
+
+        (t->*t->hook)(
+                out + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
+                temp, aux != nullptr ? aux + outFrames : nullptr);
+        outFrames += t->buffer.frameCount;
+
+        t->bufferProvider->releaseBuffer(&t->buffer);
+    }
+}
+
+/* static */
+void AudioMixerBase::processParallelTask(void *cookie, size_t index, size_t worker)
+{
+    AudioMixerBase * const mixer = static_cast<AudioMixerBase *>(cookie);
+    const ParallelTask &task = mixer->mParallelTasks[index];
+    int32_t * const temp = worker == 0 ? mixer->mResampleTemp.get()
+            : mixer->mWorkerResampleTemp[worker - 1].get();
+
+    memset(task.out, 0, sizeof(*task.out)
+            * parallelTrackSamples(mixer->mFrameCount, task.track->mMixerChannelCount));
+    mixer->processTrack(task.track, task.out, temp, nullptr /* aux */);
+}
+
+// generic code mixing each track on a worker thread, with or without resampling
+void AudioMixerBase::process__genericParallel()
+{
+    ALOGVV("process__genericParallel\n");
+    int32_t * const outTemp = mOutputTemp.get(); // naked ptr
+
+    // Tracks with an aux send all accumulate into the same aux buffer,
+    // so they are mixed in place below rather than on the workers.
+    mParallelTasks.clear();
+    int32_t *trackOut = mParallelTemp.get();
+    for (const auto &pair : mGroups) {
+        for (const int name : pair.second) {
+            TrackBase * const t = mTracks[name].get();
+            if (CC_UNLIKELY(t->needs & NEEDS_AUX)) continue;
+            mParallelTasks.push_back({t, trackOut});
+            trackOut += parallelTrackSamples(mFrameCount, t->mMixerChannelCount);
+        }
+    }
+
+    mWorkerPool->run(mParallelTasks.size(), &processParallelTask, this);
+
+    // accumulate in a fixed order so the result is independent of scheduling.
+    size_t taskIndex = 0;
+    for (const auto &pair : mGroups) {
+        const auto &group = pair.second;
+        const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
+        const size_t sampleCount = mFrameCount * t1->mMixerChannelCount;
+
+        memset(outTemp, 0, sizeof(*outTemp) * sampleCount);
+        for (const int name : group) {
+            TrackBase * const t = mTracks[name].get();
+            if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
+                processTrack(t, outTemp, mResampleTemp.get(), t->auxBuffer);
+                continue;
+            }
+            const int32_t * const in = mParallelTasks[taskIndex++].out;
+            if (t1->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                float * const fout = reinterpret_cast<float *>(outTemp);
+                const float * const fin = reinterpret_cast<const float *>(in);
+                for (size_t i = 0; i < sampleCount; ++i) {
+                    fout[i] += fin[i];
+                }
+            } else {
+                for (size_t i = 0; i < sampleCount; ++i) {
+                    outTemp[i] += in[i];
+                }
+            }
+        }
+        convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
+                outTemp, t1->mMixerInFormat, sampleCount);
+    }
+}
+
 // one track, 16 bits stereo without resampling is the most common case
 void AudioMixerBase::process__oneTrack16BitsStereoNoResampling()
 {
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MixerWorkerPool"
+//#define LOG_NDEBUG 0
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <utils/Log.h>
+
+#include "MixerWorkerPool.h"
+
+namespace android {
+
+MixerWorkerPool::MixerWorkerPool(size_t threadCount, uint64_t cpuMask)
+{
+    // Workers run at the priority of the creating (mixer) thread.
+    int policy;
+    sched_param param;
+    const bool samePriority = pthread_getschedparam(pthread_self(), &policy, &param) == 0;
+
+    mThreads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        mThreads.emplace_back(&MixerWorkerPool::threadLoop, this, i + 1);
+        const pthread_t handle = mThreads.back().native_handle();
+
+        char name[16];
+        snprintf(name, sizeof(name), "AudioMixerW%zu", i + 1);
+        pthread_setname_np(handle, name);
+
+        if (samePriority) {
+            if (int ret = pthread_setschedparam(handle, policy, &param); ret != 0) {
+                ALOGW("%s: cannot set worker %zu policy %d priority %d: %s",
+                        __func__, i + 1, policy, param.sched_priority, strerror(ret));
+            }
+        }
+#ifdef __linux__
+        if (cpuMask != 0) {
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+                if (cpuMask & (1ULL << cpu)) {
+                    CPU_SET(cpu, &cpuSet);
+                }
+            }
+            if (int ret = pthread_setaffinity_np(handle, sizeof(cpuSet), &cpuSet); ret != 0) {
+                ALOGW("%s: cannot pin worker %zu to cpu mask %#llx: %s",
+                        __func__, i + 1, (unsigned long long)cpuMask, strerror(ret));
+            }
+        }
+#else
+        (void)cpuMask;
+#endif
+    }
+}
+
+MixerWorkerPool::~MixerWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExit = true;
+    }
+    mWorkCv.notify_all();
+    for (auto &thread : mThreads) {
+        thread.join();
+    }
+}
+
+void MixerWorkerPool::run(size_t count, job_t job, void *cookie)
+{
+    if (count == 0) return;
+    if (mThreads.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            job(cookie, i, 0 /* worker */);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mJob = job;
+        mCookie = cookie;
+        mCount = count;
+        mNext.store(0, std::memory_order_relaxed);
+        ++mGeneration;
+    }
+    mWorkCv.notify_all();
+
+    drain(0 /* worker */);
+
+    // Wait for every worker that picked up this job to leave it, so that no worker can
+    // claim an index of the next job while still running this one.
+    std::unique_lock<std::mutex> lock(mLock);
+    mDoneCv.wait(lock, [this] { return mActiveWorkers == 0; });
+    mCount = 0;
+}
+
+void MixerWorkerPool::drain(size_t worker)
+{
+    for (;;) {
+        const size_t index = mNext.fetch_add(1, std::memory_order_relaxed);
+        if (index >= mCount) break;
+        mJob(mCookie, index, worker);
+    }
+}
+
+void MixerWorkerPool::threadLoop(size_t worker)
+{
+    uint64_t generation = 0;
+    std::unique_lock<std::mutex> lock(mLock);
+    for (;;) {
+        mWorkCv.wait(lock, [&] { return mExit || mGeneration != generation; });
+        if (mExit) break;
+        generation = mGeneration;
+        if (mCount == 0) continue; // job already completed before this worker woke up.
+        ++mActiveWorkers;
+        lock.unlock();
+
+        drain(worker);
+
+        lock.lock();
+        if (--mActiveWorkers == 0) {
+            mDoneCv.notify_one();
+        }
+    }
+}
+
+} // namespace android
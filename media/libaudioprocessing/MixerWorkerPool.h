@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_WORKER_POOL_H
+#define ANDROID_AUDIO_MIXER_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+// A small fixed pool of threads used by AudioMixerBase to process tracks in parallel.
+//
+// The pool is created from the mixer thread, and the worker threads inherit its scheduling
+// policy and priority so that they can meet the same deadline. Workers are optionally pinned
+// to a set of CPUs.
+class MixerWorkerPool {
+public:
+    // job(cookie, index, worker) is called once for each index in [0, count).
+    // worker is in [0, threadCount()], where 0 is the thread that called run().
+    using job_t = void (*)(void *cookie, size_t index, size_t worker);
+
+    // \param threadCount number of worker threads, in addition to the calling thread.
+    // \param cpuMask     if non-zero, workers are pinned to the CPUs set in the mask.
+    MixerWorkerPool(size_t threadCount, uint64_t cpuMask);
+    ~MixerWorkerPool();
+
+    MixerWorkerPool(const MixerWorkerPool&) = delete;
+    MixerWorkerPool& operator=(const MixerWorkerPool&) = delete;
+
+    size_t threadCount() const { return mThreads.size(); }
+
+    // Distributes |count| invocations of |job| over the workers and the calling thread,
+    // and returns once all of them have completed. Does not allocate.
+    void run(size_t count, job_t job, void *cookie);
+
+private:
+    void threadLoop(size_t worker);
+
+    // Claims and runs indices of the current job until none are left.
+    void drain(size_t worker);
+
+    std::mutex mLock;
+    std::condition_variable mWorkCv;    // signaled when a new job is posted or on exit
+    std::condition_variable mDoneCv;    // signaled when the last worker leaves a job
+
+    // Protected by mLock.
+    uint64_t mGeneration = 0;   // incremented for every job posted
+    size_t mActiveWorkers = 0;  // workers that have picked up the current job
+    bool mExit = false;
+
+    // Written by run() before the generation is incremented, under mLock.
+    job_t mJob = nullptr;
+    void *mCookie = nullptr;
+    size_t mCount = 0;
+
+    std::atomic<size_t> mNext{0};
+
+    std::vector<std::thread> mThreads;
+};
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_MIXER_WORKER_POOL_H
@@ -36,6 +36,8 @@
 
 namespace android {
 
+class MixerWorkerPool;
+
 // ----------------------------------------------------------------------------
 
 // AudioMixerBase is functional on its own if only mixing and resampling
@@ -91,12 +93,9 @@ public:
         AUXLEVEL        = 0x4210,
     };
 
-    AudioMixerBase(size_t frameCount, uint32_t sampleRate)
-        : mSampleRate(sampleRate)
-        , mFrameCount(frameCount) {
-    }
+    AudioMixerBase(size_t frameCount, uint32_t sampleRate);
 
-    virtual ~AudioMixerBase() {}
+    virtual ~AudioMixerBase();
 
     virtual bool isValidFormat(audio_format_t format) const;
     virtual bool isValidChannelMask(audio_channel_mask_t channelMask) const;
@@ -137,6 +136,21 @@ public:
 
     size_t      getUnreleasedFrames(int name) const;
 
+    // Enable parallel mixing on |threadCount| worker threads in addition to the thread
+    // calling process(), used when at least kParallelMinTracks tracks are enabled.
+    //
+    // Each track is resampled and converted into its own buffer on any thread, then the
+    // buffers are accumulated on the calling thread in track name order, so the output
+    // does not depend on thread scheduling.  Tracks with an aux send are mixed by the
+    // calling thread during accumulation.
+    //
+    // The worker threads are created on the next process() and take on the scheduling
+    // policy and priority of that thread.
+    //
+    // \param threadCount number of worker threads, 0 (the default) disables parallel mixing.
+    // \param cpuMask     if non-zero, worker threads are pinned to the CPUs set in the mask.
+    void        setParallelMixing(size_t threadCount, uint64_t cpuMask = 0);
+
     std::string trackNames() const;
 
   protected:
@@ -351,6 +365,22 @@ public:
     void process__genericNoResampling();
     void process__genericResampling();
     void process__oneTrack16BitsStereoNoResampling();
+    void process__genericParallel();
+
+    // Minimum number of enabled tracks for which parallel mixing is worth the thread handoff.
+    static constexpr size_t kParallelMinTracks = 4;
+
+    // Track processed by one invocation of the parallel mixing job.
+    struct ParallelTask {
+        TrackBase *track;
+        int32_t   *out;         // private buffer receiving the track mix, in mMixerInFormat.
+    };
+
+    // Returns true if parallel mixing can be used for the enabled tracks,
+    // allocating the worker pool and the per track and per worker buffers as needed.
+    bool prepareParallel();
+    static void processParallelTask(void *cookie, size_t index, size_t worker);
+    void processTrack(TrackBase *t, int32_t *out, int32_t *temp, int32_t *aux);
 
     template <int MIXTYPE, typename TO, typename TI, typename TA>
     void process__noResampleOneTrack();
@@ -382,6 +412,16 @@ public:
 
     // track smart pointers, by name, in increasing order of name.
     std::map<int /* name */, std::shared_ptr<TrackBase>> mTracks;
+
+    // parallel mixing, see setParallelMixing().
+    size_t mParallelThreadCount = 0;
+    uint64_t mParallelCpuMask = 0;
+    std::unique_ptr<MixerWorkerPool> mWorkerPool;
+    std::unique_ptr<int32_t[]> mParallelTemp;   // per track mix buffers
+    size_t mParallelTempSize = 0;               // in samples
+    // resampler temp buffers for each worker thread; the calling thread uses mResampleTemp.
+    std::vector<std::unique_ptr<int32_t[]>> mWorkerResampleTemp;
+    std::vector<ParallelTask> mParallelTasks;   // capacity reserved by prepareParallel()
 };
 
 }  // namespace android
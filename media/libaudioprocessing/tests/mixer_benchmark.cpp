@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks AudioMixer::process() with many enabled tracks, serially and with
+// parallel mixing (see AudioMixerBase::setParallelMixing()).
+//
+// Reported counters:
+//   tracks  - number of enabled tracks.
+//   threads - number of worker threads, 0 is the serial mixer.
+//   speedup - serial time per process() divided by the measured time per process().
+
+#include <chrono>
+#include <math.h>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/AudioMixer.h>
+
+using namespace android;
+
+static constexpr size_t kFrameCount = 960;      // 20 ms at 48 kHz, a typical mixer period
+static constexpr uint32_t kSampleRate = 48000;
+static constexpr size_t kChannelCount = 2;
+
+// Provides the same float sine buffer over and over, so the mixer never runs dry.
+class LoopProvider : public AudioBufferProvider {
+public:
+    explicit LoopProvider(double freq) : mData(kFrameCount * 4 * kChannelCount) {
+        for (size_t i = 0; i < mData.size() / kChannelCount; ++i) {
+            const float y = sin(2. * M_PI * freq * i / kSampleRate);
+            for (size_t c = 0; c < kChannelCount; ++c) {
+                mData[i * kChannelCount + c] = y;
+            }
+        }
+    }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        const size_t frames = mData.size() / kChannelCount;
+        buffer->frameCount = std::min(buffer->frameCount, frames - mNextFrame);
+        buffer->raw = &mData[mNextFrame * kChannelCount];
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mNextFrame = (mNextFrame + buffer->frameCount) % (mData.size() / kChannelCount);
+        buffer->frameCount = 0;
+        buffer->raw = nullptr;
+    }
+
+private:
+    std::vector<float> mData;
+    size_t mNextFrame = 0;
+};
+
+// Every other track runs at 44.1 kHz so that the resampler is part of the workload,
+// as it is for game audio mixed into a 48 kHz output.
+static void setupMixer(AudioMixer *mixer, std::vector<std::unique_ptr<LoopProvider>> &providers,
+        float *out, size_t trackCount) {
+    const float volume = AudioMixer::UNITY_GAIN_FLOAT / trackCount;
+    for (size_t i = 0; i < trackCount; ++i) {
+        const int name = i;
+        providers.emplace_back(new LoopProvider(220. * (i + 1)));
+        mixer->create(name, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_FLOAT,
+                AUDIO_SESSION_OUTPUT_MIX);
+        mixer->setBufferProvider(name, providers.back().get());
+        mixer->setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER, out);
+        mixer->setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+        mixer->setParameter(name, AudioMixer::TRACK, AudioMixer::FORMAT,
+                (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+        mixer->setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+                (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+        mixer->setParameter(name, AudioMixer::TRACK, AudioMixer::CHANNEL_MASK,
+                (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+        mixer->setParameter(name, AudioMixer::RESAMPLE, AudioMixer::SAMPLE_RATE,
+                (void *)(uintptr_t)(i % 2 ? 44100 : kSampleRate));
+        mixer->setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0, (void *)&volume);
+        mixer->setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1, (void *)&volume);
+        mixer->enable(name);
+    }
+}
+
+static double timePerProcess(AudioMixer *mixer, size_t iterations) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        mixer->process();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+static void BM_MixTracks(benchmark::State& state) {
+    const size_t trackCount = state.range(0);
+    const size_t threadCount = state.range(1);
+
+    std::vector<float> out(kFrameCount * kChannelCount);
+    std::vector<std::unique_ptr<LoopProvider>> providers;
+    AudioMixer mixer(kFrameCount, kSampleRate);
+    setupMixer(&mixer, providers, out.data(), trackCount);
+
+    // Serial reference, also warms up the resamplers.
+    constexpr size_t kReferenceIterations = 200;
+    const double serialTime = timePerProcess(&mixer, kReferenceIterations);
+
+    mixer.setParallelMixing(threadCount);
+    mixer.process(); // creates the worker threads.
+
+    size_t iterations = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        mixer.process();
+        benchmark::DoNotOptimize(out.data());
+        ++iterations;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    state.counters["tracks"] = trackCount;
+    state.counters["threads"] = threadCount;
+    state.counters["speedup"] = iterations > 0 ? serialTime / (elapsed.count() / iterations) : 0.;
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+static void MixTracksArgs(benchmark::internal::Benchmark* b) {
+    for (int tracks : {4, 8, 16, 32, 48}) {
+        for (int threads : {0, 1, 2, 3}) {
+            b->Args({tracks, threads});
+        }
+    }
+}
+
+BENCHMARK(BM_MixTracks)->Apply(MixTracksArgs)->UseRealTime();
+
+BENCHMARK_MAIN();
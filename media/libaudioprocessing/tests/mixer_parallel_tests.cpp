@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks that parallel mixing (see AudioMixerBase::setParallelMixing()) produces the
+// same output, bit for bit, as the serial mixer.
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "mixer_parallel_tests"
+#include <log/log.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/AudioMixer.h>
+
+using namespace android;
+
+static constexpr size_t kFrameCount = 240;
+static constexpr uint32_t kSampleRate = 48000;
+static constexpr size_t kPeriods = 60;
+
+// Provides random samples, a few frames fewer than requested now and then, so that the
+// mixer acquires its input in several buffers.
+class RandomProvider : public AudioBufferProvider {
+public:
+    RandomProvider(audio_format_t format, size_t channelCount, uint32_t seed)
+        : mFrameSize(channelCount * audio_bytes_per_sample(format)),
+          mData(kFrameCount * 8 * mFrameSize),
+          mGenerator(seed) {
+        std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+        if (format == AUDIO_FORMAT_PCM_FLOAT) {
+            float *samples = reinterpret_cast<float *>(mData.data());
+            for (size_t i = 0; i < mData.size() / sizeof(float); ++i) {
+                samples[i] = distribution(mGenerator);
+            }
+        } else {
+            int16_t *samples = reinterpret_cast<int16_t *>(mData.data());
+            for (size_t i = 0; i < mData.size() / sizeof(int16_t); ++i) {
+                samples[i] = distribution(mGenerator) * INT16_MAX;
+            }
+        }
+    }
+
+    status_t getNextBuffer(Buffer *buffer) override {
+        const size_t frames = mData.size() / mFrameSize;
+        size_t frameCount = std::min(buffer->frameCount, frames - mNextFrame);
+        if (frameCount > 1 && mGenerator() % 4 == 0) {
+            frameCount -= mGenerator() % (frameCount / 2);
+        }
+        buffer->frameCount = frameCount;
+        buffer->raw = &mData[mNextFrame * mFrameSize];
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer *buffer) override {
+        mNextFrame = (mNextFrame + buffer->frameCount) % (mData.size() / mFrameSize);
+        buffer->frameCount = 0;
+        buffer->raw = nullptr;
+    }
+
+private:
+    const size_t mFrameSize;
+    std::vector<uint8_t> mData;
+    std::minstd_rand mGenerator;
+    size_t mNextFrame = 0;
+};
+
+// A mixer with its tracks, its providers and its output buffers.
+struct TestMixer {
+    static constexpr int kMainBuffers = 2;
+
+    explicit TestMixer(size_t trackCount) : mixer(kFrameCount, kSampleRate) {
+        for (auto &buffer : mainBuffers) {
+            buffer.resize(kFrameCount * FCC_2);
+        }
+        aux.resize(kFrameCount);
+        for (size_t i = 0; i < trackCount; ++i) {
+            // Float and 16-bit, mono and stereo tracks, most of them resampled.
+            const audio_format_t format =
+                    i % 3 == 1 ? AUDIO_FORMAT_PCM_16_BIT : AUDIO_FORMAT_PCM_FLOAT;
+            const audio_channel_mask_t channelMask =
+                    i % 4 == 3 ? AUDIO_CHANNEL_OUT_MONO : AUDIO_CHANNEL_OUT_STEREO;
+            static constexpr uint32_t kSampleRates[] = {kSampleRate, 44100, 32000, 96000};
+            const uint32_t sampleRate = kSampleRates[i % 4];
+
+            const int name = i;
+            providers.emplace_back(new RandomProvider(
+                    format, audio_channel_count_from_out_mask(channelMask), i));
+            EXPECT_EQ(OK, mixer.create(name, channelMask, format, AUDIO_SESSION_OUTPUT_MIX));
+            mixer.setBufferProvider(name, providers.back().get());
+            mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER,
+                    mainBuffers[i % kMainBuffers].data());
+            mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                    (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+            mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::FORMAT,
+                    (void *)(uintptr_t)format);
+            mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+                    (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+            mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::CHANNEL_MASK,
+                    (void *)(uintptr_t)channelMask);
+            mixer.setParameter(name, AudioMixer::RESAMPLE, AudioMixer::SAMPLE_RATE,
+                    (void *)(uintptr_t)sampleRate);
+            setVolume(name, AudioMixer::VOLUME, 1.f / (i + 1));
+            // Tracks with an aux send are mixed by the calling thread.
+            if (i % 5 == 2) {
+                float level = 0.5f;
+                mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::AUX_BUFFER,
+                        aux.data());
+                mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::AUXLEVEL, &level);
+            }
+            mixer.enable(name);
+        }
+    }
+
+    void setVolume(int name, int target, float volume) {
+        // Different left and right volumes.
+        float right = volume / 2;
+        mixer.setParameter(name, target, AudioMixer::VOLUME0, &volume);
+        mixer.setParameter(name, target, AudioMixer::VOLUME1, &right);
+    }
+
+    AudioMixer mixer;
+    std::vector<std::unique_ptr<RandomProvider>> providers;
+    std::vector<float> mainBuffers[kMainBuffers];
+    std::vector<float> aux;
+};
+
+// track count, worker thread count
+class MixerParallelTest : public ::testing::TestWithParam<std::tuple<size_t, size_t>> {};
+
+TEST_P(MixerParallelTest, MatchesSerialMix) {
+    const auto [trackCount, threadCount] = GetParam();
+    TestMixer serial(trackCount);
+    TestMixer parallel(trackCount);
+    parallel.mixer.setParallelMixing(threadCount);
+
+    for (size_t period = 0; period < kPeriods; ++period) {
+        // Volume ramps, and tracks disabled and enabled again, change the process hooks.
+        for (TestMixer *test : {&serial, &parallel}) {
+            if (period == 10) {
+                for (size_t name = 0; name < trackCount; ++name) {
+                    test->setVolume(name, AudioMixer::RAMP_VOLUME, 0.1f * (name % 7));
+                }
+            } else if (period == 30) {
+                test->mixer.disable(0);
+            } else if (period == 40) {
+                test->mixer.enable(0);
+            }
+        }
+        // The aux buffer is accumulated into, and cleared by its effect.
+        std::fill(serial.aux.begin(), serial.aux.end(), 0.f);
+        std::fill(parallel.aux.begin(), parallel.aux.end(), 0.f);
+        serial.mixer.process();
+        parallel.mixer.process();
+
+        for (int i = 0; i < TestMixer::kMainBuffers; ++i) {
+            ASSERT_EQ(0, memcmp(serial.mainBuffers[i].data(), parallel.mainBuffers[i].data(),
+                                serial.mainBuffers[i].size() * sizeof(float)))
+                    << "main buffer " << i << " period " << period;
+        }
+        ASSERT_EQ(0, memcmp(serial.aux.data(), parallel.aux.data(),
+                            serial.aux.size() * sizeof(float)))
+                << "aux buffer, period " << period;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        MixerParallel, MixerParallelTest,
+        ::testing::Combine(
+                // Fewer tracks than mixed in parallel (4), as many and more.
+                ::testing::Values(3, 4, 8, 13),
+                ::testing::Values(1, 2, 3)));
@@ -38,6 +38,7 @@ using namespace android;
 static void usage(const char* name) {
     fprintf(stderr, "Usage: %s [-f] [-m] [-c channels]"
                     " [-s sample-rate] [-o <output-file>] [-a <aux-buffer-file>] [-P csv]"
+                    " [-t threads]"
                     " (<input-file> | <command>)+\n", name);
     fprintf(stderr, "    -f    enable floating point input track by default\n");
     fprintf(stderr, "    -m    enable floating point mixer output\n");
@@ -46,6 +47,7 @@ static void usage(const char* name) {
     fprintf(stderr, "    -o    <output-file> WAV file, pcm16 (or float if -m specified)\n");
     fprintf(stderr, "    -a    <aux-buffer-file>\n");
     fprintf(stderr, "    -P    # frames provided per call to resample() in CSV format\n");
+    fprintf(stderr, "    -t    # worker threads for parallel mixing (default 0, disabled)\n");
     fprintf(stderr, "    <input-file> is a WAV file\n");
     fprintf(stderr, "    <command> can be 'sine:[(i|f),]<channels>,<frequency>,<samplerate>'\n");
     fprintf(stderr, "                     'chirp:[(i|f),]<channels>,<samplerate>'\n");
@@ -100,11 +102,12 @@ int main(int argc, char* argv[]) {
     std::vector<int> Pvalues;
     const char* outputFilename = NULL;
     const char* auxFilename = NULL;
+    size_t parallelThreads = 0;
     std::vector<int32_t> names;
     std::vector<SignalProvider> providers;
     std::vector<audio_format_t> formats;
 
-    for (int ch; (ch = getopt(argc, argv, "fmc:s:o:a:P:")) != -1;) {
+    for (int ch; (ch = getopt(argc, argv, "fmc:s:o:a:P:t:")) != -1;) {
         switch (ch) {
         case 'f':
             useInputFloat = true;
@@ -130,6 +133,9 @@ int main(int argc, char* argv[]) {
                 return EXIT_FAILURE;
             }
             break;
+        case 't':
+            parallelThreads = atoi(optarg);
+            break;
         case '?':
         default:
             usage(progname);
@@ -233,6 +239,7 @@ int main(int argc, char* argv[]) {
     // create the mixer.
     const size_t mixerFrameCount = 320; // typical numbers may range from 240 or 960
     AudioMixer *mixer = new AudioMixer(mixerFrameCount, outputSampleRate);
+    mixer->setParallelMixing(parallelThreads);
     audio_format_t mixerFormat = useMixerFloat
             ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
     float f = AudioMixer::UNITY_GAIN_FLOAT / providers.size(); // normalize volume by # tracks
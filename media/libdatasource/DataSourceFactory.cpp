@@ -17,6 +17,7 @@
 #define LOG_TAG "DataSource"
 
 
+#include <cutils/properties.h>
 #include <datasource/DataSourceFactory.h>
 #include <datasource/DataURISource.h>
 #include <datasource/HTTPBase.h>
@@ -29,6 +30,14 @@
 
 namespace android {
 
+// Serve local file reads from a mapping of the file, see FileSource::enableMmap().
+static void maybeEnableMmap(const sp<FileSource> &source) {
+    if (source->initCheck() == OK
+            && property_get_bool("media.stagefright.filesource.mmap", false /* default */)) {
+        (void)source->enableMmap();
+    }
+}
+
 // static
 sp<DataSourceFactory> DataSourceFactory::sInstance;
 // static
@@ -110,6 +119,7 @@ sp<DataSource> DataSourceFactory::CreateFromURI(
 
 sp<DataSource> DataSourceFactory::CreateFromFd(int fd, int64_t offset, int64_t length) {
     sp<FileSource> source = new FileSource(fd, offset, length);
+    maybeEnableMmap(source);
     return source->initCheck() != OK ? nullptr : source;
 }
 
@@ -128,7 +138,9 @@ sp<DataSource> DataSourceFactory::CreateMediaHTTP(const sp<MediaHTTPService> &ht
 }
 
 sp<DataSource> DataSourceFactory::CreateFileSource(const char *uri) {
-    return new FileSource(uri);
+    sp<FileSource> source = new FileSource(uri);
+    maybeEnableMmap(source);
+    return source;
 }
 
 }  // namespace android
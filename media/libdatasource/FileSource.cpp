@@ -23,12 +23,17 @@
 #include <media/stagefright/FoundationUtils.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 
 namespace android {
 
+// Largest file range enableMmap() maps; keep 32-bit processes' address space usable.
+static constexpr uint64_t kMaxMapBytes =
+        sizeof(void *) == 4 ? 256ULL * 1024 * 1024 : 1ULL << 40;
+
 FileSource::FileSource(const char *filename)
     : mFd(-1),
       mOffset(0),
@@ -90,6 +95,10 @@ FileSource::FileSource(int fd, int64_t offset, int64_t length)
 }
 
 FileSource::~FileSource() {
+    if (mMapAddr != nullptr) {
+        munmap(mMapAddr, mMapSize);
+        mMapAddr = nullptr;
+    }
     if (mFd >= 0) {
         ::close(mFd);
         mFd = -1;
@@ -105,7 +114,8 @@ ssize_t FileSource::readAt(off64_t offset, void *data, size_t size) {
         return NO_INIT;
     }
 
-    Mutex::Autolock autoLock(mLock);
+    // mLength is fixed at construction and readAt_l() keeps no file position,
+    // so concurrent readers do not serialize on mLock.
     if (mLength >= 0) {
         if (offset < 0) {
             return UNKNOWN_ERROR;
@@ -122,13 +132,68 @@ ssize_t FileSource::readAt(off64_t offset, void *data, size_t size) {
 }
 
 ssize_t FileSource::readAt_l(off64_t offset, void *data, size_t size) {
-    off64_t result = lseek64(mFd, offset + mOffset, SEEK_SET);
-    if (result == -1) {
-        ALOGE("seek to %lld failed", (long long)(offset + mOffset));
+    const uint8_t *mapData = mMapData.load(std::memory_order_acquire);
+    if (mapData != nullptr && offset >= 0 && offset < mLength) {
+        uint64_t numAvailable = mLength - offset;
+        if ((uint64_t)size > numAvailable) {
+            size = numAvailable;
+        }
+        memcpy(data, mapData + offset, size);
+        return size;
+    }
+
+    ssize_t n = pread64(mFd, data, size, offset + mOffset);
+    if (n < 0) {
+        ALOGE("read at %lld failed (%s)", (long long)(offset + mOffset), strerror(errno));
         return UNKNOWN_ERROR;
     }
+    return n;
+}
+
+void FileSource::hintReadAhead(off64_t offset, size_t size) {
+    const uint8_t *mapData = mMapData.load(std::memory_order_acquire);
+    if (mapData == nullptr || offset < 0 || offset >= mLength || size == 0) {
+        return;
+    }
+    if ((uint64_t)size > (uint64_t)(mLength - offset)) {
+        size = mLength - offset;
+    }
 
-    return ::read(mFd, data, size);
+    const uintptr_t pageMask = sysconf(_SC_PAGESIZE) - 1;
+    const uintptr_t start = (uintptr_t)(mapData + offset);
+    const uintptr_t alignedStart = start & ~pageMask;
+    (void)madvise((void *)alignedStart, size + (start - alignedStart), MADV_WILLNEED);
+}
+
+status_t FileSource::enableMmap() {
+    Mutex::Autolock autoLock(mLock);
+
+    if (mFd < 0) {
+        return NO_INIT;
+    }
+    if (mMapData.load(std::memory_order_relaxed) != nullptr) {
+        return OK;
+    }
+    if (mLength <= 0 || (uint64_t)mLength > kMaxMapBytes) {
+        return ERROR_UNSUPPORTED;
+    }
+
+    const int64_t pageSize = sysconf(_SC_PAGESIZE);
+    const int64_t mapOffset = mOffset - mOffset % pageSize;
+    const size_t mapSize = (mOffset - mapOffset) + mLength;
+    void *addr = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, mFd, mapOffset);
+    if (addr == MAP_FAILED) {
+        const int err = errno;
+        ALOGW("%s: mmap of %zu bytes failed (%s), using pread",
+                mName.c_str(), mapSize, strerror(err));
+        return -err;
+    }
+
+    mMapAddr = addr;
+    mMapSize = mapSize;
+    mMapData.store((const uint8_t *)addr + (mOffset - mapOffset), std::memory_order_release);
+    ALOGV("%s: mapped %zu bytes", mName.c_str(), mapSize);
+    return OK;
 }
 
 status_t FileSource::getSize(off64_t *size) {
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures FileSource::readAt() throughput with several threads sharing one source,
+// as an extractor and a thumbnailer do, with pread64() and with enableMmap().
+//
+// Arguments: {mmap, read size}. Sequential reads start each thread at its own offset
+// and walk forward; random reads pick read-size aligned offsets across the file.
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <datasource/FileSource.h>
+
+using namespace android;
+
+static constexpr size_t kFileSize = 64 * 1024 * 1024;
+
+static std::mutex gLock;
+static sp<FileSource> gSource;
+static int gUsers = 0;
+
+// Creates the test file and the shared FileSource on first use.
+static void acquireSource(bool useMmap) {
+    std::lock_guard<std::mutex> lock(gLock);
+    if (gUsers++ > 0) return;
+
+    char path[] = "/data/local/tmp/filesource_benchmark_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) abort();
+    unlink(path);
+    std::vector<uint8_t> block(1024 * 1024);
+    std::mt19937 rng(42);
+    for (auto &byte : block) byte = rng();
+    for (size_t written = 0; written < kFileSize; written += block.size()) {
+        if (write(fd, block.data(), block.size()) != (ssize_t)block.size()) abort();
+    }
+    gSource = new FileSource(fd, 0, kFileSize);
+    if (useMmap && gSource->enableMmap() != OK) abort();
+}
+
+static void releaseSource() {
+    std::lock_guard<std::mutex> lock(gLock);
+    if (--gUsers == 0) gSource.clear();
+}
+
+static void BM_SequentialRead(benchmark::State& state) {
+    const size_t readSize = state.range(1);
+    acquireSource(state.range(0) != 0);
+    std::vector<uint8_t> buffer(readSize);
+    off64_t offset = (kFileSize / state.threads) * state.thread_index;
+
+    for (auto _ : state) {
+        if (offset + readSize > kFileSize) offset = 0;
+        if (gSource->readAt(offset, buffer.data(), readSize) != (ssize_t)readSize) {
+            state.SkipWithError("short read");
+            break;
+        }
+        offset += readSize;
+    }
+    state.SetBytesProcessed(state.iterations() * readSize);
+    releaseSource();
+}
+
+static void BM_RandomRead(benchmark::State& state) {
+    const size_t readSize = state.range(1);
+    acquireSource(state.range(0) != 0);
+    std::vector<uint8_t> buffer(readSize);
+    std::mt19937 rng(state.thread_index);
+    std::uniform_int_distribution<size_t> block(0, kFileSize / readSize - 1);
+
+    for (auto _ : state) {
+        if (gSource->readAt(block(rng) * readSize, buffer.data(), readSize)
+                != (ssize_t)readSize) {
+            state.SkipWithError("short read");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * readSize);
+    releaseSource();
+}
+
+static void ReadArgs(benchmark::internal::Benchmark* b) {
+    for (int useMmap : {0, 1}) {
+        for (int readSize : {188, 4096, 65536}) {
+            b->Args({useMmap, readSize});
+        }
+    }
+    b->ArgNames({"mmap", "size"})->ThreadRange(1, 4)->UseRealTime();
+}
+
+BENCHMARK(BM_SequentialRead)->Apply(ReadArgs);
+BENCHMARK(BM_RandomRead)->Apply(ReadArgs);
+
+BENCHMARK_MAIN();
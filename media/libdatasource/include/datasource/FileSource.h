@@ -20,6 +20,8 @@
 
 #include <stdio.h>
 
+#include <atomic>
+
 #include <media/DataSource.h>
 #include <media/stagefright/MediaErrors.h>
 #include <utils/threads.h>
@@ -38,6 +40,17 @@ public:
 
     virtual status_t getSize(off64_t *size);
 
+    // Advises the kernel to fetch the range when reads are served from the
+    // mapping. A no-op for pread64(): mediaextractor may not call fadvise64.
+    virtual void hintReadAhead(off64_t offset, size_t size);
+
+    // Serve reads from a read-only mapping of the file instead of pread64().
+    // Only use this for files that are not being written: reading a mapped page
+    // beyond the end of a file truncated after this call raises SIGBUS.
+    // Returns OK if reads are now served from the mapping; otherwise reads keep
+    // using pread64().
+    status_t enableMmap();
+
     virtual uint32_t flags() {
         return kIsLocalFileSource;
     }
@@ -48,6 +61,7 @@ public:
 
 protected:
     virtual ~FileSource();
+    // Reads with pread64() or from the mapping, and does not need mLock to be held.
     virtual ssize_t readAt_l(off64_t offset, void *data, size_t size);
 
     int mFd;
@@ -58,6 +72,11 @@ protected:
 private:
     String8 mName;
 
+    // Set once by enableMmap(), under mLock.
+    std::atomic<const uint8_t *> mMapData{nullptr};   // points at mOffset in the file
+    void *mMapAddr = nullptr;                         // page aligned start of the mapping
+    size_t mMapSize = 0;
+
     FileSource(const FileSource &);
     FileSource &operator=(const FileSource &);
 };
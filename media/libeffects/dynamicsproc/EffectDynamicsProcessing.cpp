@@ -213,8 +213,10 @@ int DP_init(DynamicsProcessingContext *pContext)
 void DP_changeVariant(DynamicsProcessingContext *pContext, int newVariant) {
     ALOGV("DP_changeVariant from %d to %d", pContext->mCurrentVariant, newVariant);
     switch(newVariant) {
-    case VARIANT_FAVOR_FREQUENCY_RESOLUTION: {
-        pContext->mCurrentVariant = VARIANT_FAVOR_FREQUENCY_RESOLUTION;
+    case VARIANT_FAVOR_FREQUENCY_RESOLUTION:
+    case VARIANT_FAVOR_TIME_RESOLUTION: {
+        //both variants use DPFrequency, configured differently.
+        pContext->mCurrentVariant = newVariant;
         delete pContext->mPDynamics;
         pContext->mPDynamics = new dp_fx::DPFrequency();
         break;
@@ -229,7 +231,8 @@ void DP_changeVariant(DynamicsProcessingContext *pContext, int newVariant) {
 void DP_configureVariant(DynamicsProcessingContext *pContext, int newVariant) {
     ALOGV("DP_configureVariant %d", newVariant);
     switch(newVariant) {
-    case VARIANT_FAVOR_FREQUENCY_RESOLUTION: {
+    case VARIANT_FAVOR_FREQUENCY_RESOLUTION:
+    case VARIANT_FAVOR_TIME_RESOLUTION: {
         int32_t minBlockSize = (int32_t)dp_fx::DPFrequency::getMinBockSize();
         int32_t desiredBlock = pContext->mPreferredFrameDuration *
                 pContext->mConfig.inputCfg.samplingRate / 1000.0f;
@@ -243,9 +246,17 @@ void DP_configureVariant(DynamicsProcessingContext *pContext, int newVariant) {
             //find next highest power of 2.
             currentBlock = 1 << (32 - __builtin_clz(desiredBlock));
         }
-        ((dp_fx::DPFrequency*)pContext->mPDynamics)->configure(currentBlock,
-                currentBlock/2,
-                pContext->mConfig.inputCfg.samplingRate);
+        if (newVariant == VARIANT_FAVOR_TIME_RESOLUTION) {
+            //process every block, eq with the resolution of several blocks.
+            ((dp_fx::DPFrequency*)pContext->mPDynamics)->configurePartitioned(
+                    currentBlock * dp_fx::DPFrequency::kDefaultPartitionCount,
+                    currentBlock,
+                    pContext->mConfig.inputCfg.samplingRate);
+        } else {
+            ((dp_fx::DPFrequency*)pContext->mPDynamics)->configure(currentBlock,
+                    currentBlock/2,
+                    pContext->mConfig.inputCfg.samplingRate);
+        }
         break;
     }
     default: {
@@ -587,6 +598,9 @@ int DP_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
                     __func__, ch, gain, gainDb);
             pChannel->setOutputGain(gainDb);
         }
+        if (pContext->mPDynamics != NULL) {
+            pContext->mPDynamics->notifyParametersChanged();
+        }
 
         const int32_t  volRet[2] = {unityGain, unityGain}; // Apply no volume before effect.
         memcpy(pReplyData, volRet, sizeof(volRet));
@@ -1251,6 +1265,9 @@ int DP_setParameter(DynamicsProcessingContext *pContext,
         break;
     }
 
+    if (pContext->mPDynamics != NULL) {
+        pContext->mPDynamics->notifyParametersChanged();
+    }
     ALOGVV("%s end param: %d, status: %d", __func__, params[0], status);
     return status;
 } /* end DP_setParameter */
@@ -86,20 +86,21 @@ void DynamicsProcessingContext::dpSetFreqDomainVariant_l(
         // find next highest power of 2.
         block = 1 << (32 - __builtin_clz(block));
     }
-    mDpFreq->configure(block, block >> 1, sampleRate);
+    if (engine.resolutionPreference ==
+        DynamicsProcessing::ResolutionPreference::FAVOR_TIME_RESOLUTION) {
+        // process every block, eq with the resolution of several blocks.
+        mDpFreq->configurePartitioned(block * dp_fx::DPFrequency::kDefaultPartitionCount, block,
+                                      sampleRate);
+    } else {
+        mDpFreq->configure(block, block >> 1, sampleRate);
+    }
 }
 
 RetCode DynamicsProcessingContext::setEngineArchitecture(
         const DynamicsProcessing::EngineArchitecture& engineArchitecture) {
     std::lock_guard lg(mMutex);
     if (!mEngineInited || mEngineArchitecture != engineArchitecture) {
-        if (engineArchitecture.resolutionPreference ==
-            DynamicsProcessing::ResolutionPreference::FAVOR_FREQUENCY_RESOLUTION) {
-            dpSetFreqDomainVariant_l(engineArchitecture);
-        } else {
-            LOG(WARNING) << __func__ << toString(engineArchitecture.resolutionPreference)
-                         << " not available now";
-        }
+        dpSetFreqDomainVariant_l(engineArchitecture);
         mEngineInited = true;
         mEngineArchitecture = engineArchitecture;
     }
@@ -474,6 +475,9 @@ RetCode DynamicsProcessingContext::setDpChannels_l(
             dp->setEnabled(it.enable);
         }
     }
+    if (mDpFreq != nullptr) {
+        mDpFreq->notifyParametersChanged();
+    }
     return ret;
 }
 
@@ -553,6 +557,9 @@ RetCode DynamicsProcessingContext::setBands_l(const std::vector<T>& bands, Stage
         }
         LOG(INFO) << __func__ << it.toString();
     }
+    if (mDpFreq != nullptr) {
+        mDpFreq->notifyParametersChanged();
+    }
     return ret;
 }
 
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <dsp/DPFrequency.h>
+
+static constexpr int kSampleRate = 48000;
+static constexpr size_t kFrameCount = 240;  // 5 ms callbacks
+static constexpr size_t kBlockSize = 2048;  // eq resolution of both modes
+static constexpr size_t kPartitionSize = kBlockSize / dp_fx::DPFrequency::kDefaultPartitionCount;
+static constexpr uint32_t kBandCount = 6;
+
+static void setupChannels(dp_fx::DPFrequency& dp, uint32_t channelCount) {
+    dp.init(channelCount, true /*preEqInUse*/, kBandCount, true /*mbcInUse*/, kBandCount,
+            true /*postEqInUse*/, kBandCount, true /*limiterInUse*/);
+    for (uint32_t ch = 0; ch < channelCount; ch++) {
+        dp_fx::DPChannel* channel = dp.getChannel(ch);
+        channel->setInputGain(-3.0f);
+        channel->getPreEq()->setEnabled(true);
+        channel->getMbc()->setEnabled(true);
+        channel->getPostEq()->setEnabled(true);
+        float cutoffHz = 125;
+        for (uint32_t b = 0; b < kBandCount; b++, cutoffHz *= 2) {
+            const float gainDb = (b % 2 == 0) ? 3.0f : -3.0f;
+            dp_fx::DPEqBand eqBand;
+            eqBand.init(true /*enabled*/, cutoffHz, gainDb);
+            channel->getPreEq()->setBand(b, eqBand);
+            eqBand.init(true /*enabled*/, cutoffHz, -gainDb);
+            channel->getPostEq()->setBand(b, eqBand);
+            dp_fx::DPMbcBand mbcBand;
+            mbcBand.init(true /*enabled*/, cutoffHz, 3 /*attackTimeMs*/, 80 /*releaseTimeMs*/,
+                         4 /*ratio*/, -30 /*thresholdDb*/, 6 /*kneeWidthDb*/,
+                         -90 /*noiseGateThresholdDb*/, 1 /*expanderRatio*/, 0 /*preGainDb*/,
+                         3 /*postGainDb*/);
+            channel->getMbc()->setBand(b, mbcBand);
+        }
+        dp_fx::DPLimiter limiter;
+        limiter.init(true /*inUse*/, true /*enabled*/, 0 /*linkGroup*/, 1 /*attackTimeMs*/,
+                     60 /*releaseTimeMs*/, 10 /*ratio*/, -2 /*thresholdDb*/, 0 /*postGainDb*/);
+        channel->setLimiter(limiter);
+    }
+    dp.notifyParametersChanged();
+}
+
+/*
+ * Processes callbacks of kFrameCount frames with all stages in use, in block mode
+ * (blockSize kBlockSize, half overlap) or in partitioned mode (kBlockSize split into
+ * partitions of kPartitionSize).
+ * Besides the average time per callback, reports the worst callback, which is what has to fit
+ * in the deadline of the audio thread.
+ *
+ * $ adb shell /data/benchmarktest/dynamicsprocessing_benchmark/dynamicsprocessing_benchmark
+ * Args: channel count, partitioned
+ */
+static void BM_DPFrequency(benchmark::State& state) {
+    const uint32_t channelCount = state.range(0);
+    const bool partitioned = state.range(1) != 0;
+
+    dp_fx::DPFrequency dp;
+    setupChannels(dp, channelCount);
+    if (partitioned) {
+        dp.configurePartitioned(kBlockSize, kPartitionSize, kSampleRate);
+    } else {
+        dp.configure(kBlockSize, kBlockSize / 2, kSampleRate);
+    }
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(channelCount);
+    std::uniform_real_distribution<> dis(-0.5f, 0.5f);
+    std::vector<float> input(kFrameCount * channelCount);
+    std::vector<float> output(kFrameCount * channelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    // Apply the parameters and fill the pipeline before measuring.
+    for (size_t i = 0; i < 2 * kBlockSize / kFrameCount; i++) {
+        dp.processSamples(input.data(), output.data(), input.size());
+    }
+
+    double maxCallUs = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+
+        const auto start = std::chrono::steady_clock::now();
+        dp.processSamples(input.data(), output.data(), input.size());
+        const std::chrono::duration<double, std::micro> elapsed =
+                std::chrono::steady_clock::now() - start;
+        maxCallUs = std::max(maxCallUs, elapsed.count());
+
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["MaxCallUs"] = maxCallUs;
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+    state.SetLabel(partitioned ? "partitioned" : "block");
+}
+
+static void DPFrequencyArgs(benchmark::internal::Benchmark* b) {
+    for (int channelCount : {2, 8}) {
+        for (int partitioned : {0, 1}) {
+            b->Args({channelCount, partitioned});
+        }
+    }
+}
+
+BENCHMARK(BM_DPFrequency)->Apply(DPFrequencyArgs);
+
+BENCHMARK_MAIN();
@@ -19,6 +19,7 @@
 
 
 #include <stdint.h>
+#include <atomic>
 #include <cmath>
 #include <vector>
 #include <android/log.h>
@@ -341,6 +342,19 @@ public:
         return mLimiterInUse;
     }
 
+    // To be called by the control thread after changing the parameters of any channel.
+    // The processing thread compares generations and only reads back the parameters after
+    // a change. This does not synchronize the parameters themselves: callers still
+    // serialize parameter changes with processing, e.g. under the mutex of the AIDL context.
+    // Implementations may override it to precompute on the control thread what depends on
+    // the new parameters, and must then call this one.
+    virtual void notifyParametersChanged() {
+        mParametersGeneration.fetch_add(1, std::memory_order_release);
+    }
+    uint32_t getParametersGeneration() const {
+        return mParametersGeneration.load(std::memory_order_acquire);
+    }
+
 private:
     bool mInitialized;
     //general
@@ -354,6 +368,8 @@ private:
     bool mLimiterInUse;
 
     std::vector<DPChannel> mChannel;
+
+    std::atomic<uint32_t> mParametersGeneration{0};
 };
 
 } //namespace dp_fx
@@ -29,6 +29,7 @@ using Eigen::MatrixXd;
 #define MIN_BLOCKSIZE 8
 
 #define CIRCULAR_BUFFER_UPSAMPLE 4  //4 times buffer size
+#define DESIGN_OVERSAMPLE 4 //eq filter design resolution, times block size
 
 static constexpr float MIN_ENVELOPE = 1e-6f; //-120 dB
 static constexpr float EPSILON = 0.0000001f;
@@ -56,8 +57,7 @@ void ChannelBuffer::initBuffers(unsigned int blockSize, unsigned int overlapSize
     ALOGV("ChannelBuffer::initBuffers blockSize %d, overlap %d, halfFft %d",
             blockSize, overlapSize, halfFftSize);
 
-    mSamplingRate = samplingRate;
-    mBlockSize = blockSize;
+    initParameters(blockSize, halfFftSize, samplingRate, dpBase);
 
     cBInput.resize(mBlockSize * CIRCULAR_BUFFER_UPSAMPLE);
     cBOutput.resize(mBlockSize * CIRCULAR_BUFFER_UPSAMPLE);
@@ -66,6 +66,12 @@ void ChannelBuffer::initBuffers(unsigned int blockSize, unsigned int overlapSize
     input.resize(mBlockSize);
     output.resize(mBlockSize);
     outTail.resize(overlapSize);
+}
+
+void ChannelBuffer::initParameters(unsigned int blockSize, unsigned int halfFftSize,
+        unsigned int samplingRate, DPBase &dpBase) {
+    mSamplingRate = samplingRate;
+    mBlockSize = blockSize;
 
     //module vectors
     mPreEqFactorVector.resize(halfFftSize, 1.0);
@@ -88,6 +94,25 @@ void ChannelBuffer::initBuffers(unsigned int blockSize, unsigned int overlapSize
     mLimiterParams.linkGroup = -1; //no group.
 }
 
+void ChannelBuffer::initPartitions(unsigned int partitionSize, unsigned int partitionCount) {
+    ALOGV("ChannelBuffer::initPartitions partitionSize %d, partitionCount %d",
+            partitionSize, partitionCount);
+
+    const unsigned int partitionBins = partitionSize + 1; //including Nyquist bin
+    partInput.assign(2 * partitionSize, 0);
+    partTemp.resize(2 * partitionSize);
+    input.assign(2 * partitionSize, 0);
+    output.resize(2 * partitionSize);
+    outTail.assign(partitionSize, 0);
+    mInputSpectra.resize(partitionCount);
+    for (unsigned int p = 0; p < partitionCount; p++) {
+        mInputSpectra[p].setZero(partitionBins);
+    }
+    mNewestInput = 0;
+    complexTemp.setZero(partitionBins);
+    mPartGainVector.assign(partitionBins, 1.0);
+}
+
 void ChannelBuffer::computeBinStartStop(BandParams &bp, size_t binStart) {
 
     bp.binStart = binStart;
@@ -122,8 +147,44 @@ void LinkedLimiters::remove(int index) {
     }
 }
 
+//== EqFilterSlot
+EqFilterSlot::~EqFilterSlot() {
+    delete mPending.exchange(nullptr);
+    delete mRetired.exchange(nullptr);
+    delete mActive;
+}
+
+void EqFilterSlot::publish(EqFilter *filter) {
+    //a filter still pending was never used. The retired one is freed after publishing, so
+    //that the processing thread finds the retired slot empty until it picks up this filter.
+    delete mPending.exchange(filter);
+    delete mRetired.exchange(nullptr);
+}
+
+const EqFilter &EqFilterSlot::acquire() {
+    //only the processing thread makes mRetired non null, so it stays empty once seen empty.
+    if (mPending.load(std::memory_order_relaxed) != nullptr && mRetired.load() == nullptr) {
+        EqFilter *filter = mPending.exchange(nullptr);
+        if (filter != nullptr) {
+            mRetired.store(mActive);
+            mActive = filter;
+        }
+    }
+    return *mActive;
+}
+
 //== DPFrequency
 void DPFrequency::reset() {
+    //clear the audio carried across blocks, so that it does not leak into the next stream.
+    for (auto &cb : mChannelBuffers) {
+        std::fill(cb.input.begin(), cb.input.end(), 0);
+        std::fill(cb.outTail.begin(), cb.outTail.end(), 0);
+        std::fill(cb.partInput.begin(), cb.partInput.end(), 0);
+        for (auto &spectrum : cb.mInputSpectra) {
+            spectrum.setZero();
+        }
+        cb.mNewestInput = 0;
+    }
 }
 
 size_t DPFrequency::getMinBockSize() {
@@ -137,6 +198,8 @@ size_t DPFrequency::getMaxBockSize() {
 void DPFrequency::configure(size_t blockSize, size_t overlapSize,
         size_t samplingRate) {
     ALOGV("configure");
+    mPartitioned = false;
+    mParametersApplied = false;
     mBlockSize = blockSize;
     if (mBlockSize > MAX_BLOCKSIZE) {
         mBlockSize = MAX_BLOCKSIZE;
@@ -163,7 +226,12 @@ void DPFrequency::configure(size_t blockSize, size_t overlapSize,
     //effective number of frames processed per second
     mBlocksPerSecond = (float)mSamplingRate / (mBlockSize - mOverlapSize);
 
-    fill_window(mVWindow, RDSP_WINDOW_HANNING_FLAT_TOP, mBlockSize, mOverlapSize);
+    computeWindow(mBlockSize, mOverlapSize);
+    prepareFftPlans();
+}
+
+void DPFrequency::computeWindow(size_t size, size_t overlap) {
+    fill_window(mVWindow, RDSP_WINDOW_HANNING_FLAT_TOP, size, overlap);
 
     //split window into analysis and synthesis. Both are the sqrt() of original
     //window
@@ -180,6 +248,100 @@ void DPFrequency::configure(size_t blockSize, size_t overlapSize,
     mWindowRms = std::max(sqrt(mWindowRms / mVWindow.size()), MIN_ENVELOPE);
 }
 
+void DPFrequency::configurePartitioned(size_t blockSize, size_t partitionSize,
+        size_t samplingRate) {
+    ALOGV("configurePartitioned");
+    configure(blockSize, 0 /*overlapSize*/, samplingRate);
+
+    mPartitionSize = partitionSize;
+    if (mPartitionSize > mBlockSize / 2) {
+        mPartitionSize = mBlockSize / 2;
+    } else if (mPartitionSize < MIN_BLOCKSIZE) {
+        mPartitionSize = MIN_BLOCKSIZE;
+    } else if (!powerof2(mPartitionSize)) {
+        //find next highest power of 2.
+        mPartitionSize = 1 << (32 - __builtin_clz(mPartitionSize));
+    }
+    mPartitionCount = mBlockSize / mPartitionSize;
+    mPartitionBins = mPartitionSize + 1;
+    ALOGV("blockSize %zu, partitionSize %zu, partitionCount %zu", mBlockSize, mPartitionSize,
+            mPartitionCount);
+
+    for (auto &cb : mChannelBuffers) {
+        cb.initPartitions(mPartitionSize, mPartitionCount);
+    }
+
+    //dynamics run on blocks of two partitions, overlapping by one.
+    mBlocksPerSecond = (float)mSamplingRate / mPartitionSize;
+    computeWindow(2 * mPartitionSize, mPartitionSize);
+
+    mDesignReal.resize(mBlockSize * DESIGN_OVERSAMPLE);
+    mDesignSpectrum.resize(mDesignReal.size() / 2 + 1);
+    mDesignTemp.assign(2 * mPartitionSize, 0);
+
+    const int channelCount = getChannelCount();
+    mDesignChannels.assign(channelCount, ChannelBuffer());
+    mEqFilterSlots.resize(channelCount);
+    for (int ch = 0; ch < channelCount; ch++) {
+        mDesignChannels[ch].initParameters(mBlockSize, mHalfFFTSize, mSamplingRate, *this);
+        EqFilter *unity = new EqFilter;
+        unity->partitions.assign(1, Eigen::VectorXcf::Ones(mPartitionBins));
+        mEqFilterSlots[ch] = std::make_unique<EqFilterSlot>(unity);
+    }
+
+    mPartitioned = true;
+    prepareFftPlans();
+    updateEqFilters(true /*force*/);
+}
+
+void DPFrequency::prepareFftPlans() {
+    mHalfFftServer.SetFlag(Eigen::FFT<float>::HalfSpectrum);
+    if (!mPartitioned) {
+        FloatVec zeroes(mBlockSize, 0);
+        Eigen::Map<Eigen::VectorXf> eZeroes(&zeroes[0], zeroes.size());
+        Eigen::VectorXcf spectrum;
+        mFftServer.fwd(spectrum, eZeroes);
+        mFftServer.inv(eZeroes, spectrum);
+        return;
+    }
+    //processing at twice the partition size, filter design at that size too.
+    mDesignFftServer.SetFlag(Eigen::FFT<float>::HalfSpectrum);
+    for (size_t size : {mDesignReal.size(), 2 * mPartitionSize}) {
+        FloatVec zeroes(size, 0);
+        std::vector<std::complex<float>> spectrum(size / 2 + 1);
+        if (size == 2 * mPartitionSize) {
+            mHalfFftServer.fwd(spectrum.data(), zeroes.data(), size);
+            mHalfFftServer.inv(zeroes.data(), spectrum.data(), size);
+        }
+        mDesignFftServer.fwd(spectrum.data(), zeroes.data(), size);
+        mDesignFftServer.inv(zeroes.data(), spectrum.data(), size);
+    }
+}
+
+void DPFrequency::notifyParametersChanged() {
+    if (mPartitioned) {
+        updateEqFilters(false /*force*/);
+    }
+    DPBase::notifyParametersChanged();
+}
+
+void DPFrequency::updateEqFilters(bool force) {
+    for (size_t ch = 0; ch < mDesignChannels.size(); ch++) {
+        DPChannel *pChannel = getChannel(ch);
+        if (pChannel == nullptr) {
+            ALOGE("Error: updateEqFilters null DPChannel %zu", ch);
+            return;
+        }
+        ChannelBuffer &cb = mDesignChannels[ch];
+        if (!updateEqParameters(cb, *pChannel, ch)) {
+            return;
+        }
+        if (cb.mEqChanged || force) {
+            mEqFilterSlots[ch]->publish(designEqFilter(cb));
+        }
+    }
+}
+
 void DPFrequency::updateParameters(ChannelBuffer &cb, int channelIndex) {
     DPChannel *pChannel = getChannel(channelIndex);
 
@@ -188,16 +350,101 @@ void DPFrequency::updateParameters(ChannelBuffer &cb, int channelIndex) {
         return;
     }
 
+    //in partitioned mode, the eq filter itself is designed by the control thread.
+    if (!updateEqParameters(cb, *pChannel, channelIndex)) {
+        return;
+    }
+
+    //===MBC
+    if (cb.mMbcInUse) {
+        DPMbc *pMbc = pChannel->getMbc();
+        if (pMbc == nullptr) {
+            ALOGE("Error: updateParameters Mbc NULL for channel: %d", channelIndex);
+            return;
+        }
+        cb.mMbcEnabled = pMbc->isEnabled();
+        if (cb.mMbcEnabled) {
+            bool changed = false;
+            for (unsigned int b = 0; b < getMbcBandCount(); b++) {
+                DPMbcBand *pMbcBand = pMbc->getBand(b);
+                if (pMbcBand == nullptr) {
+                    ALOGE("Error: updateParameters MbcBand NULL for band %d", b);
+                    return; //failed.
+                }
+                ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[b];
+                pMbcBandParams->enabled = pMbcBand->isEnabled();
+                IS_CHANGED(changed, pMbcBandParams->freqCutoffHz,
+                        pMbcBand->getCutoffFrequency());
+
+                pMbcBandParams->gainPreDb = pMbcBand->getPreGain();
+                pMbcBandParams->gainPostDb = pMbcBand->getPostGain();
+                pMbcBandParams->attackTimeMs = pMbcBand->getAttackTime();
+                pMbcBandParams->releaseTimeMs = pMbcBand->getReleaseTime();
+                pMbcBandParams->ratio = pMbcBand->getRatio();
+                pMbcBandParams->thresholdDb = pMbcBand->getThreshold();
+                pMbcBandParams->kneeWidthDb = pMbcBand->getKneeWidth();
+                pMbcBandParams->noiseGateThresholdDb = pMbcBand->getNoiseGateThreshold();
+                pMbcBandParams->expanderRatio = pMbcBand->getExpanderRatio();
+
+            }
+
+            if (changed) {
+                ALOGV("mbc changed, recomputing! channel %d", channelIndex);
+                size_t binNext= 0;
+                for (unsigned int b = 0; b < getMbcBandCount(); b++) {
+                    ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[b];
+
+                    pMbcBandParams->previousEnvelope = 0;
+
+                    //frequency translation
+                    cb.computeBinStartStop(*pMbcBandParams, binNext);
+                    binNext = pMbcBandParams->binStop + 1;
+                }
+            }
+        }
+    }
+
+    //===Limiter
+    if (cb.mLimiterInUse) {
+        bool changed = false;
+        DPLimiter *pLimiter = pChannel->getLimiter();
+        if (pLimiter == nullptr) {
+            ALOGE("Error: updateParameters Limiter NULL for channel: %d", channelIndex);
+            return;
+        }
+        cb.mLimiterEnabled = pLimiter->isEnabled();
+        if (cb.mLimiterEnabled) {
+            IS_CHANGED(changed, cb.mLimiterParams.linkGroup ,
+                    (int32_t)pLimiter->getLinkGroup());
+            cb.mLimiterParams.attackTimeMs = pLimiter->getAttackTime();
+            cb.mLimiterParams.releaseTimeMs = pLimiter->getReleaseTime();
+            cb.mLimiterParams.ratio = pLimiter->getRatio();
+            cb.mLimiterParams.thresholdDb = pLimiter->getThreshold();
+            cb.mLimiterParams.postGainDb = pLimiter->getPostGain();
+        }
+
+        if (changed) {
+            ALOGV("limiter changed, recomputing linkGroups for %d", channelIndex);
+            mLinkedLimiters.remove(channelIndex); //in case it was already there.
+            mLinkedLimiters.update(cb.mLimiterParams.linkGroup, channelIndex);
+        }
+    }
+
+    //=== Output Gain
+    cb.outputGainDb = pChannel->getOutputGain();
+}
+
+bool DPFrequency::updateEqParameters(ChannelBuffer &cb, DPChannel &channel, int channelIndex) {
     //===Input Gain and preEq
     {
         bool changed = false;
-        IS_CHANGED(changed, cb.inputGainDb, pChannel->getInputGain());
+        IS_CHANGED(changed, cb.inputGainDb, channel.getInputGain());
         //===EqPre
         if (cb.mPreEqInUse) {
-            DPEq *pPreEq = pChannel->getPreEq();
+            DPEq *pPreEq = channel.getPreEq();
             if (pPreEq == nullptr) {
                 ALOGE("Error: updateParameters null PreEq for channel: %d", channelIndex);
-                return;
+                return false;
             }
             IS_CHANGED(changed, cb.mPreEqEnabled, pPreEq->isEnabled());
             if (cb.mPreEqEnabled) {
@@ -205,7 +452,7 @@ void DPFrequency::updateParameters(ChannelBuffer &cb, int channelIndex) {
                     DPEqBand *pEqBand = pPreEq->getBand(b);
                     if (pEqBand == nullptr) {
                         ALOGE("Error: updateParameters null PreEqBand for band %d", b);
-                        return; //failed.
+                        return false; //failed.
                     }
                     ChannelBuffer::EqBandParams *pEqBandParams = &cb.mPreEqBands[b];
                     IS_CHANGED(changed, pEqBandParams->enabled, pEqBand->isEnabled());
@@ -217,6 +464,7 @@ void DPFrequency::updateParameters(ChannelBuffer &cb, int channelIndex) {
         }
 
         if (changed) {
+            cb.mEqChanged = true;
             float inputGainFactor = dBtoLinear(cb.inputGainDb);
             if (cb.mPreEqInUse && cb.mPreEqEnabled) {
                 ALOGV("preEq changed, recomputing! channel %d", channelIndex);
@@ -250,10 +498,10 @@ void DPFrequency::updateParameters(ChannelBuffer &cb, int channelIndex) {
     if (cb.mPostEqInUse) {
         bool changed = false;
 
-        DPEq *pPostEq = pChannel->getPostEq();
+        DPEq *pPostEq = channel.getPostEq();
         if (pPostEq == nullptr) {
             ALOGE("Error: updateParameters null postEq for channel: %d", channelIndex);
-            return; //failed.
+            return false; //failed.
         }
         IS_CHANGED(changed, cb.mPostEqEnabled, pPostEq->isEnabled());
         if (cb.mPostEqEnabled) {
@@ -261,7 +509,7 @@ void DPFrequency::updateParameters(ChannelBuffer &cb, int channelIndex) {
                 DPEqBand *pEqBand = pPostEq->getBand(b);
                 if (pEqBand == nullptr) {
                     ALOGE("Error: updateParameters PostEqBand NULL for band %d", b);
-                    return; //failed.
+                    return false; //failed.
                 }
                 ChannelBuffer::EqBandParams *pEqBandParams = &cb.mPostEqBands[b];
                 IS_CHANGED(changed, pEqBandParams->enabled, pEqBand->isEnabled());
@@ -289,85 +537,11 @@ void DPFrequency::updateParameters(ChannelBuffer &cb, int channelIndex) {
                 }
             }
         } //enabled
-    }
-
-    //===MBC
-    if (cb.mMbcInUse) {
-        DPMbc *pMbc = pChannel->getMbc();
-        if (pMbc == nullptr) {
-            ALOGE("Error: updateParameters Mbc NULL for channel: %d", channelIndex);
-            return;
-        }
-        cb.mMbcEnabled = pMbc->isEnabled();
-        if (cb.mMbcEnabled) {
-            bool changed = false;
-            for (unsigned int b = 0; b < getMbcBandCount(); b++) {
-                DPMbcBand *pMbcBand = pMbc->getBand(b);
-                if (pMbcBand == nullptr) {
-                    ALOGE("Error: updateParameters MbcBand NULL for band %d", b);
-                    return; //failed.
-                }
-                ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[b];
-                pMbcBandParams->enabled = pMbcBand->isEnabled();
-                IS_CHANGED(changed, pMbcBandParams->freqCutoffHz,
-                        pMbcBand->getCutoffFrequency());
-
-                pMbcBandParams->gainPreDb = pMbcBand->getPreGain();
-                pMbcBandParams->gainPostDb = pMbcBand->getPostGain();
-                pMbcBandParams->attackTimeMs = pMbcBand->getAttackTime();
-                pMbcBandParams->releaseTimeMs = pMbcBand->getReleaseTime();
-                pMbcBandParams->ratio = pMbcBand->getRatio();
-                pMbcBandParams->thresholdDb = pMbcBand->getThreshold();
-                pMbcBandParams->kneeWidthDb = pMbcBand->getKneeWidth();
-                pMbcBandParams->noiseGateThresholdDb = pMbcBand->getNoiseGateThreshold();
-                pMbcBandParams->expanderRatio = pMbcBand->getExpanderRatio();
-
-            }
-
-            if (changed) {
-                ALOGV("mbc changed, recomputing! channel %d", channelIndex);
-                size_t binNext= 0;
-                for (unsigned int b = 0; b < getMbcBandCount(); b++) {
-                    ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[b];
-
-                    pMbcBandParams->previousEnvelope = 0;
-
-                    //frequency translation
-                    cb.computeBinStartStop(*pMbcBandParams, binNext);
-                    binNext = pMbcBandParams->binStop + 1;
-                }
-            }
-        }
-    }
-
-    //===Limiter
-    if (cb.mLimiterInUse) {
-        bool changed = false;
-        DPLimiter *pLimiter = pChannel->getLimiter();
-        if (pLimiter == nullptr) {
-            ALOGE("Error: updateParameters Limiter NULL for channel: %d", channelIndex);
-            return;
-        }
-        cb.mLimiterEnabled = pLimiter->isEnabled();
-        if (cb.mLimiterEnabled) {
-            IS_CHANGED(changed, cb.mLimiterParams.linkGroup ,
-                    (int32_t)pLimiter->getLinkGroup());
-            cb.mLimiterParams.attackTimeMs = pLimiter->getAttackTime();
-            cb.mLimiterParams.releaseTimeMs = pLimiter->getReleaseTime();
-            cb.mLimiterParams.ratio = pLimiter->getRatio();
-            cb.mLimiterParams.thresholdDb = pLimiter->getThreshold();
-            cb.mLimiterParams.postGainDb = pLimiter->getPostGain();
-        }
-
         if (changed) {
-            ALOGV("limiter changed, recomputing linkGroups for %d", channelIndex);
-            mLinkedLimiters.remove(channelIndex); //in case it was already there.
-            mLinkedLimiters.update(cb.mLimiterParams.linkGroup, channelIndex);
+            cb.mEqChanged = true;
         }
     }
-
-    //=== Output Gain
-    cb.outputGainDb = pChannel->getOutputGain();
+    return true;
 }
 
 size_t DPFrequency::processSamples(const float *in, float *out, size_t samples) {
@@ -381,8 +555,13 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
        }
 
        //**Check if parameters have changed and update
-       for (int ch = 0; ch < channelCount; ch++) {
-           updateParameters(mChannelBuffers[ch], ch);
+       const uint32_t generation = getParametersGeneration();
+       if (!mParametersApplied || generation != mAppliedGeneration) {
+           mParametersApplied = true;
+           mAppliedGeneration = generation;
+           for (int ch = 0; ch < channelCount; ch++) {
+               updateParameters(mChannelBuffers[ch], ch);
+           }
        }
 
        //**separate into channels
@@ -393,7 +572,11 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
        }
 
        //**process all channelBuffers
-       processChannelBuffers(mChannelBuffers);
+       if (mPartitioned) {
+           processPartitions(mChannelBuffers);
+       } else {
+           processChannelBuffers(mChannelBuffers);
+       }
 
        //** estimate how much data is available in ALL channels
        size_t available = mChannelBuffers[0].cBOutput.availableToRead();
@@ -519,52 +702,7 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
             // caused by the window used (expected for steady state signals)
             fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
 
-            // updates computed per frame advance.
-            float fTheta = 0.0;
-            float fFAttSec = pMbcBandParams->attackTimeMs / 1000; //in seconds
-            float fFRelSec = pMbcBandParams->releaseTimeMs / 1000; //in seconds
-
-            if (fEnergySum > pMbcBandParams->previousEnvelope) {
-                fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
-            } else {
-                fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
-            }
-
-            float fEnv = (1.0 - fTheta) * fEnergySum + fTheta * pMbcBandParams->previousEnvelope;
-            //preserve for next iteration
-            pMbcBandParams->previousEnvelope = fEnv;
-
-            if (fEnv < MIN_ENVELOPE) {
-                fEnv = MIN_ENVELOPE;
-            }
-            const float envDb = linearToDb(fEnv);
-            float newLevelDb = envDb;
-            //using shorter variables for code clarity
-            const float thresholdDb = pMbcBandParams->thresholdDb;
-            const float ratio = pMbcBandParams->ratio;
-            const float kneeWidthDbHalf = pMbcBandParams->kneeWidthDb / 2;
-            const float noiseGateThresholdDb = pMbcBandParams->noiseGateThresholdDb;
-            const float expanderRatio = pMbcBandParams->expanderRatio;
-
-            //find segment
-            if (envDb > thresholdDb + kneeWidthDbHalf) {
-                //compression segment
-                newLevelDb = envDb + ((1 / ratio) - 1) * (envDb - thresholdDb);
-            } else if (envDb > thresholdDb - kneeWidthDbHalf) {
-                //knee-compression segment
-                float temp = (envDb - thresholdDb + kneeWidthDbHalf);
-                newLevelDb = envDb + ((1 / ratio) - 1) *
-                        temp * temp / (kneeWidthDbHalf * 4);
-            } else if (envDb < noiseGateThresholdDb) {
-                //expander segment
-                newLevelDb = noiseGateThresholdDb -
-                        expanderRatio * (noiseGateThresholdDb - envDb);
-            }
-
-            float newFactor = dBtoLinear(newLevelDb - envDb);
-
-            //apply post gain.
-            newFactor *= dBtoLinear(pMbcBandParams->gainPostDb);
+            float newFactor = computeMbcFactor(*pMbcBandParams, fEnergySum);
 
             //apply to this band
             for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
@@ -591,37 +729,91 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
 
         //see explanation above for energy computation logic
         fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
-        float fTheta = 0.0;
-        float fFAttSec = cb.mLimiterParams.attackTimeMs / 1000; //in seconds
-        float fFRelSec = cb.mLimiterParams.releaseTimeMs / 1000; //in seconds
+        computeLimiterFactor(cb, fEnergySum);
 
-        if (fEnergySum > cb.mLimiterParams.previousEnvelope) {
-            fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
-        } else {
-            fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
-        }
+    } //end Limiter
+    return mBlockSize;
+}
+
+float DPFrequency::computeMbcFactor(ChannelBuffer::MbcBandParams &bp, float energy) {
+    // updates computed per frame advance.
+    float fTheta = 0.0;
+    float fFAttSec = bp.attackTimeMs / 1000; //in seconds
+    float fFRelSec = bp.releaseTimeMs / 1000; //in seconds
 
-        float fEnv = (1.0 - fTheta) * fEnergySum + fTheta * cb.mLimiterParams.previousEnvelope;
-        //preserve for next iteration
-        cb.mLimiterParams.previousEnvelope = fEnv;
+    if (energy > bp.previousEnvelope) {
+        fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
+    } else {
+        fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
+    }
 
-        const float envDb = linearToDb(fEnv);
-        float newFactorDb = 0;
-        //using shorter variables for code clarity
-        const float thresholdDb = cb.mLimiterParams.thresholdDb;
-        const float ratio = cb.mLimiterParams.ratio;
+    float fEnv = (1.0 - fTheta) * energy + fTheta * bp.previousEnvelope;
+    //preserve for next iteration
+    bp.previousEnvelope = fEnv;
 
-        if (envDb > thresholdDb) {
-            //limiter segment
-            newFactorDb = ((1 / ratio) - 1) * (envDb - thresholdDb);
-        }
+    if (fEnv < MIN_ENVELOPE) {
+        fEnv = MIN_ENVELOPE;
+    }
+    const float envDb = linearToDb(fEnv);
+    float newLevelDb = envDb;
+    //using shorter variables for code clarity
+    const float thresholdDb = bp.thresholdDb;
+    const float ratio = bp.ratio;
+    const float kneeWidthDbHalf = bp.kneeWidthDb / 2;
+    const float noiseGateThresholdDb = bp.noiseGateThresholdDb;
+    const float expanderRatio = bp.expanderRatio;
+
+    //find segment
+    if (envDb > thresholdDb + kneeWidthDbHalf) {
+        //compression segment
+        newLevelDb = envDb + ((1 / ratio) - 1) * (envDb - thresholdDb);
+    } else if (envDb > thresholdDb - kneeWidthDbHalf) {
+        //knee-compression segment
+        float temp = (envDb - thresholdDb + kneeWidthDbHalf);
+        newLevelDb = envDb + ((1 / ratio) - 1) *
+                temp * temp / (kneeWidthDbHalf * 4);
+    } else if (envDb < noiseGateThresholdDb) {
+        //expander segment
+        newLevelDb = noiseGateThresholdDb -
+                expanderRatio * (noiseGateThresholdDb - envDb);
+    }
 
-        float newFactor = dBtoLinear(newFactorDb);
+    float newFactor = dBtoLinear(newLevelDb - envDb);
 
-        cb.mLimiterParams.newFactor = newFactor;
+    //apply post gain.
+    newFactor *= dBtoLinear(bp.gainPostDb);
+    return newFactor;
+}
 
-    } //end Limiter
-    return mBlockSize;
+void DPFrequency::computeLimiterFactor(ChannelBuffer &cb, float energy) {
+    float fTheta = 0.0;
+    float fFAttSec = cb.mLimiterParams.attackTimeMs / 1000; //in seconds
+    float fFRelSec = cb.mLimiterParams.releaseTimeMs / 1000; //in seconds
+
+    if (energy > cb.mLimiterParams.previousEnvelope) {
+        fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
+    } else {
+        fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
+    }
+
+    float fEnv = (1.0 - fTheta) * energy + fTheta * cb.mLimiterParams.previousEnvelope;
+    //preserve for next iteration
+    cb.mLimiterParams.previousEnvelope = fEnv;
+
+    const float envDb = linearToDb(fEnv);
+    float newFactorDb = 0;
+    //using shorter variables for code clarity
+    const float thresholdDb = cb.mLimiterParams.thresholdDb;
+    const float ratio = cb.mLimiterParams.ratio;
+
+    if (envDb > thresholdDb) {
+        //limiter segment
+        newFactorDb = ((1 / ratio) - 1) * (envDb - thresholdDb);
+    }
+
+    float newFactor = dBtoLinear(newFactorDb);
+
+    cb.mLimiterParams.newFactor = newFactor;
 }
 
 void DPFrequency::processLinkedLimiters(CBufferVector &channelBuffers) {
@@ -674,4 +866,226 @@ size_t DPFrequency::processLastStages(ChannelBuffer &cb) {
     return mBlockSize;
 }
 
+//== Partitioned mode
+size_t DPFrequency::processPartitions(CBufferVector &channelBuffers) {
+    const int channelCount = channelBuffers.size();
+    size_t processedSamples = 0;
+
+    size_t available = channelBuffers[0].cBInput.availableToRead();
+    for (int ch = 1; ch < channelCount; ch++) {
+        available = std::min(available, channelBuffers[ch].cBInput.availableToRead());
+    }
+
+    while (available >= mPartitionSize) {
+        //First pass: fft, eq filter, mbc and limiter levels
+        for (int ch = 0; ch < channelCount; ch++) {
+            processedSamples += processFirstStagesPartitioned(channelBuffers[ch],
+                    mEqFilterSlots[ch]->acquire());
+        }
+
+        //**compute linked limiters and update levels if needed
+        processLinkedLimiters(channelBuffers);
+
+        //final pass: convolution, gains and ifft
+        for (int ch = 0; ch < channelCount; ch++) {
+            processLastStagesPartitioned(channelBuffers[ch]);
+        }
+        available -= mPartitionSize;
+    }
+    return processedSamples;
+}
+
+size_t DPFrequency::processFirstStagesPartitioned(ChannelBuffer &cb, const EqFilter &eqFilter) {
+    const size_t partitionSize = mPartitionSize;
+    const size_t blockSize = 2 * partitionSize;
+
+    //move previous partition and read new one
+    std::copy(cb.partInput.begin() + partitionSize, cb.partInput.end(), cb.partInput.begin());
+    for (size_t k = 0; k < partitionSize; k++) {
+        cb.partInput[partitionSize + k] = cb.cBInput.read();
+    }
+
+    //##fft, replacing the oldest spectrum of the frequency domain delay line
+    cb.mNewestInput = (cb.mNewestInput + mPartitionCount - 1) % mPartitionCount;
+    mHalfFftServer.fwd(cb.mInputSpectra[cb.mNewestInput].data(), &cb.partInput[0], blockSize);
+
+    //== Input gain, EqPre and EqPost: partitioned convolution, newest input with first
+    // filter partition. The last partition of the overlap-save block is the output.
+    const std::vector<Eigen::VectorXcf> &filter = eqFilter.partitions;
+    cb.complexTemp = filter[0].cwiseProduct(cb.mInputSpectra[cb.mNewestInput]);
+    for (size_t p = 1; p < filter.size(); p++) {
+        cb.complexTemp += filter[p].cwiseProduct(
+                cb.mInputSpectra[(cb.mNewestInput + p) % mPartitionCount]);
+    }
+    mHalfFftServer.inv(&cb.partTemp[0], cb.complexTemp.data(), blockSize);
+
+    //move tail of previous and append filtered partition
+    std::copy(cb.input.begin() + partitionSize, cb.input.end(), cb.input.begin());
+    std::copy(cb.partTemp.begin() + partitionSize, cb.partTemp.end(),
+            cb.input.begin() + partitionSize);
+
+    const bool mbcActive = cb.mMbcInUse && cb.mMbcEnabled;
+    const bool limiterActive = cb.mLimiterInUse && cb.mLimiterEnabled;
+    if (!mbcActive && !limiterActive) {
+        return partitionSize;
+    }
+
+    //##apply window and fft
+    Eigen::Map<Eigen::VectorXf> eWindow(&mVWindow[0], mVWindow.size());
+    Eigen::Map<Eigen::VectorXf> eInput(&cb.input[0], cb.input.size());
+    Eigen::Map<Eigen::VectorXf> eWin(&cb.partTemp[0], cb.partTemp.size());
+    eWin = eInput.cwiseProduct(eWindow);
+    mHalfFftServer.fwd(cb.complexTemp.data(), &cb.partTemp[0], blockSize);
+
+    //the eq factors have the resolution of the eq filter, the dynamics stages a coarser one.
+    const size_t binRatio = mBlockSize / blockSize;
+    const bool postEqActive = cb.mPostEqInUse && cb.mPostEqEnabled;
+
+    //== MBC
+    if (mbcActive) {
+        for (size_t band = 0; band < cb.mMbcBands.size(); band++) {
+            ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[band];
+            const size_t binStart = (pMbcBandParams->binStart + binRatio - 1) / binRatio;
+            const size_t binStop = std::min(pMbcBandParams->binStop / binRatio,
+                    mPartitionBins - 1);
+            float fEnergySum = 0;
+
+            //apply pre gain.
+            float preGainFactor = dBtoLinear(pMbcBandParams->gainPreDb);
+            float preGainSquared = preGainFactor * preGainFactor;
+
+            for (size_t k = binStart; k <= binStop; k++) {
+                float energy = std::norm(cb.complexTemp[k]) * preGainSquared;
+                //levels are estimated before EqPost, which the eq filter already applied.
+                if (postEqActive) {
+                    const float postEq = cb.mPostEqFactorVector[k * binRatio];
+                    energy /= postEq * postEq;
+                }
+                fEnergySum += energy;
+            }
+
+            //see processFirstStages() for the energy computation.
+            fEnergySum = sqrt(fEnergySum * 2) / (blockSize * mWindowRms);
+
+            float newFactor = computeMbcFactor(*pMbcBandParams, fEnergySum);
+            for (size_t k = binStart; k <= binStop; k++) {
+                cb.mPartGainVector[k] = newFactor;
+            }
+        }
+    }
+
+    //== Limiter. First Pass
+    if (limiterActive) {
+        float fEnergySum = 0;
+        for (size_t k = 0; k < mPartitionBins; k++) {
+            float energy = std::norm(cb.complexTemp[k]);
+            if (mbcActive) {
+                energy *= cb.mPartGainVector[k] * cb.mPartGainVector[k];
+            }
+            fEnergySum += energy;
+        }
+        fEnergySum = sqrt(fEnergySum * 2) / (blockSize * mWindowRms);
+        computeLimiterFactor(cb, fEnergySum);
+    }
+    return partitionSize;
+}
+
+size_t DPFrequency::processLastStagesPartitioned(ChannelBuffer &cb) {
+    const size_t partitionSize = mPartitionSize;
+
+    float outputGainFactor = dBtoLinear(cb.outputGainDb);
+    const bool mbcActive = cb.mMbcInUse && cb.mMbcEnabled;
+    const bool limiterActive = cb.mLimiterInUse && cb.mLimiterEnabled;
+    if (!mbcActive && !limiterActive) {
+        //no dynamics, output the filtered partition as is, keeping the same latency.
+        for (size_t k = 0; k < partitionSize; k++) {
+            cb.cBOutput.write(cb.input[k] * outputGainFactor);
+        }
+        std::fill(cb.outTail.begin(), cb.outTail.end(), 0);
+        return partitionSize;
+    }
+
+    //== Limiter. last Pass
+    if (limiterActive) {
+        //compute factor, with post-gain
+        float factor = cb.mLimiterParams.linkFactor * dBtoLinear(cb.mLimiterParams.postGainDb);
+        outputGainFactor *= factor;
+    }
+
+    //== MBC, with all the gains
+    if (mbcActive) {
+        for (size_t k = 0; k < mPartitionBins; k++) {
+            cb.complexTemp[k] *= cb.mPartGainVector[k] * outputGainFactor;
+        }
+    } else if (!compareEquality(outputGainFactor, 1.0f)) {
+        cb.complexTemp *= outputGainFactor;
+    }
+
+    //##ifft and resynthesis
+    mHalfFftServer.inv(&cb.output[0], cb.complexTemp.data(), 2 * partitionSize);
+    for (size_t k = 0; k < partitionSize; k++) {
+        cb.cBOutput.write(cb.output[k] * mVWindow[k] + cb.outTail[k]);
+        cb.outTail[k] = cb.output[partitionSize + k] * mVWindow[partitionSize + k];
+    }
+    return partitionSize;
+}
+
+EqFilter *DPFrequency::designEqFilter(ChannelBuffer &cb) {
+    ALOGV("designEqFilter");
+    cb.mEqChanged = false;
+    EqFilter *filter = new EqFilter;
+    const bool postEqActive = cb.mPostEqInUse && cb.mPostEqEnabled;
+
+    //magnitude response of input gain, preEq and postEq
+    bool flat = true;
+    const float firstGain = cb.mPreEqFactorVector[0] *
+            (postEqActive ? cb.mPostEqFactorVector[0] : 1.0f);
+    for (size_t k = 0; k < mHalfFFTSize; k++) {
+        float gain = cb.mPreEqFactorVector[k];
+        if (postEqActive) {
+            gain *= cb.mPostEqFactorVector[k];
+        }
+        flat &= compareEquality(gain, firstGain);
+        mDesignReal[k] = std::max(gain, MIN_ENVELOPE);
+    }
+
+    if (flat) {
+        //just a gain, a single partition is enough.
+        filter->partitions.assign(1, Eigen::VectorXcf::Constant(mPartitionBins, firstGain));
+        return filter;
+    }
+
+    //minimum phase filter with this magnitude response, so that the eq adds no latency:
+    //keep the causal part of the real cepstrum of the log magnitude. The cepstrum of band
+    //edges decays slowly, so it is computed with a finer resolution to limit aliasing.
+    const size_t designSize = mDesignReal.size();
+    const size_t designBins = mDesignSpectrum.size();
+    for (size_t k = 0; k < designBins; k++) {
+        mDesignSpectrum[k] = std::log(mDesignReal[k / DESIGN_OVERSAMPLE]);
+    }
+    mDesignFftServer.inv(&mDesignReal[0], mDesignSpectrum.data(), designSize);
+    const size_t half = designSize / 2;
+    for (size_t n = 1; n < half; n++) {
+        mDesignReal[n] *= 2;
+    }
+    std::fill(mDesignReal.begin() + half + 1, mDesignReal.end(), 0);
+    mDesignFftServer.fwd(mDesignSpectrum.data(), &mDesignReal[0], designSize);
+    for (size_t k = 0; k < designBins; k++) {
+        mDesignSpectrum[k] = std::exp(mDesignSpectrum[k]);
+    }
+    mDesignFftServer.inv(&mDesignReal[0], mDesignSpectrum.data(), designSize);
+
+    //split impulse response into partitions, zero padded to the overlap-save block size.
+    const size_t partitionSize = mPartitionSize;
+    filter->partitions.resize(mPartitionCount);
+    std::fill(mDesignTemp.begin() + partitionSize, mDesignTemp.end(), 0);
+    for (size_t p = 0; p < mPartitionCount; p++) {
+        std::copy(mDesignReal.begin() + p * partitionSize,
+                mDesignReal.begin() + (p + 1) * partitionSize, mDesignTemp.begin());
+        filter->partitions[p].resize(mPartitionBins);
+        mDesignFftServer.fwd(filter->partitions[p].data(), &mDesignTemp[0], 2 * partitionSize);
+    }
+    return filter;
+}
+
 } //namespace dp_fx
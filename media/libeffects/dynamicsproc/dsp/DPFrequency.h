@@ -18,6 +18,9 @@
 #ifndef DPFREQUENCY_H_
 #define DPFREQUENCY_H_
 
+#include <atomic>
+#include <memory>
+
 #include <Eigen/Dense>
 #include <unsupported/Eigen/FFT>
 
@@ -99,8 +102,20 @@ public:
     FloatVec mPreEqFactorVector; // temp pre-computed vector to shape spectrum at preEQ stage
     FloatVec mPostEqFactorVector; // temp pre-computed vector to shape spectrum at postEQ stage
 
+    //Partitioned mode. input, output and outTail are used by the dynamics stages.
+    bool mEqChanged;    // input gain, preEq or postEq changed, eq filter must be redesigned
+    FloatVec partInput; // last two partitions of input (overlap-save block)
+    FloatVec partTemp;  // time domain temp vector, two partitions
+    std::vector<Eigen::VectorXcf> mInputSpectra; // spectra of the last partitions of input
+    size_t mNewestInput; // index in mInputSpectra of the spectrum of the newest partition
+    FloatVec mPartGainVector; // per bin gain of the mbc stage, at partition resolution
+
     void initBuffers(unsigned int blockSize, unsigned int overlapSize, unsigned int halfFftSize,
             unsigned int samplingRate, DPBase &dpBase);
+    // parameters only, for the copy of the eq parameters kept by the control thread.
+    void initParameters(unsigned int blockSize, unsigned int halfFftSize,
+            unsigned int samplingRate, DPBase &dpBase);
+    void initPartitions(unsigned int partitionSize, unsigned int partitionCount);
     void computeBinStartStop(BandParams &bp, size_t binStart);
 private:
     unsigned int mSamplingRate;
@@ -110,6 +125,34 @@ private:
 
 using CBufferVector = std::vector<ChannelBuffer>;
 
+// Eq filter of the partitioned mode: half spectrum of each partition of the impulse response.
+// A single partition when it is just a gain.
+struct EqFilter {
+    std::vector<Eigen::VectorXcf> partitions;
+};
+
+// Hands the eq filters designed by the control thread over to the processing thread without
+// locks and without allocating or freeing memory on the processing thread. The filter replaced
+// by the processing thread is retired, and freed by the control thread on the next publish().
+class EqFilterSlot {
+public:
+    explicit EqFilterSlot(EqFilter *initial) : mActive(initial) {}
+    ~EqFilterSlot();
+    EqFilterSlot(const EqFilterSlot &) = delete;
+    EqFilterSlot &operator=(const EqFilterSlot &) = delete;
+
+    // control thread. Takes ownership of filter.
+    void publish(EqFilter *filter);
+    // processing thread. Returns the newest filter published, or the one in use until the
+    // control thread has freed the previous one.
+    const EqFilter &acquire();
+
+private:
+    std::atomic<EqFilter *> mPending{nullptr};
+    std::atomic<EqFilter *> mRetired{nullptr};
+    EqFilter *mActive; // only accessed by the processing thread once configured
+};
+
 using GroupsMap = std::map<int32_t, IntVec>;
 
 class LinkedLimiters {
@@ -124,12 +167,27 @@ class DPFrequency : public DPBase {
 public:
     virtual size_t processSamples(const float *in, float *out, size_t samples);
     virtual void reset();
+    // In partitioned mode, also designs the eq filters that changed, so that the processing
+    // thread only has to pick them up.
+    virtual void notifyParametersChanged();
     void configure(size_t blockSize, size_t overlapSize, size_t samplingRate);
+    // Uniformly partitioned mode, favoring time resolution: input is processed every
+    // partitionSize frames. Input gain, preEq and postEq keep the frequency resolution of
+    // blockSize: they are applied by a minimum phase filter of blockSize taps, split into
+    // partitions of partitionSize and convolved with overlap-save. Mbc and limiter run on
+    // windowed blocks of two partitions. Latency is partitionSize instead of blockSize, and
+    // the cost of processing is spread evenly over the callbacks.
+    void configurePartitioned(size_t blockSize, size_t partitionSize, size_t samplingRate);
+    static constexpr size_t kDefaultPartitionCount = 8; // partitions of blockSize, for callers
+    bool isPartitioned() const {
+        return mPartitioned;
+    }
     static size_t getMinBockSize();
     static size_t getMaxBockSize();
 
 private:
     void updateParameters(ChannelBuffer &cb, int channelIndex);
+    bool updateEqParameters(ChannelBuffer &cb, DPChannel &channel, int channelIndex);
     size_t processMono(ChannelBuffer &cb);
     size_t processOneVector(FloatVec &output, FloatVec &input, ChannelBuffer &cb);
 
@@ -138,11 +196,30 @@ private:
     size_t processLastStages(ChannelBuffer &cb);
     void processLinkedLimiters(CBufferVector &channelBuffers);
 
+    float computeMbcFactor(ChannelBuffer::MbcBandParams &bp, float energy);
+    void computeLimiterFactor(ChannelBuffer &cb, float energy);
+
+    size_t processPartitions(CBufferVector &channelBuffers);
+    size_t processFirstStagesPartitioned(ChannelBuffer &cb, const EqFilter &eqFilter);
+    size_t processLastStagesPartitioned(ChannelBuffer &cb);
+    void updateEqFilters(bool force);
+    EqFilter *designEqFilter(ChannelBuffer &cb);
+    void computeWindow(size_t size, size_t overlap);
+    void prepareFftPlans();
+
     size_t mBlockSize;
     size_t mHalfFFTSize;
     size_t mOverlapSize;
     size_t mSamplingRate;
 
+    bool mPartitioned = false;
+    size_t mPartitionSize;
+    size_t mPartitionCount;
+    size_t mPartitionBins; // bins in half spectrum of a partition, including Nyquist bin
+
+    bool mParametersApplied = false;
+    uint32_t mAppliedGeneration;
+
     float mBlocksPerSecond;
 
     CBufferVector mChannelBuffers;
@@ -152,7 +229,20 @@ private:
     //dsp
     FloatVec mVWindow;  //window class.
     float mWindowRms;
+    // Eigen::FFT keeps the plan of every size it has been used with. prepareFftPlans() builds
+    // the plans of the sizes in use when configuring, so that processing does not allocate
+    // and reconfiguring to a size used before reuses its plan.
     Eigen::FFT<float> mFftServer;
+    Eigen::FFT<float> mHalfFftServer; // real transforms using half spectra
+
+    //eq filter design, on the control thread. Eigen::FFT has scratch buffers, so the control
+    //thread has its own, as well as its own copy of the eq parameters of each channel.
+    std::vector<std::unique_ptr<EqFilterSlot>> mEqFilterSlots;
+    CBufferVector mDesignChannels;
+    Eigen::FFT<float> mDesignFftServer;
+    FloatVec mDesignReal; // sized by blockSize
+    Eigen::VectorXcf mDesignSpectrum;
+    FloatVec mDesignTemp; // two partitions
 };
 
 } //namespace dp_fx
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <dsp/DPFrequency.h>
+
+static constexpr int kSampleRate = 48000;
+static constexpr size_t kFrameCount = 128;
+static constexpr size_t kBlockSize = 1024;
+static constexpr size_t kPartitionSize = 128;
+static constexpr uint32_t kChannelCount = 2;
+
+enum Stages {
+    PRE_EQ = 1 << 0,
+    MBC = 1 << 1,
+    POST_EQ = 1 << 2,
+    LIMITER = 1 << 3,
+    ALL = PRE_EQ | MBC | POST_EQ | LIMITER,
+};
+
+static void setupChannels(dp_fx::DPFrequency& dp, int stages) {
+    dp.init(kChannelCount, stages & PRE_EQ, 2 /*preEqBandCount*/, stages & MBC,
+            2 /*mbcBandCount*/, stages & POST_EQ, 2 /*postEqBandCount*/, stages & LIMITER);
+    for (uint32_t ch = 0; ch < kChannelCount; ch++) {
+        dp_fx::DPChannel* channel = dp.getChannel(ch);
+        dp_fx::DPEqBand eqBand;
+        dp_fx::DPMbcBand mbcBand;
+        if (stages & PRE_EQ) {
+            channel->getPreEq()->setEnabled(true);
+            eqBand.init(true /*enabled*/, 1000 /*cutoffHz*/, -12 /*gainDb*/);
+            channel->getPreEq()->setBand(0, eqBand);
+            eqBand.init(true /*enabled*/, 24000 /*cutoffHz*/, 0 /*gainDb*/);
+            channel->getPreEq()->setBand(1, eqBand);
+        }
+        if (stages & MBC) {
+            channel->getMbc()->setEnabled(true);
+            for (uint32_t b = 0; b < 2; b++) {
+                mbcBand.init(true /*enabled*/, b == 0 ? 2000 : 24000 /*cutoffHz*/,
+                             3 /*attackTimeMs*/, 80 /*releaseTimeMs*/, 4 /*ratio*/,
+                             -30 /*thresholdDb*/, 0 /*kneeWidthDb*/,
+                             -90 /*noiseGateThresholdDb*/, 1 /*expanderRatio*/,
+                             0 /*preGainDb*/, 0 /*postGainDb*/);
+                channel->getMbc()->setBand(b, mbcBand);
+            }
+        }
+        if (stages & POST_EQ) {
+            channel->getPostEq()->setEnabled(true);
+            eqBand.init(true /*enabled*/, 4000 /*cutoffHz*/, 0 /*gainDb*/);
+            channel->getPostEq()->setBand(0, eqBand);
+            eqBand.init(true /*enabled*/, 24000 /*cutoffHz*/, 6 /*gainDb*/);
+            channel->getPostEq()->setBand(1, eqBand);
+        }
+        if (stages & LIMITER) {
+            dp_fx::DPLimiter limiter;
+            limiter.init(true /*inUse*/, true /*enabled*/, 0 /*linkGroup*/, 1 /*attackTimeMs*/,
+                         60 /*releaseTimeMs*/, 10 /*ratio*/, -20 /*thresholdDb*/,
+                         0 /*postGainDb*/);
+            channel->setLimiter(limiter);
+        }
+    }
+    dp.notifyParametersChanged();
+}
+
+// Processes a sine on all channels and returns the amplitude of the output, measured over the
+// second half of the run once the dynamics have settled.
+static float processSine(dp_fx::DPFrequency& dp, float frequencyHz, float seconds) {
+    std::vector<float> buffer(kFrameCount * kChannelCount);
+    const size_t callbacks = seconds * kSampleRate / kFrameCount;
+    double energy = 0;
+    size_t count = 0;
+    size_t n = 0;
+    for (size_t i = 0; i < callbacks; i++) {
+        for (size_t f = 0; f < kFrameCount; f++, n++) {
+            const float sample = 0.5f * std::sin(2 * M_PI * frequencyHz * n / kSampleRate);
+            for (uint32_t ch = 0; ch < kChannelCount; ch++) {
+                buffer[f * kChannelCount + ch] = sample;
+            }
+        }
+        dp.processSamples(buffer.data(), buffer.data(), buffer.size());
+        if (i > callbacks / 2) {
+            for (float sample : buffer) {
+                energy += sample * sample;
+            }
+            count += buffer.size();
+        }
+    }
+    return std::sqrt(2 * energy / count);
+}
+
+class DPFrequencyPartitionedTest : public ::testing::TestWithParam<std::tuple<int, float>> {};
+
+// The partitioned mode applies the same eq, and levels the dynamics stages estimate from the
+// same signal, as the block mode.
+TEST_P(DPFrequencyPartitionedTest, MatchesBlockMode) {
+    const auto [stages, frequencyHz] = GetParam();
+    dp_fx::DPFrequency block;
+    setupChannels(block, stages);
+    block.configure(kBlockSize, kBlockSize / 2 /*overlapSize*/, kSampleRate);
+    dp_fx::DPFrequency partitioned;
+    setupChannels(partitioned, stages);
+    partitioned.configurePartitioned(kBlockSize, kPartitionSize, kSampleRate);
+
+    const float blockLevel = processSine(block, frequencyHz, 2 /*seconds*/);
+    const float partitionedLevel = processSine(partitioned, frequencyHz, 2 /*seconds*/);
+    EXPECT_NEAR(0.0f, 20 * std::log10(partitionedLevel / blockLevel), 0.1f /*dB*/)
+            << "block " << blockLevel << " partitioned " << partitionedLevel;
+}
+
+INSTANTIATE_TEST_SUITE_P(DPFrequency, DPFrequencyPartitionedTest,
+                         ::testing::Combine(::testing::Values(PRE_EQ, MBC, POST_EQ, LIMITER, ALL),
+                                            ::testing::Values(300.0f, 6000.0f)));
+
+// A gain alone is a single partition filter: exact, with a latency of one partition.
+TEST(DPFrequencyTest, PartitionedGainIsExact) {
+    dp_fx::DPFrequency dp;
+    dp.init(kChannelCount, false, 0, false, 0, false, 0, false);
+    for (uint32_t ch = 0; ch < kChannelCount; ch++) {
+        dp.getChannel(ch)->setInputGain(20 * std::log10(2.0f));
+    }
+    dp.notifyParametersChanged();
+    dp.configurePartitioned(kBlockSize, kPartitionSize, kSampleRate);
+
+    const size_t samples = kPartitionSize * kChannelCount;
+    std::vector<float> input(samples), output(samples), previous(samples, 0);
+    for (size_t i = 0; i < 20; i++) {
+        for (size_t k = 0; k < samples; k++) {
+            input[k] = std::sin(i * samples + k);
+        }
+        dp.processSamples(input.data(), output.data(), samples);
+        for (size_t k = 0; k < samples; k++) {
+            ASSERT_NEAR(2 * previous[k], output[k], 1e-5f) << "callback " << i << " sample " << k;
+        }
+        previous = input;
+    }
+}
+
+// The eq filter is designed when the parameters are notified, and not before.
+TEST(DPFrequencyTest, PartitionedEqChangeAppliesAfterNotify) {
+    dp_fx::DPFrequency dp;
+    setupChannels(dp, PRE_EQ);
+    dp.configurePartitioned(kBlockSize, kPartitionSize, kSampleRate);
+    const float before = processSine(dp, 300, 1 /*seconds*/);
+    EXPECT_NEAR(-12, 20 * std::log10(before / 0.5f), 0.1f);
+
+    dp_fx::DPEqBand eqBand;
+    eqBand.init(true /*enabled*/, 1000 /*cutoffHz*/, -6 /*gainDb*/);
+    for (uint32_t ch = 0; ch < kChannelCount; ch++) {
+        dp.getChannel(ch)->getPreEq()->setBand(0, eqBand);
+    }
+    EXPECT_FLOAT_EQ(before, processSine(dp, 300, 1 /*seconds*/));
+
+    dp.notifyParametersChanged();
+    const float after = processSine(dp, 300, 1 /*seconds*/);
+    EXPECT_NEAR(-6, 20 * std::log10(after / 0.5f), 0.1f);
+}
+
+// Filters published by one thread are picked up by the other in order, up to the newest one.
+// Run under ASan to also check that each filter is freed once, and by the publishing thread.
+TEST(DPFrequencyTest, EqFilterSlotHandsOverFilters) {
+    const auto gainFilter = [](float gain) {
+        dp_fx::EqFilter* filter = new dp_fx::EqFilter;
+        filter->partitions.assign(1, Eigen::VectorXcf::Constant(1, gain));
+        return filter;
+    };
+    constexpr int kPublishCount = 10000;
+    dp_fx::EqFilterSlot slot(gainFilter(0));
+    std::atomic<bool> done{false};
+    std::thread consumer([&] {
+        float last = 0;
+        while (!done) {
+            const float gain = slot.acquire().partitions[0][0].real();
+            EXPECT_GE(gain, last);
+            last = gain;
+        }
+    });
+    for (int i = 1; i <= kPublishCount; i++) {
+        slot.publish(gainFilter(i));
+    }
+    done = true;
+    consumer.join();
+    slot.publish(gainFilter(kPublishCount + 1));  // frees the filter retired by the consumer
+    EXPECT_EQ(kPublishCount + 1, slot.acquire().partitions[0][0].real());
+}
@@ -21,6 +21,7 @@
 
 #include "Mixer_private.h"
 #include "LVM_Macros.h"
+#include "LVM_Simd.h"
 
 /**********************************************************************************
    FUNCTION CORE_MIXHARD_2ST_D32C31_SAT
@@ -28,14 +29,30 @@
 void Core_MixHard_2St_D32C31_SAT(Mix_2St_Cll_FLOAT_t* pInstance, const LVM_FLOAT* src1,
                                  const LVM_FLOAT* src2, LVM_FLOAT* dst, LVM_INT16 n) {
     LVM_FLOAT Temp1, Temp2, Temp3;
-    LVM_INT16 ii;
+    LVM_INT16 ii = n;
     LVM_FLOAT Current1Short;
     LVM_FLOAT Current2Short;
 
     Current1Short = (pInstance->Current1);
     Current2Short = (pInstance->Current2);
 
-    for (ii = n; ii != 0; ii--) {
+#ifdef LVM_SIMD
+    /* Saturating twice the halved sum matches the comparisons with +-0.5 below. */
+    const LVM_FLOAT4 Gain1 = LVM_Dup4(Current1Short);
+    const LVM_FLOAT4 Gain2 = LVM_Dup4(Current2Short);
+    const LVM_FLOAT4 Half = LVM_Dup4(0.5f);
+    const LVM_FLOAT4 Two = LVM_Dup4(2.0f);
+    for (; ii >= 4; ii -= 4) {
+        LVM_FLOAT4 Mix1 = LVM_Mul4(LVM_Mul4(LVM_Load4(src1), Gain1), Half);
+        LVM_FLOAT4 Mix2 = LVM_Mul4(LVM_Mul4(LVM_Load4(src2), Gain2), Half);
+        LVM_Store4(dst, LVM_Saturate4(LVM_Mul4(LVM_Add4(Mix2, Mix1), Two)));
+        src1 += 4;
+        src2 += 4;
+        dst += 4;
+    }
+#endif
+
+    for (; ii != 0; ii--) {
         Temp1 = *src1++;
         Temp3 = Temp1 * Current1Short;
         Temp2 = *src2++;
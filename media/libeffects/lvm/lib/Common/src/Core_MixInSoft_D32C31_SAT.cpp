@@ -20,6 +20,7 @@
 ***********************************************************************************/
 #include "Mixer_private.h"
 #include "LVM_Macros.h"
+#include "LVM_Simd.h"
 #include "ScalarArithmetic.h"
 
 /**********************************************************************************
@@ -33,7 +34,7 @@ void Core_MixInSoft_D32C31_SAT(Mix_1St_Cll_FLOAT_t* pInstance, const LVM_FLOAT*
     LVM_INT16 InLoop;
     LVM_FLOAT TargetTimesOneMinAlpha;
     LVM_FLOAT CurrentTimesAlpha;
-    LVM_INT16 ii, jj;
+    LVM_INT16 ii;
 
     InLoop = (LVM_INT16)(n >> 2); /* Process per 4 samples */
     OutLoop = (LVM_INT16)(n - (InLoop << 2));
@@ -60,13 +61,9 @@ void Core_MixInSoft_D32C31_SAT(Mix_1St_Cll_FLOAT_t* pInstance, const LVM_FLOAT*
         CurrentTimesAlpha = pInstance->Current * pInstance->Alpha;
         pInstance->Current = TargetTimesOneMinAlpha + CurrentTimesAlpha;
 
-        for (jj = 4; jj != 0; jj--) {
-            Temp1 = *src++;
-            Temp2 = *dst;
-
-            Temp3 = Temp1 * (pInstance->Current);
-            *dst++ = LVM_Clamp(Temp2 + Temp3);
-        }
+        LVM_MacGainSat_Float(src, pInstance->Current, dst, 4);
+        src += 4;
+        dst += 4;
     }
 }
 /**********************************************************************************/
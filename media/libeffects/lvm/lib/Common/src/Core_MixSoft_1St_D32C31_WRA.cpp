@@ -21,6 +21,7 @@
 
 #include "Mixer_private.h"
 #include "LVM_Macros.h"
+#include "LVM_Simd.h"
 
 /**********************************************************************************
    FUNCTION CORE_MIXSOFT_1ST_D32C31_WRA
@@ -62,32 +63,9 @@ void Core_MixSoft_1St_D32C31_WRA(Mix_1St_Cll_FLOAT_t* pInstance, const LVM_FLOAT
         CurrentTimesAlpha = pInstance->Current * pInstance->Alpha;
         pInstance->Current = TargetTimesOneMinAlpha + CurrentTimesAlpha;
 
-        Temp1 = *src;
-        src++;
-
-        Temp2 = Temp1 * (pInstance->Current);
-        *dst = Temp2;
-        dst++;
-
-        Temp1 = *src;
-        src++;
-
-        Temp2 = Temp1 * (pInstance->Current);
-        *dst = Temp2;
-        dst++;
-
-        Temp1 = *src;
-        src++;
-
-        Temp2 = Temp1 * (pInstance->Current);
-        *dst = Temp2;
-        dst++;
-
-        Temp1 = *src;
-        src++;
-        Temp2 = Temp1 * (pInstance->Current);
-        *dst = Temp2;
-        dst++;
+        LVM_MulGain_Float(src, pInstance->Current, dst, 4);
+        src += 4;
+        dst += 4;
     }
 }
 /**********************************************************************************/
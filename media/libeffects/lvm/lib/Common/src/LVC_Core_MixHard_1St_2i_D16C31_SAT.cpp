@@ -20,12 +20,31 @@
 ***********************************************************************************/
 #include "LVC_Mixer_Private.h"
 #include "LVM_Macros.h"
+#include "LVM_Simd.h"
 #include "ScalarArithmetic.h"
 
 void LVC_Core_MixHard_1St_MC_float_SAT(Mix_Private_FLOAT_st** ptrInstance, const LVM_FLOAT* src,
                                        LVM_FLOAT* dst, LVM_INT16 NrFrames, LVM_INT16 NrChannels) {
     LVM_FLOAT Temp;
     LVM_INT16 ii, jj;
+#ifdef LVM_SIMD
+    if (NrChannels == 1 || NrChannels == 2 || NrChannels == 4) {
+        /* The gains repeat every NrChannels samples, so every 4 samples. */
+        LVM_FLOAT Gains[4];
+        for (jj = 0; jj < 4; jj++) {
+            Gains[jj] = ptrInstance[jj % NrChannels]->Current;
+        }
+        const LVM_FLOAT4 Gain = LVM_Load4(Gains);
+        LVM_INT32 NrSamples = (LVM_INT32)NrFrames * NrChannels;
+        for (; NrSamples >= 4; NrSamples -= 4) {
+            LVM_Store4(dst, LVM_Clamp4(LVM_Mul4(LVM_Load4(src), Gain)));
+            src += 4;
+            dst += 4;
+        }
+        /* The remaining samples are whole frames. */
+        NrFrames = (LVM_INT16)(NrSamples / NrChannels);
+    }
+#endif
     for (ii = NrFrames; ii != 0; ii--) {
         for (jj = 0; jj < NrChannels; jj++) {
             Mix_Private_FLOAT_st* pInstance1 = (Mix_Private_FLOAT_st*)(ptrInstance[jj]);
@@ -19,6 +19,7 @@
    INCLUDE FILES
 ***********************************************************************************/
 #include "LVC_Mixer_Private.h"
+#include "LVM_Simd.h"
 #include "ScalarArithmetic.h"
 
 /**********************************************************************************
@@ -28,7 +29,7 @@ void LVC_Core_MixHard_2St_D16C31_SAT(LVMixer3_FLOAT_st* ptrInstance1,
                                      LVMixer3_FLOAT_st* ptrInstance2, const LVM_FLOAT* src1,
                                      const LVM_FLOAT* src2, LVM_FLOAT* dst, LVM_INT16 n) {
     LVM_FLOAT Temp;
-    LVM_INT16 ii;
+    LVM_INT16 ii = n;
     LVM_FLOAT Current1;
     LVM_FLOAT Current2;
     Mix_Private_FLOAT_st* pInstance1 = (Mix_Private_FLOAT_st*)(ptrInstance1->PrivateParams);
@@ -37,7 +38,20 @@ void LVC_Core_MixHard_2St_D16C31_SAT(LVMixer3_FLOAT_st* ptrInstance1,
     Current1 = pInstance1->Current;
     Current2 = pInstance2->Current;
 
-    for (ii = n; ii != 0; ii--) {
+#ifdef LVM_SIMD
+    const LVM_FLOAT4 Gain1 = LVM_Dup4(Current1);
+    const LVM_FLOAT4 Gain2 = LVM_Dup4(Current2);
+    for (; ii >= 4; ii -= 4) {
+        LVM_FLOAT4 Temp4 = LVM_Add4(LVM_Mul4(LVM_Load4(src1), Gain1),
+                                    LVM_Mul4(LVM_Load4(src2), Gain2));
+        LVM_Store4(dst, LVM_Clamp4(Temp4));
+        src1 += 4;
+        src2 += 4;
+        dst += 4;
+    }
+#endif
+
+    for (; ii != 0; ii--) {
         Temp =  *src1++ * Current1 + *src2++ * Current2;
         *dst++ = LVM_Clamp(Temp);
     }
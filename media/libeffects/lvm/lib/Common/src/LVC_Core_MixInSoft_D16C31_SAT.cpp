@@ -20,6 +20,7 @@
 ***********************************************************************************/
 #include "LVC_Mixer_Private.h"
 #include "LVM_Macros.h"
+#include "LVM_Simd.h"
 #include "ScalarArithmetic.h"
 
 /**********************************************************************************
@@ -29,7 +30,7 @@ void LVC_Core_MixInSoft_D16C31_SAT(LVMixer3_FLOAT_st* ptrInstance, const LVM_FLO
                                    LVM_FLOAT* dst, LVM_INT16 n) {
     LVM_INT16 OutLoop;
     LVM_INT16 InLoop;
-    LVM_INT32 ii, jj;
+    LVM_INT32 ii;
     Mix_Private_FLOAT_st* pInstance = (Mix_Private_FLOAT_st*)(ptrInstance->PrivateParams);
     LVM_FLOAT Delta = pInstance->Delta;
     LVM_FLOAT Current = pInstance->Current;
@@ -56,10 +57,9 @@ void LVC_Core_MixInSoft_D16C31_SAT(LVMixer3_FLOAT_st* ptrInstance, const LVM_FLO
             Current = Temp;
             if (Current > Target) Current = Target;
 
-            for (jj = 4; jj != 0; jj--) {
-                Temp = *dst + *src++ * Current;
-                *dst++ = LVM_Clamp(Temp);
-            }
+            LVM_MacGainSat_Float(src, Current, dst, 4);
+            src += 4;
+            dst += 4;
         }
     } else {
         if (OutLoop) {
@@ -76,10 +76,9 @@ void LVC_Core_MixInSoft_D16C31_SAT(LVMixer3_FLOAT_st* ptrInstance, const LVM_FLO
             Current -= Delta;
             if (Current < Target) Current = Target;
 
-            for (jj = 4; jj != 0; jj--) {
-                Temp = *dst + *src++ * Current;
-                *dst++ = LVM_Clamp(Temp);
-            }
+            LVM_MacGainSat_Float(src, Current, dst, 4);
+            src += 4;
+            dst += 4;
         }
     }
     pInstance->Current = Current;
@@ -105,7 +104,7 @@ void LVC_Core_MixInSoft_Mc_D16C31_SAT(LVMixer3_FLOAT_st* ptrInstance, const LVM_
                                       LVM_FLOAT* dst, LVM_INT16 NrFrames, LVM_INT16 NrChannels) {
     LVM_INT16 OutLoop;
     LVM_INT16 InLoop;
-    LVM_INT32 ii, jj;
+    LVM_INT32 ii;
     Mix_Private_FLOAT_st* pInstance = (Mix_Private_FLOAT_st*)(ptrInstance->PrivateParams);
     LVM_FLOAT Delta = pInstance->Delta;
     LVM_FLOAT Current = pInstance->Current;
@@ -138,13 +137,9 @@ void LVC_Core_MixInSoft_Mc_D16C31_SAT(LVMixer3_FLOAT_st* ptrInstance, const LVM_
             Current = Temp;
             if (Current > Target) Current = Target;
 
-            for (jj = NrChannels; jj != 0; jj--) {
-                Temp = *dst + *src++ * Current;
-                *dst++ = LVM_Clamp(Temp);
-
-                Temp = *dst + *src++ * Current;
-                *dst++ = LVM_Clamp(Temp);
-            }
+            LVM_MacGainSat_Float(src, Current, dst, 2 * NrChannels);
+            src += 2 * NrChannels;
+            dst += 2 * NrChannels;
         }
     } else {
         if (OutLoop) {
@@ -161,13 +156,9 @@ void LVC_Core_MixInSoft_Mc_D16C31_SAT(LVMixer3_FLOAT_st* ptrInstance, const LVM_
             Current -= Delta;
             if (Current < Target) Current = Target;
 
-            for (jj = NrChannels; jj != 0; jj--) {
-                Temp = *dst + *src++ * Current;
-                *dst++ = LVM_Clamp(Temp);
-
-                Temp = *dst + *src++ * Current;
-                *dst++ = LVM_Clamp(Temp);
-            }
+            LVM_MacGainSat_Float(src, Current, dst, 2 * NrChannels);
+            src += 2 * NrChannels;
+            dst += 2 * NrChannels;
         }
     }
     pInstance->Current = Current;
@@ -20,6 +20,7 @@
 ***********************************************************************************/
 #include "LVC_Mixer_Private.h"
 #include "LVM_Macros.h"
+#include "LVM_Simd.h"
 #include "ScalarArithmetic.h"
 
 /**********************************************************************************
@@ -53,10 +54,9 @@ void LVC_Core_MixSoft_1St_D16C31_WRA(LVMixer3_FLOAT_st* ptrInstance, const LVM_F
 
             if (Current > Target) Current = Target;
 
-            *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-            *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-            *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-            *(dst++) = (((LVM_FLOAT) * (src++) * Current));
+            LVM_MulGain_Float(src, Current, dst, 4);
+            src += 4;
+            dst += 4;
         }
     } else {
         if (OutLoop) {
@@ -72,10 +72,9 @@ void LVC_Core_MixSoft_1St_D16C31_WRA(LVMixer3_FLOAT_st* ptrInstance, const LVM_F
             Current -= Delta;
             if (Current < Target) Current = Target;
 
-            *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-            *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-            *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-            *(dst++) = (((LVM_FLOAT) * (src++) * Current));
+            LVM_MulGain_Float(src, Current, dst, 4);
+            src += 4;
+            dst += 4;
         }
     }
     pInstance->Current = Current;
@@ -133,10 +132,9 @@ void LVC_Core_MixSoft_Mc_D16C31_WRA(LVMixer3_FLOAT_st* ptrInstance, const LVM_FL
             Current = LVM_Clamp(Current + Delta);
             if (Current > Target) Current = Target;
 
-            for (jj = NrChannels; jj != 0; jj--) {
-                *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-                *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-            }
+            LVM_MulGain_Float(src, Current, dst, 2 * NrChannels);
+            src += 2 * NrChannels;
+            dst += 2 * NrChannels;
         }
     } else {
         if (OutLoop) {
@@ -154,10 +152,9 @@ void LVC_Core_MixSoft_Mc_D16C31_WRA(LVMixer3_FLOAT_st* ptrInstance, const LVM_FL
             Current -= Delta;
             if (Current < Target) Current = Target;
 
-            for (jj = NrChannels; jj != 0; jj--) {
-                *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-                *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-            }
+            LVM_MulGain_Float(src, Current, dst, 2 * NrChannels);
+            src += 2 * NrChannels;
+            dst += 2 * NrChannels;
         }
     }
     pInstance->Current = Current;
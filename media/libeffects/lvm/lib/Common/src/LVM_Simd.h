@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LVM_SIMD_H__
+#define __LVM_SIMD_H__
+
+/**********************************************************************************
+   INCLUDE FILES
+***********************************************************************************/
+
+#include "LVM_Types.h"
+#include "ScalarArithmetic.h"
+
+/**********************************************************************************
+   DEFINITIONS
+***********************************************************************************/
+
+/*
+ * Four lane float vectors for the mixer and arithmetic kernels, selected at build
+ * time. Every operation rounds like its scalar counterpart, and LVM_Clamp4() treats
+ * NaN like LVM_Clamp(), so the vectorized kernels produce bit-exact output.
+ *
+ * ARMv7 NEON flushes denormals to zero, so it is not used. Define LVM_NO_SIMD to
+ * build the scalar kernels only; LvmSimdTest compares them with the vectorized ones.
+ */
+#if !defined(LVM_NO_SIMD) && defined(__aarch64__)
+#include <arm_neon.h>
+#define LVM_SIMD 1
+typedef float32x4_t LVM_FLOAT4;
+#elif !defined(LVM_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define LVM_SIMD 1
+typedef __m128 LVM_FLOAT4;
+#endif
+
+#ifdef LVM_SIMD
+
+#if defined(__aarch64__)
+
+static inline LVM_FLOAT4 LVM_Load4(const LVM_FLOAT* src) {
+    return vld1q_f32(src);
+}
+
+static inline void LVM_Store4(LVM_FLOAT* dst, LVM_FLOAT4 val) {
+    vst1q_f32(dst, val);
+}
+
+static inline LVM_FLOAT4 LVM_Dup4(LVM_FLOAT val) {
+    return vdupq_n_f32(val);
+}
+
+static inline LVM_FLOAT4 LVM_Add4(LVM_FLOAT4 a, LVM_FLOAT4 b) {
+    return vaddq_f32(a, b);
+}
+
+static inline LVM_FLOAT4 LVM_Mul4(LVM_FLOAT4 a, LVM_FLOAT4 b) {
+    return vmulq_f32(a, b);
+}
+
+/* fmin(fmax(val, -1.0f), 1.0f) */
+static inline LVM_FLOAT4 LVM_Clamp4(LVM_FLOAT4 val) {
+    return vminnmq_f32(vmaxnmq_f32(val, vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+}
+
+/* Clamps to [-1.0f, 1.0f] like LVM_Clamp4(), but keeps NaN */
+static inline LVM_FLOAT4 LVM_Saturate4(LVM_FLOAT4 val) {
+    return vminq_f32(vmaxq_f32(val, vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+}
+
+#else /* __SSE2__ */
+
+static inline LVM_FLOAT4 LVM_Load4(const LVM_FLOAT* src) {
+    return _mm_loadu_ps(src);
+}
+
+static inline void LVM_Store4(LVM_FLOAT* dst, LVM_FLOAT4 val) {
+    _mm_storeu_ps(dst, val);
+}
+
+static inline LVM_FLOAT4 LVM_Dup4(LVM_FLOAT val) {
+    return _mm_set1_ps(val);
+}
+
+static inline LVM_FLOAT4 LVM_Add4(LVM_FLOAT4 a, LVM_FLOAT4 b) {
+    return _mm_add_ps(a, b);
+}
+
+static inline LVM_FLOAT4 LVM_Mul4(LVM_FLOAT4 a, LVM_FLOAT4 b) {
+    return _mm_mul_ps(a, b);
+}
+
+/* fmin(fmax(val, -1.0f), 1.0f); maxps and minps return the second operand for NaN */
+static inline LVM_FLOAT4 LVM_Clamp4(LVM_FLOAT4 val) {
+    return _mm_min_ps(_mm_max_ps(val, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+}
+
+/* Clamps to [-1.0f, 1.0f] like LVM_Clamp4(), but keeps NaN */
+static inline LVM_FLOAT4 LVM_Saturate4(LVM_FLOAT4 val) {
+    return _mm_min_ps(_mm_set1_ps(1.0f), _mm_max_ps(_mm_set1_ps(-1.0f), val));
+}
+
+#endif
+
+#endif /* LVM_SIMD */
+
+/*
+ * Kernels shared by the mixers, vectorized when LVM_SIMD is available.
+ */
+
+/* dst[i] = src[i] * gain */
+static inline void LVM_MulGain_Float(const LVM_FLOAT* src, LVM_FLOAT gain, LVM_FLOAT* dst,
+                                     LVM_INT32 n) {
+    LVM_INT32 ii = 0;
+#ifdef LVM_SIMD
+    const LVM_FLOAT4 Gain = LVM_Dup4(gain);
+    for (; ii + 4 <= n; ii += 4) {
+        LVM_Store4(dst + ii, LVM_Mul4(LVM_Load4(src + ii), Gain));
+    }
+#endif
+    for (; ii < n; ii++) {
+        dst[ii] = src[ii] * gain;
+    }
+}
+
+/* dst[i] = LVM_Clamp(dst[i] + src[i] * gain) */
+static inline void LVM_MacGainSat_Float(const LVM_FLOAT* src, LVM_FLOAT gain, LVM_FLOAT* dst,
+                                        LVM_INT32 n) {
+    LVM_INT32 ii = 0;
+#ifdef LVM_SIMD
+    const LVM_FLOAT4 Gain = LVM_Dup4(gain);
+    for (; ii + 4 <= n; ii += 4) {
+        LVM_FLOAT4 Temp = LVM_Add4(LVM_Load4(dst + ii), LVM_Mul4(LVM_Load4(src + ii), Gain));
+        LVM_Store4(dst + ii, LVM_Clamp4(Temp));
+    }
+#endif
+    for (; ii < n; ii++) {
+        dst[ii] = LVM_Clamp(dst[ii] + src[ii] * gain);
+    }
+}
+
+#endif /* __LVM_SIMD_H__ */
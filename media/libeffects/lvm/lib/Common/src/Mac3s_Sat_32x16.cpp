@@ -21,11 +21,22 @@
 #include "ScalarArithmetic.h"
 #include "VectorArithmetic.h"
 #include "LVM_Macros.h"
+#include "LVM_Simd.h"
 
 void Mac3s_Sat_Float(const LVM_FLOAT* src, const LVM_FLOAT val, LVM_FLOAT* dst, LVM_INT16 n) {
-    LVM_INT16 ii;
+    LVM_INT16 ii = n;
 
-    for (ii = n; ii != 0; ii--) {
+#ifdef LVM_SIMD
+    const LVM_FLOAT4 Val = LVM_Dup4(val);
+    for (; ii >= 4; ii -= 4) {
+        LVM_FLOAT4 Temp = LVM_Mul4(LVM_Load4(src), Val);
+        LVM_Store4(dst, LVM_Clamp4(LVM_Add4(Temp, LVM_Load4(dst))));
+        src += 4;
+        dst += 4;
+    }
+#endif
+
+    for (; ii != 0; ii--) {
         LVM_FLOAT Temp = *src++ * val;
         Temp += *dst;
 
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the mixer and arithmetic kernels of libmusicbundle, vectorized with LVM_Simd.h,
+// with the same kernels built with LVM_NO_SIMD.
+
+#include <math.h>
+#include <string.h>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// The headers of the kernels are included first, so that the kernel sources below only
+// define the kernels, in namespace scalar, and the scalar loops of LVM_Simd.h.
+#define LVM_NO_SIMD
+#include "LVC_Mixer_Private.h"
+#include "LVM_Macros.h"
+#include "LVM_Simd.h"
+#include "Mixer_private.h"
+#include "ScalarArithmetic.h"
+#include "VectorArithmetic.h"
+
+namespace scalar {
+#include "Core_MixHard_2St_D32C31_SAT.cpp"
+#include "Core_MixInSoft_D32C31_SAT.cpp"
+#include "Core_MixSoft_1St_D32C31_WRA.cpp"
+#include "LVC_Core_MixHard_1St_2i_D16C31_SAT.cpp"
+#include "LVC_Core_MixHard_2St_D16C31_SAT.cpp"
+#include "LVC_Core_MixInSoft_D16C31_SAT.cpp"
+#include "LVC_Core_MixSoft_1St_D16C31_WRA.cpp"
+#include "Mac3s_Sat_32x16.cpp"
+}  // namespace scalar
+
+static constexpr int kMaxChannels = 8;
+
+// Soft mixer gains, ramping up, ramping down and not ramping.
+static const Mix_Private_FLOAT_st kRamps[] = {
+        {0.9f /* Target */, 0.1f /* Current */, 0.01f /* Delta */},
+        {0.2f, 1.0f, 0.03f},
+        {0.5f, 0.5f, 0.001f},
+};
+
+// Samples in [-1.0, 1.0] mostly, and now and then out of range samples, NaN, -0 and
+// denormals, which the vector clamps must handle like LVM_Clamp().
+static std::vector<LVM_FLOAT> makeSamples(size_t count, uint32_t seed) {
+    std::minstd_rand generator(seed);
+    std::uniform_real_distribution<LVM_FLOAT> inRange(-1.0f, 1.0f);
+    std::uniform_real_distribution<LVM_FLOAT> outOfRange(-3.0f, 3.0f);
+    std::vector<LVM_FLOAT> samples(count);
+    for (LVM_FLOAT& sample : samples) {
+        switch (generator() % 50) {
+            case 0:
+                sample = NAN;
+                break;
+            case 1:
+                sample = -0.0f;
+                break;
+            case 2:
+                sample = 1e-40f;
+                break;
+            case 3:
+            case 4:
+            case 5:
+                sample = outOfRange(generator);
+                break;
+            default:
+                sample = inRange(generator);
+                break;
+        }
+    }
+    return samples;
+}
+
+// Compares the bits, so that NaN and -0 compare too.
+static void expectBitExact(const std::vector<LVM_FLOAT>& expected,
+                           const std::vector<LVM_FLOAT>& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(0, memcmp(&expected[i], &actual[i], sizeof(LVM_FLOAT)))
+                << "sample " << i << ": " << expected[i] << " != " << actual[i];
+    }
+}
+
+static void expectBitExact(LVM_FLOAT expected, LVM_FLOAT actual) {
+    EXPECT_EQ(0, memcmp(&expected, &actual, sizeof(LVM_FLOAT)))
+            << "gain: " << expected << " != " << actual;
+}
+
+static LVMixer3_FLOAT_st makeMixer(const Mix_Private_FLOAT_st& ramp) {
+    LVMixer3_FLOAT_st mixer{};
+    *reinterpret_cast<Mix_Private_FLOAT_st*>(mixer.PrivateParams) = ramp;
+    return mixer;
+}
+
+static LVM_FLOAT getCurrent(LVMixer3_FLOAT_st& mixer) {
+    return reinterpret_cast<Mix_Private_FLOAT_st*>(mixer.PrivateParams)->Current;
+}
+
+// frame count, channel count
+using SimdTestParam = std::tuple<int, int>;
+
+class LvmSimdTest : public ::testing::TestWithParam<SimdTestParam> {
+  public:
+    LvmSimdTest()
+        : mFrameCount(std::get<0>(GetParam())),
+          mChannelCount(std::get<1>(GetParam())),
+          mSampleCount(mFrameCount * mChannelCount),
+          mSrc1(makeSamples(mSampleCount, mSampleCount + 1)),
+          mSrc2(makeSamples(mSampleCount, mSampleCount + 2)),
+          mDst(makeSamples(mSampleCount, mSampleCount + 3)) {}
+
+    const int mFrameCount;
+    const int mChannelCount;
+    const int mSampleCount;
+    const std::vector<LVM_FLOAT> mSrc1;
+    const std::vector<LVM_FLOAT> mSrc2;
+    // Initial output, for the kernels that accumulate.
+    const std::vector<LVM_FLOAT> mDst;
+};
+
+TEST_P(LvmSimdTest, Mac3sSat) {
+    for (const LVM_FLOAT gain : {0.7f, 2.5f, -1.0f}) {
+        std::vector<LVM_FLOAT> expected(mDst), actual(mDst);
+        scalar::Mac3s_Sat_Float(mSrc1.data(), gain, expected.data(), mSampleCount);
+        Mac3s_Sat_Float(mSrc1.data(), gain, actual.data(), mSampleCount);
+        ASSERT_NO_FATAL_FAILURE(expectBitExact(expected, actual)) << "gain " << gain;
+    }
+}
+
+TEST_P(LvmSimdTest, MixSoft) {
+    for (const Mix_Private_FLOAT_st& ramp : kRamps) {
+        LVMixer3_FLOAT_st expectedMixer = makeMixer(ramp), actualMixer = makeMixer(ramp);
+        std::vector<LVM_FLOAT> expected(mSampleCount), actual(mSampleCount);
+        scalar::LVC_Core_MixSoft_1St_D16C31_WRA(&expectedMixer, mSrc1.data(), expected.data(),
+                                                mSampleCount);
+        LVC_Core_MixSoft_1St_D16C31_WRA(&actualMixer, mSrc1.data(), actual.data(), mSampleCount);
+        ASSERT_NO_FATAL_FAILURE(expectBitExact(expected, actual));
+        expectBitExact(getCurrent(expectedMixer), getCurrent(actualMixer));
+
+        expectedMixer = makeMixer(ramp);
+        actualMixer = makeMixer(ramp);
+        scalar::LVC_Core_MixSoft_Mc_D16C31_WRA(&expectedMixer, mSrc1.data(), expected.data(),
+                                               mFrameCount, mChannelCount);
+        LVC_Core_MixSoft_Mc_D16C31_WRA(&actualMixer, mSrc1.data(), actual.data(), mFrameCount,
+                                       mChannelCount);
+        ASSERT_NO_FATAL_FAILURE(expectBitExact(expected, actual));
+        expectBitExact(getCurrent(expectedMixer), getCurrent(actualMixer));
+    }
+}
+
+TEST_P(LvmSimdTest, MixInSoft) {
+    for (const Mix_Private_FLOAT_st& ramp : kRamps) {
+        LVMixer3_FLOAT_st expectedMixer = makeMixer(ramp), actualMixer = makeMixer(ramp);
+        std::vector<LVM_FLOAT> expected(mDst), actual(mDst);
+        scalar::LVC_Core_MixInSoft_D16C31_SAT(&expectedMixer, mSrc1.data(), expected.data(),
+                                              mSampleCount);
+        LVC_Core_MixInSoft_D16C31_SAT(&actualMixer, mSrc1.data(), actual.data(), mSampleCount);
+        ASSERT_NO_FATAL_FAILURE(expectBitExact(expected, actual));
+        expectBitExact(getCurrent(expectedMixer), getCurrent(actualMixer));
+
+        expectedMixer = makeMixer(ramp);
+        actualMixer = makeMixer(ramp);
+        expected = mDst;
+        actual = mDst;
+        scalar::LVC_Core_MixInSoft_Mc_D16C31_SAT(&expectedMixer, mSrc1.data(), expected.data(),
+                                                 mFrameCount, mChannelCount);
+        LVC_Core_MixInSoft_Mc_D16C31_SAT(&actualMixer, mSrc1.data(), actual.data(), mFrameCount,
+                                         mChannelCount);
+        ASSERT_NO_FATAL_FAILURE(expectBitExact(expected, actual));
+        expectBitExact(getCurrent(expectedMixer), getCurrent(actualMixer));
+    }
+}
+
+TEST_P(LvmSimdTest, MixHard) {
+    LVMixer3_FLOAT_st mixer1 = makeMixer({0.9f, 0.9f, 0.0f});
+    LVMixer3_FLOAT_st mixer2 = makeMixer({1.7f, 1.7f, 0.0f});
+    std::vector<LVM_FLOAT> expected(mSampleCount), actual(mSampleCount);
+    scalar::LVC_Core_MixHard_2St_D16C31_SAT(&mixer1, &mixer2, mSrc1.data(), mSrc2.data(),
+                                            expected.data(), mSampleCount);
+    LVC_Core_MixHard_2St_D16C31_SAT(&mixer1, &mixer2, mSrc1.data(), mSrc2.data(), actual.data(),
+                                    mSampleCount);
+    ASSERT_NO_FATAL_FAILURE(expectBitExact(expected, actual));
+
+    // A different gain for each channel, some of them above unity.
+    Mix_Private_FLOAT_st gains[kMaxChannels];
+    Mix_Private_FLOAT_st* pGains[kMaxChannels];
+    for (int i = 0; i < kMaxChannels; i++) {
+        gains[i] = {0.0f, 2.0f * i / kMaxChannels - 0.6f, 0.0f};
+        pGains[i] = &gains[i];
+    }
+    scalar::LVC_Core_MixHard_1St_MC_float_SAT(pGains, mSrc1.data(), expected.data(), mFrameCount,
+                                              mChannelCount);
+    LVC_Core_MixHard_1St_MC_float_SAT(pGains, mSrc1.data(), actual.data(), mFrameCount,
+                                      mChannelCount);
+    ASSERT_NO_FATAL_FAILURE(expectBitExact(expected, actual));
+}
+
+TEST_P(LvmSimdTest, CoreMixers) {
+    Mix_2St_Cll_FLOAT_t hard{};
+    hard.Current1 = 0.9f;
+    hard.Current2 = 1.7f;
+    std::vector<LVM_FLOAT> expected(mSampleCount), actual(mSampleCount);
+    scalar::Core_MixHard_2St_D32C31_SAT(&hard, mSrc1.data(), mSrc2.data(), expected.data(),
+                                        mSampleCount);
+    Core_MixHard_2St_D32C31_SAT(&hard, mSrc1.data(), mSrc2.data(), actual.data(), mSampleCount);
+    ASSERT_NO_FATAL_FAILURE(expectBitExact(expected, actual));
+
+    for (const Mix_Private_FLOAT_st& ramp : kRamps) {
+        Mix_1St_Cll_FLOAT_t expectedMixer{};
+        expectedMixer.Alpha = 0.99f;
+        expectedMixer.Target = ramp.Target;
+        expectedMixer.Current = ramp.Current;
+        Mix_1St_Cll_FLOAT_t actualMixer = expectedMixer;
+        scalar::Core_MixSoft_1St_D32C31_WRA(&expectedMixer, mSrc1.data(), expected.data(),
+                                            mSampleCount);
+        Core_MixSoft_1St_D32C31_WRA(&actualMixer, mSrc1.data(), actual.data(), mSampleCount);
+        ASSERT_NO_FATAL_FAILURE(expectBitExact(expected, actual));
+        expectBitExact(expectedMixer.Current, actualMixer.Current);
+
+        expectedMixer.Current = actualMixer.Current = ramp.Current;
+        expected = mDst;
+        actual = mDst;
+        scalar::Core_MixInSoft_D32C31_SAT(&expectedMixer, mSrc1.data(), expected.data(),
+                                          mSampleCount);
+        Core_MixInSoft_D32C31_SAT(&actualMixer, mSrc1.data(), actual.data(), mSampleCount);
+        ASSERT_NO_FATAL_FAILURE(expectBitExact(expected, actual));
+        expectBitExact(expectedMixer.Current, actualMixer.Current);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        LvmSimdTestAll, LvmSimdTest,
+        ::testing::Combine(
+                // Shorter than a vector, and whole and partial vectors.
+                ::testing::Values(1, 3, 4, 17, 480),
+                ::testing::Range(1, kMaxChannels + 1)));
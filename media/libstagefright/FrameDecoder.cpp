@@ -47,6 +47,7 @@ namespace android {
 static const int64_t kBufferTimeOutUs = 10000LL; // 10 msec
 static const size_t kRetryCount = 100; // must be >0
 static const int64_t kDefaultSampleDurationUs = 33333LL; // 33ms
+static const size_t kMaxColorConversionThreads = 4;
 
 sp<IMemory> allocVideoFrame(const sp<MetaData>& trackMeta,
         int32_t width, int32_t height, int32_t tileWidth, int32_t tileHeight,
@@ -712,6 +713,7 @@ status_t VideoFrameDecoder::onOutputReceived(
         return ERROR_UNSUPPORTED;
     }
     converter.setSrcColorSpace(standard, range, transfer);
+    converter.setNumThreads(kMaxColorConversionThreads);
     if (converter.isValid()) {
         converter.convert(
                 (const uint8_t *)videoFrameBuffer->data(),
@@ -991,6 +993,7 @@ status_t MediaImageDecoder::onOutputReceived(
         return ERROR_UNSUPPORTED;
     }
     converter.setSrcColorSpace(standard, range, transfer);
+    converter.setNumThreads(kMaxColorConversionThreads);
 
     int32_t crop_left, crop_top, crop_right, crop_bottom;
     if (!outputFormat->findRect("crop", &crop_left, &crop_top, &crop_right, &crop_bottom)) {
@@ -30,8 +30,11 @@
 
 #include <utils/Log.h>
 
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <fcntl.h>
+#include <thread>
 
 #include <media/stagefright/MediaSource.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -499,6 +502,287 @@ private:
     Track &operator=(const Track &);
 };
 
+/*
+ * Write-behind stage between the muxer and the file. Writes are copied into
+ * buffers of kBufferSize bytes that end on kBufferSize-aligned file offsets,
+ * and a dedicated thread writes full buffers out with pwrite64(), in order.
+ * Seeks only move the logical file position; a write that lands inside the
+ * buffer being filled (e.g. a box size fixed up by endBox()) patches it in
+ * place. The producer blocks once kMaxQueuedBuffers are waiting to be written.
+ */
+class MPEG4Writer::WriteBehind {
+public:
+    WriteBehind(int fd, off64_t position, bool isBackgroundMode);
+    ~WriteBehind();
+
+    status_t start();
+    // Stops the thread once all buffered data is written. Returns ERROR_IO if
+    // any write failed.
+    status_t stop();
+
+    // Same contract as ::write() and lseek64(), including errno on failure,
+    // except that I/O errors surface on a later call.
+    ssize_t write(const void *data, size_t size);
+    off64_t seek(off64_t offset, int whence);
+
+    void dump(String8 *result) const;
+
+private:
+    static const size_t kBufferSize = 1024 * 1024;
+    static const size_t kMaxQueuedBuffers = 4;
+    // Write latency histogram buckets are powers of two milliseconds, the last
+    // one open ended.
+    static const size_t kNumLatencyBuckets = 10;
+
+    struct Buffer {
+        off64_t mOffset;
+        size_t mCapacity;
+        std::vector<uint8_t> mData;
+    };
+
+    const int mFd;
+    const bool mIsBackgroundMode;
+    mutable std::mutex mLock;
+    std::condition_variable mCondition;
+    std::thread mThread;
+    bool mStarted;
+    bool mDone;
+    int mError;  // errno of the first failed write, 0 if none
+
+    off64_t mPosition;  // logical file position of the producer
+    std::unique_ptr<Buffer> mFilling;
+    // Buffers waiting to be written, in order. The front one stays queued
+    // while it is being written.
+    std::deque<std::unique_ptr<Buffer>> mQueued;
+    std::vector<std::unique_ptr<Buffer>> mFreeBuffers;
+
+    // Statistics
+    uint64_t mBytesWritten;
+    uint64_t mNumWrites;
+    uint64_t mLatencyHistogram[kNumLatencyBuckets];
+    int64_t mMaxLatencyUs;
+    uint64_t mNumStalls;
+    int64_t mStallTimeUs;
+    size_t mMaxQueueDepth;
+
+    void threadFunc();
+    // Hands mFilling to the thread, waiting for room in the queue first.
+    void queueFilling_l(std::unique_lock<std::mutex> &lock);
+    void waitForRoom_l(std::unique_lock<std::mutex> &lock);
+
+    WriteBehind(const WriteBehind &);
+    WriteBehind &operator=(const WriteBehind &);
+};
+
+MPEG4Writer::WriteBehind::WriteBehind(int fd, off64_t position, bool isBackgroundMode)
+    : mFd(fd),
+      mIsBackgroundMode(isBackgroundMode),
+      mStarted(false),
+      mDone(false),
+      mError(0),
+      mPosition(position),
+      mBytesWritten(0),
+      mNumWrites(0),
+      mLatencyHistogram{},
+      mMaxLatencyUs(0),
+      mNumStalls(0),
+      mStallTimeUs(0),
+      mMaxQueueDepth(0) {
+}
+
+MPEG4Writer::WriteBehind::~WriteBehind() {
+    stop();
+}
+
+status_t MPEG4Writer::WriteBehind::start() {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mStarted) {
+        return OK;
+    }
+    mThread = std::thread([this] { threadFunc(); });
+    mStarted = true;
+    return OK;
+}
+
+status_t MPEG4Writer::WriteBehind::stop() {
+    {
+        std::unique_lock<std::mutex> lock(mLock);
+        if (!mStarted) {
+            return mError == 0 ? OK : ERROR_IO;
+        }
+        if (mFilling != nullptr && !mFilling->mData.empty()) {
+            queueFilling_l(lock);
+        }
+        mDone = true;
+        mCondition.notify_all();
+    }
+    mThread.join();
+
+    std::lock_guard<std::mutex> lock(mLock);
+    mStarted = false;
+    return mError == 0 ? OK : ERROR_IO;
+}
+
+ssize_t MPEG4Writer::WriteBehind::write(const void *data, size_t size) {
+    std::unique_lock<std::mutex> lock(mLock);
+    const uint8_t *ptr = (const uint8_t *)data;
+    size_t remaining = size;
+    while (remaining > 0 && mError == 0) {
+        if (mFilling != nullptr) {
+            Buffer *buffer = mFilling.get();
+            const size_t length = buffer->mData.size();
+            if (mPosition < buffer->mOffset || mPosition > buffer->mOffset + (off64_t)length
+                    || mPosition == buffer->mOffset + (off64_t)buffer->mCapacity) {
+                queueFilling_l(lock);
+                continue;
+            }
+            const size_t start = mPosition - buffer->mOffset;
+            const size_t n = std::min(remaining, buffer->mCapacity - start);
+            if (start + n > length) {
+                buffer->mData.resize(start + n);
+            }
+            memcpy(buffer->mData.data() + start, ptr, n);
+            ptr += n;
+            remaining -= n;
+            mPosition += n;
+            continue;
+        }
+
+        if (mFreeBuffers.empty()) {
+            mFilling.reset(new Buffer);
+            mFilling->mData.reserve(kBufferSize);
+        } else {
+            mFilling = std::move(mFreeBuffers.back());
+            mFreeBuffers.pop_back();
+            mFilling->mData.clear();
+        }
+        mFilling->mOffset = mPosition;
+        mFilling->mCapacity = kBufferSize - (mPosition % kBufferSize);
+    }
+
+    if (mError != 0) {
+        errno = mError;
+        return -1;
+    }
+    return size;
+}
+
+off64_t MPEG4Writer::WriteBehind::seek(off64_t offset, int whence) {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mError != 0) {
+        errno = mError;
+        return -1;
+    }
+    switch (whence) {
+        case SEEK_SET:
+            break;
+        case SEEK_CUR:
+            offset += mPosition;
+            break;
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+    if (offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    mPosition = offset;
+    return offset;
+}
+
+void MPEG4Writer::WriteBehind::queueFilling_l(std::unique_lock<std::mutex> &lock) {
+    waitForRoom_l(lock);
+    mQueued.push_back(std::move(mFilling));
+    mMaxQueueDepth = std::max(mMaxQueueDepth, mQueued.size());
+    mCondition.notify_all();
+}
+
+void MPEG4Writer::WriteBehind::waitForRoom_l(std::unique_lock<std::mutex> &lock) {
+    if (mQueued.size() < kMaxQueuedBuffers) {
+        return;
+    }
+    const auto stallStart = std::chrono::steady_clock::now();
+    ++mNumStalls;
+    mCondition.wait(lock, [this] { return mQueued.size() < kMaxQueuedBuffers; });
+    mStallTimeUs += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - stallStart).count();
+}
+
+void MPEG4Writer::WriteBehind::threadFunc() {
+    prctl(PR_SET_NAME, (unsigned long)"MPEG4WriteBehind", 0, 0, 0);
+    if (mIsBackgroundMode) {
+        androidSetThreadPriority(0 /* tid (0 = current) */, ANDROID_PRIORITY_BACKGROUND);
+    }
+
+    std::unique_lock<std::mutex> lock(mLock);
+    while (true) {
+        mCondition.wait(lock, [this] { return mDone || !mQueued.empty(); });
+        if (mQueued.empty()) {
+            break;
+        }
+        Buffer *buffer = mQueued.front().get();
+        const bool skip = mError != 0;
+        lock.unlock();
+
+        int error = 0;
+        const auto writeStart = std::chrono::steady_clock::now();
+        size_t written = 0;
+        while (!skip && written < buffer->mData.size()) {
+            ssize_t n = pwrite64(mFd, buffer->mData.data() + written,
+                    buffer->mData.size() - written, buffer->mOffset + written);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                error = n < 0 ? errno : EIO;
+                break;
+            }
+            written += n;
+        }
+        const int64_t latencyUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - writeStart).count();
+
+        lock.lock();
+        if (!skip) {
+            if (error != 0) {
+                ALOGE("WriteBehind: pwrite of %zu bytes at %lld failed: %s(%d)",
+                      buffer->mData.size(), (long long)buffer->mOffset, strerror(error), error);
+                mError = error;
+            }
+            mBytesWritten += written;
+            ++mNumWrites;
+            size_t bucket = 0;
+            while (bucket + 1 < kNumLatencyBuckets && latencyUs / 1000 >= (1 << bucket)) {
+                ++bucket;
+            }
+            ++mLatencyHistogram[bucket];
+            mMaxLatencyUs = std::max(mMaxLatencyUs, latencyUs);
+        }
+        mFreeBuffers.push_back(std::move(mQueued.front()));
+        mQueued.pop_front();
+        mCondition.notify_all();
+    }
+}
+
+void MPEG4Writer::WriteBehind::dump(String8 *result) const {
+    std::lock_guard<std::mutex> lock(mLock);
+    result->appendFormat("     write-behind: %" PRIu64 " writes, %" PRIu64 " bytes, error %d\n",
+            mNumWrites, mBytesWritten, mError);
+    result->appendFormat("       queue depth: %zu (max %zu of %zu), stalls: %" PRIu64
+            " (%" PRId64 " us)\n", mQueued.size(), mMaxQueueDepth, kMaxQueuedBuffers,
+            mNumStalls, mStallTimeUs);
+    result->appendFormat("       write latency (ms):");
+    for (size_t i = 0; i < kNumLatencyBuckets; ++i) {
+        if (i + 1 < kNumLatencyBuckets) {
+            result->appendFormat(" <%d:%" PRIu64, 1 << i, mLatencyHistogram[i]);
+        } else {
+            result->appendFormat(" >=%d:%" PRIu64, 1 << (i - 1), mLatencyHistogram[i]);
+        }
+    }
+    result->appendFormat(", max %" PRId64 " us\n", mMaxLatencyUs);
+}
+
 MPEG4Writer::MPEG4Writer(int fd) {
     initInternal(dup(fd), true /*isFirstSession*/);
 }
@@ -577,6 +861,7 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
         mAreGeoTagsAvailable = false;
         mSwitchPending = false;
         mIsFileSizeLimitExplicitlyRequested = false;
+        mWriteBehindEnabled = property_get_bool("media.mp4writer.write_behind", false);
     }
 
     // Verify mFd is seekable
@@ -609,6 +894,9 @@ status_t MPEG4Writer::dump(
     result.append(buffer);
     snprintf(buffer, SIZE, "     mStarted: %s\n", mStarted? "true": "false");
     result.append(buffer);
+    if (mWriteBehind != nullptr) {
+        mWriteBehind->dump(&result);
+    }
     ::write(fd, result.string(), result.size());
     for (List<Track *>::iterator it = mTracks.begin();
          it != mTracks.end(); ++it) {
@@ -1020,6 +1308,14 @@ status_t MPEG4Writer::start(MetaData *param) {
         return err;
     }
 
+    if (mWriteBehindEnabled) {
+        mWriteBehind.reset(new WriteBehind(mFd, mOffset, mIsBackgroundMode));
+        if (mWriteBehind->start() != OK) {
+            ALOGW("Failed to start write-behind, writing synchronously");
+            mWriteBehind.reset();
+        }
+    }
+
     writeFtypBox(param);
 
     mFreeBoxOffset = mOffset;
@@ -1197,6 +1493,11 @@ void MPEG4Writer::printWriteDurations() {
 status_t MPEG4Writer::release() {
     ALOGD("release()");
     status_t err = OK;
+    // Everything buffered has to be in the file before it is truncated and synced. The stopped
+    // write-behind stage is kept around for dump().
+    if (mWriteBehind != nullptr && mWriteBehind->stop() != OK) {
+        err = ERROR_IO;
+    }
     if (!truncatePreAllocation()) {
         if (err == OK) { err = ERROR_IO; }
     }
@@ -1770,14 +2071,20 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
     if (mWriteSeekErr == true)
         return;
 
-    auto beforeTP = std::chrono::high_resolution_clock::now();
-    ssize_t bytesWritten = ::write(fd, buf, count);
-    auto afterTP = std::chrono::high_resolution_clock::now();
-    auto writeDuration =
-            std::chrono::duration_cast<std::chrono::microseconds>(afterTP - beforeTP).count();
-    mWriteDurationPQ.emplace(writeDuration);
-    if (mWriteDurationPQ.size() > kWriteDurationsCount) {
-        mWriteDurationPQ.pop();
+    ssize_t bytesWritten;
+    if (mWriteBehind != nullptr) {
+        // The write-behind thread tracks the durations of the actual writes.
+        bytesWritten = mWriteBehind->write(buf, count);
+    } else {
+        auto beforeTP = std::chrono::high_resolution_clock::now();
+        bytesWritten = ::write(fd, buf, count);
+        auto afterTP = std::chrono::high_resolution_clock::now();
+        auto writeDuration =
+                std::chrono::duration_cast<std::chrono::microseconds>(afterTP - beforeTP).count();
+        mWriteDurationPQ.emplace(writeDuration);
+        if (mWriteDurationPQ.size() > kWriteDurationsCount) {
+            mWriteDurationPQ.pop();
+        }
     }
 
     /* Write as much as possible during stop() execution when there was an error
@@ -1799,7 +2106,8 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
 void MPEG4Writer::seekOrPostError(int fd, off64_t offset, int whence) {
     if (mWriteSeekErr == true)
         return;
-    off64_t resOffset = lseek64(fd, offset, whence);
+    off64_t resOffset = mWriteBehind != nullptr ? mWriteBehind->seek(offset, whence)
+                                                : lseek64(fd, offset, whence);
     /* Allow to seek during stop() execution even when there was an error
      * (mWriteSeekErr == true) in the previous call to write() or lseek64().
      */
@@ -3012,6 +3012,48 @@ status_t MediaCodec::queueInputBuffer(
     return PostAndAwaitResponse(msg, &response);
 }
 
+status_t MediaCodec::queueInputBuffers(
+        size_t index,
+        size_t offset,
+        size_t size,
+        const std::vector<AccessUnitInfo> &infos,
+        AString *errorDetailMsg) {
+    if (errorDetailMsg != NULL) {
+        errorDetailMsg->clear();
+    }
+    if (infos.empty()) {
+        ALOGE("queueInputBuffers: no access unit");
+        return BAD_VALUE;
+    }
+    size_t totalSize = 0;
+    for (size_t i = 0; i < infos.size(); ++i) {
+        if ((infos[i].mFlags & BUFFER_FLAG_EOS) && i + 1 < infos.size()) {
+            ALOGE("queueInputBuffers: EOS on access unit %zu of %zu", i, infos.size());
+            return BAD_VALUE;
+        }
+        totalSize += infos[i].mSize;
+    }
+    if (totalSize != size) {
+        ALOGE("queueInputBuffers: access units of %zu bytes in %zu bytes", totalSize, size);
+        return BAD_VALUE;
+    }
+
+    sp<ABuffer> accessUnitInfo = ABuffer::CreateAsCopy(
+            infos.data(), infos.size() * sizeof(AccessUnitInfo));
+
+    sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
+    msg->setSize("index", index);
+    msg->setSize("offset", offset);
+    msg->setSize("size", size);
+    msg->setInt64("timeUs", infos.front().mTimestamp);
+    msg->setInt32("flags", infos.back().mFlags & BUFFER_FLAG_EOS);
+    msg->setBuffer("accessUnitInfo", accessUnitInfo);
+    msg->setPointer("errorDetailMsg", errorDetailMsg);
+
+    sp<AMessage> response;
+    return PostAndAwaitResponse(msg, &response);
+}
+
 status_t MediaCodec::queueSecureInputBuffer(
         size_t index,
         size_t offset,
@@ -5954,6 +5996,22 @@ status_t MediaCodec::onQueueInputBuffer(const sp<AMessage> &msg) {
         return -EINVAL;
     }
 
+    sp<ABuffer> accessUnitInfo;
+    if (msg->findBuffer("accessUnitInfo", &accessUnitInfo)) {
+        size_t numAccessUnits = accessUnitInfo->size() / sizeof(AccessUnitInfo);
+        size_t maxAccessUnits = mBufferChannel->getMaxInputAccessUnits();
+        if (numAccessUnits > maxAccessUnits || hasCryptoOrDescrambler()) {
+            mErrorLog.log(LOG_TAG, base::StringPrintf(
+                    "cannot queue %zu access units in a buffer (max=%zu%s)",
+                    numAccessUnits, maxAccessUnits,
+                    hasCryptoOrDescrambler() ? ", with crypto" : ""));
+            return -EINVAL;
+        }
+        buffer->meta()->setBuffer("accessUnitInfo", accessUnitInfo);
+    } else {
+        buffer->meta()->remove("accessUnitInfo");
+    }
+
     int32_t usedMaxInputSize = mApiUsageMetrics.inputBufferSize.usedMax;
     mApiUsageMetrics.inputBufferSize.usedMax = size > usedMaxInputSize ? size : usedMaxInputSize;
 
@@ -6338,6 +6396,11 @@ void MediaCodec::onOutputBufferAvailable() {
 
         msg->setInt32("flags", flags);
 
+        sp<ABuffer> accessUnitInfo;
+        if (buffer->meta()->findBuffer("accessUnitInfo", &accessUnitInfo)) {
+            msg->setBuffer("accessUnitInfo", accessUnitInfo);
+        }
+
         statsBufferReceived(timeUs, buffer);
 
         msg->post();
@@ -22,6 +22,7 @@
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/ALooper.h>
 #include <media/stagefright/foundation/ColorUtils.h>
+#include <media/stagefright/foundation/RowBands.h>
 #include <media/stagefright/ColorConverter.h>
 #include <media/stagefright/MediaCodecConstants.h>
 #include <media/stagefright/MediaErrors.h>
@@ -30,21 +31,36 @@
 #include "libyuv/convert_argb.h"
 #include "libyuv/planar_functions.h"
 #include "libyuv/video_common.h"
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <thread>
 #include <sys/time.h>
 
 #define PERF_PROFILING 0
 
 #if defined(__aarch64__) || defined(__ARM_NEON__)
 #define USE_NEON_Y410 1
+#define USE_NEON_P010 1
 #else
 #define USE_NEON_Y410 0
+#define USE_NEON_P010 0
 #endif
 
-#if USE_NEON_Y410
+#if defined(__SSE2__)
+#define USE_SSE2_10BIT 1
+#else
+#define USE_SSE2_10BIT 0
+#endif
+
+#if USE_NEON_Y410 || USE_NEON_P010
 #include <arm_neon.h>
 #endif
 
+#if USE_SSE2_10BIT
+#include <emmintrin.h>
+#endif
+
 namespace android {
 typedef const struct libyuv::YuvConstants LibyuvConstants;
 
@@ -464,7 +480,8 @@ ColorConverter::ColorConverter(
       mDstFormat(to),
       mSrcColorSpace({0, 0, 0}),
       mClip(NULL),
-      mClip10Bit(NULL) {
+      mClip10Bit(NULL),
+      mNumThreads(1) {
 }
 
 ColorConverter::~ColorConverter() {
@@ -546,6 +563,11 @@ bool ColorConverter::isDstRGB() const {
     return isRGB(mDstFormat);
 }
 
+void ColorConverter::setNumThreads(size_t numThreads) {
+    mNumThreads = std::max<size_t>(
+            1, std::min<size_t>(numThreads, std::thread::hardware_concurrency()));
+}
+
 void ColorConverter::setSrcColorSpace(
         uint32_t standard, uint32_t range, uint32_t transfer) {
     if (isRGB(mSrcFormat)) {
@@ -667,32 +689,13 @@ status_t ColorConverter::convert(
 #if PERF_PROFILING
     int64_t startTimeUs = ALooper::GetNowUs();
 #endif
-    status_t err;
+    // 8-bit YUV formats with a fixed layout are converted as MediaImage2.
     switch ((int32_t)mSrcFormat) {
-        case COLOR_FormatYUV420Flexible:
-            err = convertYUVMediaImage(src, dst);
-            break;
-
         case OMX_COLOR_FormatYUV420Planar:
             if (!mSrcImage) {
                 mSrcImage = Image(CreateYUV420PlanarMediaImage2(
                         srcWidth, srcHeight, srcStride, srcHeight, 8 /*bitDepth*/));
             }
-            err = convertYUVMediaImage(src, dst);
-
-            break;
-
-        case OMX_COLOR_FormatYUV420Planar16:
-            err = convertYUV420Planar16(src, dst);
-            break;
-
-        case COLOR_FormatYUVP010:
-            err = convertYUVP010(src, dst);
-
-            break;
-
-        case OMX_COLOR_FormatCbYCrY:
-            err = convertCbYCrY(src, dst);
             break;
 
         case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
@@ -700,8 +703,6 @@ status_t ColorConverter::convert(
                 mSrcImage = Image(CreateYUV420SemiPlanarMediaImage2(
                     srcWidth, srcHeight, srcStride, srcHeight, 8 /*bitDepth*/, false));
             }
-            err = convertYUVMediaImage(src, dst);
-
             break;
 
         case OMX_COLOR_FormatYUV420SemiPlanar:
@@ -710,16 +711,42 @@ status_t ColorConverter::convert(
                 mSrcImage = Image(CreateYUV420SemiPlanarMediaImage2(
                     srcWidth, srcHeight, srcStride, srcHeight, 8 /*bitDepth*/));
             }
-            err = convertYUVMediaImage(src, dst);
-
             break;
 
         default:
-
-            CHECK(!"Should not be here. Unknown color conversion.");
             break;
     }
 
+    status_t err;
+    size_t numBands = std::min({mNumThreads, src.cropHeight() / 2,
+            src.cropWidth() * src.cropHeight() / kMinPixelsPerBand});
+    if (numBands <= 1) {
+        err = convertRows(src, dst);
+    } else {
+        // The clip tables are allocated on first use, so set them up before the threads
+        // share them.
+        initClip();
+        initClip10Bit();
+
+        // Bands start on even rows, so that each band starts on a row with the same chroma
+        // phase as the top of the crop rectangle.
+        std::atomic<status_t> result(OK);
+        forEachRowBand(src.cropHeight(), numBands, [&](size_t top, size_t rows) {
+            BitmapParams srcBand = src;
+            srcBand.mCropTop += top;
+            srcBand.mCropBottom = srcBand.mCropTop + rows - 1;
+            BitmapParams dstBand = dst;
+            dstBand.mCropTop += top;
+            dstBand.mCropBottom = dstBand.mCropTop + rows - 1;
+            status_t bandResult = convertRows(srcBand, dstBand);
+            if (bandResult != OK) {
+                status_t expected = OK;
+                result.compare_exchange_strong(expected, bandResult);
+            }
+        });
+        err = result;
+    }
+
 #if PERF_PROFILING
     int64_t endTimeUs = ALooper::GetNowUs();
     ALOGD("%s image took %lld us", asString_ColorFormat(mSrcFormat,"Unknown"),
@@ -729,6 +756,39 @@ status_t ColorConverter::convert(
     return err;
 }
 
+status_t ColorConverter::convertRows(
+        const BitmapParams &src, const BitmapParams &dst) {
+    status_t err;
+    switch ((int32_t)mSrcFormat) {
+        case COLOR_FormatYUV420Flexible:
+        case OMX_COLOR_FormatYUV420Planar:
+        case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
+        case OMX_COLOR_FormatYUV420SemiPlanar:
+        case OMX_TI_COLOR_FormatYUV420PackedSemiPlanar:
+            err = convertYUVMediaImage(src, dst);
+            break;
+
+        case OMX_COLOR_FormatYUV420Planar16:
+            err = convertYUV420Planar16(src, dst);
+            break;
+
+        case COLOR_FormatYUVP010:
+            err = convertYUVP010(src, dst);
+            break;
+
+        case OMX_COLOR_FormatCbYCrY:
+            err = convertCbYCrY(src, dst);
+            break;
+
+        default:
+
+            CHECK(!"Should not be here. Unknown color conversion.");
+            break;
+    }
+
+    return err;
+}
+
 const struct ColorConverter::Coeffs *ColorConverter::getMatrix() const {
     const bool isFullRange = mSrcColorSpace.mRange == ColorUtils::kColorRangeFull;
     const bool is10Bit = (mSrcFormat == COLOR_FormatYUVP010
@@ -1452,6 +1512,108 @@ status_t ColorConverter::convertYUVP010(
     return ERROR_UNSUPPORTED;
 }
 
+// Converts the leading multiple of 8 pixels of a P010 row to RGBA_1010102 with the same
+// arithmetic as the scalar loop in convertYUVP010ToRGBA1010102. Returns the number of
+// pixels converted; the caller converts the rest.
+static size_t convertP010RowToRGBA1010102(
+        const uint16_t *src_y, const uint16_t *src_uv, uint32_t *dst, size_t width,
+        signed _y, signed _c64, signed _b_u, signed _neg_g_u, signed _neg_g_v, signed _r_v) {
+    size_t x = 0;
+#if USE_NEON_P010
+    const int16x8_t c64 = vdupq_n_s16(_c64);
+    const int16x4_t c512 = vdup_n_s16(512);
+    const int32x4_t c128 = vdupq_n_s32(128);
+    const int32x4_t zero = vdupq_n_s32(0);
+    const int32x4_t max = vdupq_n_s32(1023);
+    const uint32_t alpha = 3u << 30;
+    for (; x + 7 < width; x += 8) {
+        int16x8_t y = vsubq_s16(vreinterpretq_s16_u16(vshrq_n_u16(vld1q_u16(src_y + x), 6)), c64);
+        uint16x4x2_t uv = vld2_u16(src_uv + x);
+        int16x4_t u = vsub_s16(vreinterpret_s16_u16(vshr_n_u16(uv.val[0], 6)), c512);
+        int16x4_t v = vsub_s16(vreinterpret_s16_u16(vshr_n_u16(uv.val[1], 6)), c512);
+
+        // each chroma sample covers two horizontally adjacent pixels
+        int32x4_t u_b = vmull_n_s16(u, _b_u);
+        int32x4_t uv_g = vmlal_n_s16(vmull_n_s16(u, _neg_g_u), v, _neg_g_v);
+        int32x4_t v_r = vmull_n_s16(v, _r_v);
+        int32x4x2_t b_uv = vzipq_s32(u_b, u_b);
+        int32x4x2_t g_uv = vzipq_s32(uv_g, uv_g);
+        int32x4x2_t r_uv = vzipq_s32(v_r, v_r);
+
+        int32x4_t tmp[2] = {
+            vmlal_n_s16(c128, vget_low_s16(y), _y),
+            vmlal_n_s16(c128, vget_high_s16(y), _y),
+        };
+        for (int i = 0; i < 2; ++i) {
+            int32x4_t b = vminq_s32(vmaxq_s32(vshrq_n_s32(vaddq_s32(tmp[i], b_uv.val[i]), 8), zero), max);
+            int32x4_t g = vminq_s32(vmaxq_s32(vshrq_n_s32(vaddq_s32(tmp[i], g_uv.val[i]), 8), zero), max);
+            int32x4_t r = vminq_s32(vmaxq_s32(vshrq_n_s32(vaddq_s32(tmp[i], r_uv.val[i]), 8), zero), max);
+            uint32x4_t out = vorrq_u32(
+                    vorrq_u32(vreinterpretq_u32_s32(r), vshlq_n_u32(vreinterpretq_u32_s32(g), 10)),
+                    vorrq_u32(vshlq_n_u32(vreinterpretq_u32_s32(b), 20), vdupq_n_u32(alpha)));
+            vst1q_u32(dst + x + 4 * i, out);
+        }
+    }
+#elif USE_SSE2_10BIT
+    const __m128i c64 = _mm_set1_epi16(_c64);
+    const __m128i c512 = _mm_set1_epi16(512);
+    // y * _y + 128, as a multiply-add of (y, 1) pairs
+    const __m128i yCoeff = _mm_set1_epi32((128 << 16) | (uint16_t)_y);
+    // chroma is interleaved as (u, v) pairs
+    const __m128i bCoeff = _mm_set1_epi32((uint16_t)_b_u);
+    const __m128i gCoeff = _mm_set1_epi32(((uint32_t)(uint16_t)_neg_g_v << 16) | (uint16_t)_neg_g_u);
+    const __m128i rCoeff = _mm_set1_epi32((uint32_t)(uint16_t)_r_v << 16);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(1023);
+    const __m128i alpha = _mm_set1_epi32(3u << 30);
+    for (; x + 7 < width; x += 8) {
+        __m128i y = _mm_sub_epi16(
+                _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src_y + x)), 6), c64);
+        __m128i uv = _mm_sub_epi16(
+                _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src_uv + x)), 6), c512);
+
+        __m128i tmp_lo = _mm_madd_epi16(_mm_unpacklo_epi16(y, one), yCoeff);
+        __m128i tmp_hi = _mm_madd_epi16(_mm_unpackhi_epi16(y, one), yCoeff);
+
+        // each chroma sample covers two horizontally adjacent pixels
+        __m128i u_b = _mm_madd_epi16(uv, bCoeff);
+        __m128i uv_g = _mm_madd_epi16(uv, gCoeff);
+        __m128i v_r = _mm_madd_epi16(uv, rCoeff);
+
+        // The C division rounds towards zero where the shift rounds down, which only
+        // differs for negative values that are clipped to 0 either way.
+        __m128i b = _mm_packs_epi32(
+                _mm_srai_epi32(_mm_add_epi32(tmp_lo, _mm_unpacklo_epi32(u_b, u_b)), 8),
+                _mm_srai_epi32(_mm_add_epi32(tmp_hi, _mm_unpackhi_epi32(u_b, u_b)), 8));
+        __m128i g = _mm_packs_epi32(
+                _mm_srai_epi32(_mm_add_epi32(tmp_lo, _mm_unpacklo_epi32(uv_g, uv_g)), 8),
+                _mm_srai_epi32(_mm_add_epi32(tmp_hi, _mm_unpackhi_epi32(uv_g, uv_g)), 8));
+        __m128i r = _mm_packs_epi32(
+                _mm_srai_epi32(_mm_add_epi32(tmp_lo, _mm_unpacklo_epi32(v_r, v_r)), 8),
+                _mm_srai_epi32(_mm_add_epi32(tmp_hi, _mm_unpackhi_epi32(v_r, v_r)), 8));
+        b = _mm_min_epi16(_mm_max_epi16(b, zero), max);
+        g = _mm_min_epi16(_mm_max_epi16(g, zero), max);
+        r = _mm_min_epi16(_mm_max_epi16(r, zero), max);
+
+        __m128i out_lo = _mm_or_si128(
+                _mm_or_si128(_mm_unpacklo_epi16(r, zero),
+                             _mm_slli_epi32(_mm_unpacklo_epi16(g, zero), 10)),
+                _mm_or_si128(_mm_slli_epi32(_mm_unpacklo_epi16(b, zero), 20), alpha));
+        __m128i out_hi = _mm_or_si128(
+                _mm_or_si128(_mm_unpackhi_epi16(r, zero),
+                             _mm_slli_epi32(_mm_unpackhi_epi16(g, zero), 10)),
+                _mm_or_si128(_mm_slli_epi32(_mm_unpackhi_epi16(b, zero), 20), alpha));
+        _mm_storeu_si128((__m128i *)(dst + x), out_lo);
+        _mm_storeu_si128((__m128i *)(dst + x + 4), out_hi);
+    }
+#else
+    (void)src_y; (void)src_uv; (void)dst; (void)width;
+    (void)_y; (void)_c64; (void)_b_u; (void)_neg_g_u; (void)_neg_g_v; (void)_r_v;
+#endif
+    return x;
+}
+
 status_t ColorConverter::convertYUVP010ToRGBA1010102(
         const BitmapParams &src, const BitmapParams &dst) {
     const struct Coeffs *matrix = getMatrix();
@@ -1482,7 +1644,10 @@ status_t ColorConverter::convertYUVP010ToRGBA1010102(
             + (src.mCropTop / 2) * src.mStride + src.mCropLeft * src.mBpp);
 
     for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
+        size_t x = convertP010RowToRGBA1010102(
+                src_y, src_uv, (uint32_t *)dst_ptr, src.cropWidth(),
+                _y, _c64, _b_u, _neg_g_u, _neg_g_v, _r_v);
+        for (; x < src.cropWidth(); x += 2) {
             signed y1, y2, u, v;
             y1 = (src_y[x] >> 6) - _c64;
             y2 = (src_y[x + 1] >> 6) - _c64;
@@ -1550,6 +1715,36 @@ status_t ColorConverter::convertYUV420Planar16ToY410(
 
         uint32_t u01, v01, y01, y23, y45, y67, uv0, uv1;
         size_t x = 0;
+#if USE_SSE2_10BIT
+        const __m128i mask = _mm_set1_epi16(0x3FF);
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 7 < src.cropWidth(); x += 8) {
+            __m128i u = _mm_and_si128(_mm_loadl_epi64((const __m128i *)ptr_u), mask);
+            __m128i v = _mm_and_si128(_mm_loadl_epi64((const __m128i *)ptr_v), mask);
+            ptr_u += 4;
+            ptr_v += 4;
+            __m128i uv = _mm_or_si128(_mm_unpacklo_epi16(u, zero),
+                                      _mm_slli_epi32(_mm_unpacklo_epi16(v, zero), 20));
+            __m128i uv_lo = _mm_unpacklo_epi32(uv, uv);
+            __m128i uv_hi = _mm_unpackhi_epi32(uv, uv);
+
+            __m128i ytop = _mm_and_si128(_mm_loadu_si128((const __m128i *)ptr_ytop), mask);
+            __m128i ybot = _mm_and_si128(_mm_loadu_si128((const __m128i *)ptr_ybot), mask);
+            ptr_ytop += 8;
+            ptr_ybot += 8;
+
+            _mm_storeu_si128((__m128i *)dst_top, _mm_or_si128(
+                    _mm_slli_epi32(_mm_unpacklo_epi16(ytop, zero), 10), uv_lo));
+            _mm_storeu_si128((__m128i *)(dst_top + 4), _mm_or_si128(
+                    _mm_slli_epi32(_mm_unpackhi_epi16(ytop, zero), 10), uv_hi));
+            _mm_storeu_si128((__m128i *)dst_bot, _mm_or_si128(
+                    _mm_slli_epi32(_mm_unpacklo_epi16(ybot, zero), 10), uv_lo));
+            _mm_storeu_si128((__m128i *)(dst_bot + 4), _mm_or_si128(
+                    _mm_slli_epi32(_mm_unpackhi_epi16(ybot, zero), 10), uv_hi));
+            dst_top += 8;
+            dst_bot += 8;
+        }
+#endif
         // x % 4 is always 0 so x + 3 will never overflow.
         for (; x + 3 < src.cropWidth(); x += 4) {
             u01 = *((uint32_t*)ptr_u); ptr_u += 2;
@@ -1561,17 +1756,17 @@ status_t ColorConverter::convertYUV420Planar16ToY410(
             y67 = *((uint32_t*)ptr_ybot); ptr_ybot += 2;
 
             uv0 = (u01 & 0x3FF) | ((v01 & 0x3FF) << 20);
-            uv1 = (u01 >> 16) | ((v01 >> 16) << 20);
+            uv1 = ((u01 >> 16) & 0x3FF) | (((v01 >> 16) & 0x3FF) << 20);
 
             *dst_top++ = ((y01 & 0x3FF) << 10) | uv0;
-            *dst_top++ = ((y01 >> 16) << 10) | uv0;
+            *dst_top++ = (((y01 >> 16) & 0x3FF) << 10) | uv0;
             *dst_top++ = ((y23 & 0x3FF) << 10) | uv1;
-            *dst_top++ = ((y23 >> 16) << 10) | uv1;
+            *dst_top++ = (((y23 >> 16) & 0x3FF) << 10) | uv1;
 
             *dst_bot++ = ((y45 & 0x3FF) << 10) | uv0;
-            *dst_bot++ = ((y45 >> 16) << 10) | uv0;
+            *dst_bot++ = (((y45 >> 16) & 0x3FF) << 10) | uv0;
             *dst_bot++ = ((y67 & 0x3FF) << 10) | uv1;
-            *dst_bot++ = ((y67 >> 16) << 10) | uv1;
+            *dst_bot++ = (((y67 >> 16) & 0x3FF) << 10) | uv1;
         }
 
         // There should be at most 2 more pixels to process. Note that we don't
@@ -1583,9 +1778,9 @@ status_t ColorConverter::convertYUV420Planar16ToY410(
             y45 = *((uint32_t*)ptr_ybot);
             uv0 = (u01 & 0x3FF) | ((v01 & 0x3FF) << 20);
             *dst_top++ = ((y01 & 0x3FF) << 10) | uv0;
-            *dst_top++ = ((y01 >> 16) << 10) | uv0;
+            *dst_top++ = (((y01 >> 16) & 0x3FF) << 10) | uv0;
             *dst_bot++ = ((y45 & 0x3FF) << 10) | uv0;
-            *dst_bot++ = ((y45 >> 16) << 10) | uv0;
+            *dst_bot++ = (((y45 >> 16) & 0x3FF) << 10) | uv0;
         }
 
         src_y += src.mStride * 2;
@@ -1620,17 +1815,18 @@ status_t ColorConverter::convertYUV420Planar16ToY410(
         uint16_t *ptr_v = (uint16_t*) src_v;
         uint32_t *ptr_out = (uint32_t *) out;
 
-        // Process 16-pixel at a time.
+        // Process 16-pixel at a time. Like the other paths, only the 10 low bits are used.
+        const uint16x4_t mask = vdup_n_u16(0x3FF);
         uint32_t *ptr_limit = ptr_out + (src.cropWidth() & ~15);
         while (ptr_out < ptr_limit) {
-            uint16x4_t u0123 = vld1_u16(ptr_u); ptr_u += 4;
-            uint16x4_t u4567 = vld1_u16(ptr_u); ptr_u += 4;
-            uint16x4_t v0123 = vld1_u16(ptr_v); ptr_v += 4;
-            uint16x4_t v4567 = vld1_u16(ptr_v); ptr_v += 4;
-            uint16x4_t y0123 = vld1_u16(ptr_y); ptr_y += 4;
-            uint16x4_t y4567 = vld1_u16(ptr_y); ptr_y += 4;
-            uint16x4_t y89ab = vld1_u16(ptr_y); ptr_y += 4;
-            uint16x4_t ycdef = vld1_u16(ptr_y); ptr_y += 4;
+            uint16x4_t u0123 = vand_u16(vld1_u16(ptr_u), mask); ptr_u += 4;
+            uint16x4_t u4567 = vand_u16(vld1_u16(ptr_u), mask); ptr_u += 4;
+            uint16x4_t v0123 = vand_u16(vld1_u16(ptr_v), mask); ptr_v += 4;
+            uint16x4_t v4567 = vand_u16(vld1_u16(ptr_v), mask); ptr_v += 4;
+            uint16x4_t y0123 = vand_u16(vld1_u16(ptr_y), mask); ptr_y += 4;
+            uint16x4_t y4567 = vand_u16(vld1_u16(ptr_y), mask); ptr_y += 4;
+            uint16x4_t y89ab = vand_u16(vld1_u16(ptr_y), mask); ptr_y += 4;
+            uint16x4_t ycdef = vand_u16(vld1_u16(ptr_y), mask); ptr_y += 4;
 
             uint32x2_t uvtempl;
             uint32x4_t uvtempq;
@@ -1701,12 +1897,12 @@ status_t ColorConverter::convertYUV420Planar16ToY410(
             uint16_t *ptr_v = (uint16_t*) src_v;
             uint32_t *ptr_out = (uint32_t *) out;
             for (size_t x = xstart; x < src.cropWidth(); x += 2) {
-                uint16_t u = *ptr_u++;
-                uint16_t v = *ptr_v++;
+                uint16_t u = *ptr_u++ & 0x3FF;
+                uint16_t v = *ptr_v++ & 0x3FF;
                 uint32_t y01 = *((uint32_t*)ptr_y); ptr_y += 2;
                 uint32_t uv = u | (((uint32_t)v) << 20);
                 *ptr_out++ = ((y01 & 0x3FF) << 10) | uv;
-                *ptr_out++ = ((y01 >> 16) << 10) | uv;
+                *ptr_out++ = (((y01 >> 16) & 0x3FF) << 10) | uv;
             }
             src_y += src.mStride;
             if (y & 1) {
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/MediaCodecConstants.h>
+
+using namespace android;
+
+// The source and destination formats exercised by color_conversion_fuzzer.
+static constexpr int32_t kSrcFormatType[] = {OMX_COLOR_FormatYUV420Planar,
+                                             OMX_COLOR_FormatYUV420Planar16,
+                                             OMX_COLOR_FormatYUV420SemiPlanar,
+                                             OMX_TI_COLOR_FormatYUV420PackedSemiPlanar,
+                                             OMX_COLOR_FormatCbYCrY,
+                                             OMX_QCOM_COLOR_FormatYVU420SemiPlanar,
+                                             COLOR_FormatYUVP010};
+
+static constexpr int32_t kDstFormatType[] = {
+        OMX_COLOR_Format16bitRGB565, OMX_COLOR_Format32BitRGBA8888, OMX_COLOR_Format32bitBGRA8888,
+        OMX_COLOR_FormatYUV444Y410, COLOR_Format32bitABGR2101010};
+
+static constexpr struct {
+    int32_t width;
+    int32_t height;
+} kFrameSizes[] = {{1920, 1080}, {7680, 4320}};
+
+static constexpr int32_t kNumThreads[] = {1, 4};
+
+// Bytes per frame of the formats above, with the default stride.
+static size_t getFrameSize(int32_t colorFormat, int32_t width, int32_t height) {
+    switch (colorFormat) {
+        case OMX_COLOR_FormatCbYCrY:
+        case OMX_COLOR_Format16bitRGB565:
+            return 2 * width * height;
+        case OMX_COLOR_FormatYUV420Planar16:
+        case COLOR_FormatYUVP010:
+            return 3 * width * height;
+        case OMX_COLOR_Format32bitBGRA8888:
+        case OMX_COLOR_Format32BitRGBA8888:
+        case COLOR_Format32bitABGR2101010:
+        case OMX_COLOR_FormatYUV444Y410:
+            return 4 * width * height;
+        default:
+            return width * height * 3 / 2;
+    }
+}
+
+static void BM_ColorConversion(benchmark::State& state) {
+    const auto srcFormat = (OMX_COLOR_FORMATTYPE)kSrcFormatType[state.range(0)];
+    const auto dstFormat = (OMX_COLOR_FORMATTYPE)kDstFormatType[state.range(1)];
+    const int32_t width = kFrameSizes[state.range(2)].width;
+    const int32_t height = kFrameSizes[state.range(2)].height;
+
+    ColorConverter converter(srcFormat, dstFormat);
+    converter.setNumThreads(state.range(3));
+
+    // Deterministic pseudo-random frame, with 10-bit samples in the bits each format uses.
+    const size_t srcSize = getFrameSize(srcFormat, width, height);
+    std::vector<uint16_t> src((srcSize + 1) / 2);
+    std::minstd_rand gen(srcFormat);
+    std::uniform_int_distribution<uint16_t> dis(0, 1023);
+    for (uint16_t& sample : src) {
+        sample = dis(gen);
+        if (srcFormat == COLOR_FormatYUVP010) {
+            sample <<= 6;
+        }
+    }
+    std::vector<uint8_t> dst(getFrameSize(dstFormat, width, height));
+
+    for (auto _ : state) {
+        status_t err = converter.convert(
+                src.data(), width, height, 0 /* stride */, 0, 0, width - 1, height - 1,
+                dst.data(), width, height, 0 /* stride */, 0, 0, width - 1, height - 1);
+        if (err != OK) {
+            state.SkipWithError("convert failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * width * height);
+    state.SetBytesProcessed(state.iterations() * srcSize);
+    state.SetLabel(std::string(asString_ColorFormat(srcFormat, "unknown")) + " -> "
+            + asString_ColorFormat(dstFormat, "unknown"));
+}
+
+static void ColorConversionArgs(benchmark::internal::Benchmark* b) {
+    for (int32_t src = 0; src < (int32_t)std::size(kSrcFormatType); ++src) {
+        for (int32_t dst = 0; dst < (int32_t)std::size(kDstFormatType); ++dst) {
+            ColorConverter converter((OMX_COLOR_FORMATTYPE)kSrcFormatType[src],
+                                     (OMX_COLOR_FORMATTYPE)kDstFormatType[dst]);
+            if (!converter.isValid()) {
+                continue;
+            }
+            for (int32_t size = 0; size < (int32_t)std::size(kFrameSizes); ++size) {
+                for (int32_t numThreads : kNumThreads) {
+                    b->Args({src, dst, size, numThreads});
+                }
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_ColorConversion)->Apply(ColorConversionArgs)->UseRealTime();
+
+BENCHMARK_MAIN();
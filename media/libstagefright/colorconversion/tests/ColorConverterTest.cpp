@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/MediaCodecConstants.h>
+
+using namespace android;
+
+// Narrower than the vector loops of every SIMD path, so that it is converted by the scalar
+// loops only.
+static constexpr size_t kScalarWidth = 6;
+
+// Bytes per pixel of the formats below, the 4:2:0 formats counting the luma plane only.
+static size_t getBytesPerPixel(OMX_COLOR_FORMATTYPE colorFormat) {
+    switch ((int32_t)colorFormat) {
+        case OMX_COLOR_FormatYUV420Planar:
+            return 1;
+        case OMX_COLOR_FormatYUV420Planar16:
+        case COLOR_FormatYUVP010:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+// Bytes per frame of the formats below, with the default stride.
+static size_t getFrameSize(OMX_COLOR_FORMATTYPE colorFormat, size_t width, size_t height) {
+    switch ((int32_t)colorFormat) {
+        case OMX_COLOR_FormatYUV420Planar:
+            return width * height * 3 / 2;
+        case OMX_COLOR_FormatYUV420Planar16:
+        case COLOR_FormatYUVP010:
+            return width * height * 3;
+        default:
+            return width * height * 4;
+    }
+}
+
+// source format, destination format
+using ConversionParams = std::tuple<OMX_COLOR_FORMATTYPE, OMX_COLOR_FORMATTYPE>;
+
+class ColorConverterTest : public ::testing::TestWithParam<ConversionParams> {
+protected:
+    void SetUp() override {
+        std::tie(mSrcFormat, mDstFormat) = GetParam();
+    }
+
+    // Random samples, including the bits above the 10 bits of Planar16 that the conversion
+    // to Y410 ignores.
+    std::vector<uint8_t> makeFrame(size_t width, size_t height) {
+        std::vector<uint8_t> frame(getFrameSize(mSrcFormat, width, height));
+        std::minstd_rand generator(width * height);
+        std::uniform_int_distribution<int> distribution(0, 255);
+        for (uint8_t& byte : frame) {
+            byte = distribution(generator);
+        }
+        return frame;
+    }
+
+    // Converts the columns [left, right] of all the rows of |src| into the same columns of
+    // |dst|.
+    void convert(ColorConverter& converter, const std::vector<uint8_t>& src,
+                 std::vector<uint8_t>& dst, size_t width, size_t height, size_t left,
+                 size_t right) {
+        ASSERT_EQ(OK, converter.convert(src.data(), width, height, 0 /* stride */, left, 0, right,
+                                        height - 1, dst.data(), width, height, 0 /* stride */,
+                                        left, 0, right, height - 1));
+    }
+
+    OMX_COLOR_FORMATTYPE mSrcFormat;
+    OMX_COLOR_FORMATTYPE mDstFormat;
+};
+
+// The 10-bit conversions, which have SIMD loops of their own.
+class ColorConverter10BitTest : public ColorConverterTest {};
+
+// The SIMD loops convert pixels exactly like the scalar loops that convert the rest of the rows.
+TEST_P(ColorConverter10BitTest, SimdMatchesScalar) {
+    constexpr size_t kWidth = 10 * kScalarWidth;
+    constexpr size_t kHeight = 8;
+    ColorConverter converter(mSrcFormat, mDstFormat);
+    ASSERT_TRUE(converter.isValid());
+    const std::vector<uint8_t> src = makeFrame(kWidth, kHeight);
+
+    std::vector<uint8_t> simd(getFrameSize(mDstFormat, kWidth, kHeight));
+    convert(converter, src, simd, kWidth, kHeight, 0, kWidth - 1);
+    std::vector<uint8_t> scalar(simd.size());
+    for (size_t left = 0; left < kWidth; left += kScalarWidth) {
+        convert(converter, src, scalar, kWidth, kHeight, left, left + kScalarWidth - 1);
+    }
+
+    const size_t bpp = getBytesPerPixel(mDstFormat);
+    for (size_t i = 0; i < simd.size(); i += bpp) {
+        ASSERT_EQ(0, memcmp(&scalar[i], &simd[i], bpp))
+                << "row " << i / bpp / kWidth << " column " << i / bpp % kWidth;
+    }
+}
+
+// Images converted in bands of rows on several threads are identical to the images converted
+// on the calling thread.
+TEST_P(ColorConverterTest, BandedMatchesSerial) {
+    // Large enough for a few bands, and an odd number of chroma rows per band.
+    constexpr size_t kWidth = 1280;
+    constexpr size_t kHeight = 722;
+    ColorConverter converter(mSrcFormat, mDstFormat);
+    ASSERT_TRUE(converter.isValid());
+    const std::vector<uint8_t> src = makeFrame(kWidth, kHeight);
+
+    std::vector<uint8_t> serial(getFrameSize(mDstFormat, kWidth, kHeight));
+    convert(converter, src, serial, kWidth, kHeight, 0, kWidth - 1);
+    converter.setNumThreads(4);
+    std::vector<uint8_t> banded(serial.size());
+    // Again, to also convert with the workers started by the first image.
+    for (int i = 0; i < 2; i++) {
+        convert(converter, src, banded, kWidth, kHeight, 0, kWidth - 1);
+        ASSERT_TRUE(serial == banded) << "image " << i;
+    }
+}
+
+static const ConversionParams k10BitConversions[] = {
+        {OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_FormatYUV444Y410},
+        {(OMX_COLOR_FORMATTYPE)COLOR_FormatYUVP010,
+         (OMX_COLOR_FORMATTYPE)COLOR_Format32bitABGR2101010},
+};
+
+INSTANTIATE_TEST_SUITE_P(ColorConverter, ColorConverter10BitTest,
+                         ::testing::ValuesIn(k10BitConversions));
+
+INSTANTIATE_TEST_SUITE_P(
+        ColorConverter, ColorConverterTest,
+        ::testing::Values(
+                k10BitConversions[0], k10BitConversions[1],
+                ConversionParams(OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format32BitRGBA8888)));
@@ -66,6 +66,18 @@ struct CodecParameterDescriptor {
     AMessage::Type type;
 };
 
+/**
+ * Access unit in an input or output buffer holding multiple access units. The
+ * access units are laid out back to back in the buffer.
+ *
+ * A list of these is carried in the "accessUnitInfo" ABuffer of the buffer meta.
+ */
+struct AccessUnitInfo {
+    uint32_t mFlags;     // BUFFER_FLAG_*
+    uint32_t mSize;
+    int64_t mTimestamp;  // in microseconds
+};
+
 struct CodecBase : public AHandler, /* static */ ColorUtils {
     /**
      * This interface defines events firing from CodecBase back to MediaCodec.
@@ -333,6 +345,12 @@ public:
     virtual void setCrypto(const sp<ICrypto> &) {}
     virtual void setDescrambler(const sp<IDescrambler> &) {}
 
+    /**
+     * Return the maximum number of access units the codec takes in one input
+     * buffer, described by the "accessUnitInfo" buffer meta.
+     */
+    virtual size_t getMaxInputAccessUnits() const { return 1u; }
+
     /**
      * Queue an input buffer into the buffer channel.
      *
@@ -42,6 +42,11 @@ struct ColorConverter {
 
     void setSrcColorSpace(uint32_t standard, uint32_t range, uint32_t transfer);
 
+    // Allows convert() to split large images into bands of rows that are converted on up
+    // to |numThreads| threads, including the calling one. The default of 1 converts the
+    // whole image on the calling thread.
+    void setNumThreads(size_t numThreads);
+
     status_t convert(
             const void *srcBits,
             size_t srcWidth, size_t srcHeight, size_t srcStride,
@@ -161,11 +166,15 @@ private:
         size_t mBpp, mStride;
     };
 
+    // Bands of rows handed to each thread are at least this large.
+    static constexpr size_t kMinPixelsPerBand = 256 * 1024;
+
     OMX_COLOR_FORMATTYPE mSrcFormat, mDstFormat;
     std::optional<Image> mSrcImage;
     ColorSpace mSrcColorSpace;
     uint8_t *mClip;
     uint16_t *mClip10Bit;
+    size_t mNumThreads;
 
     uint8_t *initClip();
     uint16_t *initClip10Bit();
@@ -183,6 +192,10 @@ private:
             size_t *u_stride,
             size_t *v_stride) const;
 
+    // converts the crop rectangle of src into dst on the calling thread
+    status_t convertRows(
+        const BitmapParams &src, const BitmapParams &dst);
+
     status_t convertYUVMediaImage(
         const BitmapParams &src, const BitmapParams &dst);
 
@@ -158,6 +158,10 @@ public:
         return -1;
     }
 
+    // Hint that [offset, offset + size) is about to be read sequentially, so that
+    // sources backed by local storage can start fetching it. Purely advisory.
+    virtual void hintReadAhead(off64_t /*offset*/, size_t /*size*/) {}
+
 protected:
     virtual ~DataSourceBase() {}
 
@@ -26,6 +26,7 @@
 #include <map>
 #include <media/stagefright/foundation/AHandlerReflector.h>
 #include <media/stagefright/foundation/ALooper.h>
+#include <memory>
 #include <mutex>
 #include <queue>
 
@@ -68,6 +69,10 @@ public:
     void endBox();
     uint32_t interleaveDuration() const { return mInterleaveDurationUs; }
     status_t setInterleaveDuration(uint32_t duration);
+    // Hands file writes to a separate thread that writes them out in large aligned
+    // batches, so that slow storage does not stall the muxer. Takes effect on start().
+    // Defaults to the media.mp4writer.write_behind property.
+    void setWriteBehind(bool enable) { mWriteBehindEnabled = enable; }
     int32_t getTimeScale() const { return mTimeScale; }
 
     status_t setGeoData(int latitudex10000, int longitudex10000);
@@ -83,6 +88,7 @@ protected:
 
 private:
     class Track;
+    class WriteBehind;
     friend struct AHandlerReflector<MPEG4Writer>;
 
     enum {
@@ -133,6 +139,8 @@ private:
     std::priority_queue<std::chrono::microseconds, std::vector<std::chrono::microseconds>,
                         std::greater<std::chrono::microseconds>> mWriteDurationPQ;
     const uint8_t kWriteDurationsCount = 5;
+    bool mWriteBehindEnabled;
+    std::unique_ptr<WriteBehind> mWriteBehind;
 
     sp<ALooper> mLooper;
     sp<AHandlerReflector<MPEG4Writer> > mReflector;
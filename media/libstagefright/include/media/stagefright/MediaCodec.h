@@ -51,6 +51,7 @@ class ClientConfigParcel;
 namespace android {
 
 struct ABuffer;
+struct AccessUnitInfo;
 struct AMessage;
 struct AReplyToken;
 struct AString;
@@ -185,6 +186,16 @@ struct MediaCodec : public AHandler {
             uint32_t flags,
             AString *errorDetailMsg = NULL);
 
+    // Queues an input buffer holding the access units described by |infos|,
+    // back to back. The codec must take multiple access units per input
+    // buffer, see BufferChannelBase::getMaxInputAccessUnits().
+    status_t queueInputBuffers(
+            size_t index,
+            size_t offset,
+            size_t size,
+            const std::vector<AccessUnitInfo> &infos,
+            AString *errorDetailMsg = NULL);
+
     status_t queueSecureInputBuffer(
             size_t index,
             size_t offset,
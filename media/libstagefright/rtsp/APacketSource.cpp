@@ -341,8 +341,14 @@ static bool ExtractDimensionsMPEG4Config(
     size_t offset = 0;
     bool foundVOL = false;
     while (offset + 3 < config->size()) {
-        if (memcmp("\x00\x00\x01", &ptr[offset], 3)
-                || (ptr[offset + 3] & 0xf0) != 0x20) {
+        const uint8_t *startCode =
+                findStartCodePrefix(&ptr[offset], config->size() - 1 - offset);
+        if (startCode == NULL) {
+            break;
+        }
+        offset = startCode - ptr;
+
+        if ((ptr[offset + 3] & 0xf0) != 0x20) {
             ++offset;
             continue;
         }
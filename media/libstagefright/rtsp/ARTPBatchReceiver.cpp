@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ARTPBatchReceiver"
+#include <utils/Log.h>
+
+#include <media/stagefright/rtsp/ARTPBatchReceiver.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/ADebug.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/select.h>
+#include <unistd.h>
+
+namespace android {
+
+// Room for the IP_TOS or IPV6_TCLASS ancillary data of a datagram.
+static const size_t kControlSize = CMSG_SPACE(sizeof(int));
+
+ARTPBatchReceiver::ARTPBatchReceiver(size_t batchSize, bool useEpoll)
+    : mEpollFd(useEpoll ? epoll_create1(EPOLL_CLOEXEC) : -1),
+      mBatchSize(batchSize) {
+    if (useEpoll && mEpollFd < 0) {
+        ALOGW("failed to create epoll instance, polling with select. cause=%s",
+                strerror(errno));
+    }
+
+    mHeaders.insertAt(0, mBatchSize);
+    mIovecs.insertAt(0, mBatchSize);
+    mControl.insertAt(0, mBatchSize * kControlSize);
+    for (size_t i = 0; i < mBatchSize; ++i) {
+        mBuffers.push_back(new ABuffer(kMaxDatagramSize));
+    }
+}
+
+ARTPBatchReceiver::~ARTPBatchReceiver() {
+    if (mEpollFd >= 0) {
+        close(mEpollFd);
+        mEpollFd = -1;
+    }
+}
+
+status_t ARTPBatchReceiver::addSocket(int s) {
+    if (mEpollFd >= 0) {
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = s;
+        if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, s, &event) < 0) {
+            status_t err = -errno;
+            ALOGW("failed to poll socket(%d). cause=%s", s, strerror(-err));
+            return err;
+        }
+    } else if (s < 0 || s >= FD_SETSIZE) {
+        ALOGW("failed to poll socket(%d). cause=out of select range", s);
+        return -EBADF;
+    }
+    mSockets.push_back(s);
+    return OK;
+}
+
+void ARTPBatchReceiver::removeSocket(int s) {
+    for (size_t i = 0; i < mSockets.size(); ++i) {
+        if (mSockets[i] == s) {
+            // The socket may have been closed already, which removed it
+            // from the epoll instance.
+            if (mEpollFd >= 0) {
+                epoll_ctl(mEpollFd, EPOLL_CTL_DEL, s, NULL);
+            }
+            mSockets.removeAt(i);
+            return;
+        }
+    }
+}
+
+status_t ARTPBatchReceiver::poll(int64_t timeoutUs, Vector<int> *readySockets) {
+    readySockets->clear();
+    if (mSockets.empty()) {
+        return OK;
+    }
+    if (mEpollFd < 0) {
+        return pollWithSelect(timeoutUs, readySockets);
+    }
+    if (mEvents.size() < mSockets.size()) {
+        mEvents.insertAt(mEvents.size(), mSockets.size() - mEvents.size());
+    }
+
+    int n;
+    do {
+        n = epoll_wait(mEpollFd, mEvents.editArray(), mEvents.size(),
+                (int)((timeoutUs + 999) / 1000));
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        status_t err = -errno;
+        ALOGW("failed to poll sockets. cause=%s", strerror(-err));
+        return err;
+    }
+    for (int i = 0; i < n; ++i) {
+        readySockets->push_back(mEvents[i].data.fd);
+    }
+    return OK;
+}
+
+status_t ARTPBatchReceiver::pollWithSelect(int64_t timeoutUs, Vector<int> *readySockets) {
+    fd_set rs;
+    FD_ZERO(&rs);
+
+    int maxSocket = -1;
+    for (size_t i = 0; i < mSockets.size(); ++i) {
+        FD_SET(mSockets[i], &rs);
+        if (mSockets[i] > maxSocket) {
+            maxSocket = mSockets[i];
+        }
+    }
+
+    struct timeval tv;
+    tv.tv_sec = timeoutUs / 1000000ll;
+    tv.tv_usec = timeoutUs % 1000000ll;
+
+    int n;
+    do {
+        n = select(maxSocket + 1, &rs, NULL, NULL, &tv);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        status_t err = -errno;
+        ALOGW("failed to select sockets. cause=%s", strerror(-err));
+        return err;
+    }
+    for (size_t i = 0; n > 0 && i < mSockets.size(); ++i) {
+        if (FD_ISSET(mSockets[i], &rs)) {
+            readySockets->push_back(mSockets[i]);
+        }
+    }
+    return OK;
+}
+
+ssize_t ARTPBatchReceiver::receive(int s) {
+    struct mmsghdr *headers = mHeaders.editArray();
+    struct iovec *iovecs = mIovecs.editArray();
+    uint8_t *control = mControl.editArray();
+    for (size_t i = 0; i < mBatchSize; ++i) {
+        iovecs[i].iov_base = mBuffers[i]->data();
+        iovecs[i].iov_len = mBuffers[i]->capacity();
+
+        memset(&headers[i], 0, sizeof(headers[i]));
+        headers[i].msg_hdr.msg_iov = &iovecs[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+        headers[i].msg_hdr.msg_control = control + i * kControlSize;
+        headers[i].msg_hdr.msg_controllen = kControlSize;
+    }
+
+    int n;
+    do {
+        n = recvmmsg(s, headers, mBatchSize, MSG_DONTWAIT, NULL);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        return -errno;
+    }
+    return n;
+}
+
+sp<ABuffer> ARTPBatchReceiver::getDatagram(size_t i) const {
+    CHECK_LT(i, mBatchSize);
+    size_t size = mHeaders[i].msg_len;
+    sp<ABuffer> buffer = new ABuffer(size);
+    memcpy(buffer->data(), mBuffers[i]->data(), size);
+    return buffer;
+}
+
+const struct msghdr &ARTPBatchReceiver::getHeader(size_t i) const {
+    CHECK_LT(i, mBatchSize);
+    return mHeaders[i].msg_hdr;
+}
+
+}  // namespace android
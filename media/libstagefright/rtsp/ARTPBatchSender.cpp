@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ARTPBatchSender"
+#include <utils/Log.h>
+
+#include <media/stagefright/rtsp/ARTPBatchSender.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/ADebug.h>
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <string.h>
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+namespace android {
+
+// Room for the UDP_SEGMENT ancillary data of a message.
+static const size_t kControlSize = CMSG_SPACE(sizeof(uint16_t));
+
+ARTPBatchSender::ARTPBatchSender(size_t maxPacketSize, size_t batchSize)
+    : mBatchSize(batchSize),
+      mNumQueued(0),
+      mSegmentation(false),
+      mNumSendCalls(0) {
+    CHECK_GT(mBatchSize, 0u);
+
+    mHeaders.insertAt(0, mBatchSize);
+    mIovecs.insertAt(0, mBatchSize);
+    mControl.insertAt(0, mBatchSize * kControlSize);
+    mMessagePackets.insertAt(0, mBatchSize);
+    for (size_t i = 0; i < mBatchSize; ++i) {
+        mBuffers.push_back(new ABuffer(maxPacketSize));
+    }
+}
+
+ARTPBatchSender::~ARTPBatchSender() {
+}
+
+bool ARTPBatchSender::enableSegmentation(int s) {
+    int segmentSize = 0;
+    socklen_t size = sizeof(segmentSize);
+    mSegmentation = getsockopt(s, SOL_UDP, UDP_SEGMENT, &segmentSize, &size) == 0;
+    if (!mSegmentation) {
+        ALOGI("no segmentation offload on socket(%d). cause=%s", s, strerror(errno));
+    }
+    return mSegmentation;
+}
+
+void ARTPBatchSender::disableSegmentation() {
+    mSegmentation = false;
+}
+
+sp<ABuffer> ARTPBatchSender::nextPacket() const {
+    CHECK_LT(mNumQueued, mBatchSize);
+    return mBuffers[mNumQueued];
+}
+
+void ARTPBatchSender::queuePacket() {
+    CHECK_LT(mNumQueued, mBatchSize);
+    const sp<ABuffer> &buffer = mBuffers[mNumQueued];
+    struct iovec *iovec = &mIovecs.editItemAt(mNumQueued);
+    iovec->iov_base = buffer->data();
+    iovec->iov_len = buffer->size();
+    ++mNumQueued;
+}
+
+sp<ABuffer> ARTPBatchSender::getPacket(size_t i) const {
+    CHECK_LT(i, mNumQueued);
+    return mBuffers[i];
+}
+
+size_t ARTPBatchSender::prepareMessages(
+        size_t firstPacket, const struct sockaddr *addr, socklen_t addrLen) {
+    struct mmsghdr *headers = mHeaders.editArray();
+    struct iovec *iovecs = mIovecs.editArray();
+    size_t numMessages = 0;
+
+    size_t packet = firstPacket;
+    while (packet < mNumQueued) {
+        // Every segment but the last one has the size of the first one.
+        const size_t segmentSize = iovecs[packet].iov_len;
+        size_t size = segmentSize;
+        size_t end = packet + 1;
+        if (mSegmentation && segmentSize > 0) {
+            while (end < mNumQueued && end - packet < kMaxSegments
+                    && iovecs[end].iov_len <= segmentSize
+                    && size + iovecs[end].iov_len <= kMaxDatagramSize) {
+                size += iovecs[end].iov_len;
+                if (iovecs[end++].iov_len < segmentSize) {
+                    break;
+                }
+            }
+        }
+
+        struct msghdr *header = &headers[numMessages].msg_hdr;
+        memset(&headers[numMessages], 0, sizeof(headers[numMessages]));
+        header->msg_name = const_cast<struct sockaddr *>(addr);
+        header->msg_namelen = addrLen;
+        header->msg_iov = &iovecs[packet];
+        header->msg_iovlen = end - packet;
+        if (end - packet > 1) {
+            header->msg_control = mControl.editArray() + numMessages * kControlSize;
+            header->msg_controllen = kControlSize;
+
+            struct cmsghdr *cmsg = CMSG_FIRSTHDR(header);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t gsoSize = segmentSize;
+            memcpy(CMSG_DATA(cmsg), &gsoSize, sizeof(gsoSize));
+        }
+        mMessagePackets.editItemAt(numMessages) = end - packet;
+
+        ++numMessages;
+        packet = end;
+    }
+    return numMessages;
+}
+
+ssize_t ARTPBatchSender::flush(int s, const struct sockaddr *addr, socklen_t addrLen,
+        size_t *numBytesSent) {
+    *numBytesSent = 0;
+    size_t numPacketsSent = 0;
+    status_t err = OK;
+
+    size_t packet = 0;
+    while (packet < mNumQueued) {
+        const size_t numMessages = prepareMessages(packet, addr, addrLen);
+        size_t message = 0;
+        while (message < numMessages) {
+            int n = sendmmsg(s, mHeaders.editArray() + message, numMessages - message, 0);
+            ++mNumSendCalls;
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                err = -errno;
+                if (mMessagePackets[message] > 1 && (err == -EIO || err == -EINVAL)) {
+                    // The route can not offload the segmentation, e.g. with
+                    // IPsec. Resend the packets of the message one by one.
+                    ALOGW("segmentation offload is rejected. cause=%s", strerror(-err));
+                    mSegmentation = false;
+                    break;
+                }
+                ALOGW("packets can not be sent. cause=%s", strerror(-err));
+                packet += mMessagePackets[message];
+                ++message;
+                continue;
+            }
+            for (int i = 0; i < n; ++i, ++message) {
+                numPacketsSent += mMessagePackets[message];
+                *numBytesSent += mHeaders[message].msg_len;
+                packet += mMessagePackets[message];
+            }
+        }
+    }
+    mNumQueued = 0;
+
+    if (numPacketsSent == 0 && err != OK) {
+        return err;
+    }
+    return numPacketsSent;
+}
+
+}  // namespace android
@@ -25,6 +25,7 @@
 #include <utils/Log.h>
 
 #include <media/stagefright/rtsp/ARTPAssembler.h>
+#include <media/stagefright/rtsp/ARTPBatchReceiver.h>
 #include <media/stagefright/rtsp/ARTPConnection.h>
 #include <media/stagefright/rtsp/ARTPSource.h>
 #include <media/stagefright/rtsp/ASessionDescription.h>
@@ -63,6 +64,9 @@ static uint64_t u64at(const uint8_t *data) {
 // static
 const int64_t ARTPConnection::kSelectTimeoutUs = 1000LL;
 const int64_t ARTPConnection::kMinOneSecondNotifyDelayUs = 100000ll;
+// Datagrams received from a socket per wakeup, before the other sockets and
+// messages get their turn.
+const size_t ARTPConnection::kMaxDatagramsPerWakeup = 64;
 
 struct ARTPConnection::StreamInfo {
     bool isIPv6;
@@ -82,6 +86,11 @@ struct ARTPConnection::StreamInfo {
 
     // A place to save time when it polls
     int64_t mLastPollTimeUs;
+    // Number of wakeups of the poll loop with datagrams to receive, and
+    // number of datagrams received in these wakeups.
+    int64_t mNumReceiveWakeups;
+    int64_t mNumDatagramsReceived;
+    size_t mMaxDatagramsPerWakeup;
     // RTCP Extension for CVO
     int mCVOExtMap; // will be set to 0 if cvo is not negotiated in sdp
 };
@@ -96,6 +105,7 @@ ARTPConnection::ARTPConnection(uint32_t flags)
       mRtpSockOptEcn(0),
       mIsIPv6(false),
       mStaticJitterTimeMs(kStaticJitterTimeMs) {
+    mReceiver = new ARTPBatchReceiver();
 }
 
 ARTPConnection::~ARTPConnection() {
@@ -381,6 +391,9 @@ void ARTPConnection::onAddStream(const sp<AMessage> &msg) {
 
     info->mNumRTCPPacketsReceived = 0;
     info->mNumRTPPacketsReceived = 0;
+    info->mNumReceiveWakeups = 0;
+    info->mNumDatagramsReceived = 0;
+    info->mMaxDatagramsPerWakeup = 0;
     memset(&info->mRemoteRTCPAddr, 0, sizeof(info->mRemoteRTCPAddr));
     memset(&info->mRemoteRTCPAddr6, 0, sizeof(info->mRemoteRTCPAddr6));
 
@@ -397,6 +410,26 @@ void ARTPConnection::onAddStream(const sp<AMessage> &msg) {
     }
 
     if (!injected) {
+        status_t err = mReceiver->addSocket(info->mRTPSocket);
+        if (err == OK) {
+            err = mReceiver->addSocket(info->mRTCPSocket);
+            if (err != OK) {
+                mReceiver->removeSocket(info->mRTPSocket);
+            }
+        }
+        if (err != OK) {
+            // Same event as a socket failure while receiving.
+            sp<AMessage> notify = info->mNotifyMsg->dup();
+            notify->setInt32("rtcp-event", 1);
+            notify->setInt32("payload-type", 400);
+            notify->setInt32("feedback-type", 1);
+            notify->setInt32("sender", 0);
+            notify->post();
+
+            ALOGE("failed to poll RTP/RTCP sockets of stream %zu.", info->mIndex);
+            mStreams.erase(--mStreams.end());
+            return;
+        }
         postPollEvent();
     }
 }
@@ -428,6 +461,14 @@ void ARTPConnection::onRemoveStream(const sp<AMessage> &msg) {
         return;
     }
 
+    if (!it->mIsInjected) {
+        ALOGI("stream %zu received %lld datagrams in %lld wakeups, at most %zu per wakeup",
+                it->mIndex, (long long)it->mNumDatagramsReceived,
+                (long long)it->mNumReceiveWakeups, it->mMaxDatagramsPerWakeup);
+        mReceiver->removeSocket(it->mRTPSocket);
+        mReceiver->removeSocket(it->mRTCPSocket);
+    }
+
     mStreams.erase(it);
 }
 
@@ -449,39 +490,24 @@ void ARTPConnection::onPollStreams() {
         return;
     }
 
-    struct timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = kSelectTimeoutUs;
-
-    fd_set rs;
-    FD_ZERO(&rs);
-
-    int maxSocket = -1;
+    bool hasSockets = false;
     for (List<StreamInfo>::iterator it = mStreams.begin();
          it != mStreams.end(); ++it) {
-        if ((*it).mIsInjected) {
-            continue;
-        }
-
-        FD_SET(it->mRTPSocket, &rs);
-        FD_SET(it->mRTCPSocket, &rs);
-
-        if (it->mRTPSocket > maxSocket) {
-            maxSocket = it->mRTPSocket;
-        }
-        if (it->mRTCPSocket > maxSocket) {
-            maxSocket = it->mRTCPSocket;
+        if (!(*it).mIsInjected) {
+            hasSockets = true;
+            break;
         }
     }
 
-    if (maxSocket == -1) {
+    if (!hasSockets) {
         return;
     }
 
     int64_t nowUs = ALooper::GetNowUs();
-    int res = select(maxSocket + 1, &rs, NULL, NULL, &tv);
+    Vector<int> readySockets;
+    status_t res = mReceiver->poll(kSelectTimeoutUs, &readySockets);
 
-    if (res > 0) {
+    if (res == OK && !readySockets.empty()) {
         List<StreamInfo>::iterator it = mStreams.begin();
         while (it != mStreams.end()) {
             if ((*it).mIsInjected) {
@@ -490,12 +516,28 @@ void ARTPConnection::onPollStreams() {
             }
             it->mLastPollTimeUs = nowUs;
 
+            bool rtpReady = false;
+            bool rtcpReady = false;
+            for (size_t i = 0; i < readySockets.size(); ++i) {
+                rtpReady |= readySockets[i] == it->mRTPSocket;
+                rtcpReady |= readySockets[i] == it->mRTCPSocket;
+            }
+
             status_t err = OK;
-            if (FD_ISSET(it->mRTPSocket, &rs)) {
-                err = receive(&*it, true);
+            size_t numDatagrams = 0;
+            if (rtpReady) {
+                err = receive(&*it, true, &numDatagrams);
             }
-            if (err == OK && FD_ISSET(it->mRTCPSocket, &rs)) {
-                err = receive(&*it, false);
+            if (err == OK && rtcpReady) {
+                err = receive(&*it, false, &numDatagrams);
+            }
+
+            if (numDatagrams > 0) {
+                ++it->mNumReceiveWakeups;
+                it->mNumDatagramsReceived += numDatagrams;
+                if (numDatagrams > it->mMaxDatagramsPerWakeup) {
+                    it->mMaxDatagramsPerWakeup = numDatagrams;
+                }
             }
 
             if (err == -ECONNRESET) {
@@ -510,6 +552,8 @@ void ARTPConnection::onPollStreams() {
 
                     ALOGW("failed to receive RTP/RTCP datagram.");
                 }
+                mReceiver->removeSocket(it->mRTPSocket);
+                mReceiver->removeSocket(it->mRTCPSocket);
                 it = mStreams.erase(it);
                 continue;
             }
@@ -614,62 +658,60 @@ void ARTPConnection::onAlarmStream(const sp<AMessage> msg) {
     }
 }
 
-status_t ARTPConnection::receive(StreamInfo *s, bool receiveRTP) {
+// Receives the datagrams queued on the RTP or RTCP socket of a stream, in
+// batches, up to kMaxDatagramsPerWakeup, and adds their number to
+// |numDatagrams|.
+status_t ARTPConnection::receive(StreamInfo *s, bool receiveRTP, size_t *numDatagrams) {
     ALOGV("receiving %s", receiveRTP ? "RTP" : "RTCP");
 
     CHECK(!s->mIsInjected);
 
-    sp<ABuffer> buffer = new ABuffer(65536);
-
-    struct msghdr sMsg = {};
-    struct iovec sIov[1] = {};
-
-    sIov[0].iov_base = (char *) buffer->data();
-    sIov[0].iov_len = buffer->capacity();
+    int sock = receiveRTP ? s->mRTPSocket : s->mRTCPSocket;
+    size_t numReceived = 0;
+    while (numReceived < kMaxDatagramsPerWakeup) {
+        ssize_t n = mReceiver->receive(sock);
 
-    sMsg.msg_iov = sIov;
-    sMsg.msg_iovlen = 1;
+        if (n < 0) {
+            if (numReceived > 0) {
+                // The error is reported again by the next receive.
+                break;
+            }
+            ALOGW("failed to recv rtp packet. cause=%s", strerror(-n));
+            // ECONNREFUSED may happen in next recvfrom() calling if one of
+            // outgoing packet can not be delivered to remote by using sendto()
+            if (n == -ECONNREFUSED) {
+                return -ECONNREFUSED;
+            } else {
+                return -ECONNRESET;
+            }
+        }
 
-    int cMsgSize = sizeof(struct cmsghdr) + sizeof(uint8_t);
-    char buf[CMSG_SPACE(cMsgSize)];
-    sMsg.msg_control = buf;
-    sMsg.msg_controllen = sizeof(buf);
-    sMsg.msg_flags = 0;
+        for (ssize_t i = 0; i < n; ++i) {
+            sp<ABuffer> buffer = mReceiver->getDatagram(i);
+            if (buffer->size() == 0) {
+                continue;
+            }
+            mCumulativeBytes += buffer->size();
 
-    ssize_t nbytes;
-    do {
-        // Used recvmsg to get the TOS header of incoming packet
-        nbytes = recvmsg(receiveRTP ? s->mRTPSocket : s->mRTCPSocket, &sMsg, 0);
-        mCumulativeBytes += nbytes;
-    } while (nbytes < 0 && errno == EINTR);
+            handleIpHeadersIfReceived(s, mReceiver->getHeader(i));
 
-    if (nbytes <= 0) {
-        ALOGW("failed to recv rtp packet. cause=%s", strerror(errno));
-        // ECONNREFUSED may happen in next recvfrom() calling if one of
-        // outgoing packet can not be delivered to remote by using sendto()
-        if (errno == ECONNREFUSED) {
-            return -ECONNREFUSED;
-        } else {
-            return -ECONNRESET;
+            if (receiveRTP) {
+                parseRTP(s, buffer);
+            } else {
+                parseRTCP(s, buffer);
+            }
         }
-    }
 
-    if (nbytes > 0) {
-        handleIpHeadersIfReceived(s, sMsg);
+        numReceived += n;
+        if ((size_t)n < mReceiver->batchSize()) {
+            // no more datagrams queued
+            break;
+        }
     }
 
-    buffer->setRange(0, nbytes);
+    *numDatagrams += numReceived;
 
-    // ALOGI("received %d bytes.", buffer->size());
-
-    status_t err;
-    if (receiveRTP) {
-        err = parseRTP(s, buffer);
-    } else {
-        err = parseRTCP(s, buffer);
-    }
-
-    return err;
+    return OK;
 }
 
 /* This function will check if TOS is present or not in received IP packet.
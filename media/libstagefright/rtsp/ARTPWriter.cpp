@@ -19,6 +19,7 @@
 #include <utils/Log.h>
 
 #include <media/stagefright/rtsp/ARTPWriter.h>
+#include <media/stagefright/rtsp/ARTPBatchSender.h>
 
 #include <media/stagefright/MediaSource.h>
 #include <media/stagefright/foundation/ABuffer.h>
@@ -78,7 +79,8 @@ ARTPWriter::ARTPWriter(int fd)
       mLooper(new ALooper),
       mReflector(new AHandlerReflector<ARTPWriter>(this)),
       mTrafficRec(new TrafficRecorder<uint32_t /* Time */, Bytes>(
-              kTrafficRecorderMaxEntries, kTrafficRecorderMaxTimeSpanMs)) {
+              kTrafficRecorderMaxEntries, kTrafficRecorderMaxTimeSpanMs)),
+      mSender(new ARTPBatchSender(kMaxPacketSize)) {
     CHECK_GE(fd, 0);
     mIsIPv6 = false;
 
@@ -90,6 +92,7 @@ ARTPWriter::ARTPWriter(int fd)
     CHECK_GE(mRTPSocket, 0);
     mRTCPSocket = socket(AF_INET, SOCK_DGRAM, 0);
     CHECK_GE(mRTCPSocket, 0);
+    mSender->enableSegmentation(mRTPSocket);
 
     memset(mRTPAddr.sin_zero, 0, sizeof(mRTPAddr.sin_zero));
     mRTPAddr.sin_family = AF_INET;
@@ -131,7 +134,8 @@ ARTPWriter::ARTPWriter(int fd, String8& localIp, int localPort, String8& remoteI
       mLooper(new ALooper),
       mReflector(new AHandlerReflector<ARTPWriter>(this)),
       mTrafficRec(new TrafficRecorder<uint32_t /* Time */, Bytes>(
-              kTrafficRecorderMaxEntries, kTrafficRecorderMaxTimeSpanMs)) {
+              kTrafficRecorderMaxEntries, kTrafficRecorderMaxTimeSpanMs)),
+      mSender(new ARTPBatchSender(kMaxPacketSize)) {
     CHECK_GE(fd, 0);
     mIsIPv6 = false;
 
@@ -626,23 +630,25 @@ void ARTPWriter::onSendSR(const sp<AMessage> &msg) {
     msg->post(3000000);
 }
 
-void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
-    int sizeSockSt;
-    struct sockaddr *remAddr;
-
+struct sockaddr *ARTPWriter::getRemoteAddr(bool isRTCP, socklen_t *sizeSockSt) {
     if (mIsIPv6) {
-        sizeSockSt = sizeof(struct sockaddr_in6);
+        *sizeSockSt = sizeof(struct sockaddr_in6);
         if (isRTCP)
-            remAddr = (struct sockaddr *)&mRTCPAddr6;
+            return (struct sockaddr *)&mRTCPAddr6;
         else
-            remAddr = (struct sockaddr *)&mRTPAddr6;
+            return (struct sockaddr *)&mRTPAddr6;
     } else {
-        sizeSockSt = sizeof(struct sockaddr_in);
+        *sizeSockSt = sizeof(struct sockaddr_in);
         if (isRTCP)
-            remAddr = (struct sockaddr *)&mRTCPAddr;
+            return (struct sockaddr *)&mRTCPAddr;
         else
-            remAddr = (struct sockaddr *)&mRTPAddr;
+            return (struct sockaddr *)&mRTPAddr;
     }
+}
+
+void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
+    socklen_t sizeSockSt;
+    struct sockaddr *remAddr = getRemoteAddr(isRTCP, &sizeSockSt);
 
     // Unseal code if moderator is needed (prevent overflow of instant bandwidth)
     // Set limit bits per period through the moderator.
@@ -672,6 +678,50 @@ void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
 #endif
 }
 
+void ARTPWriter::queueRTP(const sp<ABuffer> &buffer) {
+    CHECK(buffer == mSender->nextPacket());
+    mSender->queuePacket();
+
+#if LOG_TO_FILES
+    uint32_t ms = tolel(ALooper::GetNowUs() / 1000ll);
+    uint32_t length = tolel(buffer->size());
+    write(mRTPFd, &ms, sizeof(ms));
+    write(mRTPFd, &length, sizeof(length));
+    write(mRTPFd, buffer->data(), buffer->size());
+#endif
+
+    if (mSender->isFull()) {
+        flushRTP();
+    }
+}
+
+void ARTPWriter::flushRTP() {
+    const size_t numPackets = mSender->numQueued();
+    if (numPackets == 0) {
+        return;
+    }
+
+    socklen_t sizeSockSt;
+    struct sockaddr *remAddr = getRemoteAddr(false /* isRTCP */, &sizeSockSt);
+
+    // Unseal code if moderator is needed (prevent overflow of instant bandwidth)
+    // It paces the batches of up to ARTPBatchSender::batchSize() packets.
+    // ModerateInstantTraffic(10, 6 * 1024);
+
+    size_t numBytes;
+    ssize_t n = mSender->flush(mRTPSocket, remAddr, sizeSockSt, &numBytes);
+
+    if (n != (ssize_t)numPackets) {
+        ALOGW("packets can not be sent. ret=%d, packets=%zu", (int)n, numPackets);
+    }
+    if (n > 0) {
+        // Record current traffic & Print bits while last 1sec (1000ms)
+        mTrafficRec->writeBytes(numBytes +
+                n * (mIsIPv6 ? TCPIPV6_HEADER_SIZE : TCPIPV4_HEADER_SIZE));
+        mTrafficRec->printAccuBitsForLastPeriod(1000, 1000);
+    }
+}
+
 void ARTPWriter::addSR(const sp<ABuffer> &buffer) {
     uint8_t *data = buffer->data() + buffer->size();
 
@@ -1047,7 +1097,7 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
         isNonVCL = 1;
     }
 
-    sp<ABuffer> buffer = new ABuffer(kMaxPacketSize);
+    sp<ABuffer> buffer = mSender->nextPacket();
     if (mediaBuf->range_length() + TCPIP_HEADER_SIZE + RTP_HEADER_SIZE + RTP_HEADER_EXT_SIZE
             + RTP_PAYLOAD_ROOM_SIZE <= buffer->capacity()) {
         // The data fits into a single packet
@@ -1112,7 +1162,7 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
 
         buffer->setRange(0, mediaBuf->range_length() + (12 + rtpExtIndex));
 
-        send(buffer, false /* isRTCP */);
+        queueRTP(buffer);
 
         ++mSeqNo;
         ++mNumRTPSent;
@@ -1126,6 +1176,7 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
 
         bool firstPacket = true;
         while (offset < mediaBuf->range_length()) {
+            buffer = mSender->nextPacket();
             size_t size = mediaBuf->range_length() - offset;
             bool lastPacket = true;
             if (size + TCPIP_HEADER_SIZE + RTP_HEADER_SIZE + RTP_HEADER_EXT_SIZE +
@@ -1199,7 +1250,7 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
 
             buffer->setRange(0, 15 + rtpExtIndex + size);
 
-            send(buffer, false /* isRTCP */);
+            queueRTP(buffer);
 
             ++mSeqNo;
             ++mNumRTPSent;
@@ -1209,6 +1260,8 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
             offset += size;
         }
     }
+
+    flushRTP();
 }
 
 void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
@@ -1234,7 +1287,7 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
     }
 
     mTrafficRec->updateClock(ALooper::GetNowUs() / 1000);
-    sp<ABuffer> buffer = new ABuffer(kMaxPacketSize);
+    sp<ABuffer> buffer = mSender->nextPacket();
     if (mediaBuf->range_length() + TCPIP_HEADER_SIZE + RTP_HEADER_SIZE + RTP_HEADER_EXT_SIZE
             + RTP_PAYLOAD_ROOM_SIZE <= buffer->capacity()) {
         // The data fits into a single packet
@@ -1299,7 +1352,7 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
 
         buffer->setRange(0, mediaBuf->range_length() + (12 + rtpExtIndex));
 
-        send(buffer, false /* isRTCP */);
+        queueRTP(buffer);
 
         ++mSeqNo;
         ++mNumRTPSent;
@@ -1313,6 +1366,7 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
 
         bool firstPacket = true;
         while (offset < mediaBuf->range_length()) {
+            buffer = mSender->nextPacket();
             size_t size = mediaBuf->range_length() - offset;
             bool lastPacket = true;
             if (size + TCPIP_HEADER_SIZE + RTP_HEADER_SIZE + RTP_HEADER_EXT_SIZE +
@@ -1383,7 +1437,7 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
 
             buffer->setRange(0, 14 + rtpExtIndex + size);
 
-            send(buffer, false /* isRTCP */);
+            queueRTP(buffer);
 
             ++mSeqNo;
             ++mNumRTPSent;
@@ -1393,6 +1447,8 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
             offset += size;
         }
     }
+
+    flushRTP();
 }
 
 void ARTPWriter::sendH263Data(MediaBufferBase *mediaBuf) {
@@ -1637,6 +1693,7 @@ void ARTPWriter::makeSocketPairAndBind(String8& localIp, int localPort,
     CHECK_GE(mRTPSocket, 0);
     mRTCPSocket = socket(mIsIPv6 ? AF_INET6 : AF_INET, SOCK_DGRAM, 0);
     CHECK_GE(mRTCPSocket, 0);
+    mSender->enableSegmentation(mRTPSocket);
 
     int sockopt = 1;
     setsockopt(mRTPSocket, SOL_SOCKET, SO_REUSEADDR, (int *)&sockopt, sizeof(sockopt));
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef A_RTP_BATCH_RECEIVER_H_
+
+#define A_RTP_BATCH_RECEIVER_H_
+
+#include <media/stagefright/foundation/ABase.h>
+#include <utils/Errors.h>
+#include <utils/RefBase.h>
+#include <utils/Vector.h>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+namespace android {
+
+struct ABuffer;
+
+// Waits for datagrams on a set of UDP sockets with epoll, or with select if
+// epoll is unavailable, and receives the datagrams queued on a socket in
+// batches, with recvmmsg, into a pool of buffers of the maximum datagram size.
+struct ARTPBatchReceiver : public RefBase {
+    // Polls with select if |useEpoll| is false.
+    explicit ARTPBatchReceiver(size_t batchSize = kDefaultBatchSize, bool useEpoll = true);
+
+    // Returns an error if socket |s| cannot be polled, in which case it is
+    // not added.
+    status_t addSocket(int s);
+    void removeSocket(int s);
+
+    // Waits up to |timeoutUs| for added sockets to become readable, and
+    // returns them in |readySockets|.
+    status_t poll(int64_t timeoutUs, Vector<int> *readySockets);
+
+    // Receives up to a batch of the datagrams queued on socket |s|, without
+    // blocking. Returns the number of datagrams received, 0 if none is queued,
+    // or a negative errno. The datagrams and their headers, with the ancillary
+    // data, are valid until the next call.
+    ssize_t receive(int s);
+
+    // Returns a copy of the i-th datagram received, in a buffer of its size.
+    // The pool saves allocating a buffer of the maximum datagram size per
+    // datagram, but not the copy: the datagrams are queued for reassembly,
+    // and would hold on to the pool buffers.
+    sp<ABuffer> getDatagram(size_t i) const;
+    const struct msghdr &getHeader(size_t i) const;
+
+    size_t batchSize() const { return mBatchSize; }
+
+    static const size_t kDefaultBatchSize = 16;
+
+protected:
+    virtual ~ARTPBatchReceiver();
+
+private:
+    static const size_t kMaxDatagramSize = 65536;
+
+    status_t pollWithSelect(int64_t timeoutUs, Vector<int> *readySockets);
+
+    int mEpollFd;
+    const size_t mBatchSize;
+
+    Vector<int> mSockets;
+
+    Vector<sp<ABuffer> > mBuffers;
+    Vector<struct mmsghdr> mHeaders;
+    Vector<struct iovec> mIovecs;
+    Vector<uint8_t> mControl;
+    Vector<struct epoll_event> mEvents;
+
+    DISALLOW_EVIL_CONSTRUCTORS(ARTPBatchReceiver);
+};
+
+}  // namespace android
+
+#endif  // A_RTP_BATCH_RECEIVER_H_
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef A_RTP_BATCH_SENDER_H_
+
+#define A_RTP_BATCH_SENDER_H_
+
+#include <media/stagefright/foundation/ABase.h>
+#include <utils/Errors.h>
+#include <utils/RefBase.h>
+#include <utils/Vector.h>
+
+#include <sys/socket.h>
+
+namespace android {
+
+struct ABuffer;
+
+// Queues packets packetized into a pool of preallocated buffers, and sends
+// them in batches with sendmmsg. Runs of packets of the same size are sent as
+// a single UDP_SEGMENT (GSO) datagram when the socket supports it.
+struct ARTPBatchSender : public RefBase {
+    explicit ARTPBatchSender(
+            size_t maxPacketSize, size_t batchSize = kDefaultBatchSize);
+
+    // Enables segmentation offload if socket |s| supports it, and returns
+    // whether it is enabled. It is disabled again if a send is rejected.
+    bool enableSegmentation(int s);
+    void disableSegmentation();
+    bool isSegmentationEnabled() const { return mSegmentation; }
+
+    // Returns the buffer to packetize the next packet into. The packet is
+    // queued, with the range set on the buffer, by queuePacket().
+    sp<ABuffer> nextPacket() const;
+    void queuePacket();
+
+    size_t numQueued() const { return mNumQueued; }
+    bool isFull() const { return mNumQueued == mBatchSize; }
+    sp<ABuffer> getPacket(size_t i) const;
+
+    // Sends the queued packets to |addr| on socket |s|, and empties the queue.
+    // Returns the number of packets sent, with their size in |numBytesSent|,
+    // or a negative errno if none was sent.
+    ssize_t flush(int s, const struct sockaddr *addr, socklen_t addrLen,
+            size_t *numBytesSent);
+
+    size_t batchSize() const { return mBatchSize; }
+    size_t numSendCalls() const { return mNumSendCalls; }
+
+    static const size_t kDefaultBatchSize = 16;
+
+protected:
+    virtual ~ARTPBatchSender();
+
+private:
+    // Limits of a segmented datagram.
+    static const size_t kMaxSegments = 64;
+    static const size_t kMaxDatagramSize = 65507;
+
+    const size_t mBatchSize;
+    size_t mNumQueued;
+    bool mSegmentation;
+    size_t mNumSendCalls;
+
+    Vector<sp<ABuffer> > mBuffers;
+    Vector<struct mmsghdr> mHeaders;
+    Vector<struct iovec> mIovecs;
+    Vector<uint8_t> mControl;
+    // Number of packets in each message of mHeaders.
+    Vector<size_t> mMessagePackets;
+
+    size_t prepareMessages(size_t firstPacket,
+            const struct sockaddr *addr, socklen_t addrLen);
+
+    DISALLOW_EVIL_CONSTRUCTORS(ARTPBatchSender);
+};
+
+}  // namespace android
+
+#endif  // A_RTP_BATCH_SENDER_H_
@@ -25,6 +25,7 @@
 namespace android {
 
 struct ABuffer;
+struct ARTPBatchReceiver;
 struct ARTPSource;
 struct ASessionDescription;
 
@@ -82,12 +83,15 @@ private:
 
     static const int64_t kSelectTimeoutUs;
     static const int64_t kMinOneSecondNotifyDelayUs;
+    static const size_t kMaxDatagramsPerWakeup;
 
     uint32_t mFlags;
 
     struct StreamInfo;
     List<StreamInfo> mStreams;
 
+    sp<ARTPBatchReceiver> mReceiver;
+
     bool mPollEventPending;
     int64_t mLastReceiverReportTimeUs;
     int64_t mLastBitrateReportTimeUs;
@@ -114,7 +118,7 @@ private:
     void notifyCongestionToUpperLayerIfNeeded(StreamInfo *s);
     void handleIpHeadersIfReceived(StreamInfo *s, struct msghdr sMsg);
 
-    status_t receive(StreamInfo *info, bool receiveRTP);
+    status_t receive(StreamInfo *info, bool receiveRTP, size_t *numDatagrams);
     ssize_t send(const StreamInfo *info, const sp<ABuffer> buffer);
 
     status_t parseRTP(StreamInfo *info, const sp<ABuffer> &buffer);
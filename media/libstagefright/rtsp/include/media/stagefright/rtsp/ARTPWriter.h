@@ -35,6 +35,7 @@
 namespace android {
 
 struct ABuffer;
+struct ARTPBatchSender;
 class MediaBuffer;
 
 struct ARTPWriter : public MediaWriter {
@@ -122,6 +123,9 @@ private:
     typedef uint64_t Bytes;
     sp<TrafficRecorder<uint32_t /* Time */, Bytes> > mTrafficRec;
 
+    // Queues the RTP packets of an access unit, to send them at once.
+    sp<ARTPBatchSender> mSender;
+
     int32_t mNumSRsSent;
     int32_t mRTPCVOExtMap;
     int32_t mRTPCVODegrees;
@@ -157,7 +161,12 @@ private:
     void sendH263Data(MediaBufferBase *mediaBuf);
     void sendAMRData(MediaBufferBase *mediaBuf);
 
+    struct sockaddr *getRemoteAddr(bool isRTCP, socklen_t *sizeSockSt);
     void send(const sp<ABuffer> &buffer, bool isRTCP);
+    // Queues the RTP packet packetized into mSender->nextPacket(), and sends
+    // the queued packets if the queue is full.
+    void queueRTP(const sp<ABuffer> &buffer);
+    void flushRTP();
     void makeSocketPairAndBind(String8& localIp, int localPort, String8& remoteIp, int remotePort);
 
     void ModerateInstantTraffic(uint32_t samplePeriod, uint32_t limitBytes);
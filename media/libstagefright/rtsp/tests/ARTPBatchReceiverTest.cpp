@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ARTPBatchReceiverTest"
+#include <utils/Log.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/rtsp/ARTPBatchReceiver.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kBatchSize = 16;
+constexpr int64_t kTimeoutUs = 100000;
+
+uint8_t byteAt(size_t datagram, size_t offset) {
+    return datagram * 7 + offset;
+}
+
+}  // namespace
+
+// Polls with epoll, or with select.
+class ARTPBatchReceiverTest : public ::testing::TestWithParam<bool> {
+  public:
+    void SetUp() override {
+        mReceiver = new ARTPBatchReceiver(kBatchSize, GetParam() /* useEpoll */);
+        for (int &s : mSockets) {
+            s = socket(AF_INET, SOCK_DGRAM, 0);
+            ASSERT_GE(s, 0);
+            int size = 1024 * 1024;
+            setsockopt(s, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+            struct sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            ASSERT_EQ(0, bind(s, (const struct sockaddr *)&addr, sizeof(addr)));
+        }
+        mSender = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(mSender, 0);
+    }
+
+    void TearDown() override {
+        mReceiver.clear();
+        for (int s : mSockets) {
+            close(s);
+        }
+        close(mSender);
+    }
+
+    void sendDatagram(int s, size_t index, size_t size) {
+        struct sockaddr_in addr;
+        socklen_t addrLen = sizeof(addr);
+        ASSERT_EQ(0, getsockname(s, (struct sockaddr *)&addr, &addrLen));
+
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = byteAt(index, i);
+        }
+        ASSERT_EQ((ssize_t)size, sendto(mSender, data.data(), size, 0,
+                                        (const struct sockaddr *)&addr, addrLen));
+    }
+
+    static size_t datagramSize(size_t index) {
+        return 12 + (index * 131) % 1400;
+    }
+
+    // Expects the next datagrams of socket |s| to be |first| to |first| + |count|
+    // - 1, and returns the number of receive() calls.
+    size_t expectDatagrams(int s, size_t first, size_t count) {
+        size_t numReceives = 0;
+        size_t index = first;
+        while (index < first + count) {
+            ssize_t n = mReceiver->receive(s);
+            ++numReceives;
+            EXPECT_GT(n, 0);
+            if (n <= 0) {
+                break;
+            }
+            EXPECT_LE((size_t)n, kBatchSize);
+            for (ssize_t i = 0; i < n; ++i, ++index) {
+                sp<ABuffer> buffer = mReceiver->getDatagram(i);
+                EXPECT_EQ(datagramSize(index), buffer->size()) << "datagram " << index;
+                for (size_t j = 0; j < buffer->size(); ++j) {
+                    if (buffer->data()[j] != byteAt(index, j)) {
+                        ADD_FAILURE() << "datagram " << index << " differs at " << j;
+                        break;
+                    }
+                }
+            }
+        }
+        EXPECT_EQ(first + count, index);
+        return numReceives;
+    }
+
+    sp<ARTPBatchReceiver> mReceiver;
+    int mSockets[2];
+    int mSender;
+};
+
+TEST_P(ARTPBatchReceiverTest, DrainsBurstsInBatches) {
+    const size_t kNumDatagrams = 200;
+    for (int s : mSockets) {
+        ASSERT_EQ(OK, mReceiver->addSocket(s));
+    }
+    for (size_t i = 0; i < kNumDatagrams; ++i) {
+        sendDatagram(mSockets[0], i, datagramSize(i));
+    }
+    sendDatagram(mSockets[1], 0, datagramSize(0));
+
+    Vector<int> readySockets;
+    ASSERT_EQ(OK, mReceiver->poll(kTimeoutUs, &readySockets));
+    ASSERT_EQ(2u, readySockets.size());
+
+    const size_t numReceives = expectDatagrams(mSockets[0], 0, kNumDatagrams);
+    EXPECT_EQ(0, mReceiver->receive(mSockets[0]));
+    EXPECT_EQ(1u, expectDatagrams(mSockets[1], 0, 1));
+
+    ALOGI("received %zu datagrams in %zu receives", kNumDatagrams, numReceives);
+    RecordProperty("Datagrams", std::to_string(kNumDatagrams));
+    RecordProperty("Receives", std::to_string(numReceives));
+    EXPECT_EQ((kNumDatagrams + kBatchSize - 1) / kBatchSize, numReceives);
+
+    ASSERT_EQ(OK, mReceiver->poll(0, &readySockets));
+    EXPECT_TRUE(readySockets.empty());
+}
+
+TEST_P(ARTPBatchReceiverTest, ReceivesLargeDatagrams) {
+    ASSERT_EQ(OK, mReceiver->addSocket(mSockets[0]));
+    sendDatagram(mSockets[0], 0, 60000);
+    sendDatagram(mSockets[0], 1, 20);
+
+    Vector<int> readySockets;
+    ASSERT_EQ(OK, mReceiver->poll(kTimeoutUs, &readySockets));
+    ASSERT_EQ(2, mReceiver->receive(mSockets[0]));
+    sp<ABuffer> buffer = mReceiver->getDatagram(0);
+    ASSERT_EQ(60000u, buffer->size());
+    EXPECT_EQ(byteAt(0, 59999), buffer->data()[59999]);
+    EXPECT_EQ(20u, mReceiver->getDatagram(1)->size());
+}
+
+TEST_P(ARTPBatchReceiverTest, ReceivesTOS) {
+    int on = 1;
+    ASSERT_EQ(0, setsockopt(mSockets[0], IPPROTO_IP, IP_RECVTOS, &on, sizeof(on)));
+    int tos = 0x03;  // ECN CE
+    ASSERT_EQ(0, setsockopt(mSender, IPPROTO_IP, IP_TOS, &tos, sizeof(tos)));
+    ASSERT_EQ(OK, mReceiver->addSocket(mSockets[0]));
+    sendDatagram(mSockets[0], 0, 100);
+
+    Vector<int> readySockets;
+    ASSERT_EQ(OK, mReceiver->poll(kTimeoutUs, &readySockets));
+    ASSERT_EQ(1, mReceiver->receive(mSockets[0]));
+
+    struct msghdr header = mReceiver->getHeader(0);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+    ASSERT_NE(nullptr, cmsg);
+    EXPECT_EQ(IPPROTO_IP, cmsg->cmsg_level);
+    EXPECT_EQ(IP_TOS, cmsg->cmsg_type);
+    EXPECT_EQ(0x03, *CMSG_DATA(cmsg) & 0x03);
+}
+
+TEST_P(ARTPBatchReceiverTest, PollsAddedSocketsOnly) {
+    Vector<int> readySockets;
+    ASSERT_EQ(OK, mReceiver->poll(kTimeoutUs, &readySockets));
+    EXPECT_TRUE(readySockets.empty());
+
+    ASSERT_EQ(OK, mReceiver->addSocket(mSockets[0]));
+    ASSERT_EQ(OK, mReceiver->addSocket(mSockets[1]));
+    EXPECT_EQ(0, mReceiver->receive(mSockets[0]));
+    ASSERT_EQ(OK, mReceiver->poll(1000, &readySockets));
+    EXPECT_TRUE(readySockets.empty());
+
+    mReceiver->removeSocket(mSockets[0]);
+    sendDatagram(mSockets[0], 0, 100);
+    sendDatagram(mSockets[1], 0, 100);
+    ASSERT_EQ(OK, mReceiver->poll(kTimeoutUs, &readySockets));
+    ASSERT_EQ(1u, readySockets.size());
+    EXPECT_EQ(mSockets[1], readySockets[0]);
+}
+
+TEST_P(ARTPBatchReceiverTest, RejectsInvalidSockets) {
+    EXPECT_NE(OK, mReceiver->addSocket(-1));
+    ASSERT_EQ(OK, mReceiver->addSocket(mSockets[0]));
+    sendDatagram(mSockets[0], 0, 100);
+
+    Vector<int> readySockets;
+    ASSERT_EQ(OK, mReceiver->poll(kTimeoutUs, &readySockets));
+    ASSERT_EQ(1u, readySockets.size());
+    EXPECT_EQ(mSockets[0], readySockets[0]);
+}
+
+INSTANTIATE_TEST_SUITE_P(ARTPBatchReceiver, ARTPBatchReceiverTest, ::testing::Bool(),
+                         [](const ::testing::TestParamInfo<bool> &info) {
+                             return info.param ? "Epoll" : "Select";
+                         });
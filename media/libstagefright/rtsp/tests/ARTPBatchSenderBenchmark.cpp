@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/rtsp/ARTPBatchSender.h>
+
+using namespace android;
+
+namespace {
+
+// The FU-A packets ARTPWriter makes of an access unit.
+constexpr size_t kMaxPacketSize = 1280;
+constexpr size_t kFragmentSize = 1178;
+
+enum Mode {
+    kSendTo,
+    kSendMmsg,
+    kSegmentation,
+};
+
+// Sends access units of |state.range(1)| bytes over loopback, to a socket that
+// is never read, so that only the cost of sending is measured.
+// Args: mode, access unit size
+void BM_SendAccessUnit(benchmark::State &state) {
+    const Mode mode = static_cast<Mode>(state.range(0));
+    const size_t accessUnitSize = state.range(1);
+
+    int receiver = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    if (receiver < 0 || bind(receiver, (const struct sockaddr *)&addr, addrLen) != 0
+            || getsockname(receiver, (struct sockaddr *)&addr, &addrLen) != 0) {
+        state.SkipWithError("no loopback socket");
+        return;
+    }
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+
+    sp<ARTPBatchSender> sender = new ARTPBatchSender(kMaxPacketSize);
+    if (mode == kSegmentation && !sender->enableSegmentation(s)) {
+        state.SkipWithError("no UDP segmentation offload");
+    }
+    static const char *kLabels[] = {"sendto", "sendmmsg", "gso"};
+    state.SetLabel(kLabels[mode]);
+
+    sp<ABuffer> packet = new ABuffer(kMaxPacketSize);
+    memset(packet->data(), 0x5a, kMaxPacketSize);
+    size_t numPackets = 0;
+    for (auto _ : state) {
+        for (size_t offset = 0; offset < accessUnitSize; offset += kFragmentSize) {
+            const size_t size = 12 + 2 + std::min(kFragmentSize, accessUnitSize - offset);
+            if (mode == kSendTo) {
+                sendto(s, packet->data(), size, 0, (const struct sockaddr *)&addr, addrLen);
+            } else {
+                sp<ABuffer> buffer = sender->nextPacket();
+                memcpy(buffer->data(), packet->data(), size);
+                buffer->setRange(0, size);
+                sender->queuePacket();
+                if (sender->isFull()) {
+                    size_t numBytes;
+                    sender->flush(s, (const struct sockaddr *)&addr, addrLen, &numBytes);
+                }
+            }
+            ++numPackets;
+        }
+        if (mode != kSendTo && sender->numQueued() > 0) {
+            size_t numBytes;
+            sender->flush(s, (const struct sockaddr *)&addr, addrLen, &numBytes);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * accessUnitSize);
+    state.counters["packets"] = benchmark::Counter(numPackets, benchmark::Counter::kIsRate);
+
+    sender.clear();
+    close(s);
+    close(receiver);
+}
+
+}  // namespace
+
+BENCHMARK(BM_SendAccessUnit)
+        ->ArgsProduct({{kSendTo, kSendMmsg, kSegmentation}, {16 * 1024, 64 * 1024, 256 * 1024}});
+
+BENCHMARK_MAIN();
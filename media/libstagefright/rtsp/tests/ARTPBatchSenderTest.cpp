@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ARTPBatchSenderTest"
+#include <utils/Log.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/rtsp/ARTPBatchSender.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kMaxPacketSize = 1280;
+constexpr size_t kBatchSize = 16;
+
+uint8_t byteAt(size_t packet, size_t offset) {
+    return packet * 7 + offset;
+}
+
+}  // namespace
+
+class ARTPBatchSenderTest : public ::testing::Test {
+  public:
+    void SetUp() override {
+        mSender = new ARTPBatchSender(kMaxPacketSize, kBatchSize);
+
+        mReceiver = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(mReceiver, 0);
+        int size = 1024 * 1024;
+        setsockopt(mReceiver, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        struct timeval timeout = {1, 0};
+        setsockopt(mReceiver, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        mAddr = {};
+        mAddr.sin_family = AF_INET;
+        mAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ASSERT_EQ(0, bind(mReceiver, (const struct sockaddr *)&mAddr, sizeof(mAddr)));
+        socklen_t addrLen = sizeof(mAddr);
+        ASSERT_EQ(0, getsockname(mReceiver, (struct sockaddr *)&mAddr, &addrLen));
+
+        mSocket = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(mSocket, 0);
+    }
+
+    void TearDown() override {
+        mSender.clear();
+        close(mReceiver);
+        close(mSocket);
+    }
+
+    // Queues packets of |sizes|, flushing the queue when it is full, as
+    // ARTPWriter does, and flushes the rest. Returns the number of packets sent.
+    size_t sendPackets(const std::vector<size_t> &sizes) {
+        size_t numSent = 0;
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            sp<ABuffer> buffer = mSender->nextPacket();
+            EXPECT_GE(buffer->capacity(), sizes[i]);
+            for (size_t j = 0; j < sizes[i]; ++j) {
+                buffer->data()[j] = byteAt(i, j);
+            }
+            buffer->setRange(0, sizes[i]);
+            mSender->queuePacket();
+            if (mSender->isFull()) {
+                numSent += flush();
+            }
+        }
+        return numSent + flush();
+    }
+
+    size_t flush() {
+        if (mSender->numQueued() == 0) {
+            return 0;
+        }
+        size_t numQueued = mSender->numQueued();
+        size_t numBytes;
+        ssize_t n = mSender->flush(mSocket, (const struct sockaddr *)&mAddr, sizeof(mAddr),
+                                   &numBytes);
+        EXPECT_EQ((ssize_t)numQueued, n);
+        EXPECT_EQ(0u, mSender->numQueued());
+        return n > 0 ? n : 0;
+    }
+
+    void expectPackets(const std::vector<size_t> &sizes) {
+        std::vector<uint8_t> data(65536);
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            ssize_t n = recv(mReceiver, data.data(), data.size(), 0);
+            ASSERT_EQ((ssize_t)sizes[i], n) << "packet " << i;
+            for (size_t j = 0; j < sizes[i]; ++j) {
+                if (data[j] != byteAt(i, j)) {
+                    ADD_FAILURE() << "packet " << i << " differs at " << j;
+                    break;
+                }
+            }
+        }
+        EXPECT_EQ(-1, recv(mReceiver, data.data(), data.size(), MSG_DONTWAIT));
+    }
+
+    sp<ARTPBatchSender> mSender;
+    int mReceiver;
+    int mSocket;
+    struct sockaddr_in mAddr;
+};
+
+TEST_F(ARTPBatchSenderTest, SendsPacketsInBatches) {
+    mSender->disableSegmentation();
+    std::vector<size_t> sizes;
+    for (size_t i = 0; i < 40; ++i) {
+        sizes.push_back(12 + (i * 131) % (kMaxPacketSize - 12));
+    }
+    EXPECT_EQ(sizes.size(), sendPackets(sizes));
+    expectPackets(sizes);
+    EXPECT_EQ((sizes.size() + kBatchSize - 1) / kBatchSize, mSender->numSendCalls());
+}
+
+TEST_F(ARTPBatchSenderTest, SegmentsPacketsOfSameSize) {
+    if (!mSender->enableSegmentation(mSocket)) {
+        GTEST_SKIP() << "no UDP segmentation offload";
+    }
+    // The fragments of an access unit, and a packet of another one.
+    std::vector<size_t> sizes(kBatchSize - 2, 1178);
+    sizes.push_back(500);
+    sizes.push_back(1178);
+    EXPECT_EQ(sizes.size(), sendPackets(sizes));
+    expectPackets(sizes);
+    EXPECT_EQ(1u, mSender->numSendCalls());
+}
+
+TEST_F(ARTPBatchSenderTest, SplitsSegmentsOnLargerPacket) {
+    if (!mSender->enableSegmentation(mSocket)) {
+        GTEST_SKIP() << "no UDP segmentation offload";
+    }
+    std::vector<size_t> sizes = {800, 800, 1200, 1200, 1000, 1200, 20};
+    EXPECT_EQ(sizes.size(), sendPackets(sizes));
+    expectPackets(sizes);
+    EXPECT_EQ(1u, mSender->numSendCalls());
+    EXPECT_TRUE(mSender->isSegmentationEnabled());
+}
+
+TEST_F(ARTPBatchSenderTest, ReportsUnsentPackets) {
+    mSender->disableSegmentation();
+    sp<ABuffer> buffer = mSender->nextPacket();
+    for (size_t j = 0; j < 100; ++j) {
+        buffer->data()[j] = byteAt(0, j);
+    }
+    buffer->setRange(0, 100);
+    mSender->queuePacket();
+
+    // A datagram larger than the maximum UDP payload can not be sent.
+    sp<ARTPBatchSender> sender = new ARTPBatchSender(70000, 1);
+    sender->nextPacket()->setRange(0, 70000);
+    sender->queuePacket();
+    size_t numBytes;
+    EXPECT_EQ(-EMSGSIZE, sender->flush(mSocket, (const struct sockaddr *)&mAddr,
+                                       sizeof(mAddr), &numBytes));
+    EXPECT_EQ(0u, numBytes);
+    EXPECT_EQ(0u, sender->numQueued());
+
+    EXPECT_EQ(1u, flush());
+    expectPackets({100});
+}
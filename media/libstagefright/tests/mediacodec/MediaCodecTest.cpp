@@ -21,7 +21,9 @@
 #include <gtest/gtest.h>
 
 #include <gui/Surface.h>
+#include <media/stagefright/foundation/ABuffer.h>
 #include <mediadrm/ICrypto.h>
+#include <media/MediaCodecBuffer.h>
 #include <media/stagefright/CodecBase.h>
 #include <media/stagefright/MediaCodec.h>
 #include <media/stagefright/MediaCodecListWriter.h>
@@ -37,6 +39,7 @@ public:
 
     MOCK_METHOD(void, setCrypto, (const sp<ICrypto> &crypto), (override));
     MOCK_METHOD(void, setDescrambler, (const sp<IDescrambler> &descrambler), (override));
+    MOCK_METHOD(size_t, getMaxInputAccessUnits, (), (const, override));
     MOCK_METHOD(status_t, queueInputBuffer, (const sp<MediaCodecBuffer> &buffer), (override));
     MOCK_METHOD(status_t, queueSecureInputBuffer,
             (const sp<MediaCodecBuffer> &buffer,
@@ -72,6 +75,10 @@ public:
     MOCK_METHOD(void, getInputBufferArray, (Vector<sp<MediaCodecBuffer>> *array), (override));
     MOCK_METHOD(void, getOutputBufferArray, (Vector<sp<MediaCodecBuffer>> *array), (override));
     MOCK_METHOD(void, pollForRenderedBuffers, (), (override));
+
+    const std::unique_ptr<CodecBase::BufferCallback> &callback() {
+        return mCallback;
+    }
 };
 
 class MockCodec : public CodecBase {
@@ -443,3 +450,132 @@ TEST(MediaCodecTest, DeadWhileStoppingError) {
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
     looper->stop();
 }
+
+TEST(MediaCodecTest, QueueInputBuffers) {
+    // Test scenario:
+    //
+    // 1) The codec takes up to kMaxAccessUnits access units per input buffer.
+    // 2) Client queues input buffers of several access units; MediaCodec looper
+    //    thread describes them in the "accessUnitInfo" meta of the buffer.
+    // 3) Client queues more access units than the codec takes, or access units
+    //    not matching the buffer; the buffer is not sent to the codec.
+
+    static const AString kCodecName{"test.codec"};
+    static const AString kCodecOwner{"nobody"};
+    static const AString kMediaType{"audio/x-test"};
+    static constexpr size_t kMaxAccessUnits = 4;
+    static constexpr size_t kNumInputBuffers = 2;
+    static constexpr size_t kInputBufferSize = 1024;
+
+    std::mutex lock;
+    std::vector<sp<MediaCodecBuffer>> queuedBuffers;
+    sp<MockCodec> mockCodec;
+    std::function<sp<CodecBase>(const AString &name, const char *owner)> getCodecBase =
+        [&mockCodec, &lock, &queuedBuffers](const AString &, const char *) {
+            mockCodec = new MockCodec(
+                    [&lock, &queuedBuffers](const std::shared_ptr<MockBufferChannel> &channel) {
+                ON_CALL(*channel, getMaxInputAccessUnits())
+                    .WillByDefault(::testing::Return(kMaxAccessUnits));
+                ON_CALL(*channel, queueInputBuffer(_))
+                    .WillByDefault([&lock, &queuedBuffers](const sp<MediaCodecBuffer> &buffer) {
+                        std::lock_guard<std::mutex> guard(lock);
+                        queuedBuffers.push_back(buffer);
+                        return OK;
+                    });
+            });
+            ON_CALL(*mockCodec, initiateAllocateComponent(_))
+                .WillByDefault([mockCodec](const sp<AMessage> &) {
+                    mockCodec->callback()->onComponentAllocated(kCodecName.c_str());
+                });
+            ON_CALL(*mockCodec, initiateConfigureComponent(_))
+                .WillByDefault([mockCodec](const sp<AMessage> &msg) {
+                    mockCodec->callback()->onComponentConfigured(
+                            msg->dup(), msg->dup());
+                });
+            ON_CALL(*mockCodec, initiateStart())
+                .WillByDefault([mockCodec]() {
+                    mockCodec->callback()->onStartCompleted();
+                    for (size_t i = 0; i < kNumInputBuffers; ++i) {
+                        mockCodec->mMockBufferChannel->callback()->onInputBufferAvailable(
+                                i, new MediaCodecBuffer(
+                                        new AMessage, new ABuffer(kInputBufferSize)));
+                    }
+                });
+            ON_CALL(*mockCodec, initiateShutdown(_))
+                .WillByDefault([mockCodec](bool keepComponentAllocated) {
+                    if (keepComponentAllocated) {
+                        mockCodec->callback()->onStopCompleted();
+                    } else {
+                        mockCodec->callback()->onReleaseCompleted();
+                    }
+                });
+            return mockCodec;
+        };
+
+    sp<ALooper> looper{new ALooper};
+    sp<MediaCodec> codec = SetupMediaCodec(
+            kCodecOwner, kCodecName, kMediaType, looper, getCodecBase);
+    ASSERT_NE(nullptr, codec) << "Codec must not be null";
+    ASSERT_NE(nullptr, mockCodec) << "MockCodec must not be null";
+    ASSERT_EQ(OK, codec->configure(new AMessage, nullptr, nullptr, 0));
+    ASSERT_EQ(OK, codec->start());
+
+    // 2)
+    const std::vector<AccessUnitInfo> infos = {
+        { 0u, 100u, 0ll },
+        { 0u, 200u, 20000ll },
+        { MediaCodec::BUFFER_FLAG_EOS, 300u, 40000ll },
+    };
+    size_t index;
+    ASSERT_EQ(OK, codec->dequeueInputBuffer(&index, 1000000ll /* timeoutUs */));
+    EXPECT_EQ(OK, codec->queueInputBuffers(index, 0, 600, infos));
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        ASSERT_EQ(1u, queuedBuffers.size());
+        const sp<MediaCodecBuffer> &buffer = queuedBuffers.front();
+        EXPECT_EQ(0u, buffer->offset());
+        EXPECT_EQ(600u, buffer->size());
+        int64_t timeUs;
+        ASSERT_TRUE(buffer->meta()->findInt64("timeUs", &timeUs));
+        EXPECT_EQ(0ll, timeUs);
+        int32_t eos;
+        EXPECT_TRUE(buffer->meta()->findInt32("eos", &eos) && eos);
+        sp<ABuffer> accessUnitInfo;
+        ASSERT_TRUE(buffer->meta()->findBuffer("accessUnitInfo", &accessUnitInfo));
+        ASSERT_EQ(infos.size() * sizeof(AccessUnitInfo), accessUnitInfo->size());
+        const AccessUnitInfo *queuedInfos =
+            reinterpret_cast<const AccessUnitInfo *>(accessUnitInfo->data());
+        for (size_t i = 0; i < infos.size(); ++i) {
+            EXPECT_EQ(infos[i].mFlags, queuedInfos[i].mFlags);
+            EXPECT_EQ(infos[i].mSize, queuedInfos[i].mSize);
+            EXPECT_EQ(infos[i].mTimestamp, queuedInfos[i].mTimestamp);
+        }
+    }
+
+    // 3)
+    ASSERT_EQ(OK, codec->dequeueInputBuffer(&index, 1000000ll /* timeoutUs */));
+    const std::vector<AccessUnitInfo> tooMany(kMaxAccessUnits + 1, { 0u, 10u, 0ll });
+    EXPECT_NE(OK, codec->queueInputBuffers(index, 0, 10 * tooMany.size(), tooMany));
+    EXPECT_EQ(BAD_VALUE, codec->queueInputBuffers(index, 0, 500, infos));
+    const std::vector<AccessUnitInfo> eosFirst = {
+        { MediaCodec::BUFFER_FLAG_EOS, 100u, 0ll },
+        { 0u, 100u, 20000ll },
+    };
+    EXPECT_EQ(BAD_VALUE, codec->queueInputBuffers(index, 0, 200, eosFirst));
+    EXPECT_EQ(BAD_VALUE, codec->queueInputBuffers(index, 0, 0, {}));
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        EXPECT_EQ(1u, queuedBuffers.size());
+    }
+    // The client still owns the buffer and can queue it as a single access unit.
+    EXPECT_EQ(OK, codec->queueInputBuffer(index, 0, 10, 60000ll, 0));
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        ASSERT_EQ(2u, queuedBuffers.size());
+        sp<ABuffer> accessUnitInfo;
+        EXPECT_FALSE(queuedBuffers.back()->meta()->findBuffer("accessUnitInfo", &accessUnitInfo));
+    }
+
+    codec->release();
+    looper->stop();
+}
@@ -896,6 +896,81 @@ TEST_P(WriteFunctionalityTest, Mpeg4WriterTest) {
     close(fd);
 }
 
+// Checks that the file written through MPEG4Writer's write-behind thread is valid
+TEST_P(WriteFunctionalityTest, Mpeg4WriteBehindTest) {
+    if (mDisableTest) return;
+    if (mWriterName != standardWriters::MPEG4) return;
+    ALOGV("Test MPEG4 writer with write-behind enabled");
+
+    inputId inpId = get<1>(GetParam());
+    string outputFile = OUTPUT_FILE_NAME;
+    int32_t fd =
+            open(outputFile.c_str(), O_CREAT | O_LARGEFILE | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR);
+    ASSERT_GE(fd, 0) << "Failed to open output file to dump writer's data";
+
+    int32_t status = createWriter(fd);
+    ASSERT_EQ(status, (status_t)OK) << "Failed to create writer for mpeg4 output format";
+
+    string inputFile = gEnv->getRes();
+    string inputInfo = gEnv->getRes();
+    configFormat param;
+    bool isAudio;
+    ASSERT_NE(inpId, UNUSED_ID) << "Test expects first inputId to be a valid id";
+
+    getFileDetails(inputFile, inputInfo, param, isAudio, inpId);
+    ASSERT_NE(inputFile.compare(gEnv->getRes()), 0) << "No input file specified";
+
+    struct stat buf;
+    status = stat(inputFile.c_str(), &buf);
+    ASSERT_EQ(status, 0) << "Failed to get properties of input file:" << inputFile;
+    size_t fileSize = buf.st_size;
+
+    ASSERT_NO_FATAL_FAILURE(getInputBufferInfo(inputFile, inputInfo));
+    status = addWriterSource(isAudio, param);
+    ASSERT_EQ((status_t)OK, status) << "Failed to add source for mpeg4 Writer";
+
+    sp<MPEG4Writer> mp4writer = static_cast<MPEG4Writer *>(mWriter.get());
+    mp4writer->setWriteBehind(true);
+
+    status = mWriter->start(mFileMeta.get());
+    ASSERT_EQ((status_t)OK, status) << "Could not start the writer";
+
+    status = sendBuffersToWriter(mInputStream[0], mBufferInfo[0], mInputFrameId[0],
+                                 mCurrentTrack[0], 0, mBufferInfo[0].size());
+    ASSERT_EQ((status_t)OK, status) << "mpeg4 writer failed";
+
+    status = mCurrentTrack[0]->stop();
+    ASSERT_EQ((status_t)OK, status) << "Failed to stop the track";
+
+    status = mWriter->stop();
+    ASSERT_EQ((status_t)OK, status) << "Failed to stop the writer";
+    mp4writer.clear();
+    close(fd);
+
+    configFormat extractorParams;
+    vector<BufferInfo> extractorBufferInfo;
+    int32_t trackCount = -1;
+
+    AMediaExtractor *extractor = AMediaExtractor_new();
+    ASSERT_NE(extractor, nullptr) << "Failed to create extractor";
+    ASSERT_NO_FATAL_FAILURE(setupExtractor(extractor, outputFile, trackCount));
+    ASSERT_EQ(trackCount, 1) << "Tracks reported by extractor does not match with input";
+
+    std::vector<char> inputBuffer(fileSize);
+    mInputStream[0].seekg(0, mInputStream[0].beg);
+    mInputStream[0].read(inputBuffer.data(), fileSize);
+    ASSERT_EQ(mInputStream[0].gcount(), fileSize);
+
+    std::vector<uint8_t> extractedBuffer(fileSize);
+    size_t bytesExtracted = 0;
+    ASSERT_NO_FATAL_FAILURE(extract(extractor, extractorParams, extractorBufferInfo,
+                                    extractedBuffer.data(), fileSize, &bytesExtracted, 0));
+    ASSERT_GT(bytesExtracted, 0) << "Total bytes extracted by extractor cannot be zero";
+    ASSERT_EQ(memcmp(extractedBuffer.data(), inputBuffer.data(), bytesExtracted), 0)
+            << "Extracted bit stream does not match with input bit stream";
+    AMediaExtractor_delete(extractor);
+}
+
 class ListenerTest
     : public WriterTest,
       public ::testing::TestWithParam<tuple<
@@ -22,6 +22,7 @@
 #include <time.h>
 #include <unistd.h>
 #include <utils/Log.h>
+#include <algorithm>
 #include <thread>
 #include "AccessorImpl.h"
 #include "Connection.h"
@@ -101,11 +102,11 @@ struct TransactionStatus {
 };
 
 // Helper template methods for handling map of set.
-template<class T, class U>
-bool insert(std::map<T, std::set<U>> *mapOfSet, T key, U value) {
+template<class MapOfSet, class T, class U>
+bool insert(MapOfSet *mapOfSet, T key, U value) {
     auto iter = mapOfSet->find(key);
     if (iter == mapOfSet->end()) {
-        std::set<U> valueSet{value};
+        typename MapOfSet::mapped_type valueSet{value};
         mapOfSet->insert(std::make_pair(key, valueSet));
         return true;
     } else if (iter->second.find(value)  == iter->second.end()) {
@@ -115,8 +116,8 @@ bool insert(std::map<T, std::set<U>> *mapOfSet, T key, U value) {
     return false;
 }
 
-template<class T, class U>
-bool erase(std::map<T, std::set<U>> *mapOfSet, T key, U value) {
+template<class MapOfSet, class T, class U>
+bool erase(MapOfSet *mapOfSet, T key, U value) {
     bool ret = false;
     auto iter = mapOfSet->find(key);
     if (iter != mapOfSet->end()) {
@@ -130,8 +131,8 @@ bool erase(std::map<T, std::set<U>> *mapOfSet, T key, U value) {
     return ret;
 }
 
-template<class T, class U>
-bool contains(std::map<T, std::set<U>> *mapOfSet, T key, U value) {
+template<class MapOfSet, class T, class U>
+bool contains(MapOfSet *mapOfSet, T key, U value) {
     auto iter = mapOfSet->find(key);
     if (iter != mapOfSet->end()) {
         auto setIter = iter->second.find(value);
@@ -461,7 +462,7 @@ bool Accessor::Impl::BufferPool::handleReleaseBuffer(
                 iter->second->mTransactionCount == 0) {
             if (!iter->second->mInvalidated) {
                 mStats.onBufferUnused(iter->second->mAllocSize);
-                mFreeBuffers.insert(bufferId);
+                addFreeBuffer(*iter->second);
             } else {
                 mStats.onBufferUnused(iter->second->mAllocSize);
                 mStats.onBufferEvicted(iter->second->mAllocSize);
@@ -550,7 +551,7 @@ bool Accessor::Impl::BufferPool::handleTransferResult(const BufferStatusMessage
                 && bufferIter->second->mTransactionCount == 0) {
                 if (!bufferIter->second->mInvalidated) {
                     mStats.onBufferUnused(bufferIter->second->mAllocSize);
-                    mFreeBuffers.insert(message.bufferId);
+                    addFreeBuffer(*bufferIter->second);
                 } else {
                     mStats.onBufferUnused(bufferIter->second->mAllocSize);
                     mStats.onBufferEvicted(bufferIter->second->mAllocSize);
@@ -629,7 +630,7 @@ bool Accessor::Impl::BufferPool::handleClose(ConnectionId connectionId) {
                     // TODO: handle freebuffer insert fail
                     if (!bufferIter->second->mInvalidated) {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
-                        mFreeBuffers.insert(bufferId);
+                        addFreeBuffer(*bufferIter->second);
                     } else {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
                         mStats.onBufferEvicted(bufferIter->second->mAllocSize);
@@ -659,7 +660,7 @@ bool Accessor::Impl::BufferPool::handleClose(ConnectionId connectionId) {
                     // TODO: handle freebuffer insert fail
                     if (!bufferIter->second->mInvalidated) {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
-                        mFreeBuffers.insert(bufferId);
+                        addFreeBuffer(*bufferIter->second);
                     } else {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
                         mStats.onBufferEvicted(bufferIter->second->mAllocSize);
@@ -675,20 +676,40 @@ bool Accessor::Impl::BufferPool::handleClose(ConnectionId connectionId) {
     return true;
 }
 
+void Accessor::Impl::BufferPool::addFreeBuffer(const InternalBuffer &buffer) {
+    mFreeBuffers.insert(buffer.mId);
+    mFreeBuffersByConfig[buffer.mConfig].push_back(buffer.mId);
+}
+
+void Accessor::Impl::BufferPool::removeFreeBufferByConfig(const InternalBuffer &buffer) {
+    auto bucket = mFreeBuffersByConfig.find(buffer.mConfig);
+    if (bucket != mFreeBuffersByConfig.end()) {
+        std::vector<BufferId> &ids = bucket->second;
+        auto idIt = std::find(ids.begin(), ids.end(), buffer.mId);
+        if (idIt != ids.end()) {
+            ids.erase(idIt);
+        }
+    }
+}
+
 bool Accessor::Impl::BufferPool::getFreeBuffer(
         const std::shared_ptr<BufferPoolAllocator> &allocator,
         const std::vector<uint8_t> &params, BufferId *pId,
         const native_handle_t** handle) {
-    auto bufferIt = mFreeBuffers.begin();
-    for (;bufferIt != mFreeBuffers.end(); ++bufferIt) {
-        BufferId bufferId = *bufferIt;
-        if (allocator->compatible(params, mBuffers[bufferId]->mConfig)) {
-            break;
-        }
+    // Buffers allocated with the same parameters are the common match.
+    auto bucket = mFreeBuffersByConfig.find(params);
+    if (bucket == mFreeBuffersByConfig.end() || bucket->second.empty() ||
+            !allocator->compatible(params, bucket->first)) {
+        bucket = std::find_if(mFreeBuffersByConfig.begin(), mFreeBuffersByConfig.end(),
+                [&](const auto &entry) {
+                    return !entry.second.empty() && allocator->compatible(params, entry.first);
+                });
     }
-    if (bufferIt != mFreeBuffers.end()) {
-        BufferId id = *bufferIt;
-        mFreeBuffers.erase(bufferIt);
+    if (bucket != mFreeBuffersByConfig.end()) {
+        // The most recently freed buffer.
+        BufferId id = bucket->second.back();
+        bucket->second.pop_back();
+        mFreeBuffers.erase(id);
         mStats.onBufferRecycled(mBuffers[id]->mAllocSize);
         *handle = mBuffers[id]->handle();
         *pId = id;
@@ -750,6 +771,7 @@ void Accessor::Impl::BufferPool::cleanUp(bool clearCache) {
             if (it != mBuffers.end() &&
                     it->second->mOwnerCount == 0 && it->second->mTransactionCount == 0) {
                 mStats.onBufferEvicted(it->second->mAllocSize);
+                removeFreeBufferByConfig(*it->second);
                 mBuffers.erase(it);
                 freeIt = mFreeBuffers.erase(freeIt);
             } else {
@@ -757,6 +779,14 @@ void Accessor::Impl::BufferPool::cleanUp(bool clearCache) {
                 ALOGW("bufferpool2 inconsistent!");
             }
         }
+        // Drop the buckets of parameters that no free buffer has any more.
+        for (auto bucket = mFreeBuffersByConfig.begin(); bucket != mFreeBuffersByConfig.end();) {
+            if (bucket->second.empty()) {
+                bucket = mFreeBuffersByConfig.erase(bucket);
+            } else {
+                ++bucket;
+            }
+        }
     }
 }
 
@@ -769,6 +799,7 @@ void Accessor::Impl::BufferPool::invalidate(
             if (it != mBuffers.end() &&
                 it->second->mOwnerCount == 0 && it->second->mTransactionCount == 0) {
                 mStats.onBufferEvicted(it->second->mAllocSize);
+                removeFreeBufferByConfig(*it->second);
                 mBuffers.erase(it);
                 freeIt = mFreeBuffers.erase(freeIt);
                 continue;
@@ -19,6 +19,9 @@
 
 #include <map>
 #include <set>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <condition_variable>
 #include <utils/Timers.h>
 #include "Accessor.h"
@@ -101,22 +104,44 @@ private:
         BufferStatusObserver mObserver;
         BufferInvalidationChannel mInvalidationChannel;
 
-        std::map<ConnectionId, std::set<BufferId>> mUsingBuffers;
-        std::map<BufferId, std::set<ConnectionId>> mUsingConnections;
+        std::unordered_map<ConnectionId, std::unordered_set<BufferId>> mUsingBuffers;
+        std::unordered_map<BufferId, std::unordered_set<ConnectionId>> mUsingConnections;
 
-        std::map<ConnectionId, std::set<TransactionId>> mPendingTransactions;
+        std::unordered_map<ConnectionId, std::unordered_set<TransactionId>> mPendingTransactions;
         // Transactions completed before TRANSFER_TO message arrival.
         // Fetch does not occur for the transactions.
         // Only transaction id is kept for the transactions in short duration.
-        std::set<TransactionId> mCompletedTransactions;
+        std::unordered_set<TransactionId> mCompletedTransactions;
         // Currently active(pending) transations' status & information.
-        std::map<TransactionId, std::unique_ptr<TransactionStatus>>
+        std::unordered_map<TransactionId, std::unique_ptr<TransactionStatus>>
                 mTransactions;
 
         std::map<BufferId, std::unique_ptr<InternalBuffer>> mBuffers;
         std::set<BufferId> mFreeBuffers;
         std::set<ConnectionId> mConnectionIds;
 
+        struct ConfigHash {
+            size_t operator()(const std::vector<uint8_t> &config) const {
+                return std::hash<std::string_view>()(std::string_view(
+                        reinterpret_cast<const char *>(config.data()), config.size()));
+            }
+        };
+        // mFreeBuffers grouped by the allocation parameters of the buffers.
+        // Buffers with the same parameters are recycled together, so that
+        // recycling checks compatibility once per distinct parameters instead
+        // of once per free buffer. Buckets may be empty.
+        std::unordered_map<std::vector<uint8_t>, std::vector<BufferId>, ConfigHash>
+                mFreeBuffersByConfig;
+
+        /** Adds a buffer which is not used nor being transferred to the free buffers. */
+        void addFreeBuffer(const InternalBuffer &buffer);
+
+        /**
+         * Removes a free buffer from mFreeBuffersByConfig. The caller removes it from
+         * mFreeBuffers.
+         */
+        void removeFreeBufferByConfig(const InternalBuffer &buffer);
+
         struct Invalidation {
             static std::atomic<std::uint32_t> sInvSeqId;
 
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BufferpoolBenchmark"
+
+#include <benchmark/benchmark.h>
+
+#include <bufferpool/ClientManager.h>
+
+#include <memory>
+#include <vector>
+
+#include "allocator.h"
+
+using android::hardware::media::bufferpool::BufferPoolData;
+using android::hardware::media::bufferpool::V2_0::ResultStatus;
+using android::hardware::media::bufferpool::V2_0::implementation::ClientManager;
+using android::hardware::media::bufferpool::V2_0::implementation::ConnectionId;
+using android::hardware::media::bufferpool::V2_0::implementation::TransactionId;
+
+namespace {
+
+// Buffers cached by the pool, as for a video decoder.
+constexpr int kNumCachedBuffers = 64;
+
+// Allocation parameters of TestBufferPoolAllocator with the given capacity.
+std::vector<uint8_t> getParams(uint32_t capacity) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&capacity);
+    return std::vector<uint8_t>(bytes, bytes + sizeof(capacity));
+}
+
+void closeHandle(native_handle_t* handle) {
+    if (handle) {
+        native_handle_close(handle);
+        native_handle_delete(handle);
+    }
+}
+
+}  // namespace
+
+/*
+ * Allocates a buffer, transfers it to a receiver and releases it again, with
+ * kNumCachedBuffers buffers cached by the pool. The allocation parameters cycle
+ * through a number of configs, like the buffers of a stream with resolution
+ * changes. Reports the cycles per second as items_per_second.
+ *
+ * $ adb shell /data/benchmarktest64/BufferpoolBenchmark/BufferpoolBenchmark
+ * Args: number of distinct allocation parameters
+ */
+static void BM_AllocateTransferRelease(benchmark::State& state) {
+    const int numConfigs = state.range(0);
+
+    android::sp<ClientManager> manager = ClientManager::getInstance();
+    std::shared_ptr<BufferPoolAllocator> allocator = std::make_shared<TestBufferPoolAllocator>();
+    ConnectionId connectionId;
+    ConnectionId receiverId;
+    if (manager->create(allocator, &connectionId) != ResultStatus::OK) {
+        state.SkipWithError("cannot create a bufferpool connection");
+        return;
+    }
+    manager->registerSender(manager, connectionId, &receiverId);
+
+    std::vector<std::vector<uint8_t>> configs;
+    for (int i = 0; i < numConfigs; ++i) {
+        configs.push_back(getParams(4096 * (i + 1)));
+    }
+
+    // Fill the cache with free buffers of every config.
+    {
+        std::vector<std::shared_ptr<BufferPoolData>> buffers;
+        for (int i = 0; i < kNumCachedBuffers; ++i) {
+            std::shared_ptr<BufferPoolData> buffer;
+            native_handle_t* handle = nullptr;
+            if (manager->allocate(connectionId, configs[i % numConfigs], &handle, &buffer) !=
+                ResultStatus::OK) {
+                state.SkipWithError("cannot allocate a buffer");
+                manager->close(connectionId);
+                return;
+            }
+            closeHandle(handle);
+            buffers.push_back(buffer);
+        }
+    }
+
+    size_t cycle = 0;
+    for (auto _ : state) {
+        std::shared_ptr<BufferPoolData> sendBuffer;
+        std::shared_ptr<BufferPoolData> receiveBuffer;
+        native_handle_t* allocHandle = nullptr;
+        native_handle_t* receiveHandle = nullptr;
+        TransactionId transactionId;
+        int64_t postUs;
+
+        ResultStatus status = manager->allocate(connectionId, configs[cycle++ % numConfigs],
+                                                &allocHandle, &sendBuffer);
+        if (status == ResultStatus::OK) {
+            status = manager->postSend(receiverId, sendBuffer, &transactionId, &postUs);
+        }
+        if (status == ResultStatus::OK) {
+            status = manager->receive(receiverId, transactionId, sendBuffer->mId, postUs,
+                                      &receiveHandle, &receiveBuffer);
+        }
+        closeHandle(allocHandle);
+        closeHandle(receiveHandle);
+        if (status != ResultStatus::OK) {
+            state.SkipWithError("allocate/transfer failed");
+            break;
+        }
+        // Both buffers are released here.
+    }
+
+    manager->close(connectionId);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_AllocateTransferRelease)->Arg(1)->Arg(8)->Arg(32);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "AnnexBConverter"
+#include <log/log.h>
+#include <utils/Log.h>
+
+#include <string.h>
+
+#include "AnnexBConverter.h"
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/AUtils.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+#include <media/stagefright/MediaErrors.h>
+
+namespace android {
+
+AnnexBConverter::AnnexBConverter(size_t nalLengthSize)
+    : mNALLengthSize(nalLengthSize) {
+}
+
+size_t AnnexBConverter::parseNALSize(const uint8_t *data) const {
+    switch (mNALLengthSize) {
+        case 1:
+            return *data;
+        case 2:
+            return U16_AT(data);
+        case 3:
+            return ((size_t)data[0] << 16) | U16_AT(&data[1]);
+        case 4:
+            return U32_AT(data);
+    }
+
+    // This cannot happen, mNALLengthSize springs to life by adding 1 to
+    // a 2-bit integer.
+    CHECK(!"Should not be here.");
+
+    return 0;
+}
+
+bool AnnexBConverter::getAnnexBSize(
+        const uint8_t *data, size_t *size, size_t *annexBSize, size_t *shift) const {
+    size_t srcOffset = 0;
+    size_t dstOffset = 0;
+    *shift = 0;
+    while (srcOffset < *size) {
+        size_t nalLength = 0;
+        bool isMalFormed = !isInRange((size_t)0u, *size, srcOffset, mNALLengthSize);
+        if (!isMalFormed) {
+            nalLength = parseNALSize(&data[srcOffset]);
+            isMalFormed = !isInRange((size_t)0u, *size, srcOffset + mNALLengthSize, nalLength);
+        }
+        if (isMalFormed) {
+            *size = srcOffset;
+            *annexBSize = dstOffset;
+            return false;
+        }
+        srcOffset += mNALLengthSize;
+        if (nalLength == 0) {
+            continue;
+        }
+        // the start code must not overwrite the NAL unit before it is moved
+        if (dstOffset + 4 > srcOffset + *shift) {
+            *shift = dstOffset + 4 - srcOffset;
+        }
+        srcOffset += nalLength;
+        dstOffset += 4 + nalLength;
+    }
+    *annexBSize = dstOffset;
+    return true;
+}
+
+size_t AnnexBConverter::convertToAnnexB(const uint8_t *src, uint8_t *dst, size_t size) const {
+    static const uint8_t kStartCode[4] = { 0, 0, 0, 1 };
+    size_t srcOffset = 0;
+    size_t dstOffset = 0;
+    while (srcOffset < size) {
+        size_t nalLength = parseNALSize(&src[srcOffset]);
+        srcOffset += mNALLengthSize;
+        if (nalLength == 0) {
+            continue;
+        }
+        memcpy(&dst[dstOffset], kStartCode, sizeof(kStartCode));
+        dstOffset += sizeof(kStartCode);
+        // With 4 byte lengths, the NAL units are already in place
+        if (&dst[dstOffset] != &src[srcOffset]) {
+            memmove(&dst[dstOffset], &src[srcOffset], nalLength);
+        }
+        srcOffset += nalLength;
+        dstOffset += nalLength;
+    }
+    return dstOffset;
+}
+
+status_t AnnexBConverter::convert(uint8_t *data, size_t capacity, size_t size,
+        bool truncateMalformed, uint8_t *scratch, size_t scratchSize,
+        size_t *annexBSize) const {
+    size_t shift;
+    if (!getAnnexBSize(data, &size, annexBSize, &shift)) {
+        if (!truncateMalformed) {
+            ALOGE("Video is malformed; nalLength exceeds the sample");
+            return ERROR_MALFORMED;
+        }
+        //if nallength abnormal,ignore it.
+        ALOGW("abnormal nallength, ignore this NAL");
+    }
+    if (*annexBSize > capacity) {
+        ALOGE("b/27208621 : %zu %zu", *annexBSize, capacity);
+        android_errorWriteLog(0x534e4554, "27208621");
+        return ERROR_MALFORMED;
+    }
+
+    if (shift <= capacity - size) {
+        if (shift > 0) {
+            memmove(data + shift, data, size);
+        }
+        CHECK_EQ(convertToAnnexB(data + shift, data, size), *annexBSize);
+    } else if (scratch != nullptr && size <= scratchSize) {
+        memcpy(scratch, data, size);
+        CHECK_EQ(convertToAnnexB(scratch, data, size), *annexBSize);
+    } else {
+        return ERROR_MALFORMED;
+    }
+    return OK;
+}
+
+}  // namespace android
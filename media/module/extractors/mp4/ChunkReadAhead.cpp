@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ChunkReadAhead"
+#include <utils/Log.h>
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "ChunkReadAhead.h"
+
+#include <media/MediaExtractorPluginApi.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/foundation/AUtils.h>
+
+namespace android {
+
+ChunkReadAhead::ChunkReadAhead(DataSourceHelper *source, size_t budget)
+    : mSource(source),
+      mBudget(budget),
+      mBufferOffset(0),
+      mBufferSize(0),
+      mNumSourceReads(0),
+      mNumSourceBytes(0),
+      mHintEnd(0) {
+}
+
+void ChunkReadAhead::clear() {
+    mBufferOffset = 0;
+    mBufferSize = 0;
+}
+
+ssize_t ChunkReadAhead::readFromSource(off64_t offset, void *data, size_t size) {
+    ssize_t n = mSource->readAt(offset, data, size);
+    ++mNumSourceReads;
+    if (n > 0) {
+        mNumSourceBytes += n;
+    }
+    return n;
+}
+
+void ChunkReadAhead::hintRestOfChunk(off64_t offset, off64_t chunkEnd) {
+    if (offset < 0 || chunkEnd <= offset) {
+        return;
+    }
+    // Top the hinted range up once half of it has been read, or start over
+    // if the reader left it.
+    if (offset >= mHintEnd - (off64_t)mBudget && offset + (off64_t)mBudget / 2 <= mHintEnd) {
+        return;
+    }
+    const size_t size = std::min((off64_t)mBudget, chunkEnd - offset);
+    mSource->hintReadAhead(offset, size);
+    mHintEnd = offset + size;
+}
+
+ssize_t ChunkReadAhead::readAt(off64_t offset, void *data, size_t size, off64_t chunkEnd) {
+    if (size == 0) {
+        return 0;
+    }
+    if (mBufferSize > 0 && isInRange(mBufferOffset, mBufferSize, offset, size)) {
+        memcpy(data, &mBuffer[offset - mBufferOffset], size);
+        return size;
+    }
+
+    if (size > mBudget / kMinSamplesPerBudget) {
+        // Reading ahead after a large sample mostly reads data that is read
+        // again for the next sample, and costs a copy of the sample. Have the
+        // source fetch the following samples in the background instead.
+        hintRestOfChunk(offset + size, chunkEnd);
+        return readFromSource(offset, data, size);
+    }
+
+    size_t readAheadSize = size;
+    if (offset >= 0 && chunkEnd > offset) {
+        readAheadSize = std::max(size, (size_t)std::min((off64_t)mBudget, chunkEnd - offset));
+    }
+    if (readAheadSize == size) {
+        // nothing to read ahead
+        return readFromSource(offset, data, size);
+    }
+
+    if (mBuffer.size() < readAheadSize) {
+        mBuffer.resize(readAheadSize);
+    }
+    clear();
+    ssize_t n = readFromSource(offset, mBuffer.data(), readAheadSize);
+    if (n < (ssize_t)size) {
+        // end of source, or error
+        ALOGV("read ahead of %zu bytes at %lld returned %zd",
+                readAheadSize, (long long)offset, n);
+        if (n > 0) {
+            memcpy(data, mBuffer.data(), n);
+        }
+        return n;
+    }
+    mBufferOffset = offset;
+    mBufferSize = n;
+    memcpy(data, mBuffer.data(), size);
+    return size;
+}
+
+}  // namespace android
@@ -30,6 +30,8 @@
 #include <utils/Log.h>
 
 #include "AC4Parser.h"
+#include "AnnexBConverter.h"
+#include "ChunkReadAhead.h"
 #include "MPEG4Extractor.h"
 #include "SampleTable.h"
 #include "ItemTable.h"
@@ -85,6 +87,8 @@ enum {
 
 class MPEG4Source : public MediaTrackHelper {
 static const size_t  kMaxPcmFrameSize = 8192;
+// Samples of a chunk are read ahead up to this size.
+static const size_t  kChunkReadAheadSize = 256 * 1024;
 public:
     // Caller retains ownership of both "dataSource" and "sampleTable".
     MPEG4Source(AMediaFormat *format,
@@ -160,6 +164,8 @@ private:
     size_t mSrcBufferSize;
     uint8_t *mSrcBuffer;
 
+    std::unique_ptr<ChunkReadAhead> mChunkReadAhead;
+
     bool mIsHeif;
     bool mIsAvif;
     bool mIsAudio;
@@ -175,7 +181,9 @@ private:
      */
     uint64_t mElstInitialEmptyEditTicks;
 
-    size_t parseNALSize(const uint8_t *data) const;
+    ssize_t readSampleData(off64_t offset, void *data, size_t size, off64_t chunkEnd);
+    media_status_t readAnnexB(off64_t offset, size_t size, off64_t chunkEnd,
+            bool truncateMalformed, size_t *annexBSize);
     status_t parseChunk(off64_t *offset);
     status_t parseTrackFragmentHeader(off64_t offset, off64_t size);
     status_t parseTrackFragmentRun(off64_t offset, off64_t size);
@@ -5297,6 +5305,12 @@ media_status_t MPEG4Source::start() {
     }
     mSrcBufferSize = max_size;
 
+    // Samples are read ahead from the chunks of the sample table. Fragments
+    // and images are read directly.
+    if (mSampleTable != NULL) {
+        mChunkReadAhead.reset(new (std::nothrow) ChunkReadAhead(mDataSource, kChunkReadAheadSize));
+    }
+
     mStarted = true;
 
     return AMEDIA_OK;
@@ -5316,6 +5330,8 @@ media_status_t MPEG4Source::stop() {
     delete[] mSrcBuffer;
     mSrcBuffer = NULL;
 
+    mChunkReadAhead.reset();
+
     mStarted = false;
     mCurrentSampleIndex = 0;
 
@@ -6086,23 +6102,38 @@ media_status_t MPEG4Source::getFormat(AMediaFormat *meta) {
     return AMEDIA_OK;
 }
 
-size_t MPEG4Source::parseNALSize(const uint8_t *data) const {
-    switch (mNALLengthSize) {
-        case 1:
-            return *data;
-        case 2:
-            return U16_AT(data);
-        case 3:
-            return ((size_t)data[0] << 16) | U16_AT(&data[1]);
-        case 4:
-            return U32_AT(data);
+// Reads sample data, reading ahead to |chunkEnd|, the end of the chunk of the
+// sample in the sample table, if positive.
+ssize_t MPEG4Source::readSampleData(
+        off64_t offset, void *data, size_t size, off64_t chunkEnd) {
+    if (mChunkReadAhead != nullptr && chunkEnd > 0) {
+        return mChunkReadAhead->readAt(offset, data, size, chunkEnd);
     }
+    return mDataSource->readAt(offset, data, size);
+}
 
-    // This cannot happen, mNALLengthSize springs to life by adding 1 to
-    // a 2-bit integer.
-    CHECK(!"Should not be here.");
+// Reads a sample of length prefixed NAL units into mBuffer, and converts it to
+// start code prefixed NAL units, in place or through mSrcBuffer. See
+// AnnexBConverter::convert().
+media_status_t MPEG4Source::readAnnexB(off64_t offset, size_t size, off64_t chunkEnd,
+        bool truncateMalformed, size_t *annexBSize) {
+    uint8_t *data = (uint8_t *)mBuffer->data();
+    if (!isInRange((size_t)0u, mBuffer->size(), size)) {
+        // We are trying to read a sample larger than the expected max sample size.
+        android_errorWriteLog(0x534e4554, "188893559");
+        return AMEDIA_ERROR_MALFORMED;
+    }
+    ssize_t num_bytes_read = readSampleData(offset, data, size, chunkEnd);
+    if (num_bytes_read < (ssize_t)size) {
+        ALOGE("i/o error");
+        return AMEDIA_ERROR_IO;
+    }
 
-    return 0;
+    if (AnnexBConverter(mNALLengthSize).convert(data, mBuffer->size(), size,
+            truncateMalformed, mSrcBuffer, mSrcBufferSize, annexBSize) != OK) {
+        return AMEDIA_ERROR_MALFORMED;
+    }
+    return AMEDIA_OK;
 }
 
 int32_t MPEG4Source::parseHEVCLayerId(const uint8_t *data, size_t size) {
@@ -6301,6 +6332,7 @@ media_status_t MPEG4Source::read(
     int64_t cts;
     uint64_t stts;
     bool isSyncSample;
+    off64_t chunkEnd = -1;
     bool newBuffer = false;
     if (mBuffer == NULL) {
         newBuffer = true;
@@ -6310,6 +6342,7 @@ media_status_t MPEG4Source::read(
             err = mSampleTable->getMetaDataForSample(mCurrentSampleIndex, &offset, &size,
                                                     (uint64_t*)&cts, &isSyncSample, &stts);
             if(err == OK) {
+                chunkEnd = mSampleTable->getChunkEnd();
                 if (mElstInitialEmptyEditTicks > 0) {
                     cts += mElstInitialEmptyEditTicks;
                 }
@@ -6406,7 +6439,7 @@ media_status_t MPEG4Source::read(
                 mBuffer->set_range(0, totalSize);
             } else {
                 ssize_t num_bytes_read =
-                    mDataSource->readAt(offset, (uint8_t *)mBuffer->data(), size);
+                    readSampleData(offset, (uint8_t *)mBuffer->data(), size, chunkEnd);
 
                 if (num_bytes_read < (ssize_t)size) {
                     mBuffer->release();
@@ -6476,7 +6509,7 @@ media_status_t MPEG4Source::read(
         dstData[dstOffset++] = (uint8_t)((size >> 8) & 0xFF);
         dstData[dstOffset++] = (uint8_t)((size >> 0) & 0xFF);
 
-        ssize_t numBytesRead = mDataSource->readAt(offset, dstData + dstOffset, size);
+        ssize_t numBytesRead = readSampleData(offset, dstData + dstOffset, size, chunkEnd);
         if (numBytesRead != (ssize_t)size) {
             mBuffer->release();
             mBuffer = NULL;
@@ -6510,65 +6543,14 @@ media_status_t MPEG4Source::read(
     } else {
         // Whole NAL units are returned but each fragment is prefixed by
         // the start code (0x00 00 00 01).
-        ssize_t num_bytes_read = 0;
-        bool mSrcBufferFitsDataToRead = size <= mSrcBufferSize;
-        if (mSrcBufferFitsDataToRead) {
-          num_bytes_read = mDataSource->readAt(offset, mSrcBuffer, size);
-        } else {
-          // We are trying to read a sample larger than the expected max sample size.
-          // Fall through and let the failure be handled by the following if.
-          android_errorWriteLog(0x534e4554, "188893559");
-        }
-
-        if (num_bytes_read < (ssize_t)size) {
+        size_t dstOffset = 0;
+        media_status_t err = readAnnexB(
+                offset, size, chunkEnd, true /* truncateMalformed */, &dstOffset);
+        if (err != AMEDIA_OK) {
             mBuffer->release();
             mBuffer = NULL;
-            return mSrcBufferFitsDataToRead ? AMEDIA_ERROR_IO : AMEDIA_ERROR_MALFORMED;
-        }
-
-        uint8_t *dstData = (uint8_t *)mBuffer->data();
-        size_t srcOffset = 0;
-        size_t dstOffset = 0;
-
-        while (srcOffset < size) {
-            bool isMalFormed = !isInRange((size_t)0u, size, srcOffset, mNALLengthSize);
-            size_t nalLength = 0;
-            if (!isMalFormed) {
-                nalLength = parseNALSize(&mSrcBuffer[srcOffset]);
-                srcOffset += mNALLengthSize;
-                isMalFormed = !isInRange((size_t)0u, size, srcOffset, nalLength);
-            }
-
-            if (isMalFormed) {
-                //if nallength abnormal,ignore it.
-                ALOGW("abnormal nallength, ignore this NAL");
-                srcOffset = size;
-                break;
-            }
-
-            if (nalLength == 0) {
-                continue;
-            }
-
-            if (dstOffset > SIZE_MAX - 4 ||
-                    dstOffset + 4 > SIZE_MAX - nalLength ||
-                    dstOffset + 4 + nalLength > mBuffer->size()) {
-                ALOGE("b/27208621 : %zu %zu", dstOffset, mBuffer->size());
-                android_errorWriteLog(0x534e4554, "27208621");
-                mBuffer->release();
-                mBuffer = NULL;
-                return AMEDIA_ERROR_MALFORMED;
-            }
-
-            dstData[dstOffset++] = 0;
-            dstData[dstOffset++] = 0;
-            dstData[dstOffset++] = 0;
-            dstData[dstOffset++] = 1;
-            memcpy(&dstData[dstOffset], &mSrcBuffer[srcOffset], nalLength);
-            srcOffset += nalLength;
-            dstOffset += nalLength;
+            return err;
         }
-        CHECK_EQ(srcOffset, size);
         CHECK(mBuffer != NULL);
         mBuffer->set_range(0, dstOffset);
 
@@ -6852,18 +6834,9 @@ media_status_t MPEG4Source::fragmentedRead(
         ALOGV("whole NAL");
         // Whole NAL units are returned but each fragment is prefixed by
         // the start code (0x00 00 00 01).
-        ssize_t num_bytes_read = 0;
-        void *data = NULL;
-        bool isMalFormed = false;
         int32_t max_size;
         if (!AMediaFormat_getInt32(mFormat, AMEDIAFORMAT_KEY_MAX_INPUT_SIZE, &max_size)
                 || !isInRange((size_t)0u, (size_t)max_size, size)) {
-            isMalFormed = true;
-        } else {
-            data = mSrcBuffer;
-        }
-
-        if (isMalFormed || data == NULL) {
             ALOGE("isMalFormed size %zu", size);
             if (mBuffer != NULL) {
                 mBuffer->release();
@@ -6871,61 +6844,15 @@ media_status_t MPEG4Source::fragmentedRead(
             }
             return AMEDIA_ERROR_MALFORMED;
         }
-        num_bytes_read = mDataSource->readAt(offset, data, size);
 
-        if (num_bytes_read < (ssize_t)size) {
+        size_t dstOffset = 0;
+        media_status_t err = readAnnexB(
+                offset, size, -1 /* chunkEnd */, false /* truncateMalformed */, &dstOffset);
+        if (err != AMEDIA_OK) {
             mBuffer->release();
             mBuffer = NULL;
-
-            ALOGE("i/o error");
-            return AMEDIA_ERROR_IO;
-        }
-
-        uint8_t *dstData = (uint8_t *)mBuffer->data();
-        size_t srcOffset = 0;
-        size_t dstOffset = 0;
-
-        while (srcOffset < size) {
-            isMalFormed = !isInRange((size_t)0u, size, srcOffset, mNALLengthSize);
-            size_t nalLength = 0;
-            if (!isMalFormed) {
-                nalLength = parseNALSize(&mSrcBuffer[srcOffset]);
-                srcOffset += mNALLengthSize;
-                isMalFormed = !isInRange((size_t)0u, size, srcOffset, nalLength)
-                        || !isInRange((size_t)0u, mBuffer->size(), dstOffset, (size_t)4u)
-                        || !isInRange((size_t)0u, mBuffer->size(), dstOffset + 4, nalLength);
-            }
-
-            if (isMalFormed) {
-                ALOGE("Video is malformed; nalLength %zu", nalLength);
-                mBuffer->release();
-                mBuffer = NULL;
-                return AMEDIA_ERROR_MALFORMED;
-            }
-
-            if (nalLength == 0) {
-                continue;
-            }
-
-            if (dstOffset > SIZE_MAX - 4 ||
-                    dstOffset + 4 > SIZE_MAX - nalLength ||
-                    dstOffset + 4 + nalLength > mBuffer->size()) {
-                ALOGE("b/26365349 : %zu %zu", dstOffset, mBuffer->size());
-                android_errorWriteLog(0x534e4554, "26365349");
-                mBuffer->release();
-                mBuffer = NULL;
-                return AMEDIA_ERROR_MALFORMED;
-            }
-
-            dstData[dstOffset++] = 0;
-            dstData[dstOffset++] = 0;
-            dstData[dstOffset++] = 0;
-            dstData[dstOffset++] = 1;
-            memcpy(&dstData[dstOffset], &mSrcBuffer[srcOffset], nalLength);
-            srcOffset += nalLength;
-            dstOffset += nalLength;
+            return err;
         }
-        CHECK_EQ(srcOffset, size);
         CHECK(mBuffer != NULL);
         mBuffer->set_range(0, dstOffset);
 
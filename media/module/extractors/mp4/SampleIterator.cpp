@@ -124,6 +124,14 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
             mCurrentChunkSampleSizes.push(sampleSize);
         }
 
+        mCurrentChunkSize = 0;
+        for (size_t i = 0; i < mCurrentChunkSampleSizes.size(); ++i) {
+            if (__builtin_add_overflow(mCurrentChunkSize, mCurrentChunkSampleSizes[i],
+                    &mCurrentChunkSize)) {
+                mCurrentChunkSize = 0;
+                break;
+            }
+        }
         mCurrentChunkIndex = chunk;
     }
 
@@ -158,6 +166,14 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
     return OK;
 }
 
+off64_t SampleIterator::getChunkEnd() const {
+    off64_t chunkEnd;
+    if (__builtin_add_overflow(mCurrentChunkOffset, mCurrentChunkSize, &chunkEnd)) {
+        return mCurrentChunkOffset;
+    }
+    return chunkEnd;
+}
+
 status_t SampleIterator::findChunkRange(uint32_t sampleIndex) {
     CHECK(sampleIndex >= mFirstChunkSampleIndex);
 
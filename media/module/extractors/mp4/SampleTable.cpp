@@ -18,6 +18,7 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <limits>
 
 #include "SampleTable.h"
@@ -129,6 +130,11 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mTimeToSampleCount(0),
       mTimeToSample(NULL),
       mSampleTimeEntries(NULL),
+      mSeekIndexBuilt(false),
+      mMinCompositionDelta(0),
+      mMaxCompositionDelta(0),
+      mSeekWindowStart(0),
+      mSeekWindowEnd(0),
       mCompositionTimeDeltaEntries(NULL),
       mNumCompositionTimeDeltaEntries(0),
       mCompositionDeltaLookup(new CompositionDeltaLookup),
@@ -464,7 +470,6 @@ status_t SampleTable::setCompositionTimeToSampleParams(
         return ERROR_MALFORMED;
     }
 
-    mNumCompositionTimeDeltaEntries = numEntries;
     uint64_t allocSize = (uint64_t)numEntries * 2 * sizeof(int32_t);
     if (allocSize > kMaxTotalSize) {
         ALOGE("Composition-time-to-sample table size too large.");
@@ -502,6 +507,10 @@ status_t SampleTable::setCompositionTimeToSampleParams(
         mCompositionTimeDeltaEntries[i] = ntohl(mCompositionTimeDeltaEntries[i]);
     }
 
+    // Only publish the entry count once the table is valid; the seek and
+    // lookup paths index mCompositionTimeDeltaEntries by this count.
+    mNumCompositionTimeDeltaEntries = numEntries;
+
     mCompositionDeltaLookup->setEntries(
             mCompositionTimeDeltaEntries, mNumCompositionTimeDeltaEntries);
 
@@ -714,45 +723,258 @@ void SampleTable::buildSampleEntriesTable() {
           CompareIncreasingTime);
 }
 
-status_t SampleTable::findSampleAtTime(
-        uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
-        uint32_t *sample_index, uint32_t flags) {
-    buildSampleEntriesTable();
+// Time arithmetic for the seek index clamps instead of wrapping around, like
+// buildSampleEntriesTable() does for malformed tables.
+static uint64_t addTime(uint64_t time, uint64_t duration) {
+    return time > UINT64_MAX - duration ? UINT64_MAX : time + duration;
+}
 
-    if (mSampleTimeEntries == NULL) {
-        return ERROR_OUT_OF_RANGE;
+static uint64_t addTimeDelta(uint64_t time, int64_t delta) {
+    if (delta < 0) {
+        uint64_t magnitude = -(uint64_t)delta;
+        return time < magnitude ? 0 : time - magnitude;
     }
+    return addTime(time, delta);
+}
 
-    if (flags == kFlagFrameIndex) {
-        if (req_time >= mNumSampleSizes) {
-            return ERROR_OUT_OF_RANGE;
+// normally we don't round
+static uint64_t scaleTime(uint64_t time, uint64_t scale_num, uint64_t scale_den) {
+    return scale_den != 0 ? (time * scale_num) / scale_den : 0;
+}
+
+void SampleTable::buildSeekIndex_l() {
+    if (mSeekIndexBuilt) {
+        return;
+    }
+    mSeekIndexBuilt = true;
+
+    RunCursor cursor = { 0, 0, 0 };
+    mTimeToSampleCheckpoints.reserve(mTimeToSampleCount / kRunCheckpointInterval + 1);
+    for (; cursor.mRun < mTimeToSampleCount; ++cursor.mRun) {
+        if (cursor.mRun % kRunCheckpointInterval == 0) {
+            mTimeToSampleCheckpoints.push_back(cursor);
         }
-        *sample_index = mSampleTimeEntries[req_time].mSampleIndex;
+        uint32_t n = mTimeToSample[2 * cursor.mRun];
+        uint32_t delta = mTimeToSample[2 * cursor.mRun + 1];
+        cursor.mFirstSample += n;
+        cursor.mFirstTime = addTime(cursor.mFirstTime, (uint64_t)n * delta);
+    }
+
+    // Samples not covered by the ctts table have no composition offset, so zero
+    // is always within [mMinCompositionDelta, mMaxCompositionDelta].
+    cursor = { 0, 0, 0 };
+    mCompositionDeltaCheckpoints.reserve(
+            mNumCompositionTimeDeltaEntries / kRunCheckpointInterval + 1);
+    for (; cursor.mRun < mNumCompositionTimeDeltaEntries; ++cursor.mRun) {
+        if (cursor.mRun % kRunCheckpointInterval == 0) {
+            mCompositionDeltaCheckpoints.push_back(cursor);
+        }
+        int32_t delta = mCompositionTimeDeltaEntries[2 * cursor.mRun + 1];
+        mMinCompositionDelta = std::min(mMinCompositionDelta, delta);
+        mMaxCompositionDelta = std::max(mMaxCompositionDelta, delta);
+        cursor.mFirstSample += (uint32_t)mCompositionTimeDeltaEntries[2 * cursor.mRun];
+    }
+}
+
+SampleTable::RunCursor SampleTable::getTimeToSampleCursor_l(uint32_t sampleIndex) const {
+    RunCursor cursor = { 0, 0, 0 };
+    auto it = std::upper_bound(
+            mTimeToSampleCheckpoints.begin(), mTimeToSampleCheckpoints.end(), sampleIndex,
+            [](uint32_t index, const RunCursor &checkpoint) {
+                return index < checkpoint.mFirstSample;
+            });
+    if (it != mTimeToSampleCheckpoints.begin()) {
+        cursor = *(it - 1);
+    }
+    advanceTimeToSampleCursor_l(&cursor, sampleIndex);
+    return cursor;
+}
+
+void SampleTable::advanceTimeToSampleCursor_l(RunCursor *cursor, uint32_t sampleIndex) const {
+    while (cursor->mRun < mTimeToSampleCount) {
+        uint32_t n = mTimeToSample[2 * cursor->mRun];
+        if (sampleIndex < cursor->mFirstSample + n) {
+            break;
+        }
+        uint32_t delta = mTimeToSample[2 * cursor->mRun + 1];
+        cursor->mFirstSample += n;
+        cursor->mFirstTime = addTime(cursor->mFirstTime, (uint64_t)n * delta);
+        ++cursor->mRun;
+    }
+}
+
+SampleTable::RunCursor SampleTable::getCompositionDeltaCursor_l(uint32_t sampleIndex) const {
+    RunCursor cursor = { 0, 0, 0 };
+    auto it = std::upper_bound(
+            mCompositionDeltaCheckpoints.begin(), mCompositionDeltaCheckpoints.end(), sampleIndex,
+            [](uint32_t index, const RunCursor &checkpoint) {
+                return index < checkpoint.mFirstSample;
+            });
+    if (it != mCompositionDeltaCheckpoints.begin()) {
+        cursor = *(it - 1);
+    }
+    advanceCompositionDeltaCursor_l(&cursor, sampleIndex);
+    return cursor;
+}
+
+void SampleTable::advanceCompositionDeltaCursor_l(
+        RunCursor *cursor, uint32_t sampleIndex) const {
+    while (cursor->mRun < mNumCompositionTimeDeltaEntries) {
+        uint32_t n = mCompositionTimeDeltaEntries[2 * cursor->mRun];
+        if (sampleIndex < cursor->mFirstSample + n) {
+            break;
+        }
+        cursor->mFirstSample += n;
+        ++cursor->mRun;
+    }
+}
+
+// Samples past the end of the stts table are treated as starting at the end
+// of the last run.
+uint64_t SampleTable::getDecodeTime_l(const RunCursor &cursor, uint32_t sampleIndex) const {
+    if (cursor.mRun >= mTimeToSampleCount) {
+        return cursor.mFirstTime;
+    }
+    uint32_t delta = mTimeToSample[2 * cursor.mRun + 1];
+    return addTime(cursor.mFirstTime, (sampleIndex - cursor.mFirstSample) * delta);
+}
+
+// Returns the first sample whose decode time is at least |decodeTime|, or
+// mNumSampleSizes if there is none.
+uint32_t SampleTable::findFirstSampleAtDecodeTime_l(uint64_t decodeTime) const {
+    RunCursor cursor = { 0, 0, 0 };
+    auto it = std::lower_bound(
+            mTimeToSampleCheckpoints.begin(), mTimeToSampleCheckpoints.end(), decodeTime,
+            [](const RunCursor &checkpoint, uint64_t time) {
+                return checkpoint.mFirstTime < time;
+            });
+    if (it != mTimeToSampleCheckpoints.begin()) {
+        cursor = *(it - 1);
+    }
+
+    uint64_t sampleIndex = mNumSampleSizes;
+    for (; cursor.mRun < mTimeToSampleCount; ++cursor.mRun) {
+        if (decodeTime <= cursor.mFirstTime) {
+            break;
+        }
+        uint32_t n = mTimeToSample[2 * cursor.mRun];
+        uint32_t delta = mTimeToSample[2 * cursor.mRun + 1];
+        uint64_t runEndTime = addTime(cursor.mFirstTime, (uint64_t)n * delta);
+        if (delta != 0 && decodeTime < runEndTime) {
+            sampleIndex = cursor.mFirstSample + (decodeTime - cursor.mFirstTime - 1) / delta + 1;
+            return std::min(sampleIndex, (uint64_t)mNumSampleSizes);
+        }
+        cursor.mFirstSample += n;
+        cursor.mFirstTime = runEndTime;
+    }
+    if (decodeTime <= cursor.mFirstTime) {
+        sampleIndex = cursor.mFirstSample;
+    }
+    return std::min(sampleIndex, (uint64_t)mNumSampleSizes);
+}
+
+status_t SampleTable::buildSeekWindow_l(uint32_t start, uint32_t end) {
+    if (start == mSeekWindowStart && end == mSeekWindowEnd && !mSeekWindow.empty()) {
         return OK;
     }
 
-    uint32_t left = 0;
-    uint32_t right_plus_one = mNumSampleSizes;
-    while (left < right_plus_one) {
-        uint32_t center = left + (right_plus_one - left) / 2;
-        uint64_t centerTime =
-            getSampleTime(center, scale_num, scale_den);
+    // The new window replaces the previous one, release it first.
+    mTotalSize -= (uint64_t)mSeekWindow.size() * sizeof(SampleTimeEntry);
+    std::vector<SampleTimeEntry>().swap(mSeekWindow);
 
-        if (req_time < centerTime) {
-            right_plus_one = center;
-        } else if (req_time > centerTime) {
-            left = center + 1;
-        } else {
-            *sample_index = mSampleTimeEntries[center].mSampleIndex;
-            return OK;
+    uint64_t allocSize = (uint64_t)(end - start) * sizeof(SampleTimeEntry);
+    mTotalSize += allocSize;
+    if (mTotalSize > kMaxTotalSize) {
+        ALOGE("Seek window size would make sample table too large.\n"
+              "    Requested seek window size = %llu\n"
+              "    Eventual sample table size >= %llu\n"
+              "    Allowed sample table size = %llu\n",
+              (unsigned long long)allocSize,
+              (unsigned long long)mTotalSize,
+              (unsigned long long)kMaxTotalSize);
+        mTotalSize -= allocSize;
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    mSeekWindow.resize(end - start);
+    RunCursor timeCursor = getTimeToSampleCursor_l(start);
+    RunCursor deltaCursor = getCompositionDeltaCursor_l(start);
+    for (uint32_t sampleIndex = start; sampleIndex < end; ++sampleIndex) {
+        advanceTimeToSampleCursor_l(&timeCursor, sampleIndex);
+        advanceCompositionDeltaCursor_l(&deltaCursor, sampleIndex);
+
+        int32_t compTimeDelta = deltaCursor.mRun < mNumCompositionTimeDeltaEntries
+                ? mCompositionTimeDeltaEntries[2 * deltaCursor.mRun + 1] : 0;
+        SampleTimeEntry &entry = mSeekWindow[sampleIndex - start];
+        entry.mSampleIndex = sampleIndex;
+        entry.mCompositionTime =
+                addTimeDelta(getDecodeTime_l(timeCursor, sampleIndex), compTimeDelta);
+    }
+    std::sort(mSeekWindow.begin(), mSeekWindow.end(),
+            [](const SampleTimeEntry &a, const SampleTimeEntry &b) {
+                return a.mCompositionTime < b.mCompositionTime;
+            });
+
+    mSeekWindowStart = start;
+    mSeekWindowEnd = end;
+    return OK;
+}
+
+// Looks up |req_time| in the current seek window. Returns false if samples
+// outside of the window could be a better match, in which case the window
+// needs to grow.
+bool SampleTable::findSampleInSeekWindow_l(
+        uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+        uint32_t *sample_index, uint32_t flags, status_t *err) {
+    const size_t numEntries = mSeekWindow.size();
+    auto getSampleTime = [&](size_t index) {
+        return scaleTime(mSeekWindow[index].mCompositionTime, scale_num, scale_den);
+    };
+
+    // [lower, upper) are the entries at exactly req_time.
+    size_t lower = std::partition_point(mSeekWindow.begin(), mSeekWindow.end(),
+            [&](const SampleTimeEntry &entry) {
+                return scaleTime(entry.mCompositionTime, scale_num, scale_den) < req_time;
+            }) - mSeekWindow.begin();
+    size_t upper = std::partition_point(mSeekWindow.begin() + lower, mSeekWindow.end(),
+            [&](const SampleTimeEntry &entry) {
+                return scaleTime(entry.mCompositionTime, scale_num, scale_den) <= req_time;
+            }) - mSeekWindow.begin();
+
+    // Composition times of the samples before the window are at most
+    // leftBound and those after it are at least rightBound. The window is
+    // conclusive if it holds a sample on either side of req_time that is
+    // closer than anything outside of it.
+    if (mSeekWindowStart > 0) {
+        uint64_t leftBound = addTimeDelta(
+                getDecodeTime_l(getTimeToSampleCursor_l(mSeekWindowStart - 1),
+                        mSeekWindowStart - 1),
+                mMaxCompositionDelta);
+        if (lower == 0 || mSeekWindow[lower - 1].mCompositionTime < leftBound) {
+            return false;
+        }
+    }
+    if (mSeekWindowEnd < mNumSampleSizes) {
+        uint64_t rightBound = addTimeDelta(
+                getDecodeTime_l(getTimeToSampleCursor_l(mSeekWindowEnd), mSeekWindowEnd),
+                mMinCompositionDelta);
+        if (upper == numEntries || mSeekWindow[upper].mCompositionTime > rightBound) {
+            return false;
         }
     }
 
-    uint32_t closestIndex = left;
+    *err = OK;
+    if (lower < upper) {
+        *sample_index = mSeekWindow[lower].mSampleIndex;
+        return true;
+    }
+
+    size_t closestIndex = lower;
 
-    if (closestIndex == mNumSampleSizes) {
+    if (closestIndex == numEntries) {
         if (flags == kFlagAfter) {
-            return ERROR_OUT_OF_RANGE;
+            *err = ERROR_OUT_OF_RANGE;
+            return true;
         }
         flags = kFlagBefore;
     } else if (closestIndex == 0) {
@@ -782,18 +1004,101 @@ status_t SampleTable::findSampleAtTime(
         {
             CHECK(flags == kFlagClosest);
             // pick closest based on timestamp. use abs_difference for safety
-            if (abs_difference(
-                    getSampleTime(closestIndex, scale_num, scale_den), req_time) >
-                abs_difference(
-                    req_time, getSampleTime(closestIndex - 1, scale_num, scale_den))) {
+            if (abs_difference(getSampleTime(closestIndex), req_time) >
+                abs_difference(req_time, getSampleTime(closestIndex - 1))) {
                 --closestIndex;
             }
             break;
         }
     }
 
-    *sample_index = mSampleTimeEntries[closestIndex].mSampleIndex;
-    return OK;
+    *sample_index = mSeekWindow[closestIndex].mSampleIndex;
+    return true;
+}
+
+size_t SampleTable::getSeekIndexSize() {
+    Mutex::Autolock autoLock(mLock);
+
+    size_t size = (mTimeToSampleCheckpoints.capacity()
+            + mCompositionDeltaCheckpoints.capacity()) * sizeof(RunCursor)
+            + mSeekWindow.capacity() * sizeof(SampleTimeEntry);
+    if (mSampleTimeEntries != NULL) {
+        size += (size_t)mNumSampleSizes * sizeof(SampleTimeEntry);
+    }
+    return size;
+}
+
+status_t SampleTable::findSampleAtTime(
+        uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+        uint32_t *sample_index, uint32_t flags) {
+    if (flags == kFlagFrameIndex && mCompositionTimeDeltaEntries != NULL) {
+        // The presentation order rank of a sample depends on every sample
+        // before it, so frame index seeks in reordered tracks still need the
+        // fully sorted table.
+        buildSampleEntriesTable();
+
+        if (mSampleTimeEntries == NULL) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        if (req_time >= mNumSampleSizes) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        *sample_index = mSampleTimeEntries[req_time].mSampleIndex;
+        return OK;
+    }
+
+    Mutex::Autolock autoLock(mLock);
+
+    if (mNumSampleSizes == 0) {
+        ALOGE("b/23247055, mNumSampleSizes(%u)", mNumSampleSizes);
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    if (flags == kFlagFrameIndex) {
+        // Without reordering, presentation order is decode order.
+        if (req_time >= mNumSampleSizes) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        *sample_index = req_time;
+        return OK;
+    }
+
+    buildSeekIndex_l();
+
+    // Consecutive seeks are often close to each other, so try the window of
+    // the previous seek before building a new one.
+    status_t err = OK;
+    if (!mSeekWindow.empty() && findSampleInSeekWindow_l(
+            req_time, scale_num, scale_den, sample_index, flags, &err)) {
+        return err;
+    }
+
+    // Samples whose composition time can be req_time have a decode time in
+    // [target - mMaxCompositionDelta, target - mMinCompositionDelta]. Start
+    // with a window around those and widen it until it is conclusive, which
+    // it is at the latest when it covers the whole table.
+    uint64_t target = 0;
+    if (scale_num != 0) {
+        double estimate = (double)req_time * scale_den / scale_num;
+        target = estimate < 0x1p63 ? (uint64_t)estimate : (1ULL << 63);
+    }
+    uint32_t first = findFirstSampleAtDecodeTime_l(
+            addTimeDelta(target, -(int64_t)mMaxCompositionDelta));
+    uint32_t last = findFirstSampleAtDecodeTime_l(
+            addTime(addTimeDelta(target, -(int64_t)mMinCompositionDelta), 1));
+
+    for (uint32_t margin = kSeekWindowMargin;;
+            margin = margin > UINT32_MAX / 2 ? UINT32_MAX : margin * 2) {
+        uint32_t start = first > margin ? first - margin : 0;
+        uint32_t end = mNumSampleSizes - last > margin ? last + margin : mNumSampleSizes;
+        err = buildSeekWindow_l(start, end);
+        if (err != OK) {
+            return err;
+        }
+        if (findSampleInSeekWindow_l(req_time, scale_num, scale_den, sample_index, flags, &err)) {
+            return err;
+        }
+    }
 }
 
 status_t SampleTable::findSyncSampleNear(
@@ -950,6 +1255,11 @@ uint32_t SampleTable::getLastSampleIndexInChunk() {
     return mSampleIterator->getLastSampleIndexInChunk();
 }
 
+off64_t SampleTable::getChunkEnd() {
+    Mutex::Autolock autoLock(mLock);
+    return mSampleIterator->getChunkEnd();
+}
+
 status_t SampleTable::getMetaDataForSample(
         uint32_t sampleIndex,
         off64_t *offset,
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANNEX_B_CONVERTER_H_
+
+#define ANNEX_B_CONVERTER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <utils/Errors.h>
+
+namespace android {
+
+// Converts AVC/HEVC samples of length prefixed NAL units, as stored in MP4
+// files, to start code prefixed NAL units (Annex B).
+struct AnnexBConverter {
+    // |nalLengthSize| is the size of the NAL unit lengths, 1 to 4 bytes.
+    explicit AnnexBConverter(size_t nalLengthSize);
+
+    size_t parseNALSize(const uint8_t *data) const;
+
+    // Returns in |annexBSize| the size of the NAL units of a sample once their
+    // lengths are replaced by start codes, and in |shift| how far the sample
+    // must be moved for convertToAnnexB() to convert it in place: the start
+    // codes are longer than 1 and 2 byte lengths. Zero length NAL units are
+    // dropped. If a NAL unit exceeds the sample, |size| is reduced to the NAL
+    // units before it and false is returned.
+    bool getAnnexBSize(const uint8_t *data, size_t *size, size_t *annexBSize,
+            size_t *shift) const;
+
+    // Replaces the lengths of the NAL units of a sample validated by
+    // getAnnexBSize() by start codes. |dst| may be |src| minus the shift
+    // returned by getAnnexBSize().
+    size_t convertToAnnexB(const uint8_t *src, uint8_t *dst, size_t size) const;
+
+    // Converts the sample of |size| bytes at the start of |data|, a buffer of
+    // |capacity| bytes. The conversion is done in place, unless the sample
+    // cannot be moved far enough within |data|: it then goes through |scratch|,
+    // a buffer of |scratchSize| bytes. NAL units exceeding the sample are
+    // dropped, with the rest of the sample, if |truncateMalformed|, otherwise
+    // the sample is malformed.
+    status_t convert(uint8_t *data, size_t capacity, size_t size, bool truncateMalformed,
+            uint8_t *scratch, size_t scratchSize, size_t *annexBSize) const;
+
+private:
+    const size_t mNALLengthSize;
+};
+
+}  // namespace android
+
+#endif  // ANNEX_B_CONVERTER_H_
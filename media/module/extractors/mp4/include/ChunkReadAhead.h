@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CHUNK_READ_AHEAD_H_
+
+#define CHUNK_READ_AHEAD_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <vector>
+
+namespace android {
+
+class DataSourceHelper;
+
+// Reads the samples of a track from the chunks they are stored in: the rest of
+// a chunk, up to a byte budget, is read at once and the following samples of
+// the chunk are served from memory. This saves a read per sample of tracks with
+// small samples, e.g. audio tracks.
+struct ChunkReadAhead {
+    ChunkReadAhead(DataSourceHelper *source, size_t budget);
+
+    // Reads |size| bytes at |offset|, which is within a chunk ending at
+    // |chunkEnd|. Returns the number of bytes read, like DataSourceHelper.
+    // Samples larger than 1/kMinSamplesPerBudget of the budget, e.g. video
+    // samples, are read directly into |data|, and the source is hinted to
+    // fetch up to a budget of the rest of the chunk.
+    ssize_t readAt(off64_t offset, void *data, size_t size, off64_t chunkEnd);
+
+    // Drops the data read ahead.
+    void clear();
+
+    // Number of reads from the source, and number of bytes they returned.
+    size_t numSourceReads() const { return mNumSourceReads; }
+    size_t numSourceBytes() const { return mNumSourceBytes; }
+
+private:
+    static constexpr size_t kMinSamplesPerBudget = 8;
+
+    DataSourceHelper *mSource;
+    const size_t mBudget;
+
+    std::vector<uint8_t> mBuffer;
+    off64_t mBufferOffset;
+    size_t mBufferSize;
+
+    size_t mNumSourceReads;
+    size_t mNumSourceBytes;
+
+    // End of the range last hinted to the source.
+    off64_t mHintEnd;
+
+    ssize_t readFromSource(off64_t offset, void *data, size_t size);
+    void hintRestOfChunk(off64_t offset, off64_t chunkEnd);
+
+    ChunkReadAhead(const ChunkReadAhead &);
+    ChunkReadAhead &operator=(const ChunkReadAhead &);
+};
+
+}  // namespace android
+
+#endif  // CHUNK_READ_AHEAD_H_
@@ -36,6 +36,8 @@ struct SampleIterator {
     uint64_t getSampleTime() const { return mCurrentSampleTime; }
     uint64_t getSampleDuration() const { return mCurrentSampleDuration; }
 
+    off64_t getChunkEnd() const;
+
     uint32_t getLastSampleIndexInChunk() const {
         return mCurrentSampleIndex + mSamplesPerChunk -
                 ((mCurrentSampleIndex - mFirstChunkSampleIndex) % mSamplesPerChunk) - 1;
@@ -60,6 +62,7 @@ private:
     uint32_t mCurrentChunkIndex;
     off64_t mCurrentChunkOffset;
     Vector<size_t> mCurrentChunkSampleSizes;
+    off64_t mCurrentChunkSize;
 
     uint32_t mTimeToSampleIndex;
     uint32_t mTTSSampleIndex;
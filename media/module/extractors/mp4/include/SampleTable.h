@@ -26,6 +26,8 @@
 #include <utils/RefBase.h>
 #include <utils/threads.h>
 
+#include <vector>
+
 namespace android {
 
 class DataSourceHelper;
@@ -73,6 +75,10 @@ public:
     // call only after getMetaDataForSample has been called successfully.
     uint32_t getLastSampleIndexInChunk();
 
+    // call only after getMetaDataForSample has been called successfully.
+    // Returns the offset of the end of the chunk of the sample.
+    off64_t getChunkEnd();
+
     enum {
         kFlagBefore,
         kFlagAfter,
@@ -89,6 +95,10 @@ public:
 
     status_t findThumbnailSample(uint32_t *sample_index);
 
+    // Returns the number of bytes currently allocated for seeking: the run
+    // checkpoints, the seek window and the sorted table of frame index seeks.
+    size_t getSeekIndexSize();
+
     void setPredictSampleSize(uint32_t sampleSize) {
         mDefaultSampleSize = sampleSize;
     }
@@ -130,8 +140,35 @@ private:
         uint32_t mSampleIndex;
         uint64_t mCompositionTime;
     };
+    // All samples sorted by composition time. Only built for frame index seeks
+    // in tracks with reordered frames.
     SampleTimeEntry *mSampleTimeEntries;
 
+    // Position within a run-length coded table (stts or ctts).
+    struct RunCursor {
+        size_t mRun;
+        uint64_t mFirstSample;  // first sample of mRun
+        uint64_t mFirstTime;    // decode time of mFirstSample, stts only
+    };
+
+    // Time seeks bisect on the stts/ctts runs instead of sorting every sample.
+    // Every kRunCheckpointInterval-th run is recorded, so that locating the run
+    // of a sample or a decode time does not have to walk the whole table.
+    static const size_t kRunCheckpointInterval = 256;
+    // Initial number of samples added on either side of a seek window.
+    static const uint32_t kSeekWindowMargin = 64;
+    bool mSeekIndexBuilt;
+    std::vector<RunCursor> mTimeToSampleCheckpoints;
+    std::vector<RunCursor> mCompositionDeltaCheckpoints;
+    int32_t mMinCompositionDelta;
+    int32_t mMaxCompositionDelta;
+
+    // Samples [mSeekWindowStart, mSeekWindowEnd) sorted by composition time,
+    // materialized around the target of the last time seek.
+    std::vector<SampleTimeEntry> mSeekWindow;
+    uint32_t mSeekWindowStart;
+    uint32_t mSeekWindowEnd;
+
     int32_t *mCompositionTimeDeltaEntries;
     size_t mNumCompositionTimeDeltaEntries;
     CompositionDeltaLookup *mCompositionDeltaLookup;
@@ -155,14 +192,6 @@ private:
 
     friend struct SampleIterator;
 
-    // normally we don't round
-    inline uint64_t getSampleTime(
-            size_t sample_index, uint64_t scale_num, uint64_t scale_den) const {
-        return (sample_index < (size_t)mNumSampleSizes && mSampleTimeEntries != NULL
-                && scale_den != 0)
-                ? (mSampleTimeEntries[sample_index].mCompositionTime * scale_num) / scale_den : 0;
-    }
-
     status_t getSampleSize_l(uint32_t sample_index, size_t *sample_size);
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
 
@@ -170,6 +199,18 @@ private:
 
     void buildSampleEntriesTable();
 
+    void buildSeekIndex_l();
+    RunCursor getTimeToSampleCursor_l(uint32_t sampleIndex) const;
+    void advanceTimeToSampleCursor_l(RunCursor *cursor, uint32_t sampleIndex) const;
+    RunCursor getCompositionDeltaCursor_l(uint32_t sampleIndex) const;
+    void advanceCompositionDeltaCursor_l(RunCursor *cursor, uint32_t sampleIndex) const;
+    uint64_t getDecodeTime_l(const RunCursor &cursor, uint32_t sampleIndex) const;
+    uint32_t findFirstSampleAtDecodeTime_l(uint64_t decodeTime) const;
+    status_t buildSeekWindow_l(uint32_t start, uint32_t end);
+    bool findSampleInSeekWindow_l(
+            uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+            uint32_t *sample_index, uint32_t flags, status_t *err);
+
     SampleTable(const SampleTable &);
     SampleTable &operator=(const SampleTable &);
 };
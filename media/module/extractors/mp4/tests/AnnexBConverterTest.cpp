@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "AnnexBConverterTest"
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/MediaErrors.h>
+
+#include <AnnexBConverter.h>
+
+using namespace android;
+
+namespace {
+
+// Builds a sample of NAL units of |nalLengths| bytes, prefixed by lengths of
+// |nalLengthSize| bytes, and the same NAL units prefixed by start codes.
+void makeSample(size_t nalLengthSize, const std::vector<size_t> &nalLengths,
+        std::vector<uint8_t> *sample, std::vector<uint8_t> *annexB) {
+    sample->clear();
+    annexB->clear();
+    uint8_t value = 0x10;
+    for (size_t nalLength : nalLengths) {
+        for (size_t i = nalLengthSize; i > 0; --i) {
+            sample->push_back(nalLength >> (8 * (i - 1)));
+        }
+        if (nalLength > 0) {
+            annexB->insert(annexB->end(), { 0, 0, 0, 1 });
+        }
+        for (size_t i = 0; i < nalLength; ++i) {
+            sample->push_back(value);
+            annexB->push_back(value);
+            ++value;
+        }
+    }
+}
+
+// Converts |sample| in a buffer of |capacity| bytes and checks the result
+// against |annexB|.
+void expectConverted(const AnnexBConverter &converter, const std::vector<uint8_t> &sample,
+        size_t capacity, uint8_t *scratch, size_t scratchSize,
+        const std::vector<uint8_t> &annexB) {
+    std::vector<uint8_t> buffer(sample);
+    buffer.resize(capacity);
+    size_t annexBSize = 0;
+    ASSERT_EQ(OK, converter.convert(buffer.data(), buffer.size(), sample.size(),
+            false /* truncateMalformed */, scratch, scratchSize, &annexBSize));
+    ASSERT_EQ(annexB.size(), annexBSize);
+    EXPECT_EQ(annexB, std::vector<uint8_t>(buffer.begin(), buffer.begin() + annexBSize));
+}
+
+}  // namespace
+
+TEST(AnnexBConverterTest, ConvertsAllNALLengthSizes) {
+    for (size_t nalLengthSize = 1; nalLengthSize <= 4; ++nalLengthSize) {
+        SCOPED_TRACE(testing::Message() << "nalLengthSize " << nalLengthSize);
+        AnnexBConverter converter(nalLengthSize);
+        std::vector<uint8_t> sample, annexB;
+        makeSample(nalLengthSize, { 1, 2, 5, 30, 3, 200 }, &sample, &annexB);
+
+        size_t size = sample.size();
+        size_t annexBSize = 0;
+        size_t shift = 0;
+        EXPECT_TRUE(converter.getAnnexBSize(sample.data(), &size, &annexBSize, &shift));
+        EXPECT_EQ(sample.size(), size);
+        EXPECT_EQ(annexB.size(), annexBSize);
+        // the start codes take 4 - nalLengthSize more bytes per NAL unit
+        EXPECT_EQ(6 * (4 - nalLengthSize), shift);
+
+        expectConverted(converter, sample, annexB.size(), nullptr, 0, annexB);
+    }
+}
+
+TEST(AnnexBConverterTest, DropsZeroLengthNALUnits) {
+    for (size_t nalLengthSize = 1; nalLengthSize <= 4; ++nalLengthSize) {
+        SCOPED_TRACE(testing::Message() << "nalLengthSize " << nalLengthSize);
+        AnnexBConverter converter(nalLengthSize);
+        std::vector<uint8_t> sample, annexB;
+        makeSample(nalLengthSize, { 0, 7, 0, 0, 12 }, &sample, &annexB);
+        ASSERT_EQ(2 * 4 + 7 + 12u, annexB.size());
+        expectConverted(converter, sample, sample.size() + 16, nullptr, 0, annexB);
+
+        makeSample(nalLengthSize, { 0, 0, 0, 1 }, &sample, &annexB);
+        expectConverted(converter, sample, sample.size() + 4, nullptr, 0, annexB);
+    }
+}
+
+TEST(AnnexBConverterTest, HandlesTruncatedNALUnits) {
+    for (size_t nalLengthSize = 1; nalLengthSize <= 4; ++nalLengthSize) {
+        SCOPED_TRACE(testing::Message() << "nalLengthSize " << nalLengthSize);
+        AnnexBConverter converter(nalLengthSize);
+        std::vector<uint8_t> complete, completeAnnexB;
+        makeSample(nalLengthSize, { 9, 4 }, &complete, &completeAnnexB);
+
+        // The last NAL unit is cut short, then its length is.
+        for (size_t cut : { (size_t)1, 4 + nalLengthSize - 1 }) {
+            std::vector<uint8_t> sample(complete.begin(), complete.end() - cut);
+            std::vector<uint8_t> annexB, unused;
+            makeSample(nalLengthSize, { 9 }, &unused, &annexB);
+
+            size_t size = sample.size();
+            size_t annexBSize = 0;
+            size_t shift = 0;
+            EXPECT_FALSE(converter.getAnnexBSize(sample.data(), &size, &annexBSize, &shift));
+            EXPECT_EQ(nalLengthSize + 9, size);
+            EXPECT_EQ(annexB.size(), annexBSize);
+
+            std::vector<uint8_t> buffer(sample);
+            buffer.resize(completeAnnexB.size());
+            EXPECT_EQ(ERROR_MALFORMED, converter.convert(buffer.data(), buffer.size(),
+                    sample.size(), false /* truncateMalformed */, nullptr, 0, &annexBSize));
+
+            ASSERT_EQ(OK, converter.convert(buffer.data(), buffer.size(), sample.size(),
+                    true /* truncateMalformed */, nullptr, 0, &annexBSize));
+            ASSERT_EQ(annexB.size(), annexBSize);
+            EXPECT_EQ(annexB, std::vector<uint8_t>(buffer.begin(), buffer.begin() + annexBSize));
+        }
+    }
+}
+
+TEST(AnnexBConverterTest, ConvertsThroughScratchBufferWithoutRoom) {
+    // The zero length NAL units take room in the sample but not in its conversion, so
+    // the buffer is too small to move the sample far enough for an in place conversion.
+    // Samples with 4 byte lengths are converted in place without moving them.
+    for (size_t nalLengthSize = 1; nalLengthSize <= 3; ++nalLengthSize) {
+        SCOPED_TRACE(testing::Message() << "nalLengthSize " << nalLengthSize);
+        AnnexBConverter converter(nalLengthSize);
+        std::vector<uint8_t> sample, annexB;
+        makeSample(nalLengthSize, { 20, 0, 0, 0, 0, 1 }, &sample, &annexB);
+        const size_t capacity = std::max(sample.size(), annexB.size());
+
+        size_t size = sample.size();
+        size_t annexBSize = 0;
+        size_t shift = 0;
+        EXPECT_TRUE(converter.getAnnexBSize(sample.data(), &size, &annexBSize, &shift));
+        ASSERT_GT(shift, capacity - sample.size());
+
+        std::vector<uint8_t> buffer(sample);
+        buffer.resize(capacity);
+        EXPECT_EQ(ERROR_MALFORMED, converter.convert(buffer.data(), buffer.size(),
+                sample.size(), false /* truncateMalformed */, nullptr, 0, &annexBSize));
+
+        std::vector<uint8_t> scratch(sample.size() - 1);
+        EXPECT_EQ(ERROR_MALFORMED, converter.convert(buffer.data(), buffer.size(),
+                sample.size(), false /* truncateMalformed */, scratch.data(), scratch.size(),
+                &annexBSize));
+
+        scratch.resize(sample.size());
+        expectConverted(converter, sample, capacity, scratch.data(), scratch.size(), annexB);
+    }
+}
+
+TEST(AnnexBConverterTest, RejectsConversionLargerThanBuffer) {
+    AnnexBConverter converter(1);
+    std::vector<uint8_t> sample, annexB;
+    makeSample(1, { 10, 10 }, &sample, &annexB);
+    std::vector<uint8_t> buffer(sample);
+    buffer.resize(annexB.size() - 1);
+    std::vector<uint8_t> scratch(annexB.size());
+    size_t annexBSize = 0;
+    EXPECT_EQ(ERROR_MALFORMED, converter.convert(buffer.data(), buffer.size(), sample.size(),
+            false /* truncateMalformed */, scratch.data(), scratch.size(), &annexBSize));
+}
@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ChunkReadAheadTest"
+#include <utils/Log.h>
+
+#include <arpa/inet.h>
+#include <string.h>
+
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/foundation/ByteUtils.h>
+
+#include <ChunkReadAhead.h>
+#include <SampleTable.h>
+
+using namespace android;
+
+namespace {
+
+// An audio track of small samples, 64 per chunk, interleaved with the chunks
+// of a video track, and a video track with samples larger than the budget.
+constexpr uint32_t kNumChunks = 50;
+constexpr uint32_t kSamplesPerChunk = 64;
+constexpr uint32_t kNumSamples = kNumChunks * kSamplesPerChunk;
+constexpr size_t kVideoChunkSize = 100 * 1024;
+constexpr size_t kBudget = 16 * 1024;
+
+constexpr uint32_t kNumLargeSamples = 8;
+constexpr size_t kLargeSampleSize = 3 * kBudget / 2;
+
+constexpr size_t kMaxSampleSize = 500;
+
+size_t sampleSize(uint32_t sampleIndex) {
+    return 200 + (sampleIndex * 37) % (kMaxSampleSize - 200);
+}
+
+// A video track with samples of 40% to 85% of the budget, like 4K video
+// samples against the read-ahead budget of the extractor.
+constexpr uint32_t kNumVideoChunks = 20;
+constexpr uint32_t kVideoSamplesPerChunk = 4;
+
+size_t videoSampleSize(uint32_t sampleIndex) {
+    return 2 * kBudget / 5 + (sampleIndex * 1733) % (kBudget * 9 / 20);
+}
+
+// Serves an in-memory file.
+class MemorySource : public DataSourceHelper {
+  public:
+    MemorySource() : DataSourceHelper((CDataSource *)nullptr) {}
+
+    ssize_t readAt(off64_t offset, void *data, size_t size) override {
+        if (offset < 0 || (uint64_t)offset >= mData.size()) {
+            return 0;
+        }
+        size = std::min(size, (size_t)(mData.size() - offset));
+        memcpy(data, &mData[offset], size);
+        return size;
+    }
+
+    status_t getSize(off64_t *size) override {
+        *size = mData.size();
+        return OK;
+    }
+
+    off64_t append32(uint32_t value) {
+        off64_t offset = mData.size();
+        mData.resize(offset + 4);
+        set32(offset, value);
+        return offset;
+    }
+
+    void set32(off64_t offset, uint32_t value) {
+        value = htonl(value);
+        memcpy(&mData[offset], &value, 4);
+    }
+
+    off64_t appendBytes(size_t size) {
+        off64_t offset = mData.size();
+        for (size_t i = 0; i < size; ++i) {
+            mData.push_back((offset + i) * 13 + (offset + i) / 251);
+        }
+        return offset;
+    }
+
+    void hintReadAhead(off64_t offset, size_t size) override {
+        mHints.push_back({offset, offset + (off64_t)size});
+    }
+
+    const uint8_t *dataAt(off64_t offset) const { return &mData[offset]; }
+
+    // Ranges passed to hintReadAhead(), as [start, end).
+    std::vector<std::pair<off64_t, off64_t>> mHints;
+
+  private:
+    std::vector<uint8_t> mData;
+};
+
+}  // namespace
+
+class ChunkReadAheadTest : public ::testing::Test {
+  public:
+    // Lays out the sample table boxes of a track, followed by its chunks.
+    void setUpTrack(uint32_t numChunks, uint32_t samplesPerChunk,
+                    size_t (*getSampleSize)(uint32_t), size_t gapSize) {
+        const uint32_t numSamples = numChunks * samplesPerChunk;
+        mSampleTable = new SampleTable(&mSource);
+
+        const off64_t stts = mSource.append32(0);
+        mSource.append32(1);
+        mSource.append32(numSamples);
+        mSource.append32(1024);
+        ASSERT_EQ(OK, mSampleTable->setTimeToSampleParams(stts, 16));
+
+        const off64_t stsc = mSource.append32(0);
+        mSource.append32(1);
+        mSource.append32(1);
+        mSource.append32(samplesPerChunk);
+        mSource.append32(1);
+        ASSERT_EQ(OK, mSampleTable->setSampleToChunkParams(stsc, 20));
+
+        const off64_t stsz = mSource.append32(0);
+        mSource.append32(0);
+        mSource.append32(numSamples);
+        for (uint32_t i = 0; i < numSamples; ++i) {
+            mSource.append32(getSampleSize(i));
+        }
+        ASSERT_EQ(OK, mSampleTable->setSampleSizeParams(
+                FOURCC("stsz"), stsz, 12 + 4 * numSamples));
+
+        const off64_t stco = mSource.append32(0);
+        mSource.append32(numChunks);
+        std::vector<off64_t> chunkOffsetOffsets;
+        for (uint32_t i = 0; i < numChunks; ++i) {
+            chunkOffsetOffsets.push_back(mSource.append32(0));
+        }
+        for (uint32_t i = 0; i < numChunks; ++i) {
+            // Another track is interleaved before every chunk.
+            mSource.appendBytes(gapSize);
+            size_t chunkSize = 0;
+            for (uint32_t j = 0; j < samplesPerChunk; ++j) {
+                chunkSize += getSampleSize(i * samplesPerChunk + j);
+            }
+            const off64_t chunkOffset = mSource.appendBytes(chunkSize);
+            mSource.set32(chunkOffsetOffsets[i], chunkOffset);
+        }
+        ASSERT_EQ(OK, mSampleTable->setChunkOffsetParams(
+                FOURCC("stco"), stco, 8 + 4 * numChunks));
+        ASSERT_EQ(numSamples, mSampleTable->countSamples());
+    }
+
+    void TearDown() override { mSampleTable.clear(); }
+
+    // Reads every sample of the track through |readAhead|, checks its content,
+    // and returns the number of bytes read.
+    size_t readAllSamples(ChunkReadAhead *readAhead) {
+        size_t numBytes = 0;
+        std::vector<uint8_t> buffer;
+        for (uint32_t i = 0; i < mSampleTable->countSamples(); ++i) {
+            off64_t offset;
+            size_t size;
+            EXPECT_EQ(OK, mSampleTable->getMetaDataForSample(i, &offset, &size, nullptr));
+            buffer.assign(size, 0);
+            ssize_t n = readAhead->readAt(
+                    offset, buffer.data(), size, mSampleTable->getChunkEnd());
+            EXPECT_EQ((ssize_t)size, n) << "sample " << i;
+            if (n != (ssize_t)size || memcmp(buffer.data(), mSource.dataAt(offset), size) != 0) {
+                ADD_FAILURE() << "sample " << i << " differs";
+                break;
+            }
+            numBytes += n;
+        }
+        return numBytes;
+    }
+
+    MemorySource mSource;
+    sp<SampleTable> mSampleTable;
+};
+
+TEST_F(ChunkReadAheadTest, ReadsSmallSamplesByChunk) {
+    setUpTrack(kNumChunks, kSamplesPerChunk, sampleSize, kVideoChunkSize);
+
+    // Without a budget, every sample is read directly.
+    ChunkReadAhead direct(&mSource, 0);
+    const size_t directBytes = readAllSamples(&direct);
+    const size_t directReads = direct.numSourceReads();
+    EXPECT_EQ(directBytes, direct.numSourceBytes());
+
+    ChunkReadAhead readAhead(&mSource, kBudget);
+    EXPECT_EQ(directBytes, readAllSamples(&readAhead));
+
+    ALOGI("%u samples: %zu reads of %zu bytes, %zu reads of %zu bytes with read-ahead",
+          kNumSamples, directReads, directBytes, readAhead.numSourceReads(),
+          readAhead.numSourceBytes());
+    RecordProperty("DirectReads", std::to_string(directReads));
+    RecordProperty("DirectBytes", std::to_string(directBytes));
+    RecordProperty("ReadAheadReads", std::to_string(readAhead.numSourceReads()));
+    RecordProperty("ReadAheadBytes", std::to_string(readAhead.numSourceBytes()));
+
+    EXPECT_EQ(kNumSamples, directReads);
+    // A chunk of ~22KB takes two reads of the 16KB budget.
+    EXPECT_LE(readAhead.numSourceReads(), 2 * kNumChunks);
+    // The samples of the interleaved track are never read, only the samples
+    // straddling the end of a read ahead are read twice.
+    EXPECT_LE(readAhead.numSourceBytes(), directBytes + kNumChunks * kMaxSampleSize);
+}
+
+TEST_F(ChunkReadAheadTest, ReadsLargeSamplesDirectly) {
+    setUpTrack(kNumLargeSamples / 2, 2, [](uint32_t) { return kLargeSampleSize; }, 1000);
+
+    ChunkReadAhead readAhead(&mSource, kBudget);
+    EXPECT_EQ(kNumLargeSamples * kLargeSampleSize, readAllSamples(&readAhead));
+    EXPECT_EQ(kNumLargeSamples, readAhead.numSourceReads());
+    EXPECT_EQ(kNumLargeSamples * kLargeSampleSize, readAhead.numSourceBytes());
+}
+
+TEST_F(ChunkReadAheadTest, ReadsVideoSamplesDirectly) {
+    setUpTrack(kNumVideoChunks, kVideoSamplesPerChunk, videoSampleSize, 1000);
+
+    ChunkReadAhead direct(&mSource, 0);
+    const size_t directBytes = readAllSamples(&direct);
+
+    ChunkReadAhead readAhead(&mSource, kBudget);
+    EXPECT_EQ(directBytes, readAllSamples(&readAhead));
+
+    RecordProperty("DirectBytes", std::to_string(directBytes));
+    RecordProperty("ReadAheadBytes", std::to_string(readAhead.numSourceBytes()));
+
+    // Reading ahead the rest of the budget after a sample this large would
+    // mostly read data that is read again with the next sample.
+    EXPECT_LE(readAhead.numSourceBytes(), directBytes + directBytes / 20);
+    EXPECT_EQ(kNumVideoChunks * kVideoSamplesPerChunk, readAhead.numSourceReads());
+}
+
+TEST_F(ChunkReadAheadTest, HintsRestOfChunkForVideoSamples) {
+    setUpTrack(kNumVideoChunks, kVideoSamplesPerChunk, videoSampleSize, 1000);
+
+    ChunkReadAhead readAhead(&mSource, kBudget);
+    readAllSamples(&readAhead);
+    EXPECT_LE(mSource.mHints.size(), (size_t)kNumVideoChunks * kVideoSamplesPerChunk);
+
+    for (uint32_t i = 0; i < mSampleTable->countSamples(); ++i) {
+        off64_t offset;
+        size_t size;
+        ASSERT_EQ(OK, mSampleTable->getMetaDataForSample(i, &offset, &size, nullptr));
+        const off64_t chunkEnd = mSampleTable->getChunkEnd();
+        bool hinted = false;
+        for (const auto &[start, end] : mSource.mHints) {
+            // hints stay within the chunk they were made for
+            if (start <= offset && offset < end) {
+                hinted = true;
+                EXPECT_LE(end, chunkEnd) << "sample " << i;
+            }
+        }
+        // all samples but the first of each chunk were hinted before being read
+        EXPECT_EQ(i % kVideoSamplesPerChunk != 0, hinted) << "sample " << i;
+    }
+}
+
+TEST_F(ChunkReadAheadTest, DoesNotHintSmallSamples) {
+    setUpTrack(kNumChunks, kSamplesPerChunk, sampleSize, kVideoChunkSize);
+
+    ChunkReadAhead readAhead(&mSource, kBudget);
+    readAllSamples(&readAhead);
+    EXPECT_TRUE(mSource.mHints.empty());
+}
+
+TEST_F(ChunkReadAheadTest, ReadsBackwards) {
+    setUpTrack(kNumChunks, kSamplesPerChunk, sampleSize, kVideoChunkSize);
+
+    ChunkReadAhead readAhead(&mSource, kBudget);
+    std::vector<uint8_t> buffer;
+    for (uint32_t i = kNumSamples; i-- > 0;) {
+        off64_t offset;
+        size_t size;
+        ASSERT_EQ(OK, mSampleTable->getMetaDataForSample(i, &offset, &size, nullptr));
+        buffer.assign(size, 0);
+        ASSERT_EQ((ssize_t)size,
+                  readAhead.readAt(offset, buffer.data(), size, mSampleTable->getChunkEnd()));
+        ASSERT_EQ(0, memcmp(buffer.data(), mSource.dataAt(offset), size)) << "sample " << i;
+    }
+}
+
+TEST_F(ChunkReadAheadTest, ReadsPastEndOfSource) {
+    MemorySource source;
+    const off64_t offset = source.appendBytes(1000);
+    ChunkReadAhead readAhead(&source, kBudget);
+
+    // The chunk claims to extend past the end of the source.
+    std::vector<uint8_t> buffer(600);
+    EXPECT_EQ(600, readAhead.readAt(offset, buffer.data(), 600, offset + 5000));
+    EXPECT_EQ(0, memcmp(buffer.data(), source.dataAt(offset), 600));
+    EXPECT_EQ(400, readAhead.readAt(offset + 600, buffer.data(), 600, offset + 5000));
+    EXPECT_EQ(0, memcmp(buffer.data(), source.dataAt(offset + 600), 400));
+    EXPECT_EQ(0, readAhead.readAt(offset + 1000, buffer.data(), 600, offset + 5000));
+}
@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SampleTableTest"
+#include <utils/Log.h>
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/foundation/ByteUtils.h>
+
+#include <SampleTable.h>
+
+using namespace android;
+
+namespace {
+
+// A track with an I frame followed by P B B groups, in decode order:
+//   sample:           0  1  2  3  4  5  6  7 ...
+//   decode slot:      0  1  2  3  4  5  6  7 ...
+//   composition slot: 1  4  2  3  7  5  6 10 ...
+// Every composition slot k >= 1 holds exactly one sample.
+constexpr uint32_t kNumSamples = 10000000;  // 1 + 3 * 3333333
+constexpr uint32_t kSampleDuration = 3000;
+
+constexpr off64_t kSttsOffset = 0;
+constexpr size_t kSttsSize = 8 + 8;
+constexpr off64_t kStszOffset = kSttsOffset + kSttsSize;
+constexpr size_t kStszSize = 12;
+constexpr off64_t kCttsOffset = kStszOffset + kStszSize;
+
+constexpr size_t getCttsSize(uint32_t numSamples) {
+    // One entry for the I frame, then one for each P frame and B frame pair.
+    return 8 + 8 * (1 + 2 * ((numSamples - 1) / 3));
+}
+constexpr size_t kCttsSize = getCttsSize(kNumSamples);
+
+// The sorted table of all samples this track used to need is 160MB.
+constexpr size_t kMaxSeekIndexSize = 1 << 20;
+
+uint32_t sampleAtCompositionSlot(uint64_t slot) {
+    if (slot == 1) {
+        return 0;
+    }
+    // P frames are presented 3 slots after they are decoded, B frames in place.
+    return slot % 3 == 1 ? slot - 3 : slot;
+}
+
+// Generates the stts, stsz and ctts boxes of the track on the fly, so that
+// the test does not hold a second copy of the 53MB ctts table. A smaller
+// |size| truncates the source, like a file that was cut short.
+class SyntheticTrackSource : public DataSourceHelper {
+  public:
+    explicit SyntheticTrackSource(uint32_t numSamples = kNumSamples, off64_t size = -1)
+        : DataSourceHelper((CDataSource *)nullptr),
+          mNumSamples(numSamples),
+          mSize(size >= 0 ? size : kCttsOffset + getCttsSize(numSamples)) {}
+
+    ssize_t readAt(off64_t offset, void *data, size_t size) override {
+        uint8_t *out = (uint8_t *)data;
+        size_t n = 0;
+        for (; n < size && offset + (off64_t)n < mSize; ++n) {
+            out[n] = byteAt(offset + n);
+        }
+        return n;
+    }
+
+    status_t getSize(off64_t *size) override {
+        *size = mSize;
+        return OK;
+    }
+
+  private:
+    const uint32_t mNumSamples;
+    const off64_t mSize;
+
+    uint32_t wordAt(off64_t offset) const {
+        if (offset < kStszOffset) {
+            const uint32_t stts[] = {0, 1, mNumSamples, kSampleDuration};
+            return stts[(offset - kSttsOffset) / 4];
+        }
+        if (offset < kCttsOffset) {
+            const uint32_t stsz[] = {0, 1024 /* default size */, mNumSamples};
+            return stsz[(offset - kStszOffset) / 4];
+        }
+        size_t word = (offset - kCttsOffset) / 4;
+        if (word < 2) {
+            return word == 0 ? 0 : (getCttsSize(mNumSamples) - 8) / 8;
+        }
+        size_t entry = (word - 2) / 2;
+        bool isCount = (word - 2) % 2 == 0;
+        if (entry == 0) {
+            // I frame
+            return isCount ? 1 : kSampleDuration;
+        }
+        if ((entry - 1) % 2 == 0) {
+            // P frame
+            return isCount ? 1 : 3 * kSampleDuration;
+        }
+        // B frames
+        return isCount ? 2 : 0;
+    }
+
+    uint8_t byteAt(off64_t offset) const {
+        return wordAt(offset & ~3) >> (8 * (3 - (offset & 3)));
+    }
+};
+
+sp<SampleTable> createSampleTable(DataSourceHelper *source) {
+    sp<SampleTable> sampleTable = new SampleTable(source);
+    EXPECT_EQ(OK, sampleTable->setTimeToSampleParams(kSttsOffset, kSttsSize));
+    EXPECT_EQ(OK, sampleTable->setSampleSizeParams(FOURCC("stsz"), kStszOffset, kStszSize));
+    return sampleTable;
+}
+
+}  // namespace
+
+class SampleTableTest : public ::testing::Test {
+  public:
+    void SetUp() override {
+        mSampleTable = createSampleTable(&mSource);
+        ASSERT_EQ(OK, mSampleTable->setCompositionTimeToSampleParams(kCttsOffset, kCttsSize));
+        ASSERT_EQ(kNumSamples, mSampleTable->countSamples());
+    }
+
+    void TearDown() override { mSampleTable.clear(); }
+
+    uint32_t findSample(uint64_t time, uint32_t flags) {
+        uint32_t sampleIndex = UINT32_MAX;
+        EXPECT_EQ(OK, mSampleTable->findSampleAtTime(time, 1, 1, &sampleIndex, flags))
+                << "time " << time << " flags " << flags;
+        return sampleIndex;
+    }
+
+    SyntheticTrackSource mSource;
+    sp<SampleTable> mSampleTable;
+};
+
+TEST_F(SampleTableTest, FirstSeekIsFastAndSmall) {
+    const auto start = std::chrono::steady_clock::now();
+
+    const uint64_t slot = kNumSamples / 2;
+    EXPECT_EQ(sampleAtCompositionSlot(slot),
+              findSample(slot * kSampleDuration, SampleTable::kFlagClosest));
+
+    const auto latencyUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    const size_t seekIndexSize = mSampleTable->getSeekIndexSize();
+    ALOGI("first seek in %u samples took %lld us, seek index holds %zu bytes",
+          kNumSamples, (long long)latencyUs, seekIndexSize);
+    RecordProperty("FirstSeekLatencyUs", std::to_string(latencyUs));
+    RecordProperty("SeekIndexSize", std::to_string(seekIndexSize));
+
+    EXPECT_GT(seekIndexSize, 0u);
+    EXPECT_LT(seekIndexSize, kMaxSeekIndexSize);
+}
+
+TEST_F(SampleTableTest, SeeksInPresentationOrder) {
+    // Spread over the track, including both ends.
+    const uint64_t slots[] = {
+        2, 3, 4, 5, 100, 101, 102, kNumSamples / 3, kNumSamples / 2 + 1,
+        kNumSamples - 100, kNumSamples - 2, kNumSamples - 1,
+    };
+    for (uint64_t slot : slots) {
+        const uint64_t time = slot * kSampleDuration;
+        EXPECT_EQ(sampleAtCompositionSlot(slot), findSample(time, SampleTable::kFlagBefore));
+        EXPECT_EQ(sampleAtCompositionSlot(slot), findSample(time + 1, SampleTable::kFlagBefore));
+        EXPECT_EQ(sampleAtCompositionSlot(slot + 1), findSample(time + 1, SampleTable::kFlagAfter));
+        EXPECT_EQ(sampleAtCompositionSlot(slot),
+                  findSample(time + kSampleDuration / 3, SampleTable::kFlagClosest));
+        EXPECT_EQ(sampleAtCompositionSlot(slot + 1),
+                  findSample(time + 2 * kSampleDuration / 3, SampleTable::kFlagClosest));
+    }
+}
+
+TEST_F(SampleTableTest, SeeksOutsideOfTrack) {
+    // Before the first sample, every seek returns the first sample.
+    EXPECT_EQ(0u, findSample(0, SampleTable::kFlagBefore));
+    EXPECT_EQ(0u, findSample(0, SampleTable::kFlagClosest));
+    EXPECT_EQ(0u, findSample(0, SampleTable::kFlagAfter));
+
+    // The last P frame is presented last.
+    const uint64_t lastSlot = kNumSamples;
+    const uint64_t pastEnd = (lastSlot + 10) * kSampleDuration;
+    EXPECT_EQ(sampleAtCompositionSlot(lastSlot), findSample(pastEnd, SampleTable::kFlagBefore));
+    EXPECT_EQ(sampleAtCompositionSlot(lastSlot), findSample(pastEnd, SampleTable::kFlagClosest));
+
+    uint32_t sampleIndex;
+    EXPECT_EQ(ERROR_OUT_OF_RANGE,
+              mSampleTable->findSampleAtTime(pastEnd, 1, 1, &sampleIndex,
+                                             SampleTable::kFlagAfter));
+}
+
+TEST(SampleTableFrameIndexTest, SeeksToFramesInPresentationOrder) {
+    // Frame index seeks need the fully sorted table, keep the track small.
+    constexpr uint32_t kNumShortSamples = 1 + 3 * 1000;
+    SyntheticTrackSource source(kNumShortSamples);
+    sp<SampleTable> sampleTable = createSampleTable(&source);
+    ASSERT_EQ(OK, sampleTable->setCompositionTimeToSampleParams(
+            kCttsOffset, getCttsSize(kNumShortSamples)));
+
+    for (uint32_t frame = 0; frame < kNumShortSamples; ++frame) {
+        uint32_t sampleIndex = UINT32_MAX;
+        ASSERT_EQ(OK, sampleTable->findSampleAtTime(
+                frame, 1, 1, &sampleIndex, SampleTable::kFlagFrameIndex));
+        EXPECT_EQ(sampleAtCompositionSlot(frame + 1), sampleIndex) << "frame " << frame;
+    }
+    uint32_t sampleIndex;
+    EXPECT_EQ(ERROR_OUT_OF_RANGE, sampleTable->findSampleAtTime(
+            kNumShortSamples, 1, 1, &sampleIndex, SampleTable::kFlagFrameIndex));
+
+    // Time seeks after a frame index seek still return the same samples.
+    const uint64_t slot = kNumShortSamples / 2;
+    EXPECT_EQ(OK, sampleTable->findSampleAtTime(
+            slot * kSampleDuration, 1, 1, &sampleIndex, SampleTable::kFlagClosest));
+    EXPECT_EQ(sampleAtCompositionSlot(slot), sampleIndex);
+    EXPECT_GE(sampleTable->getSeekIndexSize(), kNumShortSamples * sizeof(uint64_t));
+}
+
+TEST(SampleTableFrameIndexTest, SeeksToFramesInDecodeOrderWithoutReordering) {
+    SyntheticTrackSource source;
+    sp<SampleTable> sampleTable = createSampleTable(&source);
+
+    const uint32_t frames[] = {0, 1, kNumSamples / 2, kNumSamples - 1};
+    for (uint32_t frame : frames) {
+        uint32_t sampleIndex = UINT32_MAX;
+        EXPECT_EQ(OK, sampleTable->findSampleAtTime(
+                frame, 1, 1, &sampleIndex, SampleTable::kFlagFrameIndex));
+        EXPECT_EQ(frame, sampleIndex);
+    }
+    // Nothing needs to be sorted.
+    EXPECT_EQ(0u, sampleTable->getSeekIndexSize());
+}
+
+TEST(SampleTableTruncatedTest, IgnoresTruncatedCompositionTimeTable) {
+    // The ctts header claims more entries than the source holds.
+    SyntheticTrackSource source(kNumSamples, kCttsOffset + kCttsSize / 2);
+    sp<SampleTable> sampleTable = createSampleTable(&source);
+    EXPECT_EQ(ERROR_IO, sampleTable->setCompositionTimeToSampleParams(kCttsOffset, kCttsSize));
+
+    // Without a usable ctts table, samples are presented in decode order.
+    const uint32_t samples[] = {0, 1, 2, kNumSamples / 2, kNumSamples - 1};
+    for (uint32_t sample : samples) {
+        const uint64_t time = (uint64_t)sample * kSampleDuration;
+        uint32_t sampleIndex = UINT32_MAX;
+        EXPECT_EQ(OK, sampleTable->findSampleAtTime(
+                time + 1, 1, 1, &sampleIndex, SampleTable::kFlagBefore));
+        EXPECT_EQ(sample, sampleIndex);
+        EXPECT_EQ(OK, sampleTable->findSampleAtTime(
+                time, 1, 1, &sampleIndex, SampleTable::kFlagClosest));
+        EXPECT_EQ(sample, sampleIndex);
+        EXPECT_EQ(OK, sampleTable->findSampleAtTime(
+                sample, 1, 1, &sampleIndex, SampleTable::kFlagFrameIndex));
+        EXPECT_EQ(sample, sampleIndex);
+    }
+}
@@ -18,9 +18,11 @@
 #define LOG_TAG "MPEG2TSExtractor"
 
 #include <inttypes.h>
+#include <pthread.h>
 #include <utils/Log.h>
 
 #include <android-base/macros.h>
+#include <android-base/properties.h>
 
 #include "MPEG2TSExtractor.h"
 
@@ -37,6 +39,7 @@
 #include <media/stagefright/Utils.h>
 #include <mpeg2ts/AnotherPacketSource.h>
 #include <utils/String8.h>
+#include <utils/threads.h>
 
 #include <hidl/HybridInterface.h>
 #include <android/hardware/cas/1.0/ICas.h>
@@ -48,6 +51,8 @@ using hardware::cas::V1_0::ICas;
 static const size_t kTSPacketSize = 188;
 static const int kMaxDurationReadSize = 250000LL;
 static const int kMaxDurationRetry = 6;
+// Number of packets the index pass reads at a time.
+static const size_t kIndexReadPackets = 64;
 
 struct MPEG2TSSource : public MediaTrackHelper {
     MPEG2TSSource(
@@ -250,7 +255,11 @@ MPEG2TSExtractor::MPEG2TSExtractor(DataSourceHelper *source)
     : mDataSource(source),
       mParser(new ATSParser),
       mLastSyncEvent(0),
-      mOffset(0) {
+      mSeekSyncPoints(NULL),
+      mOffset(0),
+      mIndexComplete(false),
+      mSeekSourceType(ATSParser::NUM_SOURCE_TYPES),
+      mStopIndexing(false) {
     char header;
     if (source->readAt(0, &header, 1) == 1 && header == 0x47) {
         mHeaderSkip = 0;
@@ -261,6 +270,10 @@ MPEG2TSExtractor::MPEG2TSExtractor(DataSourceHelper *source)
 }
 
 MPEG2TSExtractor::~MPEG2TSExtractor() {
+    mStopIndexing = true;
+    if (mIndexThread.joinable()) {
+        mIndexThread.join();
+    }
     delete mDataSource;
 }
 
@@ -474,6 +487,8 @@ void MPEG2TSExtractor::init() {
         }
     }
 
+    startIndexing();
+
     ALOGI("haveAudio=%d, haveVideo=%d, elaspedTime=%" PRId64,
             haveAudio, haveVideo, ALooper::GetNowUs() - startTime);
 }
@@ -628,12 +643,137 @@ status_t MPEG2TSExtractor::estimateDurationsFromTimesUsAtEnd()  {
     return allDurationsFound? OK : ERROR_UNSUPPORTED;
 }
 
+void MPEG2TSExtractor::startIndexing() {
+    if (mIndexThread.joinable() || mIndexComplete || mSeekSyncPoints == NULL
+            || !(mDataSource->flags() & DataSourceBase::kIsLocalFileSource)
+            || !base::GetBoolProperty("media.mpeg2ts.index", false)) {
+        return;
+    }
+
+    for (size_t i = 0; i < mSyncPoints.size(); ++i) {
+        if (mSeekSyncPoints == &mSyncPoints.editItemAt(i)) {
+            mSeekSourceType = mSourceImpls[i] == mParser->getSource(ATSParser::VIDEO)
+                    ? ATSParser::VIDEO : ATSParser::AUDIO;
+            break;
+        }
+    }
+    if (mSeekSourceType == ATSParser::NUM_SOURCE_TYPES) {
+        return;
+    }
+    mIndexThread = std::thread([this] {
+        androidSetThreadPriority(gettid(), ANDROID_PRIORITY_BACKGROUND);
+        pthread_setname_np(pthread_self(), "MPEG2TSIndex");
+        buildIndex();
+    });
+}
+
+void MPEG2TSExtractor::buildIndex() {
+    int64_t startTimeUs = ALooper::GetNowUs();
+
+    // A parser of our own, which normalizes timestamps the same way as
+    // mParser since it also starts at the beginning of the file.
+    sp<ATSParser> parser = new ATSParser;
+    MPEG2TSIndex index;
+
+    const size_t stride = kTSPacketSize + mHeaderSkip;
+    std::vector<uint8_t> packets(kIndexReadPackets * stride);
+    off64_t offset = 0;
+    bool eos = false;
+    while (!eos) {
+        if (mStopIndexing) {
+            return;
+        }
+
+        ssize_t n;
+        {
+            // mDataSource is not thread-safe; feedMore() reads under mLock too.
+            Mutex::Autolock autoLock(mLock);
+            n = mDataSource->readAt(offset, packets.data(), packets.size());
+        }
+        if (n < 0) {
+            ALOGW("index pass failed to read at %lld", (long long)offset);
+            return;
+        }
+        eos = (size_t)n < packets.size();
+
+        for (size_t pos = 0; pos + stride <= (size_t)n; pos += stride) {
+            ATSParser::SyncEvent event(offset + pos);
+            if (parser->feedTSPacket(
+                    packets.data() + pos + mHeaderSkip, kTSPacketSize, &event) != OK) {
+                ALOGW("index pass stopped at %lld", (long long)(offset + pos));
+                return;
+            }
+            if (event.hasReturnedData() && event.getType() == mSeekSourceType) {
+                index.add(event.getTimeUs(), event.getOffset());
+            }
+        }
+        offset += ((size_t)n / stride) * stride;
+
+        if (eos) {
+            parser->signalEOS(ERROR_END_OF_STREAM);
+        }
+        // Drop what the parser assembled so far.
+        for (int i = 0; i < ATSParser::NUM_SOURCE_TYPES; ++i) {
+            sp<AnotherPacketSource> impl =
+                    parser->getSource(static_cast<ATSParser::SourceType>(i));
+            if (impl == NULL) {
+                continue;
+            }
+            status_t finalResult;
+            while (impl->hasBufferAvailable(&finalResult)) {
+                sp<ABuffer> buffer;
+                impl->dequeueAccessUnit(&buffer);
+            }
+        }
+    }
+
+    index.finalize();
+    ALOGI("indexed %zu sync points in %lld bytes, elapsedTime=%" PRId64,
+            index.size(), (long long)offset, ALooper::GetNowUs() - startTimeUs);
+
+    Mutex::Autolock autoLock(mLock);
+    mIndex = std::move(index);
+    mIndexComplete = true;
+}
+
+bool MPEG2TSExtractor::findIndexedSyncPoint(int64_t seekTimeUs,
+        const MediaTrackHelper::ReadOptions::SeekMode &seekMode,
+        MPEG2TSIndex::SyncPoint *syncPoint) {
+    MPEG2TSIndex::SeekMode mode;
+    switch (seekMode) {
+        case MediaTrackHelper::ReadOptions::SEEK_NEXT_SYNC:
+            mode = MPEG2TSIndex::kNextSync;
+            break;
+        case MediaTrackHelper::ReadOptions::SEEK_PREVIOUS_SYNC:
+        case MediaTrackHelper::ReadOptions::SEEK_CLOSEST_SYNC:
+        case MediaTrackHelper::ReadOptions::SEEK_CLOSEST:
+            // seek() falls back to PREVIOUS_SYNC for the closest modes too.
+            mode = MPEG2TSIndex::kPreviousSync;
+            break;
+        default:
+            return false;
+    }
+
+    Mutex::Autolock autoLock(mLock);
+    return mIndexComplete && mIndex.find(seekTimeUs, mode, syncPoint);
+}
+
 uint32_t MPEG2TSExtractor::flags() const {
     return CAN_PAUSE | CAN_SEEK_BACKWARD | CAN_SEEK_FORWARD;
 }
 
 status_t MPEG2TSExtractor::seek(int64_t seekTimeUs,
         const MediaTrackHelper::ReadOptions::SeekMode &seekMode) {
+    MPEG2TSIndex::SyncPoint syncPoint;
+    if (findIndexedSyncPoint(seekTimeUs, seekMode, &syncPoint)) {
+        mOffset = syncPoint.offset;
+        status_t err = queueDiscontinuityForSeek(syncPoint.timeUs);
+        if (err != OK) {
+            return err;
+        }
+        return skipToSyncFrame();
+    }
+
     if (mSeekSyncPoints == NULL || mSeekSyncPoints->isEmpty()) {
         ALOGW("No sync point to seek to.");
         // ... and therefore we have nothing useful to do here.
@@ -692,6 +832,10 @@ status_t MPEG2TSExtractor::seek(int64_t seekTimeUs,
         }
     }
 
+    return skipToSyncFrame();
+}
+
+status_t MPEG2TSExtractor::skipToSyncFrame() {
     // Fast-forward to sync frame.
     for (size_t i = 0; i < mSourceImpls.size(); ++i) {
         const sp<AnotherPacketSource> &impl = mSourceImpls[i];
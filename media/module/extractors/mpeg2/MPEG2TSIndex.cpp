@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MPEG2TSIndex"
+#include <utils/Log.h>
+
+#include "MPEG2TSIndex.h"
+
+#include <algorithm>
+
+namespace android {
+
+void MPEG2TSIndex::clear() {
+    mSyncPoints.clear();
+}
+
+void MPEG2TSIndex::add(int64_t timeUs, off64_t offset) {
+    if (!mSyncPoints.empty()) {
+        int64_t lastTimeUs = mSyncPoints.back().timeUs;
+        if (timeUs >= lastTimeUs && timeUs - lastTimeUs < kMinIntervalUs) {
+            return;
+        }
+    }
+    mSyncPoints.push_back({timeUs, offset});
+}
+
+void MPEG2TSIndex::finalize() {
+    std::stable_sort(mSyncPoints.begin(), mSyncPoints.end(),
+            [](const SyncPoint &a, const SyncPoint &b) { return a.timeUs < b.timeUs; });
+    // Like the sync points of the extractor, keep one sync point per time.
+    mSyncPoints.erase(std::unique(mSyncPoints.begin(), mSyncPoints.end(),
+            [](const SyncPoint &a, const SyncPoint &b) { return a.timeUs == b.timeUs; }),
+            mSyncPoints.end());
+}
+
+bool MPEG2TSIndex::find(int64_t timeUs, SeekMode mode, SyncPoint *syncPoint) const {
+    if (mSyncPoints.empty()) {
+        return false;
+    }
+
+    // first sync point after |timeUs|
+    auto it = std::upper_bound(mSyncPoints.begin(), mSyncPoints.end(), timeUs,
+            [](int64_t t, const SyncPoint &s) { return t < s.timeUs; });
+
+    if (mode == kNextSync) {
+        if (it != mSyncPoints.begin() && (it - 1)->timeUs == timeUs) {
+            --it;
+        } else if (it == mSyncPoints.end()) {
+            --it;
+        }
+    } else if (it != mSyncPoints.begin()) {
+        --it;
+    }
+    *syncPoint = *it;
+    return true;
+}
+
+}  // namespace android
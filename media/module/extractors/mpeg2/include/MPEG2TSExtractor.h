@@ -28,6 +28,11 @@
 #include <utils/KeyedVector.h>
 #include <utils/Vector.h>
 
+#include <atomic>
+#include <thread>
+
+#include "MPEG2TSIndex.h"
+
 namespace android {
 
 struct AMessage;
@@ -76,6 +81,19 @@ private:
 
     off64_t mOffset;
 
+    // Sync points of the seek reference track for the whole file, built by
+    // a background pass over local files when media.mpeg2ts.index is set.
+    // The index only lives as long as the extractor: mediaextractor is not
+    // allowed to write files, and the extractor API has no way for a caller
+    // to hand in a file to keep it in. So every open of the same file runs
+    // the index pass again, and init() still reads the end of the file to
+    // estimate durations.
+    MPEG2TSIndex mIndex;
+    bool mIndexComplete;
+    ATSParser::SourceType mSeekSourceType;
+    std::thread mIndexThread;
+    std::atomic<bool> mStopIndexing;
+
     static bool isScrambledFormat(MetaDataBase &format);
 
     void init();
@@ -101,6 +119,16 @@ private:
 
     status_t  estimateDurationsFromTimesUsAtEnd();
 
+    // Starts the index pass for the seek reference track, if enabled.
+    void startIndexing();
+    void buildIndex();
+    bool findIndexedSyncPoint(int64_t seekTimeUs,
+            const MediaTrackHelper::ReadOptions::SeekMode &seekMode,
+            MPEG2TSIndex::SyncPoint *syncPoint);
+
+    // Drops the access units of each track that precede its next sync frame.
+    status_t skipToSyncFrame();
+
     size_t mHeaderSkip;
     DISALLOW_EVIL_CONSTRUCTORS(MPEG2TSExtractor);
 };
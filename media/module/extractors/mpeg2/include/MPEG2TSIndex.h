@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MPEG2_TS_INDEX_H_
+
+#define MPEG2_TS_INDEX_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <vector>
+
+namespace android {
+
+// Sync points of one track of a transport stream, covering the whole file.
+// MPEG2TSExtractor builds it with a pass over the file, so that seeks do not
+// have to parse their way to the target.
+struct MPEG2TSIndex {
+    enum SeekMode {
+        kPreviousSync,
+        kNextSync,
+    };
+
+    struct SyncPoint {
+        int64_t timeUs;
+        off64_t offset;
+    };
+
+    void clear();
+
+    // Sync points are expected to be added in file order. Sync points less
+    // than kMinIntervalUs after the previous one are dropped, which bounds
+    // the size of the index for streams where every access unit is a sync
+    // point.
+    void add(int64_t timeUs, off64_t offset);
+
+    // Sorts the sync points by time. Must be called after the last add().
+    void finalize();
+
+    size_t size() const { return mSyncPoints.size(); }
+
+    // Finds the sync point at or before (kPreviousSync) or at or after
+    // (kNextSync) |timeUs|, falling back to the first or last sync point
+    // when there is none in that direction. Returns false if the index is
+    // empty.
+    bool find(int64_t timeUs, SeekMode mode, SyncPoint *syncPoint) const;
+
+private:
+    static const int64_t kMinIntervalUs = 100000LL;
+
+    std::vector<SyncPoint> mSyncPoints;
+};
+
+}  // namespace android
+
+#endif  // MPEG2_TS_INDEX_H_
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MPEG2TSIndexTest"
+#include <utils/Log.h>
+
+#include <gtest/gtest.h>
+
+#include <MPEG2TSIndex.h>
+
+using namespace android;
+
+namespace {
+
+constexpr int64_t kGopUs = 500000;
+constexpr off64_t kGopSize = 188 * 1000;
+constexpr size_t kNumGops = 20000;
+
+void buildIndex(MPEG2TSIndex *index) {
+    for (size_t i = 0; i < kNumGops; ++i) {
+        index->add(i * kGopUs, i * kGopSize);
+    }
+    index->finalize();
+}
+
+MPEG2TSIndex::SyncPoint find(
+        const MPEG2TSIndex &index, int64_t timeUs, MPEG2TSIndex::SeekMode mode) {
+    MPEG2TSIndex::SyncPoint syncPoint = {-1, -1};
+    EXPECT_TRUE(index.find(timeUs, mode, &syncPoint));
+    return syncPoint;
+}
+
+}  // namespace
+
+TEST(MPEG2TSIndexTest, FindsSyncPoints) {
+    MPEG2TSIndex index;
+    buildIndex(&index);
+    ASSERT_EQ(kNumGops, index.size());
+
+    EXPECT_EQ(0, find(index, -1, MPEG2TSIndex::kPreviousSync).timeUs);
+    EXPECT_EQ(0, find(index, -1, MPEG2TSIndex::kNextSync).timeUs);
+    EXPECT_EQ(kGopUs, find(index, kGopUs, MPEG2TSIndex::kPreviousSync).timeUs);
+    EXPECT_EQ(kGopUs, find(index, kGopUs, MPEG2TSIndex::kNextSync).timeUs);
+    EXPECT_EQ(kGopUs, find(index, kGopUs + 1, MPEG2TSIndex::kPreviousSync).timeUs);
+    EXPECT_EQ(2 * kGopUs, find(index, kGopUs + 1, MPEG2TSIndex::kNextSync).timeUs);
+    EXPECT_EQ(kGopSize, find(index, kGopUs + 1, MPEG2TSIndex::kPreviousSync).offset);
+
+    const int64_t lastUs = (kNumGops - 1) * kGopUs;
+    EXPECT_EQ(lastUs, find(index, lastUs + kGopUs, MPEG2TSIndex::kPreviousSync).timeUs);
+    EXPECT_EQ(lastUs, find(index, lastUs + kGopUs, MPEG2TSIndex::kNextSync).timeUs);
+
+    MPEG2TSIndex empty;
+    MPEG2TSIndex::SyncPoint syncPoint;
+    EXPECT_FALSE(empty.find(0, MPEG2TSIndex::kPreviousSync, &syncPoint));
+}
+
+TEST(MPEG2TSIndexTest, ThinsDenseSyncPoints) {
+    // Audio only streams have a sync point for every access unit.
+    MPEG2TSIndex index;
+    for (size_t i = 0; i < 10000; ++i) {
+        index.add(i * 21333, i * 188 * 3);
+    }
+    index.finalize();
+    EXPECT_LE(index.size(), 10000u * 21333 / 100000 + 1);
+    EXPECT_GT(index.size(), 10000u * 21333 / 200000);
+}
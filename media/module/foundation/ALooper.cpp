@@ -20,9 +20,14 @@
 #include <media/stagefright/foundation/ADebug.h>
 
 #include <utils/Log.h>
+#include <utils/String8.h>
 
 #include <sys/time.h>
 
+#include <algorithm>
+#include <iterator>
+#include <map>
+
 #include "ALooper.h"
 
 #include "AHandler.h"
@@ -33,6 +38,76 @@ namespace android {
 
 ALooperRoster gLooperRoster;
 
+namespace {
+
+// Upper bounds of the dispatch latency histogram buckets, the last bucket is unbounded.
+constexpr int64_t kLatencyBucketsUs[] = {
+    100, 1000, 5000, 10000, 20000, 50000, 100000,
+};
+constexpr size_t kNumLatencyBuckets = std::size(kLatencyBucketsUs) + 1;
+
+struct LooperStats {
+    size_t mQueueDepth = 0;
+    size_t mMaxQueueDepth = 0;
+    uint64_t mNumDispatched = 0;
+    uint64_t mLatencyHistogram[kNumLatencyBuckets] = {};  // delay between due time and dispatch
+};
+
+// The layout of ALooper is part of the VNDK ABI, so its statistics are kept in this table
+// instead. Entries are added by the first post() and removed when the looper is destroyed.
+// gLooperStatsLock is only held briefly and never while taking another lock.
+Mutex gLooperStatsLock;
+std::map<const ALooper *, LooperStats> gLooperStats;
+
+void updateQueueDepth(const ALooper *looper, size_t added, size_t removed) {
+    Mutex::Autolock autoLock(gLooperStatsLock);
+    LooperStats &stats = gLooperStats[looper];
+    stats.mQueueDepth = stats.mQueueDepth + added - removed;
+    if (stats.mQueueDepth > stats.mMaxQueueDepth) {
+        stats.mMaxQueueDepth = stats.mQueueDepth;
+    }
+}
+
+void noteDispatched(const ALooper *looper, int64_t latencyUs) {
+    size_t bucket = 0;
+    while (bucket < kNumLatencyBuckets - 1 && latencyUs >= kLatencyBucketsUs[bucket]) {
+        ++bucket;
+    }
+
+    Mutex::Autolock autoLock(gLooperStatsLock);
+    LooperStats &stats = gLooperStats[looper];
+    --stats.mQueueDepth;
+    ++stats.mNumDispatched;
+    ++stats.mLatencyHistogram[bucket];
+}
+
+}  // namespace
+
+// Appends the event queue depth and dispatch latency histogram of |looper| to |s|, and
+// resets them if |clear| is set. Used by ALooperRoster::dump().
+void dumpLooperStats(const ALooper *looper, String8 *s, bool clear) {
+    Mutex::Autolock autoLock(gLooperStatsLock);
+    LooperStats &stats = gLooperStats[looper];
+    s->appendFormat("%s: queue depth %zu (max %zu), %llu dispatched, latency us",
+            looper->getName(), stats.mQueueDepth, stats.mMaxQueueDepth,
+            (unsigned long long)stats.mNumDispatched);
+    for (size_t i = 0; i < kNumLatencyBuckets; ++i) {
+        if (i < kNumLatencyBuckets - 1) {
+            s->appendFormat(" <%lld:%llu", (long long)kLatencyBucketsUs[i],
+                    (unsigned long long)stats.mLatencyHistogram[i]);
+        } else {
+            s->appendFormat(" >=%lld:%llu", (long long)kLatencyBucketsUs[i - 1],
+                    (unsigned long long)stats.mLatencyHistogram[i]);
+        }
+    }
+
+    if (clear) {
+        stats.mMaxQueueDepth = stats.mQueueDepth;
+        stats.mNumDispatched = 0;
+        std::fill(std::begin(stats.mLatencyHistogram), std::end(stats.mLatencyHistogram), 0);
+    }
+}
+
 struct ALooper::LooperThread : public Thread {
     LooperThread(ALooper *looper, bool canCallJava)
         : Thread(canCallJava),
@@ -82,6 +157,10 @@ ALooper::ALooper()
 
 ALooper::~ALooper() {
     stop();
+    {
+        Mutex::Autolock autoLock(gLooperStatsLock);
+        gLooperStats.erase(this);
+    }
     // stale AHandlers are now cleaned up in the constructor of the next ALooper to come along
 }
 
@@ -196,6 +275,7 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
     }
 
     mEventQueue.insert(it, event);
+    updateQueueDepth(this, 1 /* added */, 0 /* removed */);
 }
 
 status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token, int64_t delayUs) {
@@ -218,9 +298,11 @@ status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token,
     bool shouldAwakeLoop = mEventQueue.empty() || whenUs < mEventQueue.begin()->mWhenUs;
 
     // Erase any previously-posted event with this token.
+    size_t numErased = 0;
     for (auto i = mEventQueue.begin(); i != mEventQueue.end();) {
         if (i->mToken == token) {
             i = mEventQueue.erase(i);
+            ++numErased;
         } else {
             ++i;
         }
@@ -237,6 +319,7 @@ status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token,
     event.mMessage = msg;
     event.mToken = token;
     mEventQueue.insert(i, event);
+    updateQueueDepth(this, 1 /* added */, numErased);
 
     // If we rescheduled the event to be earlier than the first event, then we need to wake up the
     // looper earlier than it was previously scheduled to be woken up. Otherwise, it can sleep until
@@ -275,6 +358,7 @@ bool ALooper::loop() {
 
         event = *mEventQueue.begin();
         mEventQueue.erase(mEventQueue.begin());
+        noteDispatched(this, nowUs - whenUs);
     }
 
     event.mMessage->deliver();
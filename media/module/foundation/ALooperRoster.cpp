@@ -21,6 +21,9 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "ALooperRoster.h"
 
 #include "ADebug.h"
@@ -102,6 +105,9 @@ void ALooperRoster::unregisterStaleHandlers() {
     }
 }
 
+// defined in ALooper.cpp
+extern void dumpLooperStats(const ALooper *looper, String8 *s, bool clear);
+
 static void makeFourCC(uint32_t fourcc, char *s, size_t bufsz) {
     s[0] = (fourcc >> 24) & 0xff;
     if (s[0]) {
@@ -131,6 +137,7 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
         s.append("(verbose stats collection enabled, stats will be cleared)\n");
     }
 
+    std::vector<sp<ALooper>> loopers;
     Mutex::Autolock autoLock(mLock);
     size_t n = mHandlers.size();
     s.appendFormat(" %zu registered handlers:\n", n);
@@ -140,6 +147,9 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
         HandlerInfo &info = mHandlers.editValueAt(i);
         sp<ALooper> looper = info.mLooper.promote();
         if (looper != NULL) {
+            if (std::find(loopers.begin(), loopers.end(), looper) == loopers.end()) {
+                loopers.push_back(looper);
+            }
             s.append(looper->getName());
             sp<AHandler> handler = info.mHandler.promote();
             if (handler != NULL) {
@@ -180,6 +190,13 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
         }
         s.append("\n");
     }
+
+    s.appendFormat(" %zu loopers:\n", loopers.size());
+    for (const sp<ALooper> &looper : loopers) {
+        s.append("  ");
+        dumpLooperStats(looper.get(), &s, clear);
+        s.append("\n");
+    }
     (void)write(fd, s.string(), s.size());
 }
 
@@ -20,6 +20,9 @@
 
 #include <ctype.h>
 
+#include <atomic>
+#include <new>
+
 #include "AMessage.h"
 
 #include <log/log.h>
@@ -41,6 +44,143 @@ namespace android {
 
 extern ALooperRoster gLooperRoster;
 
+namespace {
+
+// Hash index over the items of a message, with open addressing and linear probing. Each slot
+// holds the upper half of the hash of an item name and the item index + 1 in its lower half, or
+// 0 if empty. The number of slots is a power of 2, at least four times the number of items when
+// the index is built, which is rebuilt once it is half full.
+struct ItemIndex {
+    std::vector<uint32_t> mSlots;
+};
+
+constexpr uint32_t kHashTagMask = 0xFFFF0000u;
+
+// Item names are allocated with a NameTail after their terminating NUL. In the first item, it
+// holds the index of the message. AMessage and its Item are part of the VNDK ABI, so the index
+// cannot be a member of either.
+struct NameTail {
+    // Built by the first lookup once the message is large enough. Const lookups may run
+    // concurrently, so it is published atomically. Changes to the items, which must not run
+    // concurrently with lookups, update or drop it.
+    std::atomic<ItemIndex *> mIndex;
+};
+
+// Messages with fewer items are searched linearly. That mostly compares name lengths, and is
+// faster than hashing the key for the formats seen in practice.
+constexpr size_t kMinNumItemsForIndex = 32;
+
+size_t nameTailOffset(size_t len) {
+    return (len + alignof(NameTail)) & ~(alignof(NameTail) - 1);
+}
+
+NameTail *nameTail(const char *name, size_t len) {
+    return reinterpret_cast<NameTail *>(const_cast<char *>(name) + nameTailOffset(len));
+}
+
+uint32_t hashName(const char *name, size_t len) {
+    // Item names are short, so hash them a word at a time.
+    constexpr uint64_t kMultiplier = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = len * kMultiplier;
+    uint64_t word;
+    for (; len >= sizeof(word); name += sizeof(word), len -= sizeof(word)) {
+        memcpy(&word, name, sizeof(word));
+        hash = (hash ^ word) * kMultiplier;
+        hash ^= hash >> 32;
+    }
+    if (len > 0) {
+        // Avoid a call to memcpy for the variable length tail.
+        word = 0;
+        for (size_t j = 0; j < len; ++j) {
+            word |= (uint64_t)(uint8_t)name[j] << (j * 8);
+        }
+        hash = (hash ^ word) * kMultiplier;
+    }
+    return (uint32_t)(hash >> 32);
+}
+
+void addToIndex(ItemIndex *index, uint32_t hash, size_t i) {
+    const size_t mask = index->mSlots.size() - 1;
+    size_t slot = hash & mask;
+    while (index->mSlots[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    index->mSlots[slot] = (hash & kHashTagMask) | (uint32_t)(i + 1);
+}
+
+template <typename Item>
+ItemIndex *buildIndex(const std::vector<Item> &items) {
+    ItemIndex *index = new ItemIndex;
+    size_t size = 16;
+    while (size < items.size() * 4) {
+        size <<= 1;
+    }
+    index->mSlots.resize(size, 0);
+    for (size_t i = 0; i < items.size(); ++i) {
+        addToIndex(index, hashName(items[i].mName, items[i].mNameLength), i);
+    }
+    return index;
+}
+
+// The index is kept with the name of the first item.
+template <typename Item>
+std::atomic<ItemIndex *> &indexOf(const std::vector<Item> &items) {
+    return nameTail(items[0].mName, items[0].mNameLength)->mIndex;
+}
+
+// Publishes an index built by a lookup, unless another lookup did first.
+__attribute__((noinline))
+const ItemIndex *publishIndex(std::atomic<ItemIndex *> *indexRef, ItemIndex *built) {
+    ItemIndex *index = nullptr;
+    if (indexRef->compare_exchange_strong(
+            index, built, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        return built;
+    }
+    delete built;
+    return index;
+}
+
+// Kept out of line so that the linear search of small messages stays as cheap as it was.
+template <typename Item>
+__attribute__((noinline))
+size_t findIndexedItem(
+        const std::vector<Item> &items, const char *name, size_t len,
+        [[maybe_unused]] size_t *memchecks) {
+    const ItemIndex *index = indexOf(items).load(std::memory_order_acquire);
+    if (index == nullptr) {
+        index = publishIndex(&indexOf(items), buildIndex(items));
+    }
+    const uint32_t hash = hashName(name, len);
+    const size_t mask = index->mSlots.size() - 1;
+    for (size_t slot = hash & mask; index->mSlots[slot] != 0; slot = (slot + 1) & mask) {
+        const uint32_t entry = index->mSlots[slot];
+        if ((entry & kHashTagMask) != (hash & kHashTagMask)) {
+            continue;
+        }
+        const size_t i = (entry & ~kHashTagMask) - 1;
+        if (items[i].mNameLength != len) {
+            continue;
+        }
+#ifdef DUMP_STATS
+        ++*memchecks;
+#endif
+        if (!memcmp(items[i].mName, name, len)) {
+            return i;
+        }
+    }
+    return items.size();
+}
+
+// Must be called before the first item is renamed, moved or freed.
+template <typename Item>
+void dropIndex(const std::vector<Item> &items) {
+    if (!items.empty() && items[0].mName != nullptr) {
+        delete indexOf(items).exchange(nullptr, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace
+
 status_t AReplyToken::setReply(const sp<AMessage> &reply) {
     if (mReplied) {
         ALOGE("trying to post a duplicate reply");
@@ -87,6 +227,7 @@ void AMessage::setTarget(const sp<const AHandler> &handler) {
 }
 
 void AMessage::clear() {
+    dropIndex(mItems);
     // Item needs to be handled delicately
     for (Item &item : mItems) {
         delete[] item.mName;
@@ -155,16 +296,24 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
     size_t memchecks = 0;
 #endif
     size_t i = 0;
-    for (; i < mItems.size(); i++) {
-        if (len != mItems[i].mNameLength) {
-            continue;
-        }
+    if (mItems.size() < kMinNumItemsForIndex) {
+        for (; i < mItems.size(); i++) {
+            if (len != mItems[i].mNameLength) {
+                continue;
+            }
 #ifdef DUMP_STATS
-        ++memchecks;
+            ++memchecks;
 #endif
-        if (!memcmp(mItems[i].mName, name, len)) {
-            break;
+            if (!memcmp(mItems[i].mName, name, len)) {
+                break;
+            }
         }
+    } else {
+#ifdef DUMP_STATS
+        i = findIndexedItem(mItems, name, len, &memchecks);
+#else
+        i = findIndexedItem(mItems, name, len, nullptr);
+#endif
     }
 #ifdef DUMP_STATS
     {
@@ -182,8 +331,11 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
 // assumes item's name was uninitialized or NULL
 void AMessage::Item::setName(const char *name, size_t len) {
     mNameLength = len;
-    mName = new char[len + 1];
-    memcpy((void*)mName, name, len + 1);
+    char *buffer = new char[nameTailOffset(len) + sizeof(NameTail)];
+    memcpy(buffer, name, len + 1);
+    NameTail *tail = new (buffer + nameTailOffset(len)) NameTail;
+    tail->mIndex.store(nullptr, std::memory_order_relaxed);
+    mName = buffer;
 }
 
 AMessage::Item::Item(const char *name, size_t len)
@@ -205,6 +357,16 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
         i = mItems.size();
         // place a 'blank' item at the end - this is of type kTypeInt32
         mItems.emplace_back(name, len);
+        ItemIndex *index = mItems.size() < kMinNumItemsForIndex
+                ? nullptr : indexOf(mItems).load(std::memory_order_relaxed);
+        if (index != nullptr) {
+            if (mItems.size() * 2 > index->mSlots.size()) {
+                delete index;
+                indexOf(mItems).store(buildIndex(mItems), std::memory_order_release);
+            } else {
+                addToIndex(index, hashName(name, len), i);
+            }
+        }
         item = &mItems[i];
     }
 
@@ -1026,6 +1188,7 @@ status_t AMessage::setEntryNameAt(size_t index, const char *name) {
     if (findItemIndex(name, len) < mItems.size()) {
         return ALREADY_EXISTS;
     }
+    dropIndex(mItems);
     delete[] mItems[index].mName;
     mItems[index].mName = nullptr;
     mItems[index].setName(name, len);
@@ -1090,6 +1253,7 @@ status_t AMessage::removeEntryAt(size_t index) {
     if (index >= mItems.size()) {
         return BAD_INDEX;
     }
+    dropIndex(mItems);
     // delete entry data and objects
     delete[] mItems[index].mName;
     mItems[index].mName = nullptr;
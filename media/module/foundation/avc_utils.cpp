@@ -28,6 +28,12 @@
 #include <media/stagefright/MetaData.h>
 #include <utils/misc.h>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace android {
 
 unsigned parseUE(ABitReader *br) {
@@ -288,6 +294,75 @@ void FindAVCDimensions(
     }
 }
 
+static const uint8_t *findStartCodePrefixScalar(const uint8_t *data, size_t size) {
+    for (size_t offset = 0; offset + 2 < size; ++offset) {
+        if (data[offset + 2] == 0x01 && data[offset] == 0x00
+                && data[offset + 1] == 0x00) {
+            return &data[offset];
+        }
+    }
+    return NULL;
+}
+
+const uint8_t *findStartCodePrefix(const uint8_t *data, size_t size) {
+    size_t offset = 0;
+
+    // Each vector step tests the candidate positions [offset, offset + N) by comparing three
+    // overlapping loads (shifted by 0, 1 and 2 bytes) against 00, 00 and 01 respectively.
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    for (; offset + 32 + 2 <= size; offset += 32) {
+        __m256i b0 = _mm256_loadu_si256((const __m256i *)&data[offset]);
+        __m256i b1 = _mm256_loadu_si256((const __m256i *)&data[offset + 1]);
+        __m256i b2 = _mm256_loadu_si256((const __m256i *)&data[offset + 2]);
+        __m256i match = _mm256_and_si256(
+                _mm256_and_si256(_mm256_cmpeq_epi8(b0, zero), _mm256_cmpeq_epi8(b1, zero)),
+                _mm256_cmpeq_epi8(b2, one));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(match);
+        if (mask != 0) {
+            return &data[offset + __builtin_ctz(mask)];
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    for (; offset + 16 + 2 <= size; offset += 16) {
+        __m128i b0 = _mm_loadu_si128((const __m128i *)&data[offset]);
+        __m128i b1 = _mm_loadu_si128((const __m128i *)&data[offset + 1]);
+        __m128i b2 = _mm_loadu_si128((const __m128i *)&data[offset + 2]);
+        __m128i match = _mm_and_si128(
+                _mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)),
+                _mm_cmpeq_epi8(b2, one));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(match);
+        if (mask != 0) {
+            return &data[offset + __builtin_ctz(mask)];
+        }
+    }
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+    for (; offset + 16 + 2 <= size; offset += 16) {
+        uint8x16_t b0 = vld1q_u8(&data[offset]);
+        uint8x16_t b1 = vld1q_u8(&data[offset + 1]);
+        uint8x16_t b2 = vld1q_u8(&data[offset + 2]);
+        uint8x16_t match = vandq_u8(
+                vandq_u8(vceqq_u8(b0, zero), vceqq_u8(b1, zero)), vceqq_u8(b2, one));
+        uint64x2_t lanes = vreinterpretq_u64_u8(match);
+        uint64_t lo = vgetq_lane_u64(lanes, 0);
+        if (lo != 0) {
+            return &data[offset + (__builtin_ctzll(lo) >> 3)];
+        }
+        uint64_t hi = vgetq_lane_u64(lanes, 1);
+        if (hi != 0) {
+            return &data[offset + 8 + (__builtin_ctzll(hi) >> 3)];
+        }
+    }
+#endif
+
+    return findStartCodePrefixScalar(&data[offset], size - offset);
+}
+
 status_t getNextNALUnit(
         const uint8_t **_data, size_t *_size,
         const uint8_t **nalStart, size_t *nalSize,
@@ -302,43 +377,26 @@ status_t getNextNALUnit(
         return -EAGAIN;
     }
 
-    size_t offset = 0;
-
     // A valid startcode consists of at least two 0x00 bytes followed by 0x01.
-    for (; offset + 2 < size; ++offset) {
-        if (data[offset + 2] == 0x01 && data[offset] == 0x00
-                && data[offset + 1] == 0x00) {
-            break;
-        }
-    }
-    if (offset + 2 >= size) {
-        *_data = &data[offset];
+    const uint8_t *startCode = findStartCodePrefix(data, size);
+    if (startCode == NULL) {
+        *_data = &data[size - 2];
         *_size = 2;
         return -EAGAIN;
     }
-    offset += 3;
+    size_t offset = startCode - data + 3;
 
     size_t startOffset = offset;
 
-    for (;;) {
-        while (offset < size && data[offset] != 0x01) {
-            ++offset;
-        }
-
-        if (offset == size) {
-            if (startCodeFollows) {
-                offset = size + 2;
-                break;
-            }
-
+    // |offset| ends up pointing at the 0x01 of the next start code.
+    const uint8_t *nextStartCode = findStartCodePrefix(&data[offset], size - offset);
+    if (nextStartCode == NULL) {
+        if (!startCodeFollows) {
             return -EAGAIN;
         }
-
-        if (data[offset - 1] == 0x00 && data[offset - 2] == 0x00) {
-            break;
-        }
-
-        ++offset;
+        offset = size + 2;
+    } else {
+        offset = nextStartCode - data + 2;
     }
 
     size_t endOffset = offset - 2;
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/foundation/AString.h>
+
+using namespace android;
+
+// Keys of a typical video decoder output format, in the order CCodec/ACodec set them.
+static const char *kFormatKeys[] = {
+    "mime", "width", "height", "stride", "slice-height", "color-format",
+    "crop-left", "crop-top", "crop-right", "crop-bottom", "color-standard",
+    "color-range", "color-transfer", "hdr-static-info", "frame-rate",
+    "max-width", "max-height", "max-input-size", "priority", "operating-rate",
+    "rotation-degrees", "sar-width", "sar-height", "profile", "level",
+    "android._dataspace", "android._color-format", "android._video-scaling",
+    "low-latency", "push-blank-buffers-on-shutdown", "color-transfer-request",
+    "csd-0", "csd-1", "durationUs", "track-id", "language", "bitrate",
+    "i-frame-interval", "max-bframes", "tile-width",
+};
+
+// Lookups made per output buffer by the renderer and CCodec buffer channel,
+// including keys that are usually absent.
+static const char *kLookupKeys[] = {
+    "width", "height", "stride", "slice-height", "color-format", "crop-left",
+    "crop-top", "crop-right", "crop-bottom", "android._dataspace", "hdr10-plus-info",
+    "hdr-static-info", "rotation-degrees", "mime", "android._video-scaling",
+    "color-standard", "color-range", "color-transfer", "native-window", "sar-width",
+};
+
+static sp<AMessage> makeFormat(size_t numKeys) {
+    sp<AMessage> format = new AMessage;
+    for (size_t i = 0; i < numKeys; ++i) {
+        if (i < std::size(kFormatKeys)) {
+            format->setInt32(kFormatKeys[i], i);
+        } else {
+            format->setInt32(AStringPrintf("vendor.key-%zu", i).c_str(), i);
+        }
+    }
+    return format;
+}
+
+static void BM_FormatLookup(benchmark::State &state) {
+    sp<AMessage> format = makeFormat(state.range(0));
+    int32_t value;
+    size_t found = 0;
+    for (auto _ : state) {
+        for (const char *key : kLookupKeys) {
+            found += format->findInt32(key, &value);
+        }
+    }
+    benchmark::DoNotOptimize(found);
+    state.SetItemsProcessed(state.iterations() * std::size(kLookupKeys));
+}
+
+static void BM_FormatBuild(benchmark::State &state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(makeFormat(state.range(0)));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_FormatDup(benchmark::State &state) {
+    sp<AMessage> format = makeFormat(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(format->dup());
+    }
+}
+
+static void FormatSizeArgs(benchmark::internal::Benchmark *b) {
+    for (int numKeys : {4, 8, 16, 40, 80}) {
+        b->Arg(numKeys);
+    }
+}
+
+BENCHMARK(BM_FormatLookup)->Apply(FormatSizeArgs);
+BENCHMARK(BM_FormatBuild)->Apply(FormatSizeArgs);
+BENCHMARK(BM_FormatDup)->Apply(FormatSizeArgs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/avc_utils.h>
+
+using namespace android;
+
+// The byte-at-a-time loop getNextNALUnit() used before findStartCodePrefix().
+static const uint8_t *findStartCodePrefixScalar(const uint8_t *data, size_t size) {
+    for (size_t offset = 0; offset + 2 < size; ++offset) {
+        if (data[offset + 2] == 0x01 && data[offset] == 0x00 && data[offset + 1] == 0x00) {
+            return &data[offset];
+        }
+    }
+    return nullptr;
+}
+
+// Builds an Annex-B stream of |size| bytes with a start code every |nalSize| bytes.
+// Payload bytes avoid 00 00 01 sequences, like emulation-prevented slice data.
+static std::vector<uint8_t> makeAnnexBStream(size_t size, size_t nalSize) {
+    std::mt19937 rng(1234);
+    std::vector<uint8_t> stream(size);
+    for (size_t i = 0; i < size; ++i) {
+        stream[i] = (i % nalSize < 4) ? "\x00\x00\x00\x01"[i % nalSize] : (uint8_t)(rng() | 0x02);
+    }
+    return stream;
+}
+
+template <const uint8_t *(*Find)(const uint8_t *, size_t)>
+static void BM_StartCodeScan(benchmark::State &state) {
+    const size_t kStreamSize = 4 << 20;
+    const size_t nalSize = state.range(0);
+    std::vector<uint8_t> stream = makeAnnexBStream(kStreamSize, nalSize);
+
+    size_t nalCount = 0;
+    for (auto _ : state) {
+        const uint8_t *data = stream.data();
+        size_t size = stream.size();
+        while (size >= 3) {
+            const uint8_t *startCode = Find(data, size);
+            if (startCode == nullptr) {
+                break;
+            }
+            ++nalCount;
+            size -= startCode + 3 - data;
+            data = startCode + 3;
+        }
+        benchmark::DoNotOptimize(data);
+    }
+
+    state.SetBytesProcessed(state.iterations() * kStreamSize);
+    state.counters["nals"] = benchmark::Counter(nalCount, benchmark::Counter::kIsRate);
+}
+
+static void BM_GetNextNALUnit(benchmark::State &state) {
+    const size_t kStreamSize = 4 << 20;
+    std::vector<uint8_t> stream = makeAnnexBStream(kStreamSize, state.range(0));
+
+    for (auto _ : state) {
+        const uint8_t *data = stream.data();
+        size_t size = stream.size();
+        const uint8_t *nalStart;
+        size_t nalSize;
+        while (getNextNALUnit(&data, &size, &nalStart, &nalSize, true) == OK) {
+            benchmark::DoNotOptimize(nalStart);
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * kStreamSize);
+}
+
+// NAL sizes from small slices of a low bitrate stream up to large 4K IDR slices.
+static void NalSizeArgs(benchmark::internal::Benchmark *b) {
+    for (int nalSize : {64, 1024, 16384, 262144}) {
+        b->Arg(nalSize);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_StartCodeScan, findStartCodePrefixScalar)->Apply(NalSizeArgs);
+BENCHMARK_TEMPLATE(BM_StartCodeScan, findStartCodePrefix)->Apply(NalSizeArgs);
+BENCHMARK(BM_GetNextNALUnit)->Apply(NalSizeArgs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2026, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef STAGEFRIGHT_FOUNDATION_ROW_BANDS_H_
+#define STAGEFRIGHT_FOUNDATION_ROW_BANDS_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace android {
+
+/*
+ * Worker threads converting images in bands of rows.
+ *
+ * The workers are started on first use and kept for the lifetime of the process, so that
+ * converting a frame does not create threads. Bands are queued, and the calling thread converts
+ * the first band, then any band of its own still queued, before waiting for the others. Several
+ * threads may convert images at the same time.
+ *
+ * Header only, so that libraries that only use the foundation headers can use it. Each library
+ * then has its own workers.
+ */
+class RowBandWorkers {
+public:
+    using ConvertRows = std::function<void(size_t row, size_t rowCount)>;
+
+    static RowBandWorkers &get() {
+        // never destroyed, as the workers may still be waiting for bands at exit.
+        static RowBandWorkers *sWorkers = new RowBandWorkers;
+        return *sWorkers;
+    }
+
+    /*
+     * Splits |height| rows in up to |threadCount| bands starting on even rows, so that the rows
+     * of the 4:2:0 chroma planes are not shared by two bands, and calls |convertRows| with the
+     * first row and the row count of each band, concurrently. Returns once all the bands are
+     * converted.
+     */
+    void forEachRowBand(size_t height, size_t threadCount, const ConvertRows &convertRows) {
+        const size_t bandCount = std::min(threadCount, (height + 1) / 2);
+        if (bandCount <= 1) {
+            convertRows(0, height);
+            return;
+        }
+        // Round up to even rows
+        const size_t bandHeight = ((height + bandCount - 1) / bandCount + 1) & ~size_t(1);
+
+        Image image{&convertRows, 0 /* pending */, {}};
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            startWorkers_l(bandCount - 1);
+            for (size_t row = bandHeight; row < height; row += bandHeight) {
+                mBands.push_back({&image, row, std::min(bandHeight, height - row)});
+                ++image.pending;
+            }
+        }
+        mBandQueued.notify_all();
+
+        convertRows(0, std::min(bandHeight, height));
+
+        std::unique_lock<std::mutex> lock(mLock);
+        while (image.pending > 0) {
+            auto it = std::find_if(mBands.begin(), mBands.end(),
+                                   [&image](const Band &band) { return band.image == &image; });
+            if (it == mBands.end()) {
+                image.converted.wait(lock);
+                continue;
+            }
+            const Band band = *it;
+            mBands.erase(it);
+            convert_l(band, lock);
+        }
+    }
+
+private:
+    struct Image {
+        const ConvertRows *convertRows;
+        size_t pending;  // bands queued or being converted
+        std::condition_variable converted;
+    };
+
+    struct Band {
+        Image *image;
+        size_t row;
+        size_t rowCount;
+    };
+
+    RowBandWorkers() = default;
+
+    void startWorkers_l(size_t count) {
+        const size_t maxWorkers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        for (; mWorkerCount < std::min(count, maxWorkers); ++mWorkerCount) {
+            std::thread([this] { threadLoop(); }).detach();
+        }
+    }
+
+    void threadLoop() {
+        std::unique_lock<std::mutex> lock(mLock);
+        for (;;) {
+            mBandQueued.wait(lock, [this] { return !mBands.empty(); });
+            const Band band = mBands.front();
+            mBands.pop_front();
+            convert_l(band, lock);
+        }
+    }
+
+    // Converts |band| with mLock unlocked. The image is no longer accessed once its last band
+    // is converted, as its caller may then return.
+    void convert_l(const Band &band, std::unique_lock<std::mutex> &lock) {
+        lock.unlock();
+        (*band.image->convertRows)(band.row, band.rowCount);
+        lock.lock();
+        if (--band.image->pending == 0) {
+            band.image->converted.notify_all();
+        }
+    }
+
+    std::mutex mLock;
+    std::condition_variable mBandQueued;
+    std::deque<Band> mBands;
+    size_t mWorkerCount = 0;
+};
+
+/*
+ * Converts the bands of an image with the workers of RowBandWorkers. See
+ * RowBandWorkers::forEachRowBand().
+ */
+inline void forEachRowBand(size_t height, size_t threadCount,
+                           const RowBandWorkers::ConvertRows &convertRows) {
+    RowBandWorkers::get().forEachRowBand(height, threadCount, convertRows);
+}
+
+}  // namespace android
+
+#endif  // STAGEFRIGHT_FOUNDATION_ROW_BANDS_H_
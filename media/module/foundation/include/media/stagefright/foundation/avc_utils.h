@@ -75,6 +75,11 @@ inline void skipSE(ABitReader *br) {
     (void)parseSEWithFallback(br, 0);
 }
 
+// Returns a pointer to the first 00 00 01 start code prefix in the |size| bytes at |data|, or
+// NULL if there is none. Uses SIMD where available; callers scanning Annex-B or MPEG elementary
+// streams should use this instead of a byte-at-a-time loop.
+const uint8_t *findStartCodePrefix(const uint8_t *data, size_t size);
+
 status_t getNextNALUnit(
         const uint8_t **_data, size_t *_size,
         const uint8_t **nalStart, size_t *nalSize,
@@ -17,16 +17,31 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "AData_test"
 
+#include <stdio.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <utils/RefBase.h>
 
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/AString.h>
 #include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/ALooperRoster.h>
+
+namespace android {
+extern ALooperRoster gLooperRoster;
+}
 
 using namespace android;
 
+using ::testing::_;
+using ::testing::HasSubstr;
 using ::testing::InSequence;
 using ::testing::NiceMock;
 
@@ -169,6 +184,128 @@ TEST(AMessage_tests, settersAndGetters) {
   EXPECT_NE(OK, m1->removeEntryByName("notpresent"));
 }
 
+TEST(AMessage_tests, findsItemsInLargeMessages) {
+  // enough entries for the message to use its hash index
+  constexpr int32_t kNumEntries = 64;
+  sp<AMessage> m1 = new AMessage();
+  for (int32_t i = 0; i < kNumEntries; ++i) {
+    m1->setInt32(AStringPrintf("key-%d", i).c_str(), i);
+  }
+  EXPECT_EQ(kNumEntries, (int32_t)m1->countEntries());
+
+  int32_t value;
+  for (int32_t i = 0; i < kNumEntries; ++i) {
+    EXPECT_TRUE(m1->findInt32(AStringPrintf("key-%d", i).c_str(), &value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(m1->contains("key-64"));
+  EXPECT_FALSE(m1->contains("key-"));
+
+  // overwriting keeps a single entry
+  m1->setInt32("key-7", 70);
+  EXPECT_EQ(kNumEntries, (int32_t)m1->countEntries());
+  EXPECT_TRUE(m1->findInt32("key-7", &value));
+  EXPECT_EQ(70, value);
+
+  // removal moves the last entry, renaming changes the key
+  EXPECT_EQ(OK, m1->removeEntryByName("key-3"));
+  EXPECT_FALSE(m1->contains("key-3"));
+  EXPECT_TRUE(m1->findInt32("key-63", &value));
+  EXPECT_EQ(63, value);
+  EXPECT_EQ(OK, m1->setEntryNameAt(m1->findEntryByName("key-5"), "renamed"));
+  EXPECT_FALSE(m1->contains("key-5"));
+  EXPECT_TRUE(m1->findInt32("renamed", &value));
+  EXPECT_EQ(5, value);
+
+  sp<AMessage> m2 = m1->dup();
+  EXPECT_EQ(m1->countEntries(), m2->countEntries());
+  EXPECT_TRUE(m2->findInt32("renamed", &value));
+  EXPECT_EQ(5, value);
+  m2->setInt32("key-3", 3);
+  EXPECT_TRUE(m2->contains("key-3"));
+  EXPECT_FALSE(m1->contains("key-3"));
+
+  // shrinking below the index threshold falls back to a linear search
+  while (m2->countEntries() > 2) {
+    EXPECT_EQ(OK, m2->removeEntryAt(0));
+  }
+  for (size_t i = 0; i < m2->countEntries(); ++i) {
+    AMessage::Type type;
+    EXPECT_EQ(i, m2->findEntryByName(m2->getEntryNameAt(i, &type)));
+  }
+}
+
+TEST(AMessage_tests, findsItemsWhileGrowingAndShrinking) {
+  sp<AMessage> m1 = new AMessage();
+  int32_t value;
+  // the index is built by the first lookup, then grows with the message
+  for (int32_t i = 0; i < (int32_t)AMessage::maxAllowedEntries(); ++i) {
+    m1->setInt32(AStringPrintf("k%d", i).c_str(), i);
+    for (int32_t j = 0; j <= i; j += 1 + i / 8) {
+      ASSERT_TRUE(m1->findInt32(AStringPrintf("k%d", j).c_str(), &value)) << j << " of " << i;
+      EXPECT_EQ(j, value);
+    }
+    EXPECT_FALSE(m1->contains(AStringPrintf("k%d", i + 1).c_str()));
+  }
+
+  // removing the first entry moves the last one in its place
+  while (m1->countEntries() > 0) {
+    AMessage::Type type;
+    AString last = m1->getEntryNameAt(m1->countEntries() - 1, &type);
+    AString first = m1->getEntryNameAt(0, &type);
+    EXPECT_EQ(OK, m1->removeEntryAt(0));
+    EXPECT_FALSE(m1->contains(first.c_str()));
+    if (m1->countEntries() > 0) {
+      EXPECT_EQ(0u, m1->findEntryByName(last.c_str()));
+    }
+  }
+
+  // renaming the first entry
+  for (int32_t i = 0; i < 40; ++i) {
+    m1->setInt32(AStringPrintf("k%d", i).c_str(), i);
+  }
+  EXPECT_EQ(OK, m1->setEntryNameAt(0, "first"));
+  EXPECT_FALSE(m1->contains("k0"));
+  EXPECT_TRUE(m1->findInt32("first", &value));
+  EXPECT_EQ(0, value);
+  EXPECT_EQ(ALREADY_EXISTS, m1->setEntryNameAt(1, "first"));
+
+  m1->clear();
+  EXPECT_FALSE(m1->contains("first"));
+  m1->setInt32("first", 1);
+  EXPECT_TRUE(m1->findInt32("first", &value));
+  EXPECT_EQ(1, value);
+}
+
+TEST(AMessage_tests, findsItemsConcurrently) {
+  // const lookups may run on several threads, and the first ones build the index
+  constexpr int32_t kNumEntries = 64;
+  constexpr size_t kNumThreads = 4;
+  sp<AMessage> m1 = new AMessage();
+  for (int32_t i = 0; i < kNumEntries; ++i) {
+    m1->setInt32(AStringPrintf("key-%d", i).c_str(), i);
+  }
+  for (int32_t round = 0; round < 50; ++round) {
+    sp<const AMessage> m2 = m1->dup();
+    std::atomic<size_t> numFound{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kNumThreads; ++t) {
+      threads.emplace_back([m2, &numFound] {
+        int32_t value;
+        for (int32_t i = kNumEntries - 1; i >= 0; --i) {
+          if (m2->findInt32(AStringPrintf("key-%d", i).c_str(), &value) && value == i) {
+            ++numFound;
+          }
+        }
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(kNumThreads * kNumEntries, numFound.load());
+  }
+}
+
 TEST(AMessage_tests, deliversMultipleMessagesInOrderImmediately) {
   sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
   sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
@@ -234,6 +371,36 @@ TEST(AMessage_tests, deliversDelayedMessagesInSequence) {
   nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
 }
 
+// Messages due at the same time must be delivered in the order they were posted, regardless of
+// how many other messages are queued around them.
+TEST(AMessage_tests, deliversMessagesWithSameDueTimeInPostingOrder) {
+  sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
+  sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
+  looper->registerHandler(mockHandler);
+
+  std::vector<sp<AMessage>> msgsIn100;
+  std::vector<sp<AMessage>> msgsIn50;
+  for (int i = 0; i < 20; ++i) {
+    msgsIn100.push_back(new AMessage(i, mockHandler));
+    msgsIn100.back()->post(100);
+    msgsIn50.push_back(new AMessage(i, mockHandler));
+    msgsIn50.back()->post(50);
+  }
+
+  looper->setClockUs(100);
+  {
+    InSequence inSequence;
+    for (const sp<AMessage> &msg : msgsIn50) {
+      EXPECT_CALL(*mockHandler, onMessageReceived(msg)).Times(1);
+    }
+    for (const sp<AMessage> &msg : msgsIn100) {
+      EXPECT_CALL(*mockHandler, onMessageReceived(msg)).Times(1);
+    }
+  }
+  looper->start();
+  nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
+}
+
 TEST(AMessage_tests, deliversDelayedUniqueMessage) {
   sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
   sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
@@ -327,6 +494,56 @@ TEST(AMessage_tests, deliversUniqueMessageOnce) {
   nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
 }
 
+static std::string dumpLooperRoster(bool clear) {
+  Vector<String16> args;
+  if (clear) {
+    args.add(String16("-c"));
+  }
+  FILE *file = tmpfile();
+  if (file == nullptr) {
+    return "";
+  }
+  gLooperRoster.dump(fileno(file), args);
+  std::string dump;
+  char buffer[256];
+  rewind(file);
+  for (size_t n; (n = fread(buffer, 1, sizeof(buffer), file)) > 0;) {
+    dump.append(buffer, n);
+  }
+  fclose(file);
+  return dump;
+}
+
+TEST(AMessage_tests, reportsLooperQueueStats) {
+  sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
+  sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
+  looper->setName("QueueStatsLooper");
+  looper->registerHandler(mockHandler);
+
+  for (int i = 0; i < 3; ++i) {
+    sp<AMessage> msg = new AMessage(0, mockHandler);
+    msg->post(100);
+  }
+  // the second post replaces the first one
+  sp<AMessage> msg = new AMessage(0, mockHandler);
+  msg->postUnique(msg, 50);
+  msg->postUnique(msg, 100);
+
+  looper->setClockUs(2100);
+  EXPECT_CALL(*mockHandler, onMessageReceived(_)).Times(4);
+  looper->start();
+  nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
+
+  // all four messages were delivered 2ms late
+  EXPECT_THAT(dumpLooperRoster(true /* clear */), HasSubstr(
+      "QueueStatsLooper: queue depth 0 (max 4), 4 dispatched, latency us"
+      " <100:0 <1000:0 <5000:4 <10000:0"));
+  EXPECT_THAT(dumpLooperRoster(false /* clear */), HasSubstr(
+      "QueueStatsLooper: queue depth 0 (max 0), 0 dispatched, latency us"
+      " <100:0 <1000:0 <5000:0"));
+  looper->stop();
+}
+
 TEST(AMessage_tests, postUnique_withNullToken_returnsInvalidArgument) {
   sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
   sp<ALooper> looper = new ALooper();
@@ -20,6 +20,8 @@
 
 #include <fstream>
 #include <memory>
+#include <random>
+#include <vector>
 
 #include "media/stagefright/foundation/ABitReader.h"
 #include "media/stagefright/foundation/avc_utils.h"
@@ -349,6 +351,50 @@ TEST_P(AVCFrameTest, FrameTest) {
     }
 }
 
+// Reference byte-at-a-time scan that findStartCodePrefix() must agree with.
+static const uint8_t *findStartCodePrefixReference(const uint8_t *data, size_t size) {
+    for (size_t i = 0; i + 2 < size; ++i) {
+        if (data[i] == 0x00 && data[i + 1] == 0x00 && data[i + 2] == 0x01) {
+            return &data[i];
+        }
+    }
+    return nullptr;
+}
+
+TEST(StartCodeTest, MatchesReferenceScan) {
+    std::mt19937 rng(42);
+    std::vector<uint8_t> buffer(256);
+    for (int iteration = 0; iteration < 10000; ++iteration) {
+        // Bias the content towards 0x00 and 0x01 so that partial and complete start codes
+        // straddle every vector lane boundary.
+        for (uint8_t &byte : buffer) {
+            uint32_t r = rng() % 8;
+            byte = r < 3 ? 0x00 : (r == 3 ? 0x01 : (uint8_t)rng());
+        }
+        size_t offset = rng() % buffer.size();
+        size_t size = rng() % (buffer.size() - offset + 1);
+        ASSERT_EQ(findStartCodePrefixReference(&buffer[offset], size),
+                  findStartCodePrefix(&buffer[offset], size))
+                << "offset " << offset << " size " << size;
+    }
+}
+
+TEST(StartCodeTest, StartCodeAtBufferEdges) {
+    std::vector<uint8_t> buffer(67, 0xff);
+    ASSERT_EQ(nullptr, findStartCodePrefix(buffer.data(), buffer.size()));
+
+    buffer[64] = 0x00;
+    buffer[65] = 0x00;
+    buffer[66] = 0x01;
+    ASSERT_EQ(&buffer[64], findStartCodePrefix(buffer.data(), buffer.size()));
+    ASSERT_EQ(nullptr, findStartCodePrefix(buffer.data(), buffer.size() - 1));
+
+    buffer[0] = 0x00;
+    buffer[1] = 0x00;
+    buffer[2] = 0x01;
+    ASSERT_EQ(&buffer[0], findStartCodePrefix(buffer.data(), buffer.size()));
+}
+
 INSTANTIATE_TEST_SUITE_P(AVCUtilsTestAll, MpegAudioUnitTest,
                          ::testing::Values(make_tuple(0xFFFB9204, 418, 44100, 2, 128, 1152),
                                            make_tuple(0xFFFB7604, 289, 48000, 2, 96, 1152),
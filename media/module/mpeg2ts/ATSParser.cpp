@@ -43,6 +43,8 @@
 #include <utils/KeyedVector.h>
 #include <utils/Vector.h>
 
+#include <algorithm>
+
 #include <inttypes.h>
 
 namespace android {
@@ -1121,6 +1123,12 @@ bool ATSParser::Stream::ensureBufferCapacity(size_t neededSize) {
         ALOGD("[stream %d] created shared buffer for descrambling, size %zu",
                 mElementaryPID, neededSize);
     } else {
+        // Grow geometrically so that a large PES packet arriving in 184-byte
+        // TS payloads does not reallocate and copy the partial packet again
+        // for every 64K it grows by.
+        if (mBuffer != NULL) {
+            neededSize = std::max(neededSize, mBuffer->capacity() * 2);
+        }
         // Align to multiples of 64K.
         neededSize = (neededSize + 65535) & ~65535;
     }
@@ -1207,6 +1215,15 @@ status_t ATSParser::Stream::parse(
     }
 
     size_t neededSize = mBuffer->size() + payloadSizeBits / 8;
+    if (payload_unit_start_indicator && mBuffer->size() == 0 && payloadSizeBits >= 48) {
+        // Reserve room for the whole PES packet up front when its header
+        // tells us how large it is, instead of growing while assembling it.
+        const uint8_t *data = br->data();
+        if (data[0] == 0x00 && data[1] == 0x00 && data[2] == 0x01) {
+            size_t PES_packet_length = U16_AT(&data[4]);
+            neededSize = std::max(neededSize, 6 + PES_packet_length);
+        }
+    }
     if (!ensureBufferCapacity(neededSize)) {
         return NO_MEMORY;
     }
@@ -33,6 +33,7 @@
 #include <media/cas/DescramblerAPI.h>
 #include <media/hardware/CryptoAPI.h>
 
+#include <atomic>
 #include <inttypes.h>
 #include <netinet/in.h>
 
@@ -42,6 +43,10 @@
 
 namespace android {
 
+// Access units beyond this many are not recycled.
+static const size_t kMaxPooledAccessUnits = 32;
+static const size_t kAccessUnitAlignment = 4096;
+
 ElementaryStreamQueue::ElementaryStreamQueue(Mode mode, uint32_t flags)
     : mMode(mode),
       mFlags(flags),
@@ -889,13 +894,8 @@ status_t ElementaryStreamQueue::appendData(
 #else
                 uint8_t *ptr = (uint8_t *)data;
 
-                ssize_t startOffset = -1;
-                for (size_t i = 0; i + 2 < size; ++i) {
-                    if (!memcmp("\x00\x00\x01", &ptr[i], 3)) {
-                        startOffset = i;
-                        break;
-                    }
-                }
+                const uint8_t *startCode = findStartCodePrefix(ptr, size);
+                ssize_t startOffset = startCode != NULL ? startCode - ptr : -1;
 
                 if (startOffset < 0) {
                     return ERROR_MALFORMED;
@@ -922,13 +922,8 @@ status_t ElementaryStreamQueue::appendData(
 #else
                 uint8_t *ptr = (uint8_t *)data;
 
-                ssize_t startOffset = -1;
-                for (size_t i = 0; i + 2 < size; ++i) {
-                    if (!memcmp("\x00\x00\x01", &ptr[i], 3)) {
-                        startOffset = i;
-                        break;
-                    }
-                }
+                const uint8_t *startCode = findStartCodePrefix(ptr, size);
+                ssize_t startOffset = startCode != NULL ? startCode - ptr : -1;
 
                 if (startOffset < 0) {
                     return ERROR_MALFORMED;
@@ -1162,6 +1157,12 @@ status_t ElementaryStreamQueue::appendData(
     }
 
     size_t neededSize = (mBuffer == NULL ? 0 : mBuffer->size()) + size;
+    if (mBuffer != NULL && neededSize <= mBuffer->capacity()
+            && mBuffer->offset() + neededSize > mBuffer->capacity()) {
+        // Reclaim the space of the access units dequeued so far.
+        memmove(mBuffer->base(), mBuffer->data(), mBuffer->size());
+        mBuffer->setRange(0, mBuffer->size());
+    }
     if (mBuffer == NULL || neededSize > mBuffer->capacity()) {
         neededSize = (neededSize + 65535) & ~65535;
 
@@ -1179,7 +1180,7 @@ status_t ElementaryStreamQueue::appendData(
     }
 
     memcpy(mBuffer->data() + mBuffer->size(), data, size);
-    mBuffer->setRange(0, mBuffer->size() + size);
+    mBuffer->setRange(mBuffer->offset(), mBuffer->size() + size);
 
     RangeInfo info;
     info.mLength = size;
@@ -1239,6 +1240,60 @@ void ElementaryStreamQueue::appendScrambledData(
     mScrambledRangeInfos.push_back(scrambledInfo);
 }
 
+sp<ABuffer> ElementaryStreamQueue::allocateAccessUnit(size_t size) {
+    ssize_t bestIndex = -1;
+    ssize_t idleIndex = -1;
+    for (size_t i = 0; i < mAccessUnitPool.size(); ++i) {
+        const sp<ABuffer> &buffer = mAccessUnitPool[i];
+        if (buffer->getStrongCount() != 1) {
+            continue;
+        }
+        // Consumers may keep the meta after dropping the buffer, e.g. as the
+        // latest enqueued meta of AnotherPacketSource, so it must not be
+        // cleared while anyone else holds it.
+        sp<AMessage> meta = buffer->meta();
+        if (meta->getStrongCount() != 2) {  // |buffer| and |meta|
+            continue;
+        }
+        idleIndex = i;
+        if (buffer->capacity() >= size && (bestIndex < 0
+                || buffer->capacity() < mAccessUnitPool[bestIndex]->capacity())) {
+            bestIndex = i;
+        }
+    }
+
+    if (bestIndex >= 0) {
+        // Pairs with the release of the last reference by the consumer.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        sp<ABuffer> accessUnit = mAccessUnitPool[bestIndex];
+        accessUnit->setRange(0, size);
+        accessUnit->setInt32Data(0);
+        accessUnit->meta()->clear();
+        return accessUnit;
+    }
+
+    // Leave some headroom so that the buffer fits later access units of a
+    // similar size.
+    size_t capacity = (size + size / 4 + kAccessUnitAlignment - 1) & ~(kAccessUnitAlignment - 1);
+    sp<ABuffer> accessUnit = new ABuffer(capacity);
+    accessUnit->setRange(0, size);
+    if (idleIndex >= 0) {
+        // replace an idle buffer that is too small
+        mAccessUnitPool[idleIndex] = accessUnit;
+    } else if (mAccessUnitPool.size() < kMaxPooledAccessUnits) {
+        mAccessUnitPool.push_back(accessUnit);
+    }
+    return accessUnit;
+}
+
+void ElementaryStreamQueue::consumeBuffer(size_t size) {
+    if (size >= mBuffer->size()) {
+        mBuffer->setRange(0, 0);
+        return;
+    }
+    mBuffer->setRange(mBuffer->offset() + size, mBuffer->size() - size);
+}
+
 sp<ABuffer> ElementaryStreamQueue::dequeueScrambledAccessUnit() {
     size_t nextScan = mBuffer->size();
     int32_t pesOffset = 0, pesScramblingControl = 0;
@@ -1281,7 +1336,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueScrambledAccessUnit() {
     // range on mBuffer. Note that the leading clear bytes includes the
     // PES header portion, while mBuffer doesn't.
     if ((int32_t)leadingClearBytes > pesOffset) {
-        mBuffer->setRange(0, leadingClearBytes - pesOffset);
+        mBuffer->setRange(mBuffer->offset(), leadingClearBytes - pesOffset);
     } else {
         mBuffer->setRange(0, 0);
     }
@@ -1384,15 +1439,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnit() {
         RangeInfo info = *mRangeInfos.begin();
         mRangeInfos.erase(mRangeInfos.begin());
 
-        sp<ABuffer> accessUnit = new ABuffer(info.mLength);
+        sp<ABuffer> accessUnit = allocateAccessUnit(info.mLength);
         memcpy(accessUnit->data(), mBuffer->data(), info.mLength);
         accessUnit->meta()->setInt64("timeUs", info.mTimestampUs);
 
-        memmove(mBuffer->data(),
-                mBuffer->data() + info.mLength,
-                mBuffer->size() - info.mLength);
-
-        mBuffer->setRange(0, mBuffer->size() - info.mLength);
+        consumeBuffer(info.mLength);
 
         if (mFormat == NULL) {
             mFormat = new MetaData;
@@ -1473,18 +1524,13 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitDTSOrDTSHD() {
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = allocateAccessUnit(syncStartPos + payloadSize);
     memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-        mBuffer->data(),
-        mBuffer->data() + syncStartPos + payloadSize,
-        mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
+    consumeBuffer(syncStartPos + payloadSize);
 
     return accessUnit;
 }
@@ -1527,18 +1573,13 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitDTSUHD()
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = allocateAccessUnit(syncStartPos + payloadSize);
     memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-        mBuffer->data(),
-        mBuffer->data() + syncStartPos + payloadSize,
-        mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
+    consumeBuffer(syncStartPos + payloadSize);
 
     return accessUnit;
 }
@@ -1599,18 +1640,13 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitEAC3() {
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = allocateAccessUnit(syncStartPos + payloadSize);
     memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
+    consumeBuffer(syncStartPos + payloadSize);
 
     return accessUnit;
 }
@@ -1663,18 +1699,13 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAC4() {
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = allocateAccessUnit(syncStartPos + payloadSize);
     memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
+    consumeBuffer(syncStartPos + payloadSize);
     return accessUnit;
 }
 
@@ -1720,7 +1751,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitPCMAudio() {
         return NULL;
     }
 
-    sp<ABuffer> accessUnit = new ABuffer(payloadSize);
+    sp<ABuffer> accessUnit = allocateAccessUnit(payloadSize);
     memcpy(accessUnit->data(), mBuffer->data() + 4, payloadSize);
 
     int64_t timeUs = fetchTimestamp(payloadSize + 4);
@@ -1736,12 +1767,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitPCMAudio() {
         ptr[i] = ntohs(ptr[i]);
     }
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + 4 + payloadSize,
-            mBuffer->size() - 4 - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - 4 - payloadSize);
+    consumeBuffer(4 + payloadSize);
 
     return accessUnit;
 }
@@ -1882,12 +1908,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAAC() {
 
     int64_t timeUs = fetchTimestamp(offset);
 
-    sp<ABuffer> accessUnit = new ABuffer(offset);
+    sp<ABuffer> accessUnit = allocateAccessUnit(offset);
     memcpy(accessUnit->data(), mBuffer->data(), offset);
 
-    memmove(mBuffer->data(), mBuffer->data() + offset,
-            mBuffer->size() - offset);
-    mBuffer->setRange(0, mBuffer->size() - offset);
+    consumeBuffer(offset);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
@@ -1992,7 +2016,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitH264() {
             // the current one, separated by 0x00 0x00 0x00 0x01 startcodes.
 
             size_t auSize = 4 * nals.size() + totalSize;
-            sp<ABuffer> accessUnit = new ABuffer(auSize);
+            sp<ABuffer> accessUnit = allocateAccessUnit(auSize);
             sp<ABuffer> sei;
 
             if (seiCount > 0) {
@@ -2072,11 +2096,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitH264() {
             const NALPosition &pos = nals.itemAt(nals.size() - 1);
             size_t nextScan = pos.nalOffset + pos.nalSize;
 
-            memmove(mBuffer->data(),
-                    mBuffer->data() + nextScan,
-                    mBuffer->size() - nextScan);
-
-            mBuffer->setRange(0, mBuffer->size() - nextScan);
+            consumeBuffer(nextScan);
 
             int64_t timeUs = fetchTimestamp(nextScan);
             if (timeUs < 0LL) {
@@ -2155,14 +2175,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGAudio() {
 
     unsigned layer = 4 - ((header >> 17) & 3);
 
-    sp<ABuffer> accessUnit = new ABuffer(frameSize);
+    sp<ABuffer> accessUnit = allocateAccessUnit(frameSize);
     memcpy(accessUnit->data(), data, frameSize);
 
-    memmove(mBuffer->data(),
-            mBuffer->data() + frameSize,
-            mBuffer->size() - frameSize);
-
-    mBuffer->setRange(0, mBuffer->size() - frameSize);
+    consumeBuffer(frameSize);
 
     int64_t timeUs = fetchTimestamp(frameSize);
     if (timeUs < 0LL) {
@@ -2275,10 +2291,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
 
     size_t offset = 0;
     while (offset + 3 < size) {
-        if (memcmp(&data[offset], "\x00\x00\x01", 3)) {
-            ++offset;
-            continue;
+        const uint8_t *startCode = findStartCodePrefix(&data[offset], size - 1 - offset);
+        if (startCode == NULL) {
+            break;
         }
+        offset = startCode - data;
 
         pprevStartCode = prevStartCode;
         prevStartCode = currentStartCode;
@@ -2289,7 +2306,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
             size -= offset;
             (void)fetchTimestamp(offset);
             offset = 0;
-            mBuffer->setRange(0, size);
+            mBuffer->setRange(mBuffer->offset(), size);
         }
 
         if ((prevStartCode == 0xb3 && currentStartCode != 0xb5)
@@ -2318,11 +2335,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
                 sp<ABuffer> csd = new ABuffer(offset);
                 memcpy(csd->data(), data, offset);
 
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                consumeBuffer(offset);
                 size -= offset;
                 (void)fetchTimestamp(offset);
                 offset = 0;
@@ -2358,14 +2371,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
             if (!sawPictureStart) {
                 sawPictureStart = true;
             } else {
-                sp<ABuffer> accessUnit = new ABuffer(offset);
+                sp<ABuffer> accessUnit = allocateAccessUnit(offset);
                 memcpy(accessUnit->data(), data, offset);
 
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                consumeBuffer(offset);
 
                 int64_t timeUs = fetchTimestamp(offset);
                 if (timeUs < 0LL) {
@@ -2422,13 +2431,9 @@ static ssize_t getNextChunkSize(
         return -EAGAIN;
     }
 
-    size_t offset = 4;
-    while (offset + 2 < size) {
-        if (!memcmp(&data[offset], kStartCode, 3)) {
-            return offset;
-        }
-
-        ++offset;
+    const uint8_t *nextStartCode = findStartCodePrefix(&data[4], size - 4);
+    if (nextStartCode != NULL) {
+        return nextStartCode - data;
     }
 
     return -EAGAIN;
@@ -2557,12 +2562,12 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
 
                     offset += chunkSize;
 
-                    sp<ABuffer> accessUnit = new ABuffer(offset);
+                    sp<ABuffer> accessUnit = allocateAccessUnit(offset);
                     memcpy(accessUnit->data(), data, offset);
 
                     memmove(data, &data[offset], size - offset);
                     size -= offset;
-                    mBuffer->setRange(0, size);
+                    mBuffer->setRange(mBuffer->offset(), size);
 
                     int64_t timeUs = fetchTimestamp(offset);
                     if (timeUs < 0LL) {
@@ -2601,7 +2606,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
             memmove(data, &data[offset], size - offset);
             size -= offset;
             offset = 0;
-            mBuffer->setRange(0, size);
+            mBuffer->setRange(mBuffer->offset(), size);
         } else {
             offset += chunkSize;
         }
@@ -2628,7 +2633,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMetadata() {
         return NULL;
     }
 
-    sp<ABuffer> accessUnit = new ABuffer(size);
+    sp<ABuffer> accessUnit = allocateAccessUnit(size);
     int64_t timeUs = fetchTimestamp(size);
     accessUnit->meta()->setInt64("timeUs", timeUs);
 
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Replays a transport stream through ATSParser and drains the assembled
+// access units, to measure PES assembly and access unit extraction.
+//
+// Usage: ATSParserBenchmark [--benchmark options] [file.ts]
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/MediaErrors.h>
+#include <mpeg2ts/AnotherPacketSource.h>
+#include <mpeg2ts/ATSParser.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kTSPacketSize = 188;
+
+std::string gInputPath = "/data/local/tmp/ATSParserBenchmark.ts";
+
+bool readFile(const std::string &path, std::vector<uint8_t> *data) {
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp == nullptr) {
+        return false;
+    }
+    uint8_t chunk[64 * 1024];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        data->insert(data->end(), chunk, chunk + n);
+    }
+    fclose(fp);
+    return true;
+}
+
+size_t drain(const sp<ATSParser> &parser, ATSParser::SourceType type) {
+    sp<AnotherPacketSource> source = parser->getSource(type);
+    if (source == nullptr) {
+        return 0;
+    }
+    size_t count = 0;
+    status_t finalResult;
+    while (source->hasBufferAvailable(&finalResult)) {
+        sp<ABuffer> accessUnit;
+        if (source->dequeueAccessUnit(&accessUnit) != OK) {
+            break;
+        }
+        ++count;
+    }
+    return count;
+}
+
+}  // namespace
+
+static void BM_ParseTransportStream(benchmark::State &state) {
+    std::vector<uint8_t> data;
+    if (!readFile(gInputPath, &data) || data.size() < kTSPacketSize) {
+        state.SkipWithError(("cannot read " + gInputPath).c_str());
+        return;
+    }
+    const size_t numPackets = data.size() / kTSPacketSize;
+
+    size_t accessUnits = 0;
+    for (auto _ : state) {
+        sp<ATSParser> parser = new ATSParser;
+        for (size_t i = 0; i < numPackets; ++i) {
+            const off64_t offset = i * kTSPacketSize;
+            ATSParser::SyncEvent event(offset);
+            if (parser->feedTSPacket(&data[offset], kTSPacketSize, &event) != OK) {
+                break;
+            }
+            // Drain as we go, as an extractor would, so that recycled access
+            // units are exercised rather than the queues growing unbounded.
+            if ((i & 63) == 63) {
+                accessUnits += drain(parser, ATSParser::VIDEO);
+                accessUnits += drain(parser, ATSParser::AUDIO);
+            }
+        }
+        parser->signalEOS(ERROR_END_OF_STREAM);
+        accessUnits += drain(parser, ATSParser::VIDEO);
+        accessUnits += drain(parser, ATSParser::AUDIO);
+    }
+
+    state.SetBytesProcessed(state.iterations() * numPackets * kTSPacketSize);
+    state.counters["AccessUnits"] = benchmark::Counter(
+            accessUnits, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_ParseTransportStream)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char **argv) {
+    benchmark::Initialize(&argc, argv);
+    if (argc > 1) {
+        gInputPath = argv[1];
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -102,9 +102,16 @@ private:
     uint32_t mFlags;
     bool mEOSReached;
 
+    // Dequeued access units are skipped by advancing the range offset of
+    // mBuffer; appendData() moves the remaining data to the front only when it
+    // runs out of room at the end.
     sp<ABuffer> mBuffer;
     List<RangeInfo> mRangeInfos;
 
+    // Access units handed out earlier, recycled once the pool holds the only
+    // reference to them and to their meta.
+    std::vector<sp<ABuffer>> mAccessUnitPool;
+
     sp<ABuffer> mScrambledBuffer;
     List<ScrambledRangeInfo> mScrambledRangeInfos;
     int32_t mCASystemId;
@@ -119,6 +126,11 @@ private:
         return (mFlags & kFlag_SampleEncryptedData) != 0;
     }
 
+    // Returns a buffer of |size| bytes for an access unit, with empty meta.
+    sp<ABuffer> allocateAccessUnit(size_t size);
+    // Drops the first |size| bytes of mBuffer.
+    void consumeBuffer(size_t size);
+
     sp<ABuffer> dequeueAccessUnitH264();
     sp<ABuffer> dequeueAccessUnitAAC();
     sp<ABuffer> dequeueAccessUnitEAC3();
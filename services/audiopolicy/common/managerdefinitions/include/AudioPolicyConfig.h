@@ -30,6 +30,8 @@
 
 namespace android {
 
+class Parcel;
+
 // This class gathers together various bits of AudioPolicyManager configuration. It can be filled
 // out either as a result of parsing the audio_policy_configuration.xml file, from the HAL data, or
 // to default fallback data.
@@ -49,6 +51,9 @@ public:
     static const constexpr char* const kDefaultConfigSource = "AudioPolicyConfig::setDefault";
     // The suffix of the "engine default" implementation shared library name.
     static const constexpr char* const kDefaultEngineLibraryNameSuffix = "default";
+    // The binary cache of the configuration loaded from the default XML file.
+    static const constexpr char* const kDefaultCacheFilePath =
+            "/data/misc/audioserver/audio_policy_configuration.cache";
 
     // Creates the default (fallback) configuration.
     static sp<const AudioPolicyConfig> createDefault();
@@ -56,14 +61,16 @@ public:
     static sp<const AudioPolicyConfig> loadFromApmAidlConfigWithFallback(
             const media::AudioPolicyConfig& aidl);
     // Attempts to load the configuration from the XML file, falls back to default on failure.
-    // If the XML file path is not provided, uses `audio_get_audio_policy_config_file` function.
+    // If the XML file path is not provided, uses `audio_get_audio_policy_config_file` function,
+    // and uses the binary cache at kDefaultCacheFilePath while the XML files are unchanged.
     static sp<const AudioPolicyConfig> loadFromApmXmlConfigWithFallback(
             const std::string& xmlFilePath = "");
     // The factory method to use in APM tests which craft the configuration manually.
     static sp<AudioPolicyConfig> createWritableForTests();
     // The factory method to use in APM tests which use a custom XML file.
+    // If 'cacheFilePath' is not empty, the binary cache is used like for the default XML file.
     static error::Result<sp<AudioPolicyConfig>> loadFromCustomXmlConfigForTests(
-            const std::string& xmlFilePath);
+            const std::string& xmlFilePath, const std::string& cacheFilePath = "");
     // The factory method to use in VTS tests. If the 'configPath' is empty,
     // it is determined automatically from the list of known config paths.
     static error::Result<sp<AudioPolicyConfig>> loadFromCustomXmlConfigForVtsTests(
@@ -74,6 +81,9 @@ public:
     const std::string& getSource() const {
         return mSource;
     }
+    bool isLoadedFromCache() const {
+        return mLoadedFromCache;
+    }
     void setSource(const std::string& file) {
         mSource = file;
     }
@@ -147,7 +157,10 @@ private:
 
     void augmentData();
     status_t loadFromAidl(const media::AudioPolicyConfig& aidl);
-    status_t loadFromXml(const std::string& xmlFilePath, bool forVts);
+    status_t loadFromXml(const std::string& xmlFilePath, bool forVts,
+            const std::string& cacheFilePath = "");
+    status_t readFromCache(const Parcel& parcel);
+    status_t writeToCache(Parcel* parcel) const;
 
     std::string mSource;  // Not kDefaultConfigSource. Empty source means an empty config.
     std::string mEngineLibraryNameSuffix = kDefaultEngineLibraryNameSuffix;
@@ -157,6 +170,7 @@ private:
     sp<DeviceDescriptor> mDefaultOutputDevice;
     bool mIsCallScreenModeSupported = false;
     SurroundFormats mSurroundFormats;
+    bool mLoadedFromCache = false;
 };
 
 } // namespace android
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <binder/Parcel.h>
+#include <utils/Errors.h>
+
+struct _xmlDoc;
+
+namespace android {
+
+// Binary cache of a configuration parsed from XML files, which spares the parsing of the files
+// on the next start of the audio server.
+//
+// The cache file holds the parsed data in a Parcel, preceded by the build fingerprint and by
+// the path, size, modification time and content hash of every file the configuration was parsed
+// from. The cache is only used when all of them are unchanged: the content hash catches updated
+// files in partitions where all the files have the same modification time.
+class ConfigCache {
+public:
+    // |version| identifies the format of the payload, it must be changed whenever the
+    // serialization of the payload changes.
+    ConfigCache(const std::string& path, uint32_t version) : mPath(path), mVersion(version) {}
+
+    // Maps the cache file and returns a Parcel positioned at the payload, or nullptr if there is
+    // no cache for |sourceFile| (the first source file of the cache) or if it is stale.
+    std::unique_ptr<Parcel> load(const std::string& sourceFile) const;
+
+    // Replaces the cache file with the payload written by |writePayload|. The first of the
+    // |sourceFiles| is the one to pass to load(). Source files which do not exist are recorded as
+    // missing, so that the cache is invalidated when they are added.
+    status_t store(const std::vector<std::string>& sourceFiles,
+            const std::function<status_t(Parcel*)>& writePayload) const;
+
+    // Appends the files included by |doc| to |files|, including nested inclusions.
+    // Must be called after xmlXIncludeProcess().
+    static void addXIncludedFiles(_xmlDoc* doc, std::vector<std::string>* files);
+
+private:
+    const std::string mPath;
+    const uint32_t mVersion;
+};
+
+} // namespace android
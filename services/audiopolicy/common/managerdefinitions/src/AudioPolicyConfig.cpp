@@ -17,6 +17,7 @@
 #define LOG_TAG "APM_Config"
 
 #include <AudioPolicyConfig.h>
+#include <ConfigCache.h>
 #include <IOProfile.h>
 #include <Serializer.h>
 #include <hardware/audio.h>
@@ -35,6 +36,10 @@ using media::audio::common::AudioPortExt;
 
 namespace {
 
+// The version of the payload of the configuration cache. Must be changed whenever
+// AudioPolicyConfig::writeToCache() changes.
+constexpr uint32_t kCacheVersion = 1;
+
 ConversionResult<sp<PolicyAudioPort>>
 aidl2legacy_portId_PolicyAudioPort(int32_t portId,
         const std::unordered_map<int32_t, sp<PolicyAudioPort>>& ports) {
@@ -168,6 +173,172 @@ aidl2legacy_SurroundSoundConfig_SurroundFormats(const media::SurroundSoundConfig
             aidl2legacy_SurroundFormatFamily);
 };
 
+status_t writeHwModuleToCache(const sp<HwModule>& module, Parcel* parcel) {
+    RETURN_STATUS_IF_ERROR(parcel->writeCString(module->getName()));
+    RETURN_STATUS_IF_ERROR(parcel->writeUint32(module->getHalVersionMajor()));
+    RETURN_STATUS_IF_ERROR(parcel->writeUint32(module->getHalVersionMinor()));
+
+    // Mix ports and device ports are stored as AudioPortFw parcelables, like they are
+    // exchanged with the AIDL HAL.
+    IOProfileCollection mixPorts = module->getOutputProfiles();
+    mixPorts.appendVector(module->getInputProfiles());
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(mixPorts.size()));
+    for (const auto& mixPort : mixPorts) {
+        media::AudioPortFw fwPort;
+        RETURN_STATUS_IF_ERROR(mixPort->writeToParcelable(&fwPort));
+        RETURN_STATUS_IF_ERROR(parcel->writeParcelable(fwPort));
+    }
+    const DeviceVector& devicePorts = module->getDeclaredDevices();
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(devicePorts.size()));
+    for (const auto& devicePort : devicePorts) {
+        media::AudioPortFw fwPort;
+        // DeviceDescriptorBase::writeToParcelable() ignores the errors of the AudioPort part.
+        RETURN_STATUS_IF_ERROR(devicePort->AudioPort::writeToParcelable(&fwPort));
+        RETURN_STATUS_IF_ERROR(devicePort->writeToParcelable(&fwPort));
+        RETURN_STATUS_IF_ERROR(parcel->writeCString(devicePort->getTagName().c_str()));
+        RETURN_STATUS_IF_ERROR(parcel->writeUint32(devicePort->type()));
+        RETURN_STATUS_IF_ERROR(parcel->writeCString(devicePort->address().c_str()));
+        RETURN_STATUS_IF_ERROR(parcel->writeParcelable(fwPort));
+    }
+    const AudioRouteVector& routes = module->getRoutes();
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(routes.size()));
+    for (const auto& route : routes) {
+        RETURN_STATUS_IF_ERROR(parcel->writeInt32(route->getType()));
+        RETURN_STATUS_IF_ERROR(parcel->writeCString(route->getSink()->getTagName().c_str()));
+        RETURN_STATUS_IF_ERROR(parcel->writeInt32(route->getSources().size()));
+        for (const auto& source : route->getSources()) {
+            RETURN_STATUS_IF_ERROR(parcel->writeCString(source->getTagName().c_str()));
+        }
+    }
+    return NO_ERROR;
+}
+
+status_t readHwModuleFromCache(const Parcel& parcel, sp<HwModule>* module) {
+    const char* name = parcel.readCString();
+    uint32_t versionMajor = 0, versionMinor = 0;
+    if (name == nullptr || parcel.readUint32(&versionMajor) != NO_ERROR
+            || parcel.readUint32(&versionMinor) != NO_ERROR) {
+        return BAD_VALUE;
+    }
+    *module = sp<HwModule>::make(name, versionMajor, versionMinor);
+
+    int32_t count = 0;
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&count));
+    IOProfileCollection mixPorts;
+    for (int32_t i = 0; i < count; ++i) {
+        media::AudioPortFw fwPort;
+        RETURN_STATUS_IF_ERROR(parcel.readParcelable(&fwPort));
+        auto mixPort = sp<IOProfile>::make("", AUDIO_PORT_ROLE_NONE);
+        RETURN_STATUS_IF_ERROR(mixPort->readFromParcelable(fwPort));
+        mixPorts.add(mixPort);
+    }
+    (*module)->setProfiles(mixPorts);
+
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&count));
+    DeviceVector devicePorts;
+    for (int32_t i = 0; i < count; ++i) {
+        const char* tagName = parcel.readCString();
+        uint32_t type = AUDIO_DEVICE_NONE;
+        if (tagName == nullptr || parcel.readUint32(&type) != NO_ERROR) {
+            return BAD_VALUE;
+        }
+        const char* address = parcel.readCString();
+        if (address == nullptr) {
+            return BAD_VALUE;
+        }
+        // The address given at construction is the declared address of the device.
+        auto devicePort = sp<DeviceDescriptor>::make(
+                static_cast<audio_devices_t>(type), tagName, address);
+        media::AudioPortFw fwPort;
+        RETURN_STATUS_IF_ERROR(parcel.readParcelable(&fwPort));
+        RETURN_STATUS_IF_ERROR(devicePort->readFromParcelable(fwPort));
+        devicePorts.add(devicePort);
+    }
+    (*module)->setDeclaredDevices(devicePorts);
+
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&count));
+    AudioRouteVector routes;
+    for (int32_t i = 0; i < count; ++i) {
+        int32_t type = AUDIO_ROUTE_MUX;
+        RETURN_STATUS_IF_ERROR(parcel.readInt32(&type));
+        const char* sinkTagName = parcel.readCString();
+        sp<PolicyAudioPort> sink =
+                sinkTagName != nullptr ? (*module)->findPortByTagName(sinkTagName) : nullptr;
+        if (sink == nullptr) {
+            return BAD_VALUE;
+        }
+        int32_t sourceCount = 0;
+        RETURN_STATUS_IF_ERROR(parcel.readInt32(&sourceCount));
+        PolicyAudioPortVector sources;
+        for (int32_t j = 0; j < sourceCount; ++j) {
+            const char* sourceTagName = parcel.readCString();
+            sp<PolicyAudioPort> source = sourceTagName != nullptr ?
+                    (*module)->findPortByTagName(sourceTagName) : nullptr;
+            if (source == nullptr) {
+                return BAD_VALUE;
+            }
+            sources.add(source);
+        }
+        auto route = sp<AudioRoute>::make(static_cast<audio_route_type_t>(type));
+        route->setSink(sink);
+        route->setSources(sources);
+        sink->addRoute(route);
+        for (const auto& source : sources) {
+            source->addRoute(route);
+        }
+        routes.add(route);
+    }
+    (*module)->setRoutes(routes);
+    return NO_ERROR;
+}
+
+// Devices are referenced by their module and their tag name.
+status_t writeDeviceRefToCache(const HwModuleCollection& modules,
+        const sp<DeviceDescriptor>& device, Parcel* parcel) {
+    for (size_t i = 0; i < modules.size(); ++i) {
+        if (modules[i]->getDeclaredDevices().indexOf(device) >= 0) {
+            RETURN_STATUS_IF_ERROR(parcel->writeInt32(i));
+            return parcel->writeCString(device->getTagName().c_str());
+        }
+    }
+    ALOGE("%s: device %s is not declared by any module", __func__, device->toString().c_str());
+    return BAD_VALUE;
+}
+
+status_t readDeviceRefFromCache(const Parcel& parcel, const HwModuleCollection& modules,
+        sp<DeviceDescriptor>* device) {
+    int32_t moduleIndex = -1;
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&moduleIndex));
+    const char* tagName = parcel.readCString();
+    if (moduleIndex < 0 || static_cast<size_t>(moduleIndex) >= modules.size()
+            || tagName == nullptr) {
+        return BAD_VALUE;
+    }
+    *device = modules[moduleIndex]->getDeclaredDevices().getDeviceFromTagName(tagName);
+    return *device != nullptr ? NO_ERROR : BAD_VALUE;
+}
+
+status_t writeDevicesToCache(const HwModuleCollection& modules, const DeviceVector& devices,
+        Parcel* parcel) {
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(devices.size()));
+    for (const auto& device : devices) {
+        RETURN_STATUS_IF_ERROR(writeDeviceRefToCache(modules, device, parcel));
+    }
+    return NO_ERROR;
+}
+
+status_t readDevicesFromCache(const Parcel& parcel, const HwModuleCollection& modules,
+        DeviceVector* devices) {
+    int32_t count = 0;
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&count));
+    for (int32_t i = 0; i < count; ++i) {
+        sp<DeviceDescriptor> device;
+        RETURN_STATUS_IF_ERROR(readDeviceRefFromCache(parcel, modules, &device));
+        devices->add(device);
+    }
+    return NO_ERROR;
+}
+
 }  // namespace
 
 // static
@@ -192,8 +363,11 @@ sp<const AudioPolicyConfig> AudioPolicyConfig::loadFromApmXmlConfigWithFallback(
         const std::string& xmlFilePath) {
     const std::string filePath =
             xmlFilePath.empty() ? audio_get_audio_policy_config_file() : xmlFilePath;
+    // Only the default configuration is cached, custom files are usually loaded by tests.
+    const std::string cacheFilePath = xmlFilePath.empty() ? kDefaultCacheFilePath : "";
     auto config = sp<AudioPolicyConfig>::make();
-    if (status_t status = config->loadFromXml(filePath, false /*forVts*/); status == NO_ERROR) {
+    if (status_t status = config->loadFromXml(filePath, false /*forVts*/, cacheFilePath);
+            status == NO_ERROR) {
         return config;
     }
     return createDefault();
@@ -206,9 +380,10 @@ sp<AudioPolicyConfig> AudioPolicyConfig::createWritableForTests() {
 
 // static
 error::Result<sp<AudioPolicyConfig>> AudioPolicyConfig::loadFromCustomXmlConfigForTests(
-        const std::string& xmlFilePath) {
+        const std::string& xmlFilePath, const std::string& cacheFilePath) {
     auto config = sp<AudioPolicyConfig>::make();
-    if (status_t status = config->loadFromXml(xmlFilePath, false /*forVts*/); status == NO_ERROR) {
+    if (status_t status = config->loadFromXml(xmlFilePath, false /*forVts*/, cacheFilePath);
+            status == NO_ERROR) {
         return config;
     } else {
         return base::unexpected(status);
@@ -266,15 +441,34 @@ status_t AudioPolicyConfig::loadFromAidl(const media::AudioPolicyConfig& aidl) {
     return NO_ERROR;
 }
 
-status_t AudioPolicyConfig::loadFromXml(const std::string& xmlFilePath, bool forVts) {
+status_t AudioPolicyConfig::loadFromXml(const std::string& xmlFilePath, bool forVts,
+        const std::string& cacheFilePath) {
     if (xmlFilePath.empty()) {
         ALOGE("Audio policy configuration file name is empty");
         return BAD_VALUE;
     }
+    const ConfigCache cache(cacheFilePath, kCacheVersion);
+    if (!cacheFilePath.empty()) {
+        if (auto parcel = cache.load(xmlFilePath); parcel != nullptr) {
+            if (status_t status = readFromCache(*parcel); status == NO_ERROR) {
+                mSource = xmlFilePath;
+                mLoadedFromCache = true;
+                augmentData();
+                return NO_ERROR;
+            }
+            ALOGW("Could not load audio policy from the cache \"%s\", parsing \"%s\"",
+                    cacheFilePath.c_str(), xmlFilePath.c_str());
+        }
+    }
+    std::vector<std::string> sourceFiles;
     status_t status = forVts ? deserializeAudioPolicyFileForVts(xmlFilePath.c_str(), this)
-            : deserializeAudioPolicyFile(xmlFilePath.c_str(), this);
+            : deserializeAudioPolicyFile(xmlFilePath.c_str(), this, &sourceFiles);
     if (status == NO_ERROR) {
         mSource = xmlFilePath;
+        // The cache holds the configuration as parsed, augmentData() is applied on load.
+        if (!cacheFilePath.empty()) {
+            cache.store(sourceFiles, [this](Parcel* parcel) { return writeToCache(parcel); });
+        }
         augmentData();
     } else {
         ALOGE("Could not load audio policy from the configuration file \"%s\": %d",
@@ -283,6 +477,83 @@ status_t AudioPolicyConfig::loadFromXml(const std::string& xmlFilePath, bool for
     return status;
 }
 
+status_t AudioPolicyConfig::readFromCache(const Parcel& parcel) {
+    const char* engineLibraryNameSuffix = parcel.readCString();
+    if (engineLibraryNameSuffix == nullptr) {
+        return BAD_VALUE;
+    }
+    bool isCallScreenModeSupported = false;
+    RETURN_STATUS_IF_ERROR(parcel.readBool(&isCallScreenModeSupported));
+
+    int32_t count = 0;
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&count));
+    HwModuleCollection hwModules;
+    for (int32_t i = 0; i < count; ++i) {
+        sp<HwModule> module;
+        RETURN_STATUS_IF_ERROR(readHwModuleFromCache(parcel, &module));
+        hwModules.add(module);
+    }
+    DeviceVector outputDevices, inputDevices;
+    RETURN_STATUS_IF_ERROR(readDevicesFromCache(parcel, hwModules, &outputDevices));
+    RETURN_STATUS_IF_ERROR(readDevicesFromCache(parcel, hwModules, &inputDevices));
+    sp<DeviceDescriptor> defaultOutputDevice;
+    bool hasDefaultOutputDevice = false;
+    RETURN_STATUS_IF_ERROR(parcel.readBool(&hasDefaultOutputDevice));
+    if (hasDefaultOutputDevice) {
+        RETURN_STATUS_IF_ERROR(readDeviceRefFromCache(parcel, hwModules, &defaultOutputDevice));
+    }
+
+    SurroundFormats surroundFormats;
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&count));
+    for (int32_t i = 0; i < count; ++i) {
+        uint32_t format = AUDIO_FORMAT_DEFAULT;
+        int32_t subformatCount = 0;
+        RETURN_STATUS_IF_ERROR(parcel.readUint32(&format));
+        RETURN_STATUS_IF_ERROR(parcel.readInt32(&subformatCount));
+        auto& subformats = surroundFormats[static_cast<audio_format_t>(format)];
+        for (int32_t j = 0; j < subformatCount; ++j) {
+            uint32_t subformat = AUDIO_FORMAT_DEFAULT;
+            RETURN_STATUS_IF_ERROR(parcel.readUint32(&subformat));
+            subformats.insert(static_cast<audio_format_t>(subformat));
+        }
+    }
+
+    mEngineLibraryNameSuffix = engineLibraryNameSuffix;
+    mIsCallScreenModeSupported = isCallScreenModeSupported;
+    mHwModules = hwModules;
+    mOutputDevices = outputDevices;
+    mInputDevices = inputDevices;
+    mDefaultOutputDevice = defaultOutputDevice;
+    mSurroundFormats = surroundFormats;
+    return NO_ERROR;
+}
+
+status_t AudioPolicyConfig::writeToCache(Parcel* parcel) const {
+    RETURN_STATUS_IF_ERROR(parcel->writeCString(mEngineLibraryNameSuffix.c_str()));
+    RETURN_STATUS_IF_ERROR(parcel->writeBool(mIsCallScreenModeSupported));
+
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(mHwModules.size()));
+    for (const auto& module : mHwModules) {
+        RETURN_STATUS_IF_ERROR(writeHwModuleToCache(module, parcel));
+    }
+    RETURN_STATUS_IF_ERROR(writeDevicesToCache(mHwModules, mOutputDevices, parcel));
+    RETURN_STATUS_IF_ERROR(writeDevicesToCache(mHwModules, mInputDevices, parcel));
+    RETURN_STATUS_IF_ERROR(parcel->writeBool(mDefaultOutputDevice != nullptr));
+    if (mDefaultOutputDevice != nullptr) {
+        RETURN_STATUS_IF_ERROR(writeDeviceRefToCache(mHwModules, mDefaultOutputDevice, parcel));
+    }
+
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(mSurroundFormats.size()));
+    for (const auto& [format, subformats] : mSurroundFormats) {
+        RETURN_STATUS_IF_ERROR(parcel->writeUint32(format));
+        RETURN_STATUS_IF_ERROR(parcel->writeInt32(subformats.size()));
+        for (const auto subformat : subformats) {
+            RETURN_STATUS_IF_ERROR(parcel->writeUint32(subformat));
+        }
+    }
+    return NO_ERROR;
+}
+
 void AudioPolicyConfig::setDefault() {
     mSource = kDefaultConfigSource;
     mEngineLibraryNameSuffix = kDefaultEngineLibraryNameSuffix;
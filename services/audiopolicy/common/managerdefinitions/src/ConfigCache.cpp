@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "APM::ConfigCache"
+//#define LOG_NDEBUG 0
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <android-base/file.h>
+#include <android-base/properties.h>
+#include <android-base/unique_fd.h>
+#include <libxml/tree.h>
+#include <libxml/uri.h>
+#include <libxml/xinclude.h>
+#include <utils/Log.h>
+
+#include "ConfigCache.h"
+
+namespace android {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x43435041;  // "APCC"
+// magic, version, payload size, payload checksum
+constexpr size_t kHeaderSize = 4 + 4 + 8 + 8;
+// A cache file larger than this is not ours.
+constexpr size_t kMaxFileSize = 4 * 1024 * 1024;
+// The size recorded for a source file which does not exist.
+constexpr int64_t kMissingFile = -1;
+
+__attribute__((no_sanitize("unsigned-integer-overflow")))
+uint64_t checksum(const uint8_t* data, size_t size) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string getBuildFingerprint() {
+    return base::GetProperty("ro.build.fingerprint", "");
+}
+
+struct SourceFile {
+    int64_t size = kMissingFile;
+    int64_t mtimeNs = 0;
+    uint64_t hash = 0;
+
+    bool operator==(const SourceFile& other) const {
+        return size == other.size && mtimeNs == other.mtimeNs && hash == other.hash;
+    }
+    bool operator!=(const SourceFile& other) const { return !(*this == other); }
+};
+
+// Reads the attributes of a source file. The content is only hashed when the size and the
+// modification time match |expected|, if provided.
+SourceFile readSourceFile(const std::string& path, const SourceFile* expected = nullptr) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return {};
+    }
+    SourceFile file{.size = st.st_size,
+                    .mtimeNs = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec};
+    if (expected != nullptr && (file.size != expected->size || file.mtimeNs != expected->mtimeNs)) {
+        return file;
+    }
+    std::string content;
+    if (!base::ReadFileToString(path, &content)) {
+        return {};
+    }
+    file.size = content.size();
+    file.hash = checksum(reinterpret_cast<const uint8_t*>(content.data()), content.size());
+    return file;
+}
+
+bool isXIncludeElement(const xmlNode* node) {
+    return node->type == XML_ELEMENT_NODE && node->ns != nullptr
+            && (xmlStrEqual(node->ns->href, XINCLUDE_NS)
+                    || xmlStrEqual(node->ns->href, XINCLUDE_OLD_NS))
+            && xmlStrEqual(node->name, XINCLUDE_NODE);
+}
+
+// xmlGetProp() only applies to elements, XINCLUDE_START nodes keep the attributes of the
+// xi:include element they replace.
+xmlChar* getHref(xmlDoc* doc, const xmlNode* node) {
+    for (const xmlAttr* attr = node->properties; attr != nullptr; attr = attr->next) {
+        if (xmlStrEqual(attr->name, XINCLUDE_HREF)) {
+            return xmlNodeListGetString(doc, attr->children, 1);
+        }
+    }
+    return nullptr;
+}
+
+void collectXIncludedFiles(xmlDoc* doc, xmlNode* node, std::vector<std::string>* files) {
+    for (; node != nullptr; node = node->next) {
+        // Processed inclusions are kept as XINCLUDE_START nodes, followed by the included nodes.
+        // Inclusions which failed are kept as they are, the file may be added later on.
+        if (node->type == XML_XINCLUDE_START || isXIncludeElement(node)) {
+            xmlChar* href = getHref(doc, node);
+            xmlChar* base = xmlNodeGetBase(doc, node);
+            xmlChar* uri = href != nullptr ? xmlBuildURI(href, base) : nullptr;
+            if (uri != nullptr) {
+                std::string file(reinterpret_cast<const char*>(uri));
+                if (std::find(files->begin(), files->end(), file) == files->end()) {
+                    files->push_back(std::move(file));
+                }
+            }
+            xmlFree(uri);
+            xmlFree(base);
+            xmlFree(href);
+        }
+        if (node->type == XML_ELEMENT_NODE) {
+            collectXIncludedFiles(doc, node->children, files);
+        }
+    }
+}
+
+}  // namespace
+
+std::unique_ptr<Parcel> ConfigCache::load(const std::string& sourceFile) const {
+    base::unique_fd fd(TEMP_FAILURE_RETRY(open(mPath.c_str(), O_RDONLY | O_CLOEXEC)));
+    if (fd < 0) {
+        ALOGV("%s: no cache %s: %s", __func__, mPath.c_str(), strerror(errno));
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd.get(), &st) != 0 || st.st_size < (off_t)kHeaderSize
+            || (size_t)st.st_size > kMaxFileSize) {
+        ALOGW("%s: invalid cache %s", __func__, mPath.c_str());
+        return nullptr;
+    }
+    const size_t size = st.st_size;
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+    if (data == MAP_FAILED) {
+        ALOGW("%s: cannot map cache %s: %s", __func__, mPath.c_str(), strerror(errno));
+        return nullptr;
+    }
+
+    const uint8_t* header = static_cast<const uint8_t*>(data);
+    uint32_t magic, version;
+    uint64_t payloadSize, payloadChecksum;
+    memcpy(&magic, header, sizeof(magic));
+    memcpy(&version, header + 4, sizeof(version));
+    memcpy(&payloadSize, header + 8, sizeof(payloadSize));
+    memcpy(&payloadChecksum, header + 16, sizeof(payloadChecksum));
+    auto parcel = std::make_unique<Parcel>();
+    status_t status = BAD_VALUE;
+    if (magic == kMagic && version == mVersion && payloadSize == size - kHeaderSize
+            && payloadChecksum == checksum(header + kHeaderSize, payloadSize)) {
+        status = parcel->setData(header + kHeaderSize, payloadSize);
+    }
+    munmap(data, size);
+    if (status != NO_ERROR) {
+        ALOGW("%s: invalid cache %s", __func__, mPath.c_str());
+        return nullptr;
+    }
+
+    const char* fingerprint = parcel->readCString();
+    if (fingerprint == nullptr || getBuildFingerprint() != fingerprint) {
+        ALOGI("%s: cache %s is from another build", __func__, mPath.c_str());
+        return nullptr;
+    }
+    int32_t count = 0;
+    if (parcel->readInt32(&count) != NO_ERROR || count <= 0) {
+        return nullptr;
+    }
+    for (int32_t i = 0; i < count; ++i) {
+        const char* path = parcel->readCString();
+        SourceFile expected;
+        if (path == nullptr
+                || parcel->readInt64(&expected.size) != NO_ERROR
+                || parcel->readInt64(&expected.mtimeNs) != NO_ERROR
+                || parcel->readUint64(&expected.hash) != NO_ERROR) {
+            ALOGW("%s: invalid cache %s", __func__, mPath.c_str());
+            return nullptr;
+        }
+        if (i == 0 && sourceFile != path) {
+            ALOGI("%s: cache %s is for %s", __func__, mPath.c_str(), path);
+            return nullptr;
+        }
+        if (readSourceFile(path, &expected) != expected) {
+            ALOGI("%s: cache %s is stale, %s has changed", __func__, mPath.c_str(), path);
+            return nullptr;
+        }
+    }
+    return parcel;
+}
+
+status_t ConfigCache::store(const std::vector<std::string>& sourceFiles,
+        const std::function<status_t(Parcel*)>& writePayload) const {
+    if (sourceFiles.empty()) {
+        return BAD_VALUE;
+    }
+    Parcel parcel;
+    parcel.writeCString(getBuildFingerprint().c_str());
+    parcel.writeInt32(sourceFiles.size());
+    for (const auto& path : sourceFiles) {
+        const SourceFile file = readSourceFile(path);
+        parcel.writeCString(path.c_str());
+        parcel.writeInt64(file.size);
+        parcel.writeInt64(file.mtimeNs);
+        parcel.writeUint64(file.hash);
+    }
+    if (status_t status = writePayload(&parcel); status != NO_ERROR) {
+        ALOGW("%s: cannot serialize %s: %d", __func__, mPath.c_str(), status);
+        return status;
+    }
+
+    uint8_t header[kHeaderSize];
+    const uint64_t payloadSize = parcel.dataSize();
+    const uint64_t payloadChecksum = checksum(parcel.data(), parcel.dataSize());
+    memcpy(header, &kMagic, sizeof(kMagic));
+    memcpy(header + 4, &mVersion, sizeof(mVersion));
+    memcpy(header + 8, &payloadSize, sizeof(payloadSize));
+    memcpy(header + 16, &payloadChecksum, sizeof(payloadChecksum));
+
+    // Write to a temporary file and rename it, so that a reader never sees
+    // a partially written cache.
+    const std::string tmpPath = mPath + ".tmp";
+    base::unique_fd fd(TEMP_FAILURE_RETRY(
+            open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600)));
+    if (fd < 0) {
+        status_t status = -errno;
+        ALOGW("%s: cannot create %s: %s", __func__, tmpPath.c_str(), strerror(-status));
+        return status;
+    }
+    if (!base::WriteFully(fd, header, sizeof(header))
+            || !base::WriteFully(fd, parcel.data(), parcel.dataSize())) {
+        status_t status = -errno;
+        ALOGW("%s: cannot write %s: %s", __func__, tmpPath.c_str(), strerror(-status));
+        fd.reset();
+        unlink(tmpPath.c_str());
+        return status;
+    }
+    fd.reset();
+    if (rename(tmpPath.c_str(), mPath.c_str()) != 0) {
+        status_t status = -errno;
+        ALOGW("%s: cannot rename %s: %s", __func__, tmpPath.c_str(), strerror(-status));
+        unlink(tmpPath.c_str());
+        return status;
+    }
+    ALOGV("%s: stored %s (%zu bytes)", __func__, mPath.c_str(), parcel.dataSize());
+    return NO_ERROR;
+}
+
+// static
+void ConfigCache::addXIncludedFiles(_xmlDoc* doc, std::vector<std::string>* files) {
+    collectXIncludedFiles(doc, xmlDocGetRootElement(doc), files);
+}
+
+} // namespace android
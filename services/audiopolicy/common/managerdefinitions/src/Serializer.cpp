@@ -21,6 +21,7 @@
 #include <string>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include <libxml/parser.h>
 #include <libxml/xinclude.h>
@@ -29,6 +30,7 @@
 #include <utils/StrongPointer.h>
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
+#include "ConfigCache.h"
 #include "IOProfile.h"
 #include "Serializer.h"
 #include "TypeConverter.h"
@@ -230,7 +232,8 @@ class PolicySerializer
 {
 public:
     status_t deserialize(const char *configFile, AudioPolicyConfig *config,
-            bool ignoreVendorExtensions = false);
+            bool ignoreVendorExtensions = false,
+            std::vector<std::string> *sourceFiles = nullptr);
 
     template <class Trait>
     status_t deserializeCollection(const xmlNode *cur,
@@ -843,7 +846,8 @@ PolicySerializer::deserialize<SurroundSoundFormatTraits>(
 }
 
 status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig *config,
-                                       bool ignoreVendorExtensions)
+                                       bool ignoreVendorExtensions,
+                                       std::vector<std::string> *sourceFiles)
 {
     mIgnoreVendorExtensions = ignoreVendorExtensions;
     auto doc = make_xmlUnique(xmlParseFile(configFile));
@@ -859,6 +863,10 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
     if (xmlXIncludeProcess(doc.get()) < 0) {
         ALOGE("%s: libxml failed to resolve XIncludes on %s document.", __func__, configFile);
     }
+    if (sourceFiles != nullptr) {
+        sourceFiles->push_back(configFile);
+        ConfigCache::addXIncludedFiles(doc.get(), sourceFiles);
+    }
 
     if (xmlStrcmp(root->name, reinterpret_cast<const xmlChar*>(rootName)))  {
         ALOGE("%s: No %s root element found in xml data %s.", __func__, rootName,
@@ -898,10 +906,12 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
 
 }  // namespace
 
-status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config)
+status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config,
+                                    std::vector<std::string> *sourceFiles)
 {
     PolicySerializer serializer;
-    status_t status = serializer.deserialize(fileName, config);
+    status_t status = serializer.deserialize(fileName, config, false /*ignoreVendorExtensions*/,
+                                             sourceFiles);
     return status;
 }
 
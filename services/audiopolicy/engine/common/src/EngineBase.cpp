@@ -138,13 +138,31 @@ engineConfig::ParsingResult EngineBase::loadAudioPolicyEngineConfig(const std::s
         return stat(path, &fileStat) == 0 && S_ISREG(fileStat.st_mode);
     };
     const std::string filePath = xmlFilePath.empty() ? engineConfig::DEFAULT_PATH : xmlFilePath;
-    engineConfig::ParsingResult result =
-            fileExists(filePath.c_str()) ?
-            engineConfig::parse(filePath.c_str()) : engineConfig::ParsingResult{};
+    // Only the default configuration is cached, custom files are usually loaded by tests.
+    // The cache holds the final result, including the fallback and the system volume groups.
+    const bool useCache = xmlFilePath.empty();
+    if (useCache) {
+        engineConfig::ParsingResult result = engineConfig::loadFromCache(
+                engineConfig::DEFAULT_CACHE_PATH, filePath.c_str());
+        if (result.parsedConfig != nullptr) {
+            ALOGE_IF(result.nbSkippedElement != 0, "skipped %zu elements",
+                    result.nbSkippedElement);
+            return processParsingResult(std::move(result));
+        }
+    }
+    std::vector<std::string> sourceFiles;
+    engineConfig::ParsingResult result;
+    if (fileExists(filePath.c_str())) {
+        result = engineConfig::parse(filePath.c_str(), &sourceFiles);
+    } else {
+        // Recorded as missing, adding the file invalidates the cache.
+        sourceFiles.push_back(filePath);
+    }
     if (result.parsedConfig == nullptr) {
         ALOGD("%s: No configuration found, using default matching phone experience.", __FUNCTION__);
         engineConfig::Config config = gDefaultEngineConfig;
-        android::status_t ret = engineConfig::parseLegacyVolumes(config.volumeGroups);
+        android::status_t ret = engineConfig::parseLegacyVolumes(config.volumeGroups,
+                                                                 &sourceFiles);
         result = {std::make_unique<engineConfig::Config>(config),
                   static_cast<size_t>(ret == NO_ERROR ? 0 : 1)};
     } else {
@@ -153,6 +171,9 @@ engineConfig::ParsingResult EngineBase::loadAudioPolicyEngineConfig(const std::s
                     std::end(result.parsedConfig->volumeGroups),
                     std::begin(gSystemVolumeGroups), std::end(gSystemVolumeGroups));
     }
+    if (useCache) {
+        engineConfig::storeToCache(engineConfig::DEFAULT_CACHE_PATH, result, sourceFiles);
+    }
     ALOGE_IF(result.nbSkippedElement != 0, "skipped %zu elements", result.nbSkippedElement);
     return processParsingResult(std::move(result));
 }
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -37,6 +38,9 @@ namespace engineConfig {
 
 /** Default path of audio policy usages configuration file. */
 constexpr char DEFAULT_PATH[] = "/vendor/etc/audio_policy_engine_configuration.xml";
+/** Default path of the binary cache of the configuration loaded from DEFAULT_PATH. */
+constexpr char DEFAULT_CACHE_PATH[] =
+        "/data/misc/audioserver/audio_policy_engine_configuration.cache";
 
 using AttributesVector = std::vector<audio_attributes_t>;
 using StreamVector = std::vector<audio_stream_type_t>;
@@ -113,13 +117,31 @@ struct ParsingResult {
 };
 
 /** Parses the provided audio policy usage configuration.
+ * If sourceFiles is not null, the path of the file and of all the files it includes
+ * are appended to it.
  * @return audio policy usage @see Config
  */
-ParsingResult parse(const char* path = DEFAULT_PATH);
-android::status_t parseLegacyVolumes(VolumeGroups &volumeGroups);
+ParsingResult parse(const char* path = DEFAULT_PATH,
+                    std::vector<std::string>* sourceFiles = nullptr);
+android::status_t parseLegacyVolumes(VolumeGroups &volumeGroups,
+                                     std::vector<std::string>* sourceFiles = nullptr);
 ParsingResult convert(const ::android::media::audio::common::AudioHalEngineConfig& aidlConfig);
 // Exposed for testing.
-android::status_t parseLegacyVolumeFile(const char* path, VolumeGroups &volumeGroups);
+android::status_t parseLegacyVolumeFile(const char* path, VolumeGroups &volumeGroups,
+                                        std::vector<std::string>* sourceFiles = nullptr);
+
+/** Loads a result stored by `storeToCache()`.
+ * @param path the first of the source files the result was stored with.
+ * @return the cached result, with a null parsedConfig if there is no cache for path
+ *         or if any of the source files has changed since.
+ */
+ParsingResult loadFromCache(const char* cachePath, const char* path);
+/** Stores the result of parsing sourceFiles, the first of them being the path to give
+ * to `loadFromCache()`. Files which do not exist are recorded so that adding them
+ * invalidates the cache.
+ */
+android::status_t storeToCache(const char* cachePath, const ParsingResult& result,
+                               const std::vector<std::string>& sourceFiles);
 
 } // namespace engineConfig
 } // namespace android
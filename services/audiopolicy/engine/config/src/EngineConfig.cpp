@@ -27,8 +27,10 @@
 //#define LOG_NDEBUG 0
 
 #include "EngineConfig.h"
+#include <ConfigCache.h>
 #include <TypeConverter.h>
 #include <Volume.h>
+#include <binder/Parcel.h>
 #include <cutils/properties.h>
 #include <libxml/parser.h>
 #include <libxml/xinclude.h>
@@ -737,8 +739,11 @@ private:
 
 }  // namespace
 
-ParsingResult parse(const char* path) {
+ParsingResult parse(const char* path, std::vector<std::string>* sourceFiles) {
     XmlErrorHandler errorHandler;
+    if (sourceFiles != nullptr) {
+        sourceFiles->push_back(path);
+    }
     auto doc = make_xmlUnique(xmlParseFile(path));
     if (doc == NULL) {
         // It is OK not to find an engine config file at the default location
@@ -757,6 +762,9 @@ ParsingResult parse(const char* path) {
         ALOGE("%s: libxml failed to resolve XIncludes on document %s", __FUNCTION__, path);
         return {nullptr, 0};
     }
+    if (sourceFiles != nullptr) {
+        ConfigCache::addXIncludedFiles(doc.get(), sourceFiles);
+    }
     std::string version = getXmlAttribute(cur, gVersionAttribute);
     if (version.empty()) {
         ALOGE("%s: No version found", __func__);
@@ -777,8 +785,12 @@ ParsingResult parse(const char* path) {
     return {std::move(config), nbSkippedElements};
 }
 
-android::status_t parseLegacyVolumeFile(const char* path, VolumeGroups &volumeGroups) {
+android::status_t parseLegacyVolumeFile(const char* path, VolumeGroups &volumeGroups,
+                                        std::vector<std::string>* sourceFiles) {
     XmlErrorHandler errorHandler;
+    if (sourceFiles != nullptr) {
+        sourceFiles->push_back(path);
+    }
     auto doc = make_xmlUnique(xmlParseFile(path));
     if (doc == NULL) {
         ALOGE("%s: Could not parse document %s", __FUNCTION__, path);
@@ -793,14 +805,18 @@ android::status_t parseLegacyVolumeFile(const char* path, VolumeGroups &volumeGr
         ALOGE("%s: libxml failed to resolve XIncludes on document %s", __FUNCTION__, path);
         return BAD_VALUE;
     }
+    if (sourceFiles != nullptr) {
+        ConfigCache::addXIncludedFiles(doc.get(), sourceFiles);
+    }
     size_t nbSkippedElements = 0;
     return deserializeLegacyVolumeCollection(doc.get(), cur, volumeGroups, nbSkippedElements);
 }
 
-android::status_t parseLegacyVolumes(VolumeGroups &volumeGroups) {
+android::status_t parseLegacyVolumes(VolumeGroups &volumeGroups,
+                                     std::vector<std::string>* sourceFiles) {
     if (std::string audioPolicyXmlConfigFile = audio_get_audio_policy_config_file();
             !audioPolicyXmlConfigFile.empty()) {
-        return parseLegacyVolumeFile(audioPolicyXmlConfigFile.c_str(), volumeGroups);
+        return parseLegacyVolumeFile(audioPolicyXmlConfigFile.c_str(), volumeGroups, sourceFiles);
     } else {
         ALOGE("No readable audio policy config file found");
         return BAD_VALUE;
@@ -827,5 +843,192 @@ ParsingResult convert(const ::android::media::audio::common::AudioHalEngineConfi
     return {.parsedConfig=std::move(config), .nbSkippedElement=0};
  }
 
+namespace {
+
+// The version of the payload of the configuration cache. Must be changed whenever
+// the serialization below changes.
+constexpr uint32_t kCacheVersion = 1;
+
+status_t readString(const Parcel& parcel, std::string* str) {
+    const char* cstr = parcel.readCString();
+    if (cstr == nullptr) {
+        return BAD_VALUE;
+    }
+    *str = cstr;
+    return NO_ERROR;
+}
+
+template <typename T, typename WriteElement>
+status_t writeCollection(const std::vector<T>& collection, Parcel* parcel,
+                         WriteElement writeElement) {
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(collection.size()));
+    for (const auto& element : collection) {
+        RETURN_STATUS_IF_ERROR(writeElement(element));
+    }
+    return NO_ERROR;
+}
+
+template <typename T, typename ReadElement>
+status_t readCollection(const Parcel& parcel, std::vector<T>* collection,
+                        ReadElement readElement) {
+    int32_t count = 0;
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&count));
+    for (int32_t i = 0; i < count; ++i) {
+        T element{};
+        RETURN_STATUS_IF_ERROR(readElement(&element));
+        collection->push_back(std::move(element));
+    }
+    return NO_ERROR;
+}
+
+status_t writeConfig(const Config& config, Parcel* parcel) {
+    RETURN_STATUS_IF_ERROR(parcel->writeFloat(config.version));
+    RETURN_STATUS_IF_ERROR(writeCollection(config.productStrategies, parcel,
+            [parcel](const ProductStrategy& strategy) {
+        RETURN_STATUS_IF_ERROR(parcel->writeCString(strategy.name.c_str()));
+        return writeCollection(strategy.attributesGroups, parcel,
+                [parcel](const AttributesGroup& group) {
+            RETURN_STATUS_IF_ERROR(parcel->writeInt32(group.stream));
+            RETURN_STATUS_IF_ERROR(parcel->writeCString(group.volumeGroup.c_str()));
+            return writeCollection(group.attributesVect, parcel,
+                    [parcel](const audio_attributes_t& attributes) {
+                RETURN_STATUS_IF_ERROR(parcel->writeInt32(attributes.content_type));
+                RETURN_STATUS_IF_ERROR(parcel->writeInt32(attributes.usage));
+                RETURN_STATUS_IF_ERROR(parcel->writeInt32(attributes.source));
+                RETURN_STATUS_IF_ERROR(parcel->writeUint32(attributes.flags));
+                return parcel->writeCString(attributes.tags);
+            });
+        });
+    }));
+    RETURN_STATUS_IF_ERROR(writeCollection(config.criteria, parcel,
+            [parcel](const Criterion& criterion) {
+        RETURN_STATUS_IF_ERROR(parcel->writeCString(criterion.name.c_str()));
+        RETURN_STATUS_IF_ERROR(parcel->writeCString(criterion.typeName.c_str()));
+        return parcel->writeCString(criterion.defaultLiteralValue.c_str());
+    }));
+    RETURN_STATUS_IF_ERROR(writeCollection(config.criterionTypes, parcel,
+            [parcel](const CriterionType& criterionType) {
+        RETURN_STATUS_IF_ERROR(parcel->writeCString(criterionType.name.c_str()));
+        RETURN_STATUS_IF_ERROR(parcel->writeBool(criterionType.isInclusive));
+        return writeCollection(criterionType.valuePairs, parcel,
+                [parcel](const ValuePair& valuePair) {
+            RETURN_STATUS_IF_ERROR(parcel->writeUint64(std::get<0>(valuePair)));
+            RETURN_STATUS_IF_ERROR(parcel->writeUint32(std::get<1>(valuePair)));
+            return parcel->writeCString(std::get<2>(valuePair).c_str());
+        });
+    }));
+    return writeCollection(config.volumeGroups, parcel,
+            [parcel](const VolumeGroup& volumeGroup) {
+        RETURN_STATUS_IF_ERROR(parcel->writeCString(volumeGroup.name.c_str()));
+        RETURN_STATUS_IF_ERROR(parcel->writeInt32(volumeGroup.indexMin));
+        RETURN_STATUS_IF_ERROR(parcel->writeInt32(volumeGroup.indexMax));
+        return writeCollection(volumeGroup.volumeCurves, parcel,
+                [parcel](const VolumeCurve& curve) {
+            RETURN_STATUS_IF_ERROR(parcel->writeCString(curve.deviceCategory.c_str()));
+            return writeCollection(curve.curvePoints, parcel,
+                    [parcel](const CurvePoint& point) {
+                RETURN_STATUS_IF_ERROR(parcel->writeInt32(point.index));
+                return parcel->writeInt32(point.attenuationInMb);
+            });
+        });
+    });
+}
+
+status_t readConfig(const Parcel& parcel, Config* config) {
+    RETURN_STATUS_IF_ERROR(parcel.readFloat(&config->version));
+    RETURN_STATUS_IF_ERROR(readCollection(parcel, &config->productStrategies,
+            [&parcel](ProductStrategy* strategy) {
+        RETURN_STATUS_IF_ERROR(readString(parcel, &strategy->name));
+        return readCollection(parcel, &strategy->attributesGroups,
+                [&parcel](AttributesGroup* group) {
+            int32_t stream = AUDIO_STREAM_DEFAULT;
+            RETURN_STATUS_IF_ERROR(parcel.readInt32(&stream));
+            group->stream = static_cast<audio_stream_type_t>(stream);
+            RETURN_STATUS_IF_ERROR(readString(parcel, &group->volumeGroup));
+            return readCollection(parcel, &group->attributesVect,
+                    [&parcel](audio_attributes_t* attributes) -> status_t {
+                int32_t contentType, usage, source;
+                RETURN_STATUS_IF_ERROR(parcel.readInt32(&contentType));
+                RETURN_STATUS_IF_ERROR(parcel.readInt32(&usage));
+                RETURN_STATUS_IF_ERROR(parcel.readInt32(&source));
+                *attributes = AUDIO_ATTRIBUTES_INITIALIZER;
+                attributes->content_type = static_cast<audio_content_type_t>(contentType);
+                attributes->usage = static_cast<audio_usage_t>(usage);
+                attributes->source = static_cast<audio_source_t>(source);
+                uint32_t flags = AUDIO_FLAG_NONE;
+                RETURN_STATUS_IF_ERROR(parcel.readUint32(&flags));
+                attributes->flags = static_cast<audio_flags_mask_t>(flags);
+                const char* tags = parcel.readCString();
+                if (tags == nullptr) {
+                    return BAD_VALUE;
+                }
+                strlcpy(attributes->tags, tags, AUDIO_ATTRIBUTES_TAGS_MAX_SIZE);
+                return NO_ERROR;
+            });
+        });
+    }));
+    RETURN_STATUS_IF_ERROR(readCollection(parcel, &config->criteria,
+            [&parcel](Criterion* criterion) {
+        RETURN_STATUS_IF_ERROR(readString(parcel, &criterion->name));
+        RETURN_STATUS_IF_ERROR(readString(parcel, &criterion->typeName));
+        return readString(parcel, &criterion->defaultLiteralValue);
+    }));
+    RETURN_STATUS_IF_ERROR(readCollection(parcel, &config->criterionTypes,
+            [&parcel](CriterionType* criterionType) {
+        RETURN_STATUS_IF_ERROR(readString(parcel, &criterionType->name));
+        RETURN_STATUS_IF_ERROR(parcel.readBool(&criterionType->isInclusive));
+        return readCollection(parcel, &criterionType->valuePairs,
+                [&parcel](ValuePair* valuePair) {
+            RETURN_STATUS_IF_ERROR(parcel.readUint64(&std::get<0>(*valuePair)));
+            RETURN_STATUS_IF_ERROR(parcel.readUint32(&std::get<1>(*valuePair)));
+            return readString(parcel, &std::get<2>(*valuePair));
+        });
+    }));
+    return readCollection(parcel, &config->volumeGroups,
+            [&parcel](VolumeGroup* volumeGroup) {
+        RETURN_STATUS_IF_ERROR(readString(parcel, &volumeGroup->name));
+        RETURN_STATUS_IF_ERROR(parcel.readInt32(&volumeGroup->indexMin));
+        RETURN_STATUS_IF_ERROR(parcel.readInt32(&volumeGroup->indexMax));
+        return readCollection(parcel, &volumeGroup->volumeCurves,
+                [&parcel](VolumeCurve* curve) {
+            RETURN_STATUS_IF_ERROR(readString(parcel, &curve->deviceCategory));
+            return readCollection(parcel, &curve->curvePoints,
+                    [&parcel](CurvePoint* point) {
+                RETURN_STATUS_IF_ERROR(parcel.readInt32(&point->index));
+                return parcel.readInt32(&point->attenuationInMb);
+            });
+        });
+    });
+}
+
+}  // namespace
+
+ParsingResult loadFromCache(const char* cachePath, const char* path) {
+    std::unique_ptr<Parcel> parcel = ConfigCache(cachePath, kCacheVersion).load(path);
+    if (parcel == nullptr) {
+        return {nullptr, 0};
+    }
+    auto config = std::make_unique<Config>();
+    uint64_t nbSkippedElement = 0;
+    if (readConfig(*parcel, config.get()) != NO_ERROR
+            || parcel->readUint64(&nbSkippedElement) != NO_ERROR) {
+        ALOGW("%s: invalid cache %s", __func__, cachePath);
+        return {nullptr, 0};
+    }
+    return {std::move(config), static_cast<size_t>(nbSkippedElement)};
+}
+
+android::status_t storeToCache(const char* cachePath, const ParsingResult& result,
+                               const std::vector<std::string>& sourceFiles) {
+    if (result.parsedConfig == nullptr) {
+        return BAD_VALUE;
+    }
+    return ConfigCache(cachePath, kCacheVersion).store(sourceFiles,
+            [&result](Parcel* parcel) {
+        RETURN_STATUS_IF_ERROR(writeConfig(*result.parsedConfig, parcel));
+        return parcel->writeUint64(result.nbSkippedElement);
+    });
+}
+
 } // namespace engineConfig
 } // namespace android
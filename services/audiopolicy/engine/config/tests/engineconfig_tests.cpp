@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <cstring>
+
 #include <gtest/gtest.h>
 
 #define LOG_TAG "APM_Test"
@@ -38,3 +40,54 @@ TEST(EngineConfigTestInit, LegacyVolumeGroupsLoadingIsTransactional) {
     ASSERT_EQ(NO_ERROR, status);
     EXPECT_FALSE(groups.empty());
 }
+
+TEST(EngineConfigTestInit, LoadFromCache) {
+    TemporaryDir tempDir;
+    const std::string path = std::string(tempDir.path) + "/test_apm_volume_tables.xml";
+    const std::string cachePath = std::string(tempDir.path) + "/engine_configuration.cache";
+    std::string xml;
+    ASSERT_TRUE(base::ReadFileToString(
+            base::GetExecutableDirectory() + "/test_apm_volume_tables.xml", &xml));
+    ASSERT_TRUE(base::WriteStringToFile(xml, path));
+    EXPECT_EQ(nullptr,
+            engineConfig::loadFromCache(cachePath.c_str(), path.c_str()).parsedConfig);
+
+    auto config = std::make_unique<engineConfig::Config>();
+    config->version = 1.0f;
+    std::vector<std::string> sourceFiles;
+    ASSERT_EQ(NO_ERROR, engineConfig::parseLegacyVolumeFile(
+            path.c_str(), config->volumeGroups, &sourceFiles));
+    EXPECT_EQ(std::vector<std::string>{path}, sourceFiles);
+    audio_attributes_t attributes = AUDIO_ATTRIBUTES_INITIALIZER;
+    attributes.usage = AUDIO_USAGE_MEDIA;
+    strlcpy(attributes.tags, "oem=1", AUDIO_ATTRIBUTES_TAGS_MAX_SIZE);
+    config->productStrategies.push_back(
+            {"STRATEGY_MEDIA", {{AUDIO_STREAM_MUSIC, "music", {attributes}}}});
+    config->criterionTypes.push_back({"OutputDevicesMaskType", true, {{2, 0, "Speaker"}}});
+    config->criteria.push_back({"AvailableOutputDevices", "OutputDevicesMaskType", "Speaker"});
+    const engineConfig::ParsingResult result{std::move(config), 1};
+    ASSERT_EQ(NO_ERROR, engineConfig::storeToCache(cachePath.c_str(), result, sourceFiles));
+
+    engineConfig::ParsingResult cached =
+            engineConfig::loadFromCache(cachePath.c_str(), path.c_str());
+    ASSERT_NE(nullptr, cached.parsedConfig);
+    EXPECT_EQ(1u, cached.nbSkippedElement);
+    ASSERT_EQ(1u, cached.parsedConfig->productStrategies.size());
+    EXPECT_EQ(AUDIO_USAGE_MEDIA,
+            cached.parsedConfig->productStrategies[0].attributesGroups[0].attributesVect[0].usage);
+    // Storing the cached result again must give the same file if nothing was lost.
+    const std::string cachePath2 = std::string(tempDir.path) + "/engine_configuration2.cache";
+    ASSERT_EQ(NO_ERROR, engineConfig::storeToCache(cachePath2.c_str(), cached, sourceFiles));
+    std::string cacheContent, cacheContent2;
+    ASSERT_TRUE(base::ReadFileToString(cachePath, &cacheContent));
+    ASSERT_TRUE(base::ReadFileToString(cachePath2, &cacheContent2));
+    EXPECT_EQ(cacheContent, cacheContent2);
+
+    // The cache is only valid for its first source file, and while it is unchanged.
+    EXPECT_EQ(nullptr, engineConfig::loadFromCache(cachePath.c_str(),
+            (base::GetExecutableDirectory() + "/test_apm_volume_tables.xml").c_str())
+                    .parsedConfig);
+    ASSERT_TRUE(base::WriteStringToFile(xml + "<!-- updated -->\n", path));
+    EXPECT_EQ(nullptr,
+            engineConfig::loadFromCache(cachePath.c_str(), path.c_str()).parsedConfig);
+}
@@ -1607,8 +1607,8 @@ audio_io_handle_t AudioPolicyManager::getOutputForDevices(
     if (audio_is_linear_pcm(config->format)) {
         // get which output is suitable for the specified stream. The actual
         // routing change will happen when startOutput() will be called
-        SortedVector<audio_io_handle_t> outputs = getOutputsForDevices(devices, mOutputs);
         if (prefMixerConfigInfo != nullptr) {
+            SortedVector<audio_io_handle_t> outputs = getOutputsForDevices(devices, mOutputs);
             for (audio_io_handle_t outputHandle : outputs) {
                 sp<SwAudioOutputDescriptor> outputDesc = mOutputs.valueFor(outputHandle);
                 if (outputDesc->mProfile == prefMixerConfigInfo->getProfile()) {
@@ -1635,8 +1635,8 @@ audio_io_handle_t AudioPolicyManager::getOutputForDevices(
             // at this stage we should ignore the DIRECT flag as no direct output could be
             // found earlier
             *flags = (audio_output_flags_t) (*flags & ~AUDIO_OUTPUT_FLAG_DIRECT);
-            output = selectOutput(
-                    outputs, *flags, config->format, channelMask, config->sample_rate, session);
+            output = selectOutputForDevices(
+                    devices, *flags, config->format, channelMask, config->sample_rate, session);
         }
     }
     ALOGW_IF((output == 0), "getOutputForDevices() could not find output for stream %d, "
@@ -2087,6 +2087,52 @@ audio_io_handle_t AudioPolicyManager::selectOutput(const SortedVector<audio_io_h
     return bestOutput;
 }
 
+audio_io_handle_t AudioPolicyManager::selectOutputForDevices(const DeviceVector &devices,
+                                                             audio_output_flags_t flags,
+                                                             audio_format_t format,
+                                                             audio_channel_mask_t channelMask,
+                                                             uint32_t samplingRate,
+                                                             audio_session_t sessionId)
+{
+    // The output of a haptic-generating effect depends on the session, see selectOutput().
+    if (sessionId != AUDIO_SESSION_NONE &&
+            mEffects.getIoForSession(sessionId, FX_IID_HAPTICGENERATOR) != AUDIO_IO_HANDLE_NONE) {
+        return selectOutput(getOutputsForDevices(devices, mOutputs),
+                            flags, format, channelMask, samplingRate, sessionId);
+    }
+
+    if (mOutputSelectionCacheGeneration != mOutputSelectionGeneration) {
+        mOutputSelectionCache.clear();
+        mOutputSelectionCacheGeneration = mOutputSelectionGeneration;
+    }
+    std::vector<audio_port_handle_t> deviceIds;
+    deviceIds.reserve(devices.size());
+    for (const auto& device : devices) {
+        deviceIds.push_back(device->getId());
+    }
+    OutputSelectionKey key{.deviceIds = std::move(deviceIds), .flags = flags, .format = format,
+                           .channelMask = channelMask, .samplingRate = samplingRate};
+    if (auto it = mOutputSelectionCache.find(key); it != mOutputSelectionCache.end()
+            && (it->second == AUDIO_IO_HANDLE_NONE || mOutputs.indexOfKey(it->second) >= 0)) {
+        mOutputSelectionCacheHits++;
+        return it->second;
+    }
+    mOutputSelectionCacheMisses++;
+
+    const audio_io_handle_t output = selectOutput(getOutputsForDevices(devices, mOutputs),
+                                                  flags, format, channelMask, samplingRate);
+    if (mOutputSelectionCache.size() >= kMaxOutputSelectionCacheSize) {
+        mOutputSelectionCache.clear();
+    }
+    mOutputSelectionCache[std::move(key)] = output;
+    return output;
+}
+
+void AudioPolicyManager::invalidateOutputSelectionCache()
+{
+    mOutputSelectionGeneration++;
+}
+
 status_t AudioPolicyManager::startOutput(audio_port_handle_t portId)
 {
     ALOGV("%s portId %d", __FUNCTION__, portId);
@@ -4177,6 +4223,9 @@ void AudioPolicyManager::dump(String8 *dst) const
     dst->appendFormat(" Master mono: %s\n", mMasterMono ? "on" : "off");
     dst->appendFormat(" Communication Strategy id: %d\n", mCommunnicationStrategy);
     dst->appendFormat(" Config source: %s\n", mConfig->getSource().c_str());
+    dst->appendFormat(" Output selection cache: %zu entries, %" PRIu64 " hits, %" PRIu64
+                      " misses\n", mOutputSelectionCache.size(), mOutputSelectionCacheHits,
+                      mOutputSelectionCacheMisses);
 
     dst->append("\n");
     mAvailableOutputDevices.dump(dst, String8("Available output"), 1);
@@ -6331,6 +6380,7 @@ void AudioPolicyManager::addOutput(audio_io_handle_t output,
                                    const sp<SwAudioOutputDescriptor>& outputDesc)
 {
     mOutputs.add(output, outputDesc);
+    invalidateOutputSelectionCache();
     applyStreamVolumes(outputDesc, DeviceTypeSet(), 0 /* delayMs */, true /* force */);
     updateMono(output); // update mono status when adding to output list
     selectOutputForMusicEffects();
@@ -6344,6 +6394,7 @@ void AudioPolicyManager::removeOutput(audio_io_handle_t output)
         mPrimaryOutput = nullptr;
     }
     mOutputs.removeItem(output);
+    invalidateOutputSelectionCache();
     selectOutputForMusicEffects();
 }
 
@@ -7298,6 +7349,7 @@ void AudioPolicyManager::updateDevicesAndOutputs()
 {
     mEngine->updateDeviceSelectionCache();
     mPreviousOutputs = mOutputs;
+    invalidateOutputSelectionCache();
 }
 
 uint32_t AudioPolicyManager::checkDeviceMuteStrategies(const sp<AudioOutputDescriptor>& outputDesc,
@@ -18,8 +18,11 @@
 
 #include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
+#include <tuple>
 #include <unordered_set>
+#include <vector>
 
 #include <stdint.h>
 #include <sys/types.h>
@@ -770,6 +773,21 @@ protected:
                                        audio_channel_mask_t channelMask = AUDIO_CHANNEL_NONE,
                                        uint32_t samplingRate = 0,
                                        audio_session_t sessionId = AUDIO_SESSION_NONE);
+        /**
+         * @brief selectOutputForDevices same as selectOutput() applied to the outputs returned
+         *      by getOutputsForDevices(devices, mOutputs), memoized in mOutputSelectionCache.
+         *      Only mixed PCM outputs are considered: must be called once no direct output
+         *      could be opened for the request.
+         */
+        audio_io_handle_t selectOutputForDevices(const DeviceVector &devices,
+                                                 audio_output_flags_t flags,
+                                                 audio_format_t format,
+                                                 audio_channel_mask_t channelMask,
+                                                 uint32_t samplingRate,
+                                                 audio_session_t sessionId);
+        // Drops the memoized output selections, must be called whenever the open outputs or the
+        // devices they can reach change.
+        void invalidateOutputSelectionCache();
         // samplingRate, format, channelMask are in/out and so may be modified
         sp<IOProfile> getInputProfile(const sp<DeviceDescriptor> & device,
                                       uint32_t& samplingRate,
@@ -1001,6 +1019,31 @@ protected:
                  std::map<product_strategy_t,
                           sp<PreferredMixerAttributesInfo>>> mPreferredMixerAttrInfos;
 
+        // Output selected for the mixed output path of getOutputForDevices(), for a given set of
+        // devices and client configuration. The selection only depends on the open outputs and
+        // on the devices they support, so entries are valid until the generation is bumped by
+        // invalidateOutputSelectionCache().
+        struct OutputSelectionKey {
+            std::vector<audio_port_handle_t> deviceIds;
+            audio_output_flags_t flags;
+            audio_format_t format;
+            audio_channel_mask_t channelMask;
+            uint32_t samplingRate;
+
+            bool operator<(const OutputSelectionKey& other) const {
+                return std::tie(deviceIds, flags, format, channelMask, samplingRate) <
+                        std::tie(other.deviceIds, other.flags, other.format, other.channelMask,
+                                other.samplingRate);
+            }
+        };
+        // Bounds the cache in case of clients iterating over configurations.
+        static constexpr size_t kMaxOutputSelectionCacheSize = 64;
+        std::map<OutputSelectionKey, audio_io_handle_t> mOutputSelectionCache;
+        uint32_t mOutputSelectionGeneration = 0;
+        uint32_t mOutputSelectionCacheGeneration = 0;
+        uint64_t mOutputSelectionCacheHits = 0;
+        uint64_t mOutputSelectionCacheMisses = 0;
+
         // Support for Multi-Stream Decoder (MSD) module
         sp<DeviceDescriptor> getMsdAudioInDevice() const;
         DeviceVector getMsdAudioOutDevices() const;
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+
+#include <AudioPolicyConfig.h>
+#include <EngineConfig.h>
+
+using namespace android;
+
+static const std::vector<std::string> kApmConfigFiles = {
+        "audio_policy_configuration_generic.xml",
+        "audio_policy_configuration_generic_tv.xml",
+};
+
+/*
+ * Loads the audio policy configuration of the generic phone and TV devices, by parsing the
+ * XML files or from the binary cache, like the audio server does on start.
+ *
+ * $ adb shell /data/benchmarktest/audiopolicy_config_benchmark/audiopolicy_config_benchmark
+ * Args: config file index, cached
+ */
+static void BM_LoadApmConfig(benchmark::State& state) {
+    const std::string& fileName = kApmConfigFiles[state.range(0)];
+    const bool cached = state.range(1) != 0;
+    const std::string path = base::GetExecutableDirectory() + "/" + fileName;
+
+    TemporaryDir tempDir;
+    const std::string cachePath = cached ? std::string(tempDir.path) + "/apm.cache" : "";
+    if (cached && !AudioPolicyConfig::loadFromCustomXmlConfigForTests(path, cachePath).ok()) {
+        state.SkipWithError("Could not parse the configuration");
+        return;
+    }
+
+    for (auto _ : state) {
+        auto result = AudioPolicyConfig::loadFromCustomXmlConfigForTests(path, cachePath);
+        if (!result.ok() || result.value()->isLoadedFromCache() != cached) {
+            state.SkipWithError("Could not load the configuration");
+            break;
+        }
+        benchmark::DoNotOptimize(result.value().get());
+    }
+    state.SetLabel(fileName + (cached ? " cache" : " xml"));
+}
+
+BENCHMARK(BM_LoadApmConfig)->ArgsProduct({{0, 1}, {0, 1}});
+
+/*
+ * Loads the engine configuration of the phone example, and for TV, which has no engine
+ * configuration file, the volume tables of its audio policy configuration.
+ *
+ * Args: tv, cached
+ */
+static void BM_LoadEngineConfig(benchmark::State& state) {
+    const bool tv = state.range(0) != 0;
+    const bool cached = state.range(1) != 0;
+    const std::string path = base::GetExecutableDirectory() + (tv ?
+            "/audio_policy_configuration_generic_tv.xml" :
+            "/phone/audio_policy_engine_configuration.xml");
+    auto parse = [&](std::vector<std::string>* sourceFiles) -> engineConfig::ParsingResult {
+        if (!tv) {
+            return engineConfig::parse(path.c_str(), sourceFiles);
+        }
+        auto config = std::make_unique<engineConfig::Config>();
+        if (engineConfig::parseLegacyVolumeFile(
+                        path.c_str(), config->volumeGroups, sourceFiles) != NO_ERROR) {
+            return {nullptr, 0};
+        }
+        return {std::move(config), 0};
+    };
+
+    TemporaryDir tempDir;
+    const std::string cachePath = std::string(tempDir.path) + "/engine.cache";
+    if (cached) {
+        std::vector<std::string> sourceFiles;
+        if (engineConfig::storeToCache(cachePath.c_str(), parse(&sourceFiles), sourceFiles)
+                != NO_ERROR) {
+            state.SkipWithError("Could not parse the configuration");
+            return;
+        }
+    }
+
+    for (auto _ : state) {
+        engineConfig::ParsingResult result = cached ?
+                engineConfig::loadFromCache(cachePath.c_str(), path.c_str()) : parse(nullptr);
+        if (result.parsedConfig == nullptr) {
+            state.SkipWithError("Could not load the configuration");
+            break;
+        }
+        benchmark::DoNotOptimize(result.parsedConfig.get());
+    }
+    state.SetLabel(std::string(tv ? "tv" : "phone") + (cached ? " cache" : " xml"));
+}
+
+BENCHMARK(BM_LoadEngineConfig)->ArgsProduct({{0, 1}, {0, 1}});
+
+BENCHMARK_MAIN();
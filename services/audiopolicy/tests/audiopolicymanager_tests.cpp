@@ -16,6 +16,7 @@
 
 #include <cstring>
 #include <memory>
+#include <set>
 #include <string>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -124,6 +125,100 @@ TEST(AudioPolicyConfigTest, LoadForTests) {
     }
 }
 
+namespace {
+
+std::set<std::string> getTagNames(const DeviceVector& devices) {
+    std::set<std::string> tagNames;
+    for (const auto& device : devices) {
+        tagNames.insert(device->getTagName());
+    }
+    return tagNames;
+}
+
+template <typename Port>
+media::AudioPortFw toAudioPortFw(const sp<Port>& port) {
+    media::AudioPortFw fwPort;
+    EXPECT_EQ(NO_ERROR, port->writeToParcelable(&fwPort));
+    return fwPort;
+}
+
+void expectEqualMixPorts(const IOProfileCollection& expected, const IOProfileCollection& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(toAudioPortFw(expected[i]), toAudioPortFw(actual[i])) << expected[i]->getName();
+        EXPECT_EQ(getTagNames(expected[i]->getSupportedDevices()),
+                getTagNames(actual[i]->getSupportedDevices())) << expected[i]->getName();
+    }
+}
+
+// Device vectors are sorted by address, so devices are matched by their tag name.
+void expectEqualConfigs(const AudioPolicyConfig& expected, const AudioPolicyConfig& actual) {
+    EXPECT_EQ(expected.getEngineLibraryNameSuffix(), actual.getEngineLibraryNameSuffix());
+    EXPECT_EQ(expected.isCallScreenModeSupported(), actual.isCallScreenModeSupported());
+    EXPECT_EQ(expected.getSurroundFormats(), actual.getSurroundFormats());
+    EXPECT_EQ(getTagNames(expected.getOutputDevices()), getTagNames(actual.getOutputDevices()));
+    EXPECT_EQ(getTagNames(expected.getInputDevices()), getTagNames(actual.getInputDevices()));
+    ASSERT_NE(nullptr, actual.getDefaultOutputDevice());
+    EXPECT_EQ(expected.getDefaultOutputDevice()->getTagName(),
+            actual.getDefaultOutputDevice()->getTagName());
+    ASSERT_EQ(expected.getHwModules().size(), actual.getHwModules().size());
+    for (size_t i = 0; i < expected.getHwModules().size(); ++i) {
+        const sp<HwModule>& expectedModule = expected.getHwModules()[i];
+        const sp<HwModule>& actualModule = actual.getHwModules()[i];
+        SCOPED_TRACE(expectedModule->getName());
+        EXPECT_STREQ(expectedModule->getName(), actualModule->getName());
+        EXPECT_EQ(expectedModule->getHalVersionMajor(), actualModule->getHalVersionMajor());
+        EXPECT_EQ(expectedModule->getHalVersionMinor(), actualModule->getHalVersionMinor());
+        expectEqualMixPorts(expectedModule->getOutputProfiles(),
+                actualModule->getOutputProfiles());
+        expectEqualMixPorts(expectedModule->getInputProfiles(), actualModule->getInputProfiles());
+        ASSERT_EQ(expectedModule->getDeclaredDevices().size(),
+                actualModule->getDeclaredDevices().size());
+        for (const auto& expectedDevice : expectedModule->getDeclaredDevices()) {
+            sp<DeviceDescriptor> actualDevice = actualModule->getDeclaredDevices()
+                    .getDeviceFromTagName(expectedDevice->getTagName());
+            ASSERT_NE(nullptr, actualDevice) << expectedDevice->getTagName();
+            EXPECT_EQ(toAudioPortFw(expectedDevice), toAudioPortFw(actualDevice))
+                    << expectedDevice->getTagName();
+        }
+        EXPECT_EQ(expectedModule->getRoutes().size(), actualModule->getRoutes().size());
+    }
+}
+
+}  // namespace
+
+TEST(AudioPolicyConfigTest, LoadFromCache) {
+    TemporaryDir tempDir;
+    const std::string source = std::string(tempDir.path) + "/test_audio_policy_configuration.xml";
+    const std::string cache = std::string(tempDir.path) + "/test_audio_policy_configuration.cache";
+    std::string xml;
+    ASSERT_TRUE(base::ReadFileToString(
+            base::GetExecutableDirectory() + "/test_audio_policy_configuration.xml", &xml));
+    ASSERT_TRUE(base::WriteStringToFile(xml, source));
+
+    auto parsed = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source);
+    ASSERT_TRUE(parsed.ok());
+    auto stored = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source, cache);
+    ASSERT_TRUE(stored.ok());
+    EXPECT_FALSE(stored.value()->isLoadedFromCache());
+    ASSERT_EQ(0, access(cache.c_str(), R_OK));
+
+    auto cached = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source, cache);
+    ASSERT_TRUE(cached.ok());
+    EXPECT_TRUE(cached.value()->isLoadedFromCache());
+    EXPECT_EQ(source, cached.value()->getSource());
+    expectEqualConfigs(*parsed.value(), *cached.value());
+
+    // A change of the XML file invalidates the cache, which is then updated.
+    ASSERT_TRUE(base::WriteStringToFile(xml + "<!-- updated -->\n", source));
+    auto reparsed = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source, cache);
+    ASSERT_TRUE(reparsed.ok());
+    EXPECT_FALSE(reparsed.value()->isLoadedFromCache());
+    auto recached = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source, cache);
+    ASSERT_TRUE(recached.ok());
+    EXPECT_TRUE(recached.value()->isLoadedFromCache());
+}
+
 TEST(AudioPolicyManagerTestInit, EngineFailure) {
     AudioPolicyTestClient client;
     auto config = AudioPolicyConfig::createWritableForTests();
@@ -940,6 +1035,37 @@ TEST_F(AudioPolicyManagerTestWithConfigurationFile, Dump) {
     dumpToLog();
 }
 
+TEST_F(AudioPolicyManagerTestWithConfigurationFile, OutputSelectionIsMemoized) {
+    audio_port_handle_t selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    audio_io_handle_t output = AUDIO_IO_HANDLE_NONE;
+    const audio_attributes_t attr = {
+        .content_type = AUDIO_CONTENT_TYPE_MUSIC, .usage = AUDIO_USAGE_MEDIA};
+    ASSERT_NO_FATAL_FAILURE(getOutputForAttr(&selectedDeviceId, AUDIO_FORMAT_PCM_16_BIT,
+            AUDIO_CHANNEL_OUT_STEREO, 48000, AUDIO_OUTPUT_FLAG_NONE, &output, nullptr, attr));
+    const uint64_t misses = mManager->getOutputSelectionCacheMisses();
+    const uint64_t hits = mManager->getOutputSelectionCacheHits();
+
+    // Same request: the output selection is served from the cache.
+    audio_io_handle_t cachedOutput = AUDIO_IO_HANDLE_NONE;
+    selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    ASSERT_NO_FATAL_FAILURE(getOutputForAttr(&selectedDeviceId, AUDIO_FORMAT_PCM_16_BIT,
+            AUDIO_CHANNEL_OUT_STEREO, 48000, AUDIO_OUTPUT_FLAG_NONE, &cachedOutput, nullptr,
+            attr));
+    EXPECT_EQ(output, cachedOutput);
+    EXPECT_EQ(hits + 1, mManager->getOutputSelectionCacheHits());
+    EXPECT_EQ(misses, mManager->getOutputSelectionCacheMisses());
+
+    // A routing change invalidates the cache.
+    mManager->setForceUse(AUDIO_POLICY_FORCE_FOR_MEDIA, AUDIO_POLICY_FORCE_NO_BT_A2DP);
+    selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    ASSERT_NO_FATAL_FAILURE(getOutputForAttr(&selectedDeviceId, AUDIO_FORMAT_PCM_16_BIT,
+            AUDIO_CHANNEL_OUT_STEREO, 48000, AUDIO_OUTPUT_FLAG_NONE, &cachedOutput, nullptr,
+            attr));
+    EXPECT_EQ(output, cachedOutput);
+    EXPECT_EQ(hits + 1, mManager->getOutputSelectionCacheHits());
+    EXPECT_EQ(misses + 1, mManager->getOutputSelectionCacheMisses());
+}
+
 TEST_F(AudioPolicyManagerTestWithConfigurationFile, ListAudioPortsHasFlags) {
     // Create an input for VOIP TX because it's not opened automatically like outputs are.
     audio_port_handle_t selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
@@ -278,7 +278,7 @@ status_t DistortionMapper::mapRawToCorrected(int32_t *coordPairs, int coordCount
     }
 
     for (int i = 0; i < coordCount * 2; i += 2) {
-        const GridQuad *quad = findEnclosingQuad(coordPairs + i, mapperInfo->mDistortedGrid);
+        const GridQuad *quad = findEnclosingQuad(coordPairs + i, *mapperInfo);
         if (quad == nullptr) {
             ALOGE("Raw to corrected mapping failure: No quad found for (%d, %d)",
                     *(coordPairs + i), *(coordPairs + i + 1));
@@ -487,48 +487,141 @@ status_t DistortionMapper::buildGrids(DistortionMapperInfo *mapperInfo) {
             if (res != OK) return res;
         }
     }
+    buildQuadIndex(mapperInfo);
 
     mapperInfo->mValidGrids = true;
     return OK;
 }
 
+void DistortionMapper::buildQuadIndex(DistortionMapperInfo *mapperInfo) {
+    const std::vector<GridQuad>& grid = mapperInfo->mDistortedGrid;
+
+    // Bounding boxes of the quads, and of the whole grid
+    std::vector<std::array<float, 4>> bounds(grid.size());
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    for (size_t i = 0; i < grid.size(); i++) {
+        const std::array<float, 8>& coords = grid[i].coords;
+        bounds[i] = {
+            std::min({coords[0], coords[2], coords[4], coords[6]}) - kQuadIndexMargin,
+            std::min({coords[1], coords[3], coords[5], coords[7]}) - kQuadIndexMargin,
+            std::max({coords[0], coords[2], coords[4], coords[6]}) + kQuadIndexMargin,
+            std::max({coords[1], coords[3], coords[5], coords[7]}) + kQuadIndexMargin
+        };
+        minX = std::min(minX, bounds[i][0]);
+        minY = std::min(minY, bounds[i][1]);
+        maxX = std::max(maxX, bounds[i][2]);
+        maxY = std::max(maxY, bounds[i][3]);
+    }
+    mapperInfo->mQuadIndexX = minX;
+    mapperInfo->mQuadIndexY = minY;
+    mapperInfo->mQuadIndexInvCellWidth = kQuadIndexSize / (maxX - minX);
+    mapperInfo->mQuadIndexInvCellHeight = kQuadIndexSize / (maxY - minY);
+
+    // Cells overlapped by each quad. quadIndexCell() is monotonic, so the cell of any point
+    // within the bounding box of a quad is in this range.
+    std::vector<std::array<int, 4>> cellRanges(grid.size());
+    std::vector<uint32_t>& cells = mapperInfo->mQuadIndexCells;
+    cells.assign(kQuadIndexSize * kQuadIndexSize + 1, 0);
+    for (size_t i = 0; i < grid.size(); i++) {
+        cellRanges[i] = {
+            quadIndexCell(bounds[i][0], minX, mapperInfo->mQuadIndexInvCellWidth),
+            quadIndexCell(bounds[i][1], minY, mapperInfo->mQuadIndexInvCellHeight),
+            quadIndexCell(bounds[i][2], minX, mapperInfo->mQuadIndexInvCellWidth),
+            quadIndexCell(bounds[i][3], minY, mapperInfo->mQuadIndexInvCellHeight)
+        };
+        for (int cy = cellRanges[i][1]; cy <= cellRanges[i][3]; cy++) {
+            for (int cx = cellRanges[i][0]; cx <= cellRanges[i][2]; cx++) {
+                cells[cy * kQuadIndexSize + cx + 1]++;
+            }
+        }
+    }
+    for (size_t cell = 1; cell < cells.size(); cell++) {
+        cells[cell] += cells[cell - 1];
+    }
+
+    // Fill the cells in grid order, so that the first quad of a cell enclosing a point is the
+    // one a linear search of the grid finds.
+    std::vector<uint32_t> cellEnds(cells.begin(), cells.end() - 1);
+    mapperInfo->mQuadIndexQuads.resize(cells.back());
+    for (size_t i = 0; i < grid.size(); i++) {
+        for (int cy = cellRanges[i][1]; cy <= cellRanges[i][3]; cy++) {
+            for (int cx = cellRanges[i][0]; cx <= cellRanges[i][2]; cx++) {
+                mapperInfo->mQuadIndexQuads[cellEnds[cy * kQuadIndexSize + cx]++] = i;
+            }
+        }
+    }
+}
+
+int DistortionMapper::quadIndexCell(float coord, float indexOrigin, float invCellSize) {
+    const float cell = std::floor((coord - indexOrigin) * invCellSize);
+    if (!(cell >= 0)) return -1;
+    // The end of the range belongs to the last cell
+    return static_cast<int>(std::min(cell, static_cast<float>(kQuadIndexSize - 1)));
+}
+
 const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
         const int32_t pt[2], const std::vector<GridQuad>& grid) {
     const float x = pt[0];
     const float y = pt[1];
 
     for (const GridQuad& quad : grid) {
-        const float &x1 = quad.coords[0];
-        const float &y1 = quad.coords[1];
-        const float &x2 = quad.coords[2];
-        const float &y2 = quad.coords[3];
-        const float &x3 = quad.coords[4];
-        const float &y3 = quad.coords[5];
-        const float &x4 = quad.coords[6];
-        const float &y4 = quad.coords[7];
-
-        // Point-in-quad test:
-
-        // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
-        // edges (or on top of one of the edges or corners), traversed in a consistent direction.
-        // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
-        // have the same sign (or be zero) for all edges.
-        // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
-        // En is to the left of Ep, or overlapping.
-        float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
-        if (s1 > 0) continue;
-        float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
-        if (s2 > 0) continue;
-        float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
-        if (s3 > 0) continue;
-        float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
-        if (s4 > 0) continue;
-
-        return &quad;
+        if (quadEnclosesPoint(quad, x, y)) return &quad;
     }
     return nullptr;
 }
 
+const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
+        const int32_t pt[2], const DistortionMapperInfo& mapperInfo) {
+    const float x = pt[0];
+    const float y = pt[1];
+
+    // Points to the right of or below the index are in the last cells, and are rejected by the
+    // point-in-quad test
+    const int cx = quadIndexCell(x, mapperInfo.mQuadIndexX, mapperInfo.mQuadIndexInvCellWidth);
+    const int cy = quadIndexCell(y, mapperInfo.mQuadIndexY, mapperInfo.mQuadIndexInvCellHeight);
+    if (cx >= 0 && cy >= 0) {
+        const size_t cell = cy * kQuadIndexSize + cx;
+        for (uint32_t i = mapperInfo.mQuadIndexCells[cell];
+                i < mapperInfo.mQuadIndexCells[cell + 1]; i++) {
+            const GridQuad& quad = mapperInfo.mDistortedGrid[mapperInfo.mQuadIndexQuads[i]];
+            if (quadEnclosesPoint(quad, x, y)) return &quad;
+        }
+    }
+    // The point-in-quad test may accept points outside of a quad folded by an extreme
+    // distortion, which the index does not list; fall back to the linear search.
+    return findEnclosingQuad(pt, mapperInfo.mDistortedGrid);
+}
+
+bool DistortionMapper::quadEnclosesPoint(const GridQuad& quad, float x, float y) {
+    const float &x1 = quad.coords[0];
+    const float &y1 = quad.coords[1];
+    const float &x2 = quad.coords[2];
+    const float &y2 = quad.coords[3];
+    const float &x3 = quad.coords[4];
+    const float &y3 = quad.coords[5];
+    const float &x4 = quad.coords[6];
+    const float &y4 = quad.coords[7];
+
+    // Point-in-quad test:
+
+    // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
+    // edges (or on top of one of the edges or corners), traversed in a consistent direction.
+    // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
+    // have the same sign (or be zero) for all edges.
+    // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
+    // En is to the left of Ep, or overlapping.
+    float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
+    if (s1 > 0) return false;
+    float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
+    if (s2 > 0) return false;
+    float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
+    if (s3 > 0) return false;
+    float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
+    if (s4 > 0) return false;
+
+    return true;
+}
+
 float DistortionMapper::calculateUorV(const int32_t pt[2], const GridQuad& quad, bool calculateU) {
     const float x = pt[0];
     const float y = pt[1];
@@ -155,12 +155,26 @@ class DistortionMapper : public CoordinateMapper {
 
         std::vector<GridQuad> mCorrectedGrid;
         std::vector<GridQuad> mDistortedGrid;
+
+        // Spatial index of mDistortedGrid: its bounding box is split into
+        // kQuadIndexSize x kQuadIndexSize cells, each listing the quads whose bounding box
+        // overlaps the cell, in grid order
+        float mQuadIndexX, mQuadIndexY;
+        float mQuadIndexInvCellWidth, mQuadIndexInvCellHeight;
+        // Start of the quads of each cell in mQuadIndexQuads, followed by the end of the last cell
+        std::vector<uint32_t> mQuadIndexCells;
+        std::vector<uint32_t> mQuadIndexQuads;
     };
 
     // Find which grid quad encloses the point; returns null if none do
     static const GridQuad* findEnclosingQuad(
             const int32_t pt[2], const std::vector<GridQuad>& grid);
 
+    // Same as above for the distorted grid, only testing the quads listed in the spatial index
+    // cell of the point. Requires valid grids.
+    static const GridQuad* findEnclosingQuad(
+            const int32_t pt[2], const DistortionMapperInfo& mapperInfo);
+
     // Calculate 'horizontal' interpolation coordinate for the point and the quad
     // Assumes the point P is within the quad Q.
     // Given quad with points P1-P4, and edges E12-E41, and considering the edge segments as
@@ -188,6 +202,11 @@ class DistortionMapper : public CoordinateMapper {
     constexpr static float kGridMargin = 0.05f;
     // Fuzziness for float inequality tests
     constexpr static float kFloatFuzz = 1e-4;
+    // Number of cells in each dimension of the spatial index of the distorted grid
+    constexpr static size_t kQuadIndexSize = 2 * kGridSize;
+    // Margin to expand the quad bounding boxes by in the spatial index, so that points found
+    // on a quad edge despite rounding errors are not missed
+    constexpr static float kQuadIndexMargin = 1.f;
 
     bool mMaxResolution = false;
 
@@ -209,6 +228,15 @@ class DistortionMapper : public CoordinateMapper {
     // Utility to create reverse mapping grids
     status_t buildGrids(DistortionMapperInfo *mapperInfo);
 
+    // Utility to create the spatial index of the distorted grid
+    static void buildQuadIndex(DistortionMapperInfo *mapperInfo);
+
+    // Cell of the spatial index of the distorted grid containing the coordinate, or -1
+    static int quadIndexCell(float coord, float indexOrigin, float invCellSize);
+
+    // Point-in-quad test
+    static bool quadEnclosesPoint(const GridQuad& quad, float x, float y);
+
     DistortionMapperInfo mDistortionMapperInfo;
     DistortionMapperInfo mDistortionMapperInfoMaximumResolution;
 
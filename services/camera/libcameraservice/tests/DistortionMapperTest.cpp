@@ -348,6 +348,89 @@ TEST(DistortionMapperTest, LargeTransform) {
     RandomTransformTest(this, testActiveArray, m, /*clamp*/false, /*simple*/false);
 }
 
+// Verify that the spatial index of the distorted grid finds the same quads as the linear
+// search, and record the speed of both lookups
+void QuadLookupTest(::testing::Test *test, int32_t preCorrectionActiveArray[4],
+        DistortionMapper &m) {
+    unsigned int seed = 1234; // Ensure repeatability for debugging
+    const size_t coordCount = 1e5; // Number of random test points
+
+    // Build the grids
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+    std::array<int32_t, 2> coord = {
+        preCorrectionActiveArray[2] / 2, preCorrectionActiveArray[3] / 2};
+    ASSERT_EQ(OK, m.mapRawToCorrected(coord.data(), 1, mapperInfo, /*clamp*/false,
+            /*simple*/false));
+
+    // Include points out of the array, which may not be enclosed by any quad
+    std::default_random_engine gen(seed);
+    std::uniform_int_distribution<int> x_dist(-preCorrectionActiveArray[2] / 10,
+            preCorrectionActiveArray[2] * 11 / 10);
+    std::uniform_int_distribution<int> y_dist(-preCorrectionActiveArray[3] / 10,
+            preCorrectionActiveArray[3] * 11 / 10);
+    std::vector<int32_t> randCoords(coordCount * 2);
+    for (size_t i = 0; i < randCoords.size(); i += 2) {
+        randCoords[i] = x_dist(gen);
+        randCoords[i + 1] = y_dist(gen);
+    }
+
+    std::vector<const DistortionMapper::GridQuad*> linearQuads(coordCount);
+    base::Timer linearTimer;
+    for (size_t i = 0; i < coordCount; i++) {
+        linearQuads[i] = DistortionMapper::findEnclosingQuad(randCoords.data() + 2 * i,
+                mapperInfo->mDistortedGrid);
+    }
+    auto linearDuration = linearTimer.duration();
+
+    std::vector<const DistortionMapper::GridQuad*> indexedQuads(coordCount);
+    base::Timer indexedTimer;
+    for (size_t i = 0; i < coordCount; i++) {
+        indexedQuads[i] = DistortionMapper::findEnclosingQuad(randCoords.data() + 2 * i,
+                *mapperInfo);
+    }
+    auto indexedDuration = indexedTimer.duration();
+
+    for (size_t i = 0; i < coordCount; i++) {
+        EXPECT_EQ(linearQuads[i], indexedQuads[i]) << "(" << randCoords[2 * i] << ", "
+                << randCoords[2 * i + 1] << ")";
+    }
+
+    float linearDurationPerCoordUs =
+            (std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+                linearDuration) / coordCount).count();
+    float indexedDurationPerCoordUs =
+            (std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+                indexedDuration) / coordCount).count();
+    test->RecordProperty("LinearQuadLookupPerCoordUs",
+            base::StringPrintf("%f", linearDurationPerCoordUs));
+    test->RecordProperty("IndexedQuadLookupPerCoordUs",
+            base::StringPrintf("%f", indexedDurationPerCoordUs));
+}
+
+TEST(DistortionMapperTest, QuadLookup) {
+    int32_t activeArray[] = {0, 8, 3278, 2450};
+    int32_t preCorrectionActiveArray[] = {0, 0, 3280, 2464};
+
+    float distortion[] = {0.06875723, -0.13922249, 0.02818312, -0.00032781, -0.00025431};
+    float intrinsics[] = {1812.50000000, 1812.50000000, 1645.59533691, 1229.23229980, 0.00000000};
+
+    DistortionMapper m;
+    setupTestMapper(&m, distortion, intrinsics, activeArray, preCorrectionActiveArray);
+
+    QuadLookupTest(this, preCorrectionActiveArray, m);
+}
+
+TEST(DistortionMapperTest, LargeTransformQuadLookup) {
+    float bigDistortion[] = {0.1, -0.003, 0.004, 0.02, 0.01};
+
+    DistortionMapper m;
+    setupTestMapper(&m, bigDistortion, testICal,
+            /*activeArray*/testActiveArray,
+            /*preCorrectionActiveArray*/testPreCorrActiveArray);
+
+    QuadLookupTest(this, testPreCorrActiveArray, m);
+}
+
 // Compare against values calculated by OpenCV
 // undistortPoints() method, which is the same as mapRawToCorrected
 // Ignore clamping
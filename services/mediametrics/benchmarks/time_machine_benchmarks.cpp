@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <malloc.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/MediaMetricsItem.h>
+#include <mediametricsservice/TimeMachine.h>
+
+using namespace android;
+
+// Keys per thread, each with the properties of a typical audio track item.
+static constexpr int kKeysPerThread = 32;
+static constexpr int kPropertiesPerKey = 12;
+
+static std::vector<std::string> makePropertyNames() {
+    std::vector<std::string> names;
+    for (int i = 0; i < kPropertiesPerKey; ++i) {
+        names.push_back("property" + std::to_string(i));
+    }
+    return names;
+}
+
+static const std::vector<std::string> kPropertyNames = makePropertyNames();
+
+static std::shared_ptr<mediametrics::Item> makeItem(const std::string& key, int64_t value) {
+    auto item = std::make_shared<mediametrics::Item>(key);
+    for (const auto& name : kPropertyNames) {
+        item->set(name.c_str(), (int64_t)(value + name.size()));
+    }
+    return item;
+}
+
+/*
+ * Concurrent put and get of items on a shared TimeMachine, as done by the
+ * binder threads of the service. Each thread updates its own keys, which
+ * stay below the high water mark, so no garbage collection takes place.
+ *
+ * $ adb shell /data/nativetest64/time_machine_benchmarks/time_machine_benchmarks
+ */
+static void BM_TimeMachinePutGet(benchmark::State& state) {
+    static mediametrics::TimeMachine timeMachine;
+    if (state.thread_index() == 0) {
+        timeMachine.clear();
+    }
+
+    std::vector<std::string> keys;
+    std::vector<std::string> urls;
+    for (int i = 0; i < kKeysPerThread; ++i) {
+        keys.push_back("audio.track." + std::to_string(state.thread_index() * 1000 + i));
+        urls.push_back(keys.back() + "." + kPropertyNames[i % kPropertiesPerKey]);
+    }
+
+    int64_t value = 0;
+    for (auto _ : state) {
+        const int i = value % kKeysPerThread;
+        auto item = makeItem(keys[i], value++);
+        benchmark::DoNotOptimize(timeMachine.put(item, true /* isTrusted */));
+
+        int64_t i64;
+        benchmark::DoNotOptimize(timeMachine.get(urls[i], &i64, -1 /* uidCheck */));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_TimeMachinePutGet)->ThreadRange(1, 8)->UseRealTime();
+
+/*
+ * Heap used by a TimeMachine filled up to the high water mark, where each key
+ * has full time sequences for its properties.
+ */
+static void BM_TimeMachineHighWater(benchmark::State& state) {
+    constexpr size_t kKeyLowWaterMark = 400;
+    constexpr size_t kKeyHighWaterMark = 500;
+    constexpr size_t kKeys = kKeyHighWaterMark - 1;  // avoid gc
+    constexpr int kUpdates = 64;  // more than the time sequence holds
+
+    size_t bytes = 0;
+    for (auto _ : state) {
+        const size_t before = mallinfo().uordblks;
+        auto timeMachine = std::make_unique<mediametrics::TimeMachine>(
+                kKeyLowWaterMark, kKeyHighWaterMark);
+        for (int update = 0; update < kUpdates; ++update) {
+            for (size_t key = 0; key < kKeys; ++key) {
+                auto item = makeItem("audio.track." + std::to_string(key), update);
+                item->setTimestamp(update + 1);
+                timeMachine->put(item, true /* isTrusted */);
+            }
+        }
+        bytes = mallinfo().uordblks - before;
+
+        state.PauseTiming();
+        timeMachine.reset();
+        state.ResumeTiming();
+    }
+    state.counters["HighWaterBytes"] = bytes;
+    state.counters["BytesPerKey"] = bytes / kKeys;
+}
+
+BENCHMARK(BM_TimeMachineHighWater)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
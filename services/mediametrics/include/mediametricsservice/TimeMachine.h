@@ -16,11 +16,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <any>
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -70,16 +74,54 @@ public:
 
 private:
 
+    /**
+     * Shares the storage of property names between keys, as keys of the same
+     * type mostly have the same properties.
+     *
+     * Names are held weakly; names no longer used by any key are dropped on
+     * garbage collection. The lock is never held while acquiring another lock.
+     */
+    class NamePool {
+    public:
+        std::shared_ptr<const std::string> intern(const std::string &name) {
+            std::lock_guard lock(mLock);
+            std::weak_ptr<const std::string> &entry = mNames[name];
+            std::shared_ptr<const std::string> interned = entry.lock();
+            if (interned == nullptr) {
+                interned = std::make_shared<const std::string>(name);
+                entry = interned;
+            }
+            return interned;
+        }
+
+        void purge() {
+            std::lock_guard lock(mLock);
+            for (auto it = mNames.begin(); it != mNames.end();) {
+                if (it->second.expired()) {
+                    it = mNames.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+    private:
+        std::mutex mLock;
+        std::unordered_map<std::string, std::weak_ptr<const std::string>> mNames
+                GUARDED_BY(mLock);
+    };
+
     // KeyHistory contains no lock.
     // Access is through the TimeMachine, and a hash-striped lock is used
     // before calling into KeyHistory.
     class KeyHistory  {
     public:
         template <typename T>
-        KeyHistory(T key, uid_t allowUid, int64_t time)
+        KeyHistory(T key, uid_t allowUid, int64_t time, std::shared_ptr<NamePool> namePool)
             : mKey(key)
             , mAllowUid(allowUid)
             , mCreationTime(time)
+            , mNamePool(std::move(namePool))
             , mLastModificationTime(time)
         {
             (void)mCreationTime; // suppress unused warning.
@@ -110,7 +152,7 @@ private:
             if (time == 0) time = systemTime(SYSTEM_TIME_REALTIME);
             const auto tsptr = mPropertyMap.find(property);
             if (tsptr == mPropertyMap.end()) return BAD_VALUE;
-            const auto& timeSequence = tsptr->second;
+            const auto& timeSequence = tsptr->second.history;
             auto eptr = timeSequence.upper_bound(time);
             if (eptr == timeSequence.begin()) return BAD_VALUE;
             --eptr;
@@ -140,24 +182,34 @@ private:
                 REQUIRES(mPseudoKeyHistoryLock) {
             if (time == 0) time = systemTime(SYSTEM_TIME_REALTIME);
             mLastModificationTime = time;
-            if (mPropertyMap.size() >= kKeyMaxProperties &&
-                    !mPropertyMap.count(property)) {
-                ALOGV("%s: too many properties, rejecting %s", __func__, property.c_str());
-                mRejectedPropertiesCount++;
-                return;
+            auto tsptr = mPropertyMap.find(property);
+            if (tsptr == mPropertyMap.end()) {
+                if (mPropertyMap.size() >= kKeyMaxProperties) {
+                    ALOGV("%s: too many properties, rejecting %s", __func__, property.c_str());
+                    mRejectedPropertiesCount++;
+                    return;
+                }
+                std::shared_ptr<const std::string> name = mNamePool->intern(property);
+                const std::string_view nameView = *name;
+                tsptr = mPropertyMap.emplace(nameView, Property{std::move(name), {}}).first;
             }
-            auto& timeSequence = mPropertyMap[property];
+            auto& timeSequence = tsptr->second.history;
             Elem el{std::forward<T>(e)};
             if (timeSequence.empty()           // no elements
                     || property.back() == AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED
                     || timeSequence.rbegin()->second != el) { // value changed
-                timeSequence.emplace_hint(timeSequence.end(), time, std::move(el));
-
-                if (timeSequence.size() > kTimeSequenceMaxElements) {
+                if (timeSequence.size() < kTimeSequenceMaxElements) {
+                    timeSequence.emplace_hint(timeSequence.end(), time, std::move(el));
+                } else if (time >= timeSequence.begin()->first) {
                     ALOGV("%s: restricting maximum elements (discarding oldest) for %s",
                             __func__, property.c_str());
-                    timeSequence.erase(timeSequence.begin());
-                }
+                    // Reuse the node of the oldest element, so that updating a full
+                    // time sequence does not allocate.
+                    auto node = timeSequence.extract(timeSequence.begin());
+                    node.key() = time;
+                    node.mapped() = std::move(el);
+                    timeSequence.insert(timeSequence.end(), std::move(node));
+                } // else the new element would be the oldest, which is discarded.
             }
         }
 
@@ -165,9 +217,9 @@ private:
                 REQUIRES(mPseudoKeyHistoryLock) {
             std::stringstream ss;
             int32_t ll = lines;
-            for (auto& tsPair : mPropertyMap) {
+            for (const auto& [name, property] : mPropertyMap) {
                 if (ll <= 0) break;
-                std::string s = dump(mKey, tsPair, time);
+                std::string s = dump(mKey, name, property.history, time);
                 if (s.size() > 0) {
                     --ll;
                     ss << s;
@@ -187,15 +239,15 @@ private:
     private:
         static std::string dump(
                 const std::string &key,
-                const std::pair<std::string /* prop */, PropertyHistory>& tsPair,
+                std::string_view name,
+                const PropertyHistory& timeSequence,
                 int64_t time) {
-            const auto timeSequence = tsPair.second;
             auto eptr = timeSequence.lower_bound(time);
             if (eptr == timeSequence.end()) {
-                return {}; // don't dump anything. tsPair.first + "={};\n";
+                return {}; // don't dump anything. name + "={};\n";
             }
             std::stringstream ss;
-            ss << key << "." << tsPair.first << "={";
+            ss << key << "." << name << "={";
 
             time_string_t last_timestring{}; // last timestring used.
             while (true) {
@@ -215,16 +267,23 @@ private:
             return ss.str();
         }
 
+        struct Property {
+            std::shared_ptr<const std::string> name; // interned
+            PropertyHistory history;
+        };
+
         const std::string mKey;
         const uid_t mAllowUid;
         const int64_t mCreationTime;
+        const std::shared_ptr<NamePool> mNamePool;
 
         unsigned int mRejectedPropertiesCount = 0;
         int64_t mLastModificationTime;
-        std::map<std::string /* property */, PropertyHistory> mPropertyMap;
+        // Keyed by a view of the name held by the Property.
+        std::map<std::string_view /* property */, Property, std::less<>> mPropertyMap;
     };
 
-    using History = std::map<std::string /* key */, std::shared_ptr<KeyHistory>>;
+    using History = std::unordered_map<std::string /* key */, std::shared_ptr<KeyHistory>>;
 
     static inline constexpr size_t kTimeSequenceMaxElements = 50;
     static inline constexpr size_t kKeyMaxProperties = 128;
@@ -255,21 +314,31 @@ public:
         *this = other;
     }
     TimeMachine& operator=(const TimeMachine& other) {
-        std::lock_guard lock(mLock);
-        mHistory.clear();
+        if (this == &other) return *this;
+        size_t keyCount = 0;
+        for (size_t i = 0; i < kShards; ++i) {
+            const Shard &otherShard = other.mShards[i];
+            Shard &shard = mShards[i];
+            History history;
+            {
+                std::lock_guard lock(otherShard.mLock);
+                history = otherShard.mHistory;
+            }
 
-        {
-            std::lock_guard lock2(other.mLock);
-            mHistory = other.mHistory;
-            mGarbageCollectionCount = other.mGarbageCollectionCount.load();
-        }
+            // Now that we safely have our own shared pointers, let's dup them
+            // to ensure they are decoupled.  We do this by acquiring the other lock.
+            for (auto &[lkey, lhist] : history) {
+                std::lock_guard lock(other.getLockForKey(lkey));
+                lhist = std::make_shared<KeyHistory>(*lhist);
+            }
+            keyCount += history.size();
 
-        // Now that we safely have our own shared pointers, let's dup them
-        // to ensure they are decoupled.  We do this by acquiring the other lock.
-        for (const auto &[lkey, lhist] : mHistory) {
-            std::lock_guard lock2(other.getLockForKey(lkey));
-            mHistory[lkey] = std::make_shared<KeyHistory>(*lhist);
+            // Both TimeMachines place a key in the same shard.
+            std::lock_guard lock(shard.mLock);
+            shard.mHistory.swap(history);
         }
+        mKeyCount = keyCount;
+        mGarbageCollectionCount = other.mGarbageCollectionCount.load();
         return *this;
     }
 
@@ -283,28 +352,29 @@ public:
         ALOGV("%s(%zu, %zu): key: %s  isTrusted:%d  size:%zu",
                 __func__, mKeyLowWaterMark, mKeyHighWaterMark,
                 key.c_str(), (int)isTrusted, item->count());
-        std::shared_ptr<KeyHistory> keyHistory;
-        {
-            std::vector<std::any> garbage;
-            std::lock_guard lock(mLock);
-
-            auto it = mHistory.find(key);
-            if (it == mHistory.end()) {
-                if (!isTrusted) return PERMISSION_DENIED;
+        std::shared_ptr<KeyHistory> keyHistory = getKeyHistory(key);
+        if (keyHistory == nullptr) {
+            if (!isTrusted) return PERMISSION_DENIED;
 
+            {
+                std::vector<std::any> garbage;
                 (void)gc(garbage);
-
-                // We set the allowUid for client access on key creation.
-                int32_t allowUid = -1;
-                (void)item->get(AMEDIAMETRICS_PROP_ALLOWUID, &allowUid);
-                // no keylock needed here as we are sole owner
-                // until placed on mHistory.
-                keyHistory = std::make_shared<KeyHistory>(
-                    key, allowUid, time);
-                mHistory[key] = keyHistory;
-            } else {
-                keyHistory = it->second;
             }
+
+            // We set the allowUid for client access on key creation.
+            int32_t allowUid = -1;
+            (void)item->get(AMEDIAMETRICS_PROP_ALLOWUID, &allowUid);
+            // no keylock needed here as we are sole owner
+            // until placed on mHistory.
+            auto newKeyHistory = std::make_shared<KeyHistory>(
+                key, allowUid, time, mNamePool);
+
+            Shard &shard = getShard(key);
+            std::lock_guard lock(shard.mLock);
+            // Another thread may have created the key in the meantime.
+            auto [it, inserted] = shard.mHistory.emplace(key, std::move(newKeyHistory));
+            if (inserted) ++mKeyCount;
+            keyHistory = it->second;
         }
 
         // deferred contains remote properties (for other keys) to do later.
@@ -340,13 +410,8 @@ public:
             std::string remoteKey = name.substr(1, end - 1);
             std::string remoteName = name.substr(end + 1);
             if (remoteKey.size() == 0 || remoteName.size() == 0) continue;
-            std::shared_ptr<KeyHistory> remoteKeyHistory;
-            {
-                std::lock_guard lock(mLock);
-                auto it = mHistory.find(remoteKey);
-                if (it == mHistory.end()) continue;
-                remoteKeyHistory = it->second;
-            }
+            std::shared_ptr<KeyHistory> remoteKeyHistory = getKeyHistory(remoteKey);
+            if (remoteKeyHistory == nullptr) continue;
             std::lock_guard lock(getLockForKey(remoteKey));
             remoteKeyHistory->putProp(remoteName, prop, time);
         }
@@ -356,13 +421,8 @@ public:
     template <typename T>
     status_t get(const std::string &key, const std::string &property,
             T* value, int32_t uidCheck = -1, int64_t time = 0) const {
-        std::shared_ptr<KeyHistory> keyHistory;
-        {
-            std::lock_guard lock(mLock);
-            const auto it = mHistory.find(key);
-            if (it == mHistory.end()) return BAD_VALUE;
-            keyHistory = it->second;
-        }
+        std::shared_ptr<KeyHistory> keyHistory = getKeyHistory(key);
+        if (keyHistory == nullptr) return BAD_VALUE;
         std::lock_guard lock(getLockForKey(key));
         return keyHistory->checkPermission(uidCheck)
                 ?: keyHistory->getValue(property, value, time);
@@ -417,16 +477,21 @@ public:
      *  Returns number of keys in the Time Machine.
      */
     size_t size() const {
-        std::lock_guard lock(mLock);
-        return mHistory.size();
+        return mKeyCount;
     }
 
     /**
      * Clears all properties from the Time Machine.
      */
     void clear() {
-        std::lock_guard lock(mLock);
-        mHistory.clear();
+        for (Shard &shard : mShards) {
+            History history;
+            {
+                std::lock_guard lock(shard.mLock);
+                history.swap(shard.mHistory);
+                mKeyCount -= history.size();
+            }
+        }
         mGarbageCollectionCount = 0;
     }
 
@@ -444,17 +509,24 @@ public:
      */
     std::pair<std::string, int32_t> dump(
             int32_t lines = INT32_MAX, int64_t sinceNs = 0, const char *prefix = nullptr) const {
-        std::lock_guard lock(mLock);
+        // Collect the keys of all shards, to dump them in order.
+        std::vector<std::pair<std::string, std::shared_ptr<KeyHistory>>> keyHistories;
+        for (const Shard &shard : mShards) {
+            std::lock_guard lock(shard.mLock);
+            for (const auto &[key, keyHistory] : shard.mHistory) {
+                if (prefix != nullptr && !startsWith(key, prefix)) continue;
+                keyHistories.emplace_back(key, keyHistory);
+            }
+        }
+        std::sort(keyHistories.begin(), keyHistories.end(),
+                [](const auto &a, const auto &b) { return a.first < b.first; });
+
         std::stringstream ss;
         int32_t ll = lines;
-
-        for (auto it = prefix != nullptr ? mHistory.lower_bound(prefix) : mHistory.begin();
-                it != mHistory.end();
-                ++it) {
+        for (const auto &[key, keyHistory] : keyHistories) {
             if (ll <= 0) break;
-            if (prefix != nullptr && !startsWith(it->first, prefix)) break;
-            std::lock_guard lock2(getLockForKey(it->first));
-            auto [s, l] = it->second->dump(ll, sinceNs);
+            std::lock_guard lock(getLockForKey(key));
+            auto [s, l] = keyHistory->dump(ll, sinceNs);
             ss << s;
             ll -= l;
         }
@@ -467,30 +539,53 @@ public:
 
 private:
 
+    // Number of shards of the key index.
+    static inline constexpr size_t kShards = 16;
+
+    struct Shard {
+        mutable std::mutex mLock;        // Lock for mHistory
+        History mHistory GUARDED_BY(mLock);
+    };
+
+    Shard &getShard(const std::string &key) {
+        return mShards[std::hash<std::string>{}(key) % kShards];
+    }
+
+    const Shard &getShard(const std::string &key) const {
+        return mShards[std::hash<std::string>{}(key) % kShards];
+    }
+
     // Obtains the lock for a KeyHistory.
     std::mutex &getLockForKey(const std::string &key) const
             RETURN_CAPABILITY(mPseudoKeyHistoryLock) {
         return mKeyLocks[std::hash<std::string>{}(key) % std::size(mKeyLocks)];
     }
 
+    // Finds the KeyHistory of a key.  Returns nullptr if not found.
+    std::shared_ptr<KeyHistory> getKeyHistory(const std::string &key) const {
+        const Shard &shard = getShard(key);
+        std::lock_guard lock(shard.mLock);
+        const auto it = shard.mHistory.find(key);
+        return it == shard.mHistory.end() ? nullptr : it->second;
+    }
+
     // Finds a KeyHistory from a URL.  Returns nullptr if not found.
+    //
+    // The URL is the key, a '.' and the property name. As keys contain '.'
+    // themselves, the longest matching key is used.
     std::shared_ptr<KeyHistory> getKeyHistoryFromUrl(
             const std::string& url, std::string* key, std::string *prop) const {
-        std::lock_guard lock(mLock);
-
-        auto it = mHistory.upper_bound(url);
-        if (it == mHistory.begin()) {
-           return nullptr;
-        }
-        --it;  // go to the actual key, if it exists.
-
-        const std::string& itKey = it->first;
-        if (strncmp(itKey.c_str(), url.c_str(), itKey.size())) {
-            return nullptr;
+        for (size_t pos = url.rfind('.'); pos != std::string::npos && pos > 0;
+                pos = url.rfind('.', pos - 1)) {
+            std::string candidate = url.substr(0, pos);
+            std::shared_ptr<KeyHistory> keyHistory = getKeyHistory(candidate);
+            if (keyHistory != nullptr) {
+                if (prop) *prop = url.substr(pos + 1);
+                if (key) *key = std::move(candidate);
+                return keyHistory;
+            }
         }
-        if (key) *key = itKey;
-        if (prop) *prop = url.substr(itKey.size() + 1);
-        return it->second;
+        return nullptr;
     }
 
     /**
@@ -504,48 +599,70 @@ private:
      *
      * \return true if garbage collection was done.
      */
-    bool gc(std::vector<std::any>& garbage) REQUIRES(mLock) {
+    bool gc(std::vector<std::any>& garbage) NO_THREAD_SAFETY_ANALYSIS {
         // TODO: something better than this for garbage collection.
-        if (mHistory.size() < mKeyHighWaterMark) return false;
+        if (mKeyCount < mKeyHighWaterMark) return false;
+
+        // All shards are locked, in order, so that keys are neither added nor
+        // removed during the collection.
+        for (Shard &shard : mShards) shard.mLock.lock();
+        if (mKeyCount < mKeyHighWaterMark) {
+            // Another thread collected.
+            for (Shard &shard : mShards) shard.mLock.unlock();
+            return false;
+        }
 
         // erase everything explicitly expired.
-        std::multimap<int64_t, std::string> accessList;
+        // The access list refers to the keys in the shards, ties are broken by key.
+        std::vector<std::pair<int64_t, const std::string *>> accessList;
         // use a stale vector with precise type to avoid type erasure overhead in garbage
         std::vector<std::shared_ptr<KeyHistory>> stale;
 
-        for (auto it = mHistory.begin(); it != mHistory.end();) {
-            const std::string& key = it->first;
-            std::shared_ptr<KeyHistory> &keyHist = it->second;
-
-            std::lock_guard lock(getLockForKey(it->first));
-            int64_t expireTime = keyHist->getValue("_expire", -1 /* default */);
-            if (expireTime != -1) {
-                stale.emplace_back(std::move(it->second));
-                it = mHistory.erase(it);
-            } else {
-                accessList.emplace(keyHist->getLastModificationTime(), key);
-                ++it;
+        for (Shard &shard : mShards) {
+            for (auto it = shard.mHistory.begin(); it != shard.mHistory.end();) {
+                const std::string& key = it->first;
+                std::shared_ptr<KeyHistory> &keyHist = it->second;
+
+                std::lock_guard lock(getLockForKey(key));
+                int64_t expireTime = keyHist->getValue("_expire", -1 /* default */);
+                if (expireTime != -1) {
+                    stale.emplace_back(std::move(it->second));
+                    it = shard.mHistory.erase(it);
+                    --mKeyCount;
+                } else {
+                    accessList.emplace_back(keyHist->getLastModificationTime(), &key);
+                    ++it;
+                }
             }
         }
 
-        if (mHistory.size() > mKeyLowWaterMark) {
-           const size_t toDelete = mHistory.size() - mKeyLowWaterMark;
-           auto it = accessList.begin();
-           for (size_t i = 0; i < toDelete; ++i) {
-               auto it2 = mHistory.find(it->second);
+        if (mKeyCount > mKeyLowWaterMark) {
+           const size_t toDelete = mKeyCount - mKeyLowWaterMark;
+           auto oldest = accessList.begin() + toDelete;
+           std::partial_sort(accessList.begin(), oldest, accessList.end(),
+                   [](const auto &a, const auto &b) {
+                       return a.first < b.first || (a.first == b.first && *a.second < *b.second);
+                   });
+           for (auto it = accessList.begin(); it != oldest; ++it) {
+               History &history = getShard(*it->second).mHistory;
+               auto it2 = history.find(*it->second);
                stale.emplace_back(std::move(it2->second));
-               mHistory.erase(it2);
-               ++it;
+               history.erase(it2);
+               --mKeyCount;
            }
         }
-        garbage.emplace_back(std::move(accessList));
         garbage.emplace_back(std::move(stale));
 
         ALOGD("%s(%zu, %zu): key size:%zu",
                 __func__, mKeyLowWaterMark, mKeyHighWaterMark,
-                mHistory.size());
+                mKeyCount.load());
 
         ++mGarbageCollectionCount;
+        for (Shard &shard : mShards) shard.mLock.unlock();
+
+        // The names of the collected keys are released with the garbage,
+        // those of earlier collections are dropped now.
+        mNamePool->purge();
         return true;
     }
 
@@ -557,9 +674,11 @@ private:
     /**
      * Locking Strategy
      *
-     * Each key in the History has a KeyHistory. To get a shared pointer to
-     * the KeyHistory requires a lookup of mHistory under mLock.  Once the shared
-     * pointer to KeyHistory is obtained, the mLock for mHistory can be released.
+     * Each key in the History has a KeyHistory. The keys are spread over
+     * kShards shards by the hash of the key string. To get a shared pointer
+     * to the KeyHistory requires a lookup of the shard's mHistory under the
+     * shard's mLock.  Once the shared pointer to KeyHistory is obtained, the
+     * shard lock can be released.
      *
      * Once the shared pointer to the key's KeyHistory is obtained, the KeyHistory
      * can be locked for read and modification through the method getLockForKey().
@@ -568,14 +687,19 @@ private:
      * which assigns a mutex based on the hash of the key string.
      *
      * Once the last shared pointer reference to KeyHistory is released, it is
-     * destroyed.  This is done through the garbage collection method.
+     * destroyed.  This is done through the garbage collection method, which
+     * is the only one to hold more than one shard lock, acquired in order.
      *
      * This two level locking allows multiple threads to access the TimeMachine
-     * in parallel.
+     * in parallel, and threads using keys of different shards do not contend.
      */
 
-    mutable std::mutex mLock;           // Lock for mHistory
-    History mHistory GUARDED_BY(mLock);
+    Shard mShards[kShards];
+    // Number of keys in all shards; only changed with the shard lock held.
+    std::atomic<size_t> mKeyCount{};
+
+    // Property names shared by the KeyHistories.
+    const std::shared_ptr<NamePool> mNamePool = std::make_shared<NamePool>();
 
     // KEY_LOCKS is the number of mutexes for keys.
     // It need not be a power of 2, but faster that way.
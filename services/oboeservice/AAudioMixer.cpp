@@ -20,6 +20,7 @@
 
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
+#include <algorithm>
 #include <cstring>
 #include <utils/Trace.h>
 
@@ -29,33 +30,104 @@
 #define AAUDIO_MIXER_ATRACE_ENABLED    1
 #endif
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define AAUDIO_MIXER_SIMD 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define AAUDIO_MIXER_SIMD 1
+#endif
+
 using android::WrappingBuffer;
 using android::FifoBuffer;
 using android::fifo_frames_t;
 
+// Limit the mix to the same headroom as ClipToRange in the AAudio flowgraph,
+// which is 3 dB to match AudioTrack for float data.
+static constexpr float kMaxHeadroom = 1.41253754f;
+
+namespace {
+
+float clipToHeadroom(float sample) {
+    return std::min(std::max(sample, -kMaxHeadroom), kMaxHeadroom);
+}
+
+#ifdef AAUDIO_MIXER_SIMD
+
+constexpr int32_t kSamplesPerVector = 4;
+
+#if defined(__aarch64__)
+using float4 = float32x4_t;
+float4 load4(const float *p) { return vld1q_f32(p); }
+void store4(float *p, float4 v) { vst1q_f32(p, v); }
+float4 add4(float4 a, float4 b) { return vaddq_f32(a, b); }
+// Like clipToHeadroom(), NaN is kept.
+float4 clip4(float4 v) {
+    return vminq_f32(vmaxq_f32(v, vdupq_n_f32(-kMaxHeadroom)), vdupq_n_f32(kMaxHeadroom));
+}
+#else
+using float4 = __m128;
+float4 load4(const float *p) { return _mm_loadu_ps(p); }
+void store4(float *p, float4 v) { _mm_storeu_ps(p, v); }
+float4 add4(float4 a, float4 b) { return _mm_add_ps(a, b); }
+// Like clipToHeadroom(), NaN is kept: maxps and minps return their second operand for NaN.
+float4 clip4(float4 v) {
+    return _mm_min_ps(_mm_set1_ps(kMaxHeadroom), _mm_max_ps(_mm_set1_ps(-kMaxHeadroom), v));
+}
+#endif
+
+#endif // AAUDIO_MIXER_SIMD
+
+/**
+ * Accumulate N contiguous blocks of samples, one per stream, into the destination in a single
+ * pass. If clip is true then the sums are clipped to the headroom.
+ */
+template <int N>
+void mixRuns(float *destination, const float *const *sources, int32_t numSamples, bool clip) {
+    int32_t sampleIndex = 0;
+
+#ifdef AAUDIO_MIXER_SIMD
+    for (; sampleIndex + kSamplesPerVector <= numSamples; sampleIndex += kSamplesPerVector) {
+        float4 sum = load4(destination + sampleIndex);
+        for (int i = 0; i < N; i++) {
+            sum = add4(sum, load4(sources[i] + sampleIndex));
+        }
+        store4(destination + sampleIndex, clip ? clip4(sum) : sum);
+    }
+#endif // AAUDIO_MIXER_SIMD
+
+    for (; sampleIndex < numSamples; sampleIndex++) {
+        float sum = destination[sampleIndex];
+        for (int i = 0; i < N; i++) {
+            sum += sources[i][sampleIndex];
+        }
+        destination[sampleIndex] = clip ? clipToHeadroom(sum) : sum;
+    }
+}
+
+} // namespace
+
 void AAudioMixer::allocate(int32_t samplesPerFrame, int32_t framesPerBurst) {
     mSamplesPerFrame = samplesPerFrame;
     mFramesPerBurst = framesPerBurst;
     int32_t samplesPerBuffer = samplesPerFrame * framesPerBurst;
     mOutputBuffer = std::make_unique<float[]>(samplesPerBuffer);
     mBufferSizeInBytes = samplesPerBuffer * sizeof(float);
+    // Avoid allocating in the callback thread for a typical number of streams.
+    mStreams.reserve(4 * kMaxStreamsPerPass);
 }
 
 void AAudioMixer::clear() {
     memset(mOutputBuffer.get(), 0, mBufferSizeInBytes);
 }
 
-int32_t AAudioMixer::mix(
-        int streamIndex, const std::shared_ptr<FifoBuffer>& fifo, bool allowUnderflow) {
-    WrappingBuffer wrappingBuffer;
-    float *destination = mOutputBuffer.get();
-
-#if AAUDIO_MIXER_ATRACE_ENABLED
-    ATRACE_BEGIN("aaMix");
-#endif /* AAUDIO_MIXER_ATRACE_ENABLED */
+int32_t AAudioMixer::addStream(int streamIndex,
+                               std::shared_ptr<FifoBuffer> fifo,
+                               bool allowUnderflow) {
+    Stream stream;
 
     // Gather the data from the client. May be in two parts.
-    fifo_frames_t fullFrames = fifo->getFullDataAvailable(&wrappingBuffer);
+    fifo_frames_t fullFrames = fifo->getFullDataAvailable(&stream.wrappingBuffer);
 #if AAUDIO_MIXER_ATRACE_ENABLED
     if (ATRACE_ENABLED()) {
         char rdyText[] = "aaMixRdy#";
@@ -64,7 +136,7 @@ int32_t AAudioMixer::mix(
         ATRACE_INT(rdyText, fullFrames);
     }
 #else /* MIXER_ATRACE_ENABLED */
-    (void) trackIndex;
+    (void) streamIndex;
 #endif /* AAUDIO_MIXER_ATRACE_ENABLED */
 
     // If allowUnderflow then always advance by one burst even if we do not have the data.
@@ -78,38 +150,97 @@ int32_t AAudioMixer::mix(
         framesDesired = fullFrames; // just use what is available then stop
     }
 
-    // Mix data in one or two parts.
-    int partIndex = 0;
-    int32_t framesLeft = framesDesired;
-    while (framesLeft > 0 && partIndex < WrappingBuffer::SIZE) {
-        fifo_frames_t framesToMixFromPart = framesLeft;
-        fifo_frames_t framesAvailableFromPart = wrappingBuffer.numFrames[partIndex];
-        if (framesAvailableFromPart > 0) {
-            if (framesToMixFromPart > framesAvailableFromPart) {
-                framesToMixFromPart = framesAvailableFromPart;
-            }
-            mixPart(destination, (float *)wrappingBuffer.data[partIndex],
-                    framesToMixFromPart);
+    const fifo_frames_t framesToRead = std::min(framesDesired, fullFrames);
+    stream.fifo = std::move(fifo);
+    stream.framesToRead = framesToRead;
+    stream.framesDesired = framesDesired;
+    mStreams.push_back(std::move(stream));
+    return framesToRead;
+}
 
-            destination += framesToMixFromPart * mSamplesPerFrame;
-            framesLeft -= framesToMixFromPart;
-        }
-        partIndex++;
+void AAudioMixer::mixStreams() {
+#if AAUDIO_MIXER_ATRACE_ENABLED
+    ATRACE_BEGIN("aaMix");
+#endif /* AAUDIO_MIXER_ATRACE_ENABLED */
+
+    const int numStreams = mStreams.size();
+    for (int first = 0; first < numStreams; first += kMaxStreamsPerPass) {
+        const int count = std::min(numStreams - first, kMaxStreamsPerPass);
+        // Clip while accumulating the last streams.
+        mixPass(&mStreams[first], count, first + count == numStreams);
     }
-    fifo->advanceReadIndex(framesDesired);
+
+    for (Stream &stream : mStreams) {
+        stream.fifo->advanceReadIndex(stream.framesDesired);
+    }
+    mStreams.clear();
 
 #if AAUDIO_MIXER_ATRACE_ENABLED
     ATRACE_END();
 #endif /* AAUDIO_MIXER_ATRACE_ENABLED */
-
-    return (framesDesired - framesLeft); // framesRead
 }
 
-void AAudioMixer::mixPart(float *destination, float *source, int32_t numFrames) {
-    int32_t numSamples = numFrames * mSamplesPerFrame;
-    // TODO maybe optimize using SIMD
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
-        *destination++ += *source++;
+void AAudioMixer::mixPass(const Stream *streams, int numStreams, bool clip) {
+    // Split the burst wherever one of the streams wraps around the end of its FIFO
+    // or runs out of data, so that every stream is contiguous within a segment.
+    int32_t boundaries[2 * kMaxStreamsPerPass + 1];
+    int numBoundaries = 0;
+    for (int i = 0; i < numStreams; i++) {
+        boundaries[numBoundaries++] = std::min(streams[i].framesToRead,
+                                               streams[i].wrappingBuffer.numFrames[0]);
+        boundaries[numBoundaries++] = streams[i].framesToRead;
+    }
+    boundaries[numBoundaries++] = mFramesPerBurst;
+    std::sort(boundaries, boundaries + numBoundaries);
+
+    int32_t segmentStart = 0;
+    for (int b = 0; b < numBoundaries; b++) {
+        const int32_t segmentEnd = boundaries[b];
+        if (segmentEnd <= segmentStart) {
+            continue;
+        }
+
+        const float *sources[kMaxStreamsPerPass];
+        int numRuns = 0;
+        for (int i = 0; i < numStreams; i++) {
+            const Stream &stream = streams[i];
+            const int32_t firstPartFrames = std::min(stream.framesToRead,
+                                                     stream.wrappingBuffer.numFrames[0]);
+            const float *source;
+            if (segmentStart < firstPartFrames) {
+                source = (const float *) stream.wrappingBuffer.data[0]
+                        + segmentStart * mSamplesPerFrame;
+            } else if (segmentStart < stream.framesToRead) {
+                source = (const float *) stream.wrappingBuffer.data[1]
+                        + (segmentStart - firstPartFrames) * mSamplesPerFrame;
+            } else {
+                continue; // no more data from this stream
+            }
+            sources[numRuns++] = source;
+        }
+
+        float *destination = mOutputBuffer.get() + segmentStart * mSamplesPerFrame;
+        const int32_t numSamples = (segmentEnd - segmentStart) * mSamplesPerFrame;
+        switch (numRuns) {
+            case 0:
+                if (clip) {
+                    mixRuns<0>(destination, sources, numSamples, clip);
+                }
+                break;
+            case 1:
+                mixRuns<1>(destination, sources, numSamples, clip);
+                break;
+            case 2:
+                mixRuns<2>(destination, sources, numSamples, clip);
+                break;
+            case 3:
+                mixRuns<3>(destination, sources, numSamples, clip);
+                break;
+            default:
+                mixRuns<4>(destination, sources, numSamples, clip);
+                break;
+        }
+        segmentStart = segmentEnd;
     }
 }
 
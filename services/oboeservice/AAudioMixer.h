@@ -18,6 +18,8 @@
 #define AAUDIO_AAUDIO_MIXER_H
 
 #include <stdint.h>
+#include <memory>
+#include <vector>
 
 #include <aaudio/AAudio.h>
 #include <fifo/FifoBuffer.h>
@@ -31,24 +33,42 @@ public:
     void clear();
 
     /**
-     * Mix from this FIFO
+     * Add this FIFO to the next mix. The data is not read until mixStreams() is called,
+     * so the caller must keep the FIFO and its storage alive until then.
      * @param streamIndex for marking stream variables in systrace
      * @param fifo to read from
      * @param allowUnderflow if true then allow mixer to advance read index past the write index
-     * @return frames read from this stream
+     * @return frames that will be read from this stream
      */
-    int32_t mix(int streamIndex,
-                const std::shared_ptr<android::FifoBuffer>& fifo,
-                bool allowUnderflow);
+    int32_t addStream(int streamIndex,
+                      std::shared_ptr<android::FifoBuffer> fifo,
+                      bool allowUnderflow);
+
+    /**
+     * Accumulate the streams added since the last call into the output buffer, clip the
+     * result and advance the read index of each FIFO.
+     * Up to kMaxStreamsPerPass streams are accumulated in a single pass over the burst.
+     */
+    void mixStreams();
 
     float *getOutputBuffer();
 
     int32_t getFramesPerBurst() const { return mFramesPerBurst; }
 
+    static constexpr int kMaxStreamsPerPass = 4;
+
 private:
-    void mixPart(float *destination, float *source, int32_t numFrames);
+    struct Stream {
+        std::shared_ptr<android::FifoBuffer> fifo;
+        android::WrappingBuffer              wrappingBuffer;
+        int32_t                              framesToRead;
+        int32_t                              framesDesired;
+    };
+
+    void mixPass(const Stream *streams, int numStreams, bool clip);
 
     std::unique_ptr<float[]> mOutputBuffer;
+    std::vector<Stream>      mStreams;
     int32_t  mSamplesPerFrame = 0;
     int32_t  mFramesPerBurst = 0;
     int32_t  mBufferSizeInBytes = 0;
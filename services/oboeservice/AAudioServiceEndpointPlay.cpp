@@ -51,6 +51,7 @@ aaudio_result_t AAudioServiceEndpointPlay::open(const aaudio::AAudioStreamReques
     if (result == AAUDIO_OK) {
         mMixer.allocate(getStreamInternal()->getSamplesPerFrame(),
                         getStreamInternal()->getFramesPerBurst());
+        mMixedStreams.reserve(4 * AAudioMixer::kMaxStreamsPerPass);
 
         int32_t burstsPerBuffer = AudioSystem::getAAudioMixerBurstCount();
         if (burstsPerBuffer == 0) {
@@ -80,7 +81,6 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
 
             std::lock_guard <std::mutex> lock(mLockStreams);
             for (const auto& clientStream : mRegisteredStreams) {
-                int64_t clientFramesRead = 0;
                 bool allowUnderflow = true;
 
                 if (clientStream->isSuspended()) {
@@ -107,29 +107,39 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
 
                         // Determine offset between framePosition in client's stream
                         // vs the underlying MMAP stream.
-                        clientFramesRead = fifo->getReadCounter();
+                        int64_t clientFramesRead = fifo->getReadCounter();
                         // These two indices refer to the same frame.
                         int64_t positionOffset = mmapFramesWritten - clientFramesRead;
                         streamShared->setTimestampPositionOffset(positionOffset);
 
-                        int32_t framesMixed = mMixer.mix(index, fifo, allowUnderflow);
-
-                        if (streamShared->isFlowing()) {
-                            // Consider it an underflow if we got less than a burst
-                            // after the data started flowing.
-                            bool underflowed = allowUnderflow
-                                               && framesMixed < mMixer.getFramesPerBurst();
-                            if (underflowed) {
-                                streamShared->incrementXRunCount();
-                            }
-                        } else if (framesMixed > 0) {
-                            // Mark beginning of data flow after a start.
-                            streamShared->setFlowing(true);
-                        }
-                        clientFramesRead = fifo->getReadCounter();
+                        // The data is read below, in one pass over all the streams.
+                        int32_t framesMixed = mMixer.addStream(index, fifo, allowUnderflow);
+                        mMixedStreams.push_back({streamShared, std::move(audioDataQueue),
+                                                 std::move(fifo), allowUnderflow, framesMixed});
                     }
                 }
 
+                index++; // just used for labelling tracks in systrace
+            }
+
+            mMixer.mixStreams();
+
+            for (MixedStream& mixedStream : mMixedStreams) {
+                const sp<AAudioServiceStreamShared>& streamShared = mixedStream.stream;
+                if (streamShared->isFlowing()) {
+                    // Consider it an underflow if we got less than a burst
+                    // after the data started flowing.
+                    bool underflowed = mixedStream.allowUnderflow
+                                       && mixedStream.framesMixed < mMixer.getFramesPerBurst();
+                    if (underflowed) {
+                        streamShared->incrementXRunCount();
+                    }
+                } else if (mixedStream.framesMixed > 0) {
+                    // Mark beginning of data flow after a start.
+                    streamShared->setFlowing(true);
+                }
+
+                int64_t clientFramesRead = mixedStream.fifo->getReadCounter();
                 if (clientFramesRead > 0) {
                     // This timestamp represents the completion of data being read out of the
                     // client buffer. It is sent to the client and used in the timing model
@@ -137,9 +147,8 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
                     Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
                     streamShared->markTransferTime(timestamp);
                 }
-
-                index++; // just used for labelling tracks in systrace
             }
+            mMixedStreams.clear();
         }
 
         // Write mixer output to stream using a blocking write.
@@ -45,8 +45,19 @@ public:
     void *callbackLoop() override;
 
 private:
+    // A stream added to the mixer in this burst.
+    struct MixedStream {
+        android::sp<AAudioServiceStreamShared>   stream;
+        // Keeps the memory of the FIFO valid until it is read, even if the stream is closed.
+        std::shared_ptr<SharedRingBuffer>        audioDataQueue;
+        std::shared_ptr<android::FifoBuffer>     fifo;
+        bool                                     allowUnderflow;
+        int32_t                                  framesMixed;
+    };
+
     bool                     mLatencyTuningEnabled = false; // TODO implement tuning
     AAudioMixer              mMixer;    //
+    std::vector<MixedStream> mMixedStreams; // only used by the callback thread
 };
 
 } /* namespace aaudio */
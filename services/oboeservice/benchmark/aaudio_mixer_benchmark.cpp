@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <fifo/FifoBuffer.h>
+
+#include "AAudioMixer.h"
+
+using android::FifoBuffer;
+using android::FifoBufferAllocated;
+
+static constexpr int32_t kSampleRate = 48000;
+static constexpr int32_t kChannelCount = 2;
+// Not a multiple of the burst, so that the reads wrap around the end of the FIFOs.
+static constexpr int32_t kFifoCapacityFrames = 1000;
+
+/*
+ * Mixes one burst of each client stream, like the callback thread of a shared MMAP endpoint.
+ * Besides the average time per burst, reports the worst burst and how much of the burst
+ * period it used, which must stay well below 100% for the mixer to keep up.
+ *
+ * $ adb shell /data/benchmarktest/aaudio_mixer_benchmark/aaudio_mixer_benchmark
+ * Args: stream count, frames per burst
+ */
+static void BM_MixStreams(benchmark::State& state) {
+    const int32_t streamCount = state.range(0);
+    const int32_t framesPerBurst = state.range(1);
+
+    AAudioMixer mixer;
+    mixer.allocate(kChannelCount, framesPerBurst);
+
+    // Initialize the client data with deterministic pseudo-random values
+    std::minstd_rand gen(streamCount);
+    std::uniform_real_distribution<> dis(-0.5f, 0.5f);
+    std::vector<float> burst(framesPerBurst * kChannelCount);
+    for (auto& sample : burst) {
+        sample = dis(gen);
+    }
+
+    std::vector<std::shared_ptr<FifoBuffer>> fifos;
+    for (int32_t i = 0; i < streamCount; i++) {
+        fifos.push_back(std::make_shared<FifoBufferAllocated>(
+                kChannelCount * sizeof(float), kFifoCapacityFrames));
+        fifos.back()->write(burst.data(), framesPerBurst);
+    }
+
+    double maxBurstUs = 0;
+    for (auto _ : state) {
+        const auto start = std::chrono::steady_clock::now();
+        mixer.clear();
+        for (int32_t i = 0; i < streamCount; i++) {
+            mixer.addStream(i, fifos[i], true /* allowUnderflow */);
+        }
+        mixer.mixStreams();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        state.SetIterationTime(elapsed.count());
+        maxBurstUs = std::max(maxBurstUs, elapsed.count() * 1e6);
+
+        benchmark::DoNotOptimize(mixer.getOutputBuffer());
+        benchmark::ClobberMemory();
+
+        // The clients write the next burst.
+        for (const auto& fifo : fifos) {
+            fifo->write(burst.data(), framesPerBurst);
+        }
+    }
+
+    const double burstPeriodUs = 1e6 * framesPerBurst / kSampleRate;
+    state.counters["MaxBurstUs"] = maxBurstUs;
+    state.counters["MaxLoadPercent"] = 100 * maxBurstUs / burstPeriodUs;
+    state.SetItemsProcessed(state.iterations() * framesPerBurst * streamCount);
+}
+
+static void MixStreamsArgs(benchmark::internal::Benchmark* b) {
+    for (int streamCount : {1, 2, 4, 8, 16}) {
+        for (int framesPerBurst : {48, 96, 192, 480}) {
+            b->Args({streamCount, framesPerBurst});
+        }
+    }
+}
+
+BENCHMARK(BM_MixStreams)->Apply(MixStreamsArgs)->UseManualTime();
+
+BENCHMARK_MAIN();
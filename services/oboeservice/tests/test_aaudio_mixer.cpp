@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <fifo/FifoBuffer.h>
+
+#include "AAudioMixer.h"
+
+using android::FifoBuffer;
+using android::FifoBufferAllocated;
+
+// Same headroom as the mixer and ClipToRange in the AAudio flowgraph.
+static constexpr float kMaxHeadroom = 1.41253754f;
+// Not a multiple of the bursts, so that the reads wrap around the end of the FIFOs.
+static constexpr int32_t kFifoCapacityFrames = 300;
+
+struct ClientStream {
+    std::shared_ptr<FifoBuffer> fifo;
+    std::vector<float> written; // every sample written, in order
+    int64_t framesRead = 0;     // frames the reference has consumed
+};
+
+// stream count, channel count, frames per burst
+using MixerParams = std::tuple<int, int32_t, int32_t>;
+
+class AAudioMixerTest : public ::testing::TestWithParam<MixerParams> {
+protected:
+    void SetUp() override {
+        std::tie(mStreamCount, mChannelCount, mFramesPerBurst) = GetParam();
+        mMixer.allocate(mChannelCount, mFramesPerBurst);
+        for (int i = 0; i < mStreamCount; i++) {
+            ClientStream stream;
+            stream.fifo = std::make_shared<FifoBufferAllocated>(
+                    mChannelCount * sizeof(float), kFifoCapacityFrames);
+            mStreams.push_back(std::move(stream));
+        }
+    }
+
+    // The client writes frames of random samples, loud enough for the mix to clip.
+    void write(ClientStream& stream, int32_t frames) {
+        std::vector<float> samples(frames * mChannelCount);
+        for (float& sample : samples) {
+            sample = mDistribution(mGenerator);
+        }
+        ASSERT_EQ(frames, stream.fifo->write(samples.data(), frames));
+        stream.written.insert(stream.written.end(), samples.begin(), samples.end());
+    }
+
+    // Mixes one burst with the mixer and with a scalar reference, and compares them.
+    void mixAndCompare(const std::vector<bool>& allowUnderflow) {
+        const int32_t samplesPerBurst = mFramesPerBurst * mChannelCount;
+        std::vector<float> expected(samplesPerBurst, 0.0f);
+        std::vector<int32_t> expectedFramesMixed;
+        std::vector<int32_t> expectedFramesAdvanced;
+        for (int i = 0; i < mStreamCount; i++) {
+            ClientStream& stream = mStreams[i];
+            const int32_t available = stream.fifo->getFullFramesAvailable();
+            const int32_t framesDesired = allowUnderflow[i]
+                    ? mFramesPerBurst : std::min(available, mFramesPerBurst);
+            const int32_t framesRead = std::min(available, framesDesired);
+            const float* source = stream.written.data() + stream.framesRead * mChannelCount;
+            for (int32_t k = 0; k < framesRead * mChannelCount; k++) {
+                expected[k] += source[k];
+            }
+            // Frames read past the write index after an underflow are not mixed, but are
+            // consumed: the client will overwrite them.
+            stream.framesRead += framesDesired;
+            stream.written.resize(std::max<size_t>(stream.written.size(),
+                                                   stream.framesRead * mChannelCount));
+            expectedFramesMixed.push_back(framesRead);
+            expectedFramesAdvanced.push_back(framesDesired);
+        }
+        for (float& sample : expected) {
+            sample = std::min(std::max(sample, -kMaxHeadroom), kMaxHeadroom);
+        }
+
+        std::vector<int64_t> readCounters;
+        mMixer.clear();
+        for (int i = 0; i < mStreamCount; i++) {
+            readCounters.push_back(mStreams[i].fifo->getReadCounter());
+            EXPECT_EQ(expectedFramesMixed[i],
+                      mMixer.addStream(i, mStreams[i].fifo, allowUnderflow[i]));
+        }
+        mMixer.mixStreams();
+
+        for (int i = 0; i < mStreamCount; i++) {
+            EXPECT_EQ(readCounters[i] + expectedFramesAdvanced[i],
+                      mStreams[i].fifo->getReadCounter()) << "stream " << i;
+        }
+        const float* output = mMixer.getOutputBuffer();
+        for (int32_t k = 0; k < samplesPerBurst; k++) {
+            // The mixer adds the streams in the same order, so the sums are identical.
+            ASSERT_EQ(expected[k], output[k]) << "sample " << k;
+        }
+    }
+
+    // After an underflow, the write index lags the read index. The client catches up by
+    // writing what it missed, which the mixer has already skipped.
+    void catchUp(ClientStream& stream) {
+        const int64_t behind = stream.fifo->getReadCounter() - stream.fifo->getWriteCounter();
+        if (behind > 0) {
+            stream.written.resize(stream.fifo->getWriteCounter() * mChannelCount);
+            write(stream, behind);
+        }
+    }
+
+    int mStreamCount;
+    int32_t mChannelCount;
+    int32_t mFramesPerBurst;
+    AAudioMixer mMixer;
+    std::vector<ClientStream> mStreams;
+    std::minstd_rand mGenerator{42};
+    std::uniform_real_distribution<float> mDistribution{-1.0f, 1.0f};
+};
+
+TEST_P(AAudioMixerTest, MatchesScalarMix) {
+    const std::vector<bool> allowUnderflow(mStreamCount, true);
+    for (int burst = 0; burst < 20; burst++) {
+        for (ClientStream& stream : mStreams) {
+            write(stream, mFramesPerBurst);
+        }
+        mixAndCompare(allowUnderflow);
+    }
+}
+
+// Streams run out of data at different frames of the burst, and some of them are stopping.
+TEST_P(AAudioMixerTest, MatchesScalarMixWithUnderflows) {
+    std::vector<bool> allowUnderflow;
+    for (int i = 0; i < mStreamCount; i++) {
+        allowUnderflow.push_back(i % 3 != 2);
+    }
+    for (int burst = 0; burst < 20; burst++) {
+        for (int i = 0; i < mStreamCount; i++) {
+            ClientStream& stream = mStreams[i];
+            catchUp(stream);
+            // Full bursts, partial ones and none at all.
+            const int32_t frames = (burst + i) % 4 == 0 ? 0
+                    : std::min(stream.fifo->getEmptyFramesAvailable(),
+                               mFramesPerBurst * ((burst + i) % 3) / 2);
+            write(stream, frames);
+        }
+        mixAndCompare(allowUnderflow);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        AAudioMixer, AAudioMixerTest,
+        ::testing::Combine(
+                // Fewer, as many and more streams than accumulated per pass.
+                ::testing::Values(1, 3, AAudioMixer::kMaxStreamsPerPass, 5, 9),
+                ::testing::Values(1, 2, 3, 6),
+                // Bursts that are and are not a multiple of the vector size.
+                ::testing::Values(48, 37)));